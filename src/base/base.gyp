@@ -96,6 +96,7 @@
       'toolsets': ['host', 'target'],
       'sources': [
         '<(gen_out_dir)/character_set.inc',
+        'container/arena.cc',
         'environ.cc',
         'file/recursive.cc',
         'file/temp_dir.cc',
@@ -109,6 +110,7 @@
         'strings/internal/utf8_internal.cc',
         'system_util.cc',
         'text_normalizer.cc',
+        'thread.cc',
         'util.cc',
         'vlog.cc',
       ],
@@ -0,0 +1,182 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/container/arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+
+namespace mozc {
+namespace {
+
+constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+
+struct RequestArenaState {
+  Arena arena;
+  int depth = 0;
+};
+
+RequestArenaState &GetRequestArenaState() {
+  thread_local RequestArenaState state;
+  return state;
+}
+
+}  // namespace
+
+Arena::Arena(size_t block_size, std::pmr::memory_resource *upstream)
+    : block_size_(std::max<size_t>(block_size, 1 << kMaxSizeClassShift)),
+      upstream_(upstream) {}
+
+Arena::~Arena() {
+  Reset();
+  for (const Block &block : blocks_) {
+    upstream_->deallocate(block.data, block.size, block.alignment);
+  }
+}
+
+void Arena::Reset() {
+  for (const Block &allocation : large_allocations_) {
+    upstream_->deallocate(allocation.data, allocation.size,
+                          allocation.alignment);
+    bytes_reserved_ -= allocation.size;
+  }
+  large_allocations_.clear();
+  free_lists_.fill(nullptr);
+
+  // Keeps the first blocks for the next round.
+  size_t retained = 0;
+  size_t num_retained_blocks = 0;
+  for (; num_retained_blocks < blocks_.size(); ++num_retained_blocks) {
+    retained += blocks_[num_retained_blocks].size;
+    if (retained > kMaxRetainedBytes) {
+      break;
+    }
+  }
+  for (size_t i = num_retained_blocks; i < blocks_.size(); ++i) {
+    upstream_->deallocate(blocks_[i].data, blocks_[i].size,
+                          blocks_[i].alignment);
+    bytes_reserved_ -= blocks_[i].size;
+  }
+  blocks_.resize(num_retained_blocks);
+
+  current_block_ = 0;
+  offset_ = 0;
+  bytes_in_use_ = 0;
+}
+
+size_t Arena::GetSizeClass(size_t bytes, size_t alignment) {
+  if (alignment > kBlockAlignment || bytes > (1 << kMaxSizeClassShift)) {
+    return kNumSizeClasses;
+  }
+  const size_t size = std::max<size_t>(bytes, 1 << kMinSizeClassShift);
+  return std::bit_width(size - 1) - kMinSizeClassShift;
+}
+
+void *Arena::AllocateFromBlocks(size_t size) {
+  // `size` is a multiple of kBlockAlignment, so `offset_` is always aligned.
+  for (; current_block_ < blocks_.size(); ++current_block_, offset_ = 0) {
+    Block &block = blocks_[current_block_];
+    if (offset_ + size <= block.size) {
+      void *ptr = static_cast<char *>(block.data) + offset_;
+      offset_ += size;
+      return ptr;
+    }
+  }
+  const size_t block_size = std::max(block_size_, size);
+  blocks_.push_back({upstream_->allocate(block_size, kBlockAlignment),
+                     block_size, kBlockAlignment});
+  bytes_reserved_ += block_size;
+  current_block_ = blocks_.size() - 1;
+  offset_ = size;
+  return blocks_.back().data;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment) {
+  const size_t size_class = GetSizeClass(bytes, alignment);
+  if (size_class == kNumSizeClasses) {
+    void *ptr = upstream_->allocate(bytes, alignment);
+    large_allocations_.push_back({ptr, bytes, alignment});
+    bytes_reserved_ += bytes;
+    bytes_in_use_ += bytes;
+    return ptr;
+  }
+
+  const size_t size = size_t{1} << (size_class + kMinSizeClassShift);
+  bytes_in_use_ += size;
+  if (FreeNode *node = free_lists_[size_class]; node != nullptr) {
+    free_lists_[size_class] = node->next;
+    return node;
+  }
+  return AllocateFromBlocks(size);
+}
+
+void Arena::do_deallocate(void *p, size_t bytes, size_t alignment) {
+  const size_t size_class = GetSizeClass(bytes, alignment);
+  if (size_class == kNumSizeClasses) {
+    // Large allocations are rare, and the recent one is likely to be freed
+    // first.
+    auto it = std::find_if(
+        large_allocations_.rbegin(), large_allocations_.rend(),
+        [p](const Block &allocation) { return allocation.data == p; });
+    if (it != large_allocations_.rend()) {
+      upstream_->deallocate(p, bytes, alignment);
+      bytes_reserved_ -= bytes;
+      bytes_in_use_ -= bytes;
+      large_allocations_.erase(std::next(it).base());
+    }
+    return;
+  }
+
+  bytes_in_use_ -= size_t{1} << (size_class + kMinSizeClassShift);
+  FreeNode *node = static_cast<FreeNode *>(p);
+  node->next = free_lists_[size_class];
+  free_lists_[size_class] = node;
+}
+
+std::pmr::memory_resource *GetRequestMemoryResource() {
+  RequestArenaState &state = GetRequestArenaState();
+  if (state.depth == 0) {
+    return std::pmr::new_delete_resource();
+  }
+  return &state.arena;
+}
+
+RequestArenaScope::RequestArenaScope() { ++GetRequestArenaState().depth; }
+
+RequestArenaScope::~RequestArenaScope() {
+  RequestArenaState &state = GetRequestArenaState();
+  if (--state.depth == 0) {
+    state.arena.Reset();
+  }
+}
+
+}  // namespace mozc
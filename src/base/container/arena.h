@@ -0,0 +1,151 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_BASE_CONTAINER_ARENA_H_
+#define MOZC_BASE_CONTAINER_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace mozc {
+
+// A memory resource for short-lived objects, which serves allocations by
+// bumping a pointer in large blocks. Deallocated memory is kept in per size
+// class free lists and reused by the following allocations of the same size
+// class. All the memory is reclaimed at once by Reset(), while the blocks are
+// kept for the next round so that the steady state does not call the upstream
+// allocator at all.
+//
+// Arena is not thread-safe.
+//
+// Usage:
+//   Arena arena;
+//   {
+//     std::pmr::vector<int> v(&arena);
+//     ...
+//   }
+//   arena.Reset();
+class Arena : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  Arena() : Arena(kDefaultBlockSize) {}
+  // `block_size` is rounded up to the largest size class.
+  explicit Arena(size_t block_size,
+                 std::pmr::memory_resource *upstream =
+                     std::pmr::get_default_resource());
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  ~Arena() override;
+
+  // Reclaims all the memory allocated from this arena. Objects allocated from
+  // the arena must not be used after this call. Blocks up to the retention
+  // limit are kept for reuse.
+  void Reset();
+
+  // Bytes handed out and not yet reclaimed, including the rounding to the size
+  // classes. Deallocated memory waiting in the free lists is not counted.
+  size_t bytes_in_use() const { return bytes_in_use_; }
+  // Bytes obtained from the upstream resource.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block {
+    void *data;
+    size_t size;
+    size_t alignment;
+  };
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  // Size classes are the powers of two from 16 bytes to 64 KiB. Larger or
+  // over-aligned allocations go to the upstream resource directly.
+  static constexpr size_t kMinSizeClassShift = 4;
+  static constexpr size_t kMaxSizeClassShift = 16;
+  static constexpr size_t kNumSizeClasses =
+      kMaxSizeClassShift - kMinSizeClassShift + 1;
+  // Blocks exceeding this total are returned to upstream by Reset().
+  static constexpr size_t kMaxRetainedBytes = 1024 * 1024;
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  // Returns the index of the size class for the size, or kNumSizeClasses if
+  // it is not served by the size classes.
+  static size_t GetSizeClass(size_t bytes, size_t alignment);
+  void *AllocateFromBlocks(size_t size);
+
+  const size_t block_size_;
+  std::pmr::memory_resource *const upstream_;
+  std::vector<Block> blocks_;
+  // Index of the block to bump, and the current position in it.
+  size_t current_block_ = 0;
+  size_t offset_ = 0;
+  std::array<FreeNode *, kNumSizeClasses> free_lists_ = {};
+  // Allocations served by the upstream directly.
+  std::vector<Block> large_allocations_;
+  size_t bytes_in_use_ = 0;
+  size_t bytes_reserved_ = 0;
+};
+
+// Returns the memory resource for the objects that live only during the
+// current request on this thread. Inside a RequestArenaScope it is the
+// thread-local Arena, which is reset when the outermost scope exits.
+// Otherwise it is std::pmr::new_delete_resource(), so it is always safe to
+// call.
+//
+// Objects allocated from this resource must not outlive the request. In
+// particular, don't use it for anything cached across requests, like the
+// lattice in Segments.
+std::pmr::memory_resource *GetRequestMemoryResource();
+
+// Marks the duration of a request on this thread. Scopes can be nested; only
+// the outermost one resets the arena.
+class RequestArenaScope {
+ public:
+  RequestArenaScope();
+
+  RequestArenaScope(const RequestArenaScope &) = delete;
+  RequestArenaScope &operator=(const RequestArenaScope &) = delete;
+
+  ~RequestArenaScope();
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_CONTAINER_ARENA_H_
@@ -0,0 +1,122 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/container/arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+TEST(ArenaTest, AllocateAndReset) {
+  Arena arena;
+  std::vector<void *> ptrs;
+  for (size_t size = 1; size <= 1024; size *= 2) {
+    void *ptr = arena.allocate(size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t), 0);
+    ptrs.push_back(ptr);
+  }
+  EXPECT_GT(arena.bytes_in_use(), 0);
+  const size_t reserved = arena.bytes_reserved();
+  EXPECT_GE(reserved, arena.bytes_in_use());
+
+  arena.Reset();
+  EXPECT_EQ(arena.bytes_in_use(), 0);
+  // Blocks are kept for the next round and handed out from the beginning.
+  EXPECT_EQ(arena.bytes_reserved(), reserved);
+  EXPECT_EQ(arena.allocate(1), ptrs.front());
+}
+
+TEST(ArenaTest, ReuseDeallocatedMemoryOfSameSizeClass) {
+  Arena arena;
+  void *ptr = arena.allocate(100);
+  arena.deallocate(ptr, 100);
+  EXPECT_EQ(arena.bytes_in_use(), 0);
+  // 100 and 120 bytes are in the same size class.
+  EXPECT_EQ(arena.allocate(120), ptr);
+  EXPECT_NE(arena.allocate(100), ptr);
+}
+
+TEST(ArenaTest, LargeAndOverAlignedAllocations) {
+  Arena arena;
+  constexpr size_t kLargeSize = 1024 * 1024;
+  void *large = arena.allocate(kLargeSize);
+  EXPECT_GE(arena.bytes_in_use(), kLargeSize);
+  arena.deallocate(large, kLargeSize);
+  EXPECT_EQ(arena.bytes_in_use(), 0);
+
+  constexpr size_t kAlignment = 256;
+  void *aligned = arena.allocate(16, kAlignment);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % kAlignment, 0);
+
+  // Not deallocated explicitly, but released by Reset().
+  EXPECT_NE(arena.allocate(kLargeSize), nullptr);
+  arena.Reset();
+  EXPECT_EQ(arena.bytes_in_use(), 0);
+}
+
+TEST(ArenaTest, PmrContainers) {
+  Arena arena;
+  {
+    std::pmr::vector<std::pmr::string> strings(&arena);
+    for (int i = 0; i < 1000; ++i) {
+      strings.emplace_back(i % 50, 'a');
+    }
+    EXPECT_EQ(strings[999].size(), 49);
+  }
+  EXPECT_EQ(arena.bytes_in_use(), 0);
+  arena.Reset();
+}
+
+TEST(ArenaTest, RequestArenaScope) {
+  EXPECT_EQ(GetRequestMemoryResource(), std::pmr::new_delete_resource());
+  {
+    const RequestArenaScope scope;
+    std::pmr::memory_resource *resource = GetRequestMemoryResource();
+    EXPECT_NE(resource, std::pmr::new_delete_resource());
+    Arena *arena = dynamic_cast<Arena *>(resource);
+    ASSERT_NE(arena, nullptr);
+    {
+      const RequestArenaScope nested_scope;
+      EXPECT_EQ(GetRequestMemoryResource(), resource);
+      EXPECT_NE(resource->allocate(10), nullptr);
+    }
+    // The nested scope doesn't reset the arena.
+    EXPECT_GT(arena->bytes_in_use(), 0);
+  }
+  EXPECT_EQ(GetRequestMemoryResource(), std::pmr::new_delete_resource());
+}
+
+}  // namespace
+}  // namespace mozc
@@ -44,13 +44,16 @@ namespace mozc {
 // This class runs unneeded T's constructor along with the memory chunk
 // allocation.
 // Please do take care to use this class.
-template <class T>
+//
+// The chunks are allocated by `Allocator`. With
+// std::pmr::polymorphic_allocator, a FreeList local to a request can take its
+// chunks from the request arena (see base/container/arena.h).
+template <class T, class Allocator = std::allocator<T>>
 class FreeList {
  public:
   using value_type = T;
-  // FreeList currently only supports std::allocator.
-  using allocator_type = std::allocator<T>;
-  using allocator_traits = std::allocator_traits<std::allocator<T>>;
+  using allocator_type = Allocator;
+  using allocator_traits = std::allocator_traits<Allocator>;
   using reference = T&;
   using const_reference = const T&;
   using size_type = typename allocator_traits::size_type;
@@ -60,7 +63,9 @@ class FreeList {
 
   static_assert(!std::is_const_v<T>, "FreeList can't hold a const type.");
 
-  explicit FreeList(const size_type chunk_size) : chunk_size_(chunk_size) {}
+  explicit FreeList(const size_type chunk_size,
+                    const allocator_type& allocator = allocator_type())
+      : chunk_size_(chunk_size), allocator_(allocator) {}
 
   FreeList(FreeList&& other) noexcept
       : pool_(std::move(other.pool_)),
@@ -73,16 +78,17 @@ class FreeList {
     other.pool_.clear();
   }
 
-  FreeList& operator=(FreeList&& other) noexcept {
+  // The chunks of `other` can only be adopted with its allocator, so move
+  // assignment requires an allocator propagating on move assignment.
+  FreeList& operator=(FreeList&& other) noexcept
+    requires(allocator_traits::propagate_on_container_move_assignment::value)
+  {
     static_assert(std::is_nothrow_move_assignable_v<decltype(pool_)>);
     // Destroy `this` freelist and move `other` over.
     Destroy();
     pool_ = std::move(other.pool_);
     next_in_chunk_ = other.next_in_chunk_;
     chunk_size_ = other.chunk_size_;
-    static_assert(
-        allocator_traits::propagate_on_container_move_assignment::value,
-        "std::allocator is supposed to propagate on move assignments.");
     allocator_ = std::move(other.allocator_);
     other.pool_.clear();
     return *this;
@@ -167,10 +173,12 @@ class FreeList {
   allocator_type allocator_;
 };
 
-template <class T>
+template <class T, class Allocator = std::allocator<T>>
 class ObjectPool {
  public:
-  explicit ObjectPool(const int chunk_size) : freelist_(chunk_size) {}
+  explicit ObjectPool(const int chunk_size,
+                      const Allocator& allocator = Allocator())
+      : freelist_(chunk_size, allocator) {}
   ObjectPool(ObjectPool&&) = default;
   ObjectPool& operator=(ObjectPool&&) = default;
 
@@ -209,7 +217,7 @@ class ObjectPool {
   FRIEND_TEST(SegmentsTest, BasicTest);
 
   std::vector<T*> released_;
-  FreeList<T> freelist_;
+  FreeList<T, Allocator> freelist_;
 };
 
 }  // namespace mozc
@@ -29,6 +29,9 @@
 
 #include "base/container/freelist.h"
 
+#include <array>
+#include <cstddef>
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
@@ -209,5 +212,30 @@ TEST_F(FreeListTest, ObjectPoolAllocReleaseFree) {
   }
 }
 
+TEST_F(FreeListTest, PolymorphicAllocator) {
+  alignas(Stub) std::array<std::byte, 64 * sizeof(Stub)> buffer;
+  std::pmr::monotonic_buffer_resource resource(
+      buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+  {
+    FreeList<Stub, std::pmr::polymorphic_allocator<Stub>> free_list(4,
+                                                                    &resource);
+    for (int i = 0; i < 10; ++i) {
+      const Stub *p = free_list.Alloc();
+      // All the chunks are taken from the buffer.
+      EXPECT_GE(reinterpret_cast<const std::byte *>(p), buffer.data());
+      EXPECT_LT(reinterpret_cast<const std::byte *>(p),
+                buffer.data() + buffer.size());
+    }
+    EXPECT_EQ(free_list.get_allocator().resource(), &resource);
+
+    FreeList<Stub, std::pmr::polymorphic_allocator<Stub>> moved(
+        std::move(free_list));
+    EXPECT_EQ(moved.size(), 10);
+    EXPECT_EQ(moved.get_allocator().resource(), &resource);
+  }
+  EXPECT_EQ(Stub::constructed(), 10);
+  EXPECT_EQ(Stub::destructed(), 10);
+}
+
 }  // namespace
 }  // namespace mozc
@@ -30,6 +30,7 @@
 #include "base/mmap.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <utility>
 
@@ -74,8 +75,9 @@ namespace {
 //         OpenFile(): Opens a file and returns FileDescriptor.
 //      GetFileSize(): Gets the file size.
 //      GetPageSize(): Gets the number satisfying mmap alignment.
-//          MapFile(): Performs mmap.
+//          MapFile(): Performs mmap, optionally pre-faulting the pages.
 //            Unmap(): Releases a mmap.
+//      AdvisePages(): Performs madvise (POSIX only).
 #ifdef _WIN32
 
 struct SyscallParams {
@@ -157,7 +159,8 @@ constexpr std::pair<DWORD, DWORD> GetHiAndLo(size_t value) {
 }
 
 absl::StatusOr<void *> MapFile(FileDescriptor fd, size_t offset, size_t size,
-                               const SyscallParams &params) {
+                               const SyscallParams &params,
+                               bool /*unused_populate*/) {
   const auto [max_size_hi, max_size_lo] = GetHiAndLo(size);
   wil::unique_handle handle(::CreateFileMapping(
       fd, 0, params.protect, max_size_hi, max_size_lo, nullptr));
@@ -258,8 +261,14 @@ absl::StatusOr<size_t> GetPageSize() {
 }
 
 absl::StatusOr<void *> MapFile(FileDescriptor fd, size_t offset, size_t size,
-                               const SyscallParams &params) {
-  void *const ptr = mmap(nullptr, size, params.prot, MAP_SHARED, fd, offset);
+                               const SyscallParams &params, bool populate) {
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif  // MAP_POPULATE
+  void *const ptr = mmap(nullptr, size, params.prot, flags, fd, offset);
   if (ptr == MAP_FAILED) {
     return absl::ErrnoToStatus(errno, "mmap() failed");
   }
@@ -272,12 +281,26 @@ void Unmap(void *ptr, size_t size) {
   }
 }
 
+// Calls madvise() for the pages enclosing `[addr, addr + len)`.
+int AdvisePages(const void *addr, size_t len, int advice) {
+  absl::StatusOr<size_t> page_size = GetPageSize();
+  if (!page_size.ok()) {
+    return -1;
+  }
+  // madvise() requires a page-aligned address.
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(addr);
+  const uintptr_t aligned_begin = begin - begin % *page_size;
+  return madvise(reinterpret_cast<void *>(aligned_begin),
+                 len + (begin - aligned_begin), advice);
+}
+
 #endif  // _WIN32
 
 }  // namespace
 
 absl::StatusOr<Mmap> Mmap::Map(zstring_view filename, size_t offset,
-                               std::optional<size_t> size, Mode mode) {
+                               std::optional<size_t> size, Mode mode,
+                               const Options &options) {
   absl::StatusOr<SyscallParams> params = GetSyscallParams(mode);
   if (!params.ok()) {
     return std::move(params).status();
@@ -317,12 +340,24 @@ absl::StatusOr<Mmap> Mmap::Map(zstring_view filename, size_t offset,
   const size_t map_offset = offset - adjust;
   const size_t map_size = *size + adjust;
 
-  absl::StatusOr<void *> ptr = MapFile(*fd, map_offset, map_size, *params);
+  absl::StatusOr<void *> ptr =
+      MapFile(*fd, map_offset, map_size, *params, options.populate);
   if (!ptr.ok()) {
     return std::move(ptr).status();
   }
 
-  MaybeMLock(*ptr, map_size);
+  if (options.advice != Advice::kNormal) {
+    MaybeAdvise(*ptr, map_size, options.advice);
+  }
+#ifndef MAP_POPULATE
+  if (options.populate) {
+    Prefetch(*ptr, map_size);
+  }
+#endif  // MAP_POPULATE
+
+  if (options.mlock) {
+    MaybeMLock(*ptr, map_size);
+  }
 
   Mmap mmap;
   mmap.data_ = absl::MakeSpan(static_cast<char *>(*ptr) + adjust, *size);
@@ -389,4 +424,61 @@ int Mmap::MaybeMUnlock(const void *addr, size_t len) { return -1; }
 
 #undef MOZC_HAVE_MLOCK
 
+#ifdef _WIN32
+int Mmap::MaybeAdvise(const void *addr, size_t len, Advice advice) {
+  return -1;
+}
+#else   // _WIN32
+int Mmap::MaybeAdvise(const void *addr, size_t len, Advice advice) {
+  int native_advice;
+  switch (advice) {
+    case Advice::kNormal:
+      native_advice = MADV_NORMAL;
+      break;
+    case Advice::kRandom:
+      native_advice = MADV_RANDOM;
+      break;
+    case Advice::kSequential:
+      native_advice = MADV_SEQUENTIAL;
+      break;
+    case Advice::kWillNeed:
+      native_advice = MADV_WILLNEED;
+      break;
+    case Advice::kHugePage:
+#ifdef MADV_HUGEPAGE
+      native_advice = MADV_HUGEPAGE;
+      break;
+#else   // MADV_HUGEPAGE
+      return -1;
+#endif  // MADV_HUGEPAGE
+    default:
+      return -1;
+  }
+  if (len == 0) {
+    return 0;
+  }
+  return AdvisePages(addr, len, native_advice);
+}
+#endif  // _WIN32
+
+void Mmap::Prefetch(const void *addr, size_t len) {
+  if (len == 0) {
+    return;
+  }
+#ifdef MADV_POPULATE_READ
+  // Linux 5.14+ can populate the page tables in a single call.
+  if (AdvisePages(addr, len, MADV_POPULATE_READ) == 0) {
+    return;
+  }
+#endif  // MADV_POPULATE_READ
+  absl::StatusOr<size_t> page_size = GetPageSize();
+  const size_t stride = page_size.ok() ? *page_size : 4096;
+  // Touches one byte per page. The volatile reads are not optimized away.
+  const volatile char *data = static_cast<const volatile char *>(addr);
+  for (size_t i = 0; i < len; i += stride) {
+    static_cast<void>(data[i]);
+  }
+  static_cast<void>(data[len - 1]);
+}
+
 }  // namespace mozc
@@ -46,11 +46,36 @@ class Mmap final {
     READ_WRITE,
   };
 
+  // Hints on the access pattern of mapped pages. These correspond to
+  // madvise(2) advices and are silently ignored where not supported.
+  enum class Advice {
+    kNormal,      // MADV_NORMAL: Default readahead.
+    kRandom,      // MADV_RANDOM: Pages are accessed randomly; no readahead.
+    kSequential,  // MADV_SEQUENTIAL: Aggressive readahead.
+    kWillNeed,    // MADV_WILLNEED: Starts reading the pages asynchronously.
+    kHugePage,    // MADV_HUGEPAGE: Prefers transparent huge pages.
+  };
+
+  // Options applied when creating a mapping.
+  struct Options {
+    // Faults in all the pages of the mapping before returning (MAP_POPULATE).
+    // Falls back to Prefetch() on platforms without MAP_POPULATE.
+    bool populate = false;
+    // Access pattern hint for the entire mapping.
+    Advice advice = Advice::kNormal;
+    // Tries to mlock the mapping. See MaybeMLock().
+    bool mlock = true;
+  };
+
   // Creates a mapping of an entire file into the address space.
   static absl::StatusOr<Mmap> Map(zstring_view filename,
                                   Mode mode = READ_ONLY) {
     return Map(filename, 0, std::nullopt, mode);
   }
+  static absl::StatusOr<Mmap> Map(zstring_view filename, Mode mode,
+                                  const Options &options) {
+    return Map(filename, 0, std::nullopt, mode, options);
+  }
 
   // Creates a mapping of a partial region of a file into the address space. The
   // file region `[offset, offset + size)` is mapped to the returned instance.
@@ -58,7 +83,12 @@ class Mmap final {
   // mapped.
   static absl::StatusOr<Mmap> Map(zstring_view filename, size_t offset,
                                   std::optional<size_t> size,
-                                  Mode mode = READ_ONLY);
+                                  Mode mode = READ_ONLY) {
+    return Map(filename, offset, size, mode, Options());
+  }
+  static absl::StatusOr<Mmap> Map(zstring_view filename, size_t offset,
+                                  std::optional<size_t> size, Mode mode,
+                                  const Options &options);
 
   Mmap() = default;
 
@@ -87,6 +117,18 @@ class Mmap final {
   static int MaybeMLock(const void *addr, size_t len);
   static int MaybeMUnlock(const void *addr, size_t len);
 
+  // Gives the kernel a hint about the access pattern of `[addr, addr + len)`.
+  // The range is widened to the enclosing page boundaries, so it should be a
+  // part of a mapping. Like MaybeMLock(), returns the result of madvise(), or
+  // -1 if the advice is not supported on the platform.
+  static int MaybeAdvise(const void *addr, size_t len, Advice advice);
+
+  // Synchronously faults in the pages of `[addr, addr + len)` so that the
+  // subsequent accesses don't hit the disk. Unlike Advice::kWillNeed, this
+  // blocks until the pages are resident, thus should be called off the
+  // latency critical path.
+  static void Prefetch(const void *addr, size_t len);
+
   constexpr char &operator[](size_t i) { return data_[i]; }
   constexpr char operator[](size_t i) const { return data_[i]; }
   constexpr char *begin() { return data_.begin(); }
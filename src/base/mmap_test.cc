@@ -41,8 +41,10 @@
 #include "absl/random/random.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/file/temp_dir.h"
 #include "base/file_util.h"
+#include "base/port.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 
@@ -149,6 +151,53 @@ TEST(MmapTest, MaybeMLockTest) {
   }
 }
 
+TEST(MmapTest, MapWithOptions) {
+  constexpr size_t kFileSize = 3 * 4096 + 123;
+  const std::vector<char> data = GetRandomContents(kFileSize);
+  const absl::StatusOr<TempFile> temp_file =
+      TempDirectory::Default().CreateTempFile();
+  ASSERT_OK(temp_file);
+  ASSERT_OK(FileUtil::SetContents(temp_file->path(),
+                                  absl::string_view(data.data(), data.size())));
+
+  for (const Mmap::Advice advice :
+       {Mmap::Advice::kNormal, Mmap::Advice::kRandom,
+        Mmap::Advice::kSequential, Mmap::Advice::kWillNeed,
+        Mmap::Advice::kHugePage}) {
+    for (const bool populate : {false, true}) {
+      const absl::StatusOr<Mmap> mmap =
+          Mmap::Map(temp_file->path(), 100, std::nullopt, Mmap::READ_ONLY,
+                    {.populate = populate, .advice = advice});
+      ASSERT_OK(mmap);
+      EXPECT_EQ(mmap->span(), absl::MakeConstSpan(data).subspan(100));
+    }
+  }
+}
+
+TEST(MmapTest, AdviseAndPrefetchUnalignedRange) {
+  constexpr size_t kFileSize = 5 * 4096;
+  const std::vector<char> data = GetRandomContents(kFileSize);
+  const absl::StatusOr<TempFile> temp_file =
+      TempDirectory::Default().CreateTempFile();
+  ASSERT_OK(temp_file);
+  ASSERT_OK(FileUtil::SetContents(temp_file->path(),
+                                  absl::string_view(data.data(), data.size())));
+
+  const absl::StatusOr<Mmap> mmap = Mmap::Map(temp_file->path());
+  ASSERT_OK(mmap);
+  const char *const ptr = mmap->data() + 1234;
+  constexpr size_t kLen = 2 * 4096 + 17;
+  if constexpr (!TargetIsWindows()) {
+    EXPECT_EQ(Mmap::MaybeAdvise(ptr, kLen, Mmap::Advice::kWillNeed), 0);
+    EXPECT_EQ(Mmap::MaybeAdvise(ptr, kLen, Mmap::Advice::kRandom), 0);
+  }
+  EXPECT_EQ(Mmap::MaybeAdvise(ptr, 0, Mmap::Advice::kWillNeed) == 0,
+            !TargetIsWindows());
+  Mmap::Prefetch(ptr, kLen);
+  Mmap::Prefetch(ptr, 0);
+  EXPECT_EQ(mmap->span(), data);
+}
+
 class MmapEntireFileTest : public ::testing::TestWithParam<size_t> {};
 
 TEST_P(MmapEntireFileTest, Read) {
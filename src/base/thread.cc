@@ -0,0 +1,170 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/thread.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+
+namespace mozc {
+namespace {
+
+// Upper bound of the workers in the default pool. Background tasks are mostly
+// I/O bound (loading and saving user data), so a few workers are enough.
+constexpr size_t kMaxDefaultThreads = 4;
+
+// At least two workers so that a long-running task (e.g. data loading) doesn't
+// hold up the others.
+constexpr size_t kMinDefaultThreads = 2;
+
+}  // namespace
+
+bool ThreadPool::Task::Cancel() {
+  absl::MutexLock lock(&mutex_);
+  if (state_ != State::kPending) {
+    return false;
+  }
+  state_ = State::kCancelled;
+  fn_ = nullptr;
+  return true;
+}
+
+void ThreadPool::Task::RunOrWait() {
+  if (TryRun()) {
+    return;
+  }
+  absl::MutexLock lock(
+      &mutex_, absl::Condition(
+                   +[](State *state) { return *state != State::kRunning; },
+                   &state_));
+}
+
+bool ThreadPool::Task::Done() const {
+  absl::MutexLock lock(&mutex_);
+  return state_ == State::kDone || state_ == State::kCancelled;
+}
+
+bool ThreadPool::Task::TryRun() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (state_ != State::kPending) {
+      return false;
+    }
+    state_ = State::kRunning;
+  }
+  std::move(fn_)();
+  fn_ = nullptr;
+  absl::MutexLock lock(&mutex_);
+  state_ = State::kDone;
+  return true;
+}
+
+ThreadPool::ThreadPool(size_t max_threads)
+    : max_threads_(std::max<size_t>(max_threads, 1)) {}
+
+ThreadPool::~ThreadPool() {
+  std::vector<Thread> workers;
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+    workers = std::move(workers_);
+  }
+  for (Thread &worker : workers) {
+    worker.Join();
+  }
+}
+
+std::shared_ptr<ThreadPool::Task> ThreadPool::Schedule(
+    absl::AnyInvocable<void() &&> fn, Priority priority) {
+  // `Task` has a private constructor, so `std::make_shared` is not available.
+  std::shared_ptr<Task> task(new Task(std::move(fn)));
+  absl::MutexLock lock(&mutex_);
+  queues_[static_cast<size_t>(priority)].push_back(task);
+  if (GetPendingTaskCountLocked() > idle_workers_ &&
+      workers_.size() < max_threads_) {
+    workers_.emplace_back([this] { WorkerMain(); });
+  }
+  return task;
+}
+
+size_t ThreadPool::GetPendingTaskCount() const {
+  absl::MutexLock lock(&mutex_);
+  return GetPendingTaskCountLocked();
+}
+
+size_t ThreadPool::GetPendingTaskCountLocked() const {
+  size_t count = 0;
+  for (const auto &queue : queues_) {
+    count += queue.size();
+  }
+  return count;
+}
+
+bool ThreadPool::HasTaskOrShutdown() const {
+  return shutdown_ || GetPendingTaskCountLocked() > 0;
+}
+
+ThreadPool &ThreadPool::Default() {
+  static ThreadPool *pool = new ThreadPool(std::clamp<size_t>(
+      std::thread::hardware_concurrency(), kMinDefaultThreads,
+      kMaxDefaultThreads));
+  return *pool;
+}
+
+void ThreadPool::WorkerMain() {
+  while (true) {
+    std::shared_ptr<Task> task;
+    {
+      absl::MutexLock lock(&mutex_);
+      ++idle_workers_;
+      mutex_.Await(absl::Condition(this, &ThreadPool::HasTaskOrShutdown));
+      --idle_workers_;
+      for (auto &queue : queues_) {
+        if (!queue.empty()) {
+          task = std::move(queue.front());
+          queue.pop_front();
+          break;
+        }
+      }
+      if (task == nullptr) {
+        // Shutting down and no remaining task.
+        return;
+      }
+    }
+    // The task may have been cancelled or taken by `RunOrWait()`.
+    task->TryRun();
+  }
+}
+
+}  // namespace mozc
@@ -30,12 +30,17 @@
 #ifndef MOZC_BASE_THREAD_H_
 #define MOZC_BASE_THREAD_H_
 
+#include <array>
+#include <cstddef>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/functional/bind_front.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
@@ -85,8 +90,106 @@ class Thread {
   std::thread thread_;
 };
 
-// Represents a value that will be available in the future. This class spawns
-// a dedicated background thread to execute the provider function.
+// A bounded pool of worker threads that executes background tasks.
+//
+// Tasks are picked up in priority order (FIFO within the same priority) by at
+// most `max_threads` workers. Workers are spawned lazily when there is no idle
+// one, and are kept until the pool is destroyed, so scheduling a task costs a
+// queue insertion instead of a thread creation.
+//
+// Most code should use `ThreadPool::Default()`, which is shared by the whole
+// process, via `BackgroundFuture`.
+class ThreadPool {
+ public:
+  enum class Priority {
+    kHigh,
+    kNormal,
+    kLow,
+  };
+
+  // Handle to a scheduled task, shared by the pool and the scheduler.
+  class Task {
+   public:
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    // Cancels the task unless it has already started. Returns true if the
+    // task is cancelled, in which case the function is never invoked.
+    bool Cancel() ABSL_LOCKS_EXCLUDED(mutex_);
+
+    // Invokes the function on the calling thread if no worker has picked it up
+    // yet, and otherwise blocks until the running invocation finishes. Waiting
+    // this way cannot deadlock even if all the workers are blocked by tasks
+    // waiting for each other. Returns immediately if the task is cancelled.
+    void RunOrWait() ABSL_LOCKS_EXCLUDED(mutex_);
+
+    // Returns true if the task has finished or has been cancelled.
+    bool Done() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+   private:
+    friend class ThreadPool;
+
+    enum class State {
+      kPending,
+      kRunning,
+      kDone,
+      kCancelled,
+    };
+
+    explicit Task(absl::AnyInvocable<void() &&> fn) : fn_(std::move(fn)) {}
+
+    // Runs the function if the task is still pending. Returns false if the
+    // task has been taken by another thread or cancelled.
+    bool TryRun() ABSL_LOCKS_EXCLUDED(mutex_);
+
+    mutable absl::Mutex mutex_;
+    State state_ ABSL_GUARDED_BY(mutex_) = State::kPending;
+    // Only accessed by the thread that moved `state_` to `kRunning`.
+    absl::AnyInvocable<void() &&> fn_;
+  };
+
+  explicit ThreadPool(size_t max_threads);
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Runs all the remaining tasks and joins the workers.
+  ~ThreadPool();
+
+  // Schedules `fn` to be run by a worker.
+  std::shared_ptr<Task> Schedule(absl::AnyInvocable<void() &&> fn,
+                                 Priority priority = Priority::kNormal)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of tasks that are waiting for a worker, including the
+  // ones cancelled or taken by `RunOrWait()` but not yet dequeued.
+  size_t GetPendingTaskCount() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  size_t max_threads() const { return max_threads_; }
+
+  // Returns the process-wide pool, which is never destroyed.
+  static ThreadPool &Default();
+
+ private:
+  static constexpr size_t kNumPriorities = 3;
+
+  void WorkerMain() ABSL_LOCKS_EXCLUDED(mutex_);
+  size_t GetPendingTaskCountLocked() const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasTaskOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t max_threads_;
+  mutable absl::Mutex mutex_;
+  std::array<std::deque<std::shared_ptr<Task>>, kNumPriorities> queues_
+      ABSL_GUARDED_BY(mutex_);
+  size_t idle_workers_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<Thread> workers_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Represents a value that will be available in the future. By default this
+// class spawns a dedicated background thread to execute the provider function.
+// If a `ThreadPool` is given, the function is scheduled on the pool instead.
 //
 // `R` must be a movable type if not `void`.
 //
@@ -100,6 +203,19 @@ class BackgroundFuture {
   template <class F, class... Args>
   explicit BackgroundFuture(F &&f, Args &&...args);
 
+  // Schedules `f(args...)` on `pool` with `priority`, and eventually fulfills
+  // the future. Waiting for the future runs the function on the waiting thread
+  // if no worker has started it yet.
+  template <class F, class... Args>
+  BackgroundFuture(ThreadPool &pool, ThreadPool::Priority priority, F &&f,
+                   Args &&...args);
+
+  // Same as above with `ThreadPool::Priority::kNormal`.
+  template <class F, class... Args>
+  BackgroundFuture(ThreadPool &pool, F &&f, Args &&...args)
+      : BackgroundFuture(pool, ThreadPool::Priority::kNormal,
+                         std::forward<F>(f), std::forward<Args>(args)...) {}
+
   BackgroundFuture(const BackgroundFuture &) = delete;
   BackgroundFuture &operator=(const BackgroundFuture &) = delete;
 
@@ -132,8 +248,14 @@ class BackgroundFuture {
     mutable absl::Mutex mutex;
     std::optional<R> value ABSL_GUARDED_BY(mutex);
   };
+
+  // Finishes the background work, either by joining the thread or by running
+  // or waiting for the pool task.
+  void Finish();
+
   std::unique_ptr<State> state_;
   Thread thread_;
+  std::shared_ptr<ThreadPool::Task> task_;
 };
 
 template <>
@@ -146,6 +268,19 @@ class BackgroundFuture<void> {
   template <class F, class... Args>
   explicit BackgroundFuture(F &&f, Args &&...args);
 
+  // Schedules `f(args...)` on `pool` with `priority`, and eventually fulfills
+  // the future. Waiting for the future runs the function on the waiting thread
+  // if no worker has started it yet.
+  template <class F, class... Args>
+  BackgroundFuture(ThreadPool &pool, ThreadPool::Priority priority, F &&f,
+                   Args &&...args);
+
+  // Same as above with `ThreadPool::Priority::kNormal`.
+  template <class F, class... Args>
+  BackgroundFuture(ThreadPool &pool, F &&f, Args &&...args)
+      : BackgroundFuture(pool, ThreadPool::Priority::kNormal,
+                         std::forward<F>(f), std::forward<Args>(args)...) {}
+
   BackgroundFuture(const BackgroundFuture &) = delete;
   BackgroundFuture &operator=(const BackgroundFuture &) = delete;
 
@@ -160,9 +295,17 @@ class BackgroundFuture<void> {
   // Blocks until the future becomes ready.
   void Wait() const;
 
+  // Cancels the function scheduled on a pool unless a thread has started it.
+  // The future of a cancelled function becomes ready without invoking it.
+  // Returns true if cancelled, and always false for a dedicated thread.
+  bool Cancel();
+
  private:
+  void Finish();
+
   std::unique_ptr<absl::Notification> done_;
   Thread thread_;
+  std::shared_ptr<ThreadPool::Task> task_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -182,25 +325,52 @@ BackgroundFuture<R>::BackgroundFuture(F &&f, Args &&...args)
         state.value = std::move(r);
       }) {}
 
+template <class R>
+template <class F, class... Args>
+BackgroundFuture<R>::BackgroundFuture(ThreadPool &pool,
+                                      ThreadPool::Priority priority, F &&f,
+                                      Args &&...args)
+    : state_(std::make_unique<State>()),
+      task_(pool.Schedule(
+          [&state = *state_,
+           f = absl::bind_front(std::forward<F>(f),
+                                std::forward<Args>(args)...)]() mutable {
+            R r = std::invoke(std::move(f));
+
+            absl::MutexLock lock(&state.mutex);
+            state.value = std::move(r);
+          },
+          priority)) {}
+
 template <class R>
 BackgroundFuture<R> &BackgroundFuture<R>::operator=(BackgroundFuture &&other) {
-  if (thread_.Joinable()) {
-    thread_.Join();
-  }
+  Finish();
   state_ = std::move(other.state_);
   thread_ = std::move(other.thread_);
+  task_ = std::move(other.task_);
   return *this;
 }
 
 template <class R>
 BackgroundFuture<R>::~BackgroundFuture() {
+  Finish();
+}
+
+template <class R>
+void BackgroundFuture<R>::Finish() {
   if (thread_.Joinable()) {
     thread_.Join();
   }
+  if (task_) {
+    task_->RunOrWait();
+  }
 }
 
 template <class R>
 const R &BackgroundFuture<R>::Get() const & {
+  if (task_) {
+    task_->RunOrWait();
+  }
   absl::MutexLock lock(
       &state_->mutex,
       absl::Condition(
@@ -210,6 +380,9 @@ const R &BackgroundFuture<R>::Get() const & {
 
 template <class R>
 R BackgroundFuture<R>::Get() && {
+  if (task_) {
+    task_->RunOrWait();
+  }
   absl::MutexLock lock(
       &state_->mutex,
       absl::Condition(
@@ -227,6 +400,9 @@ bool BackgroundFuture<R>::Ready() const noexcept {
 
 template <class R>
 void BackgroundFuture<R>::Wait() const {
+  if (task_) {
+    task_->RunOrWait();
+  }
   absl::MutexLock lock(
       &state_->mutex,
       absl::Condition(
@@ -243,23 +419,44 @@ BackgroundFuture<void>::BackgroundFuture(F &&f, Args &&...args)
         done.Notify();
       }) {}
 
+template <class F, class... Args>
+BackgroundFuture<void>::BackgroundFuture(ThreadPool &pool,
+                                         ThreadPool::Priority priority, F &&f,
+                                         Args &&...args)
+    : done_(std::make_unique<absl::Notification>()),
+      task_(pool.Schedule(
+          [&done = *done_,
+           f = absl::bind_front(std::forward<F>(f),
+                                std::forward<Args>(args)...)]() mutable {
+            std::invoke(std::move(f));
+            done.Notify();
+          },
+          priority)) {}
+
 inline BackgroundFuture<void> &BackgroundFuture<void>::operator=(
     BackgroundFuture &&other) {
-  if (thread_.Joinable()) {
-    thread_.Join();
-  }
+  Finish();
   done_ = std::move(other.done_);
   thread_ = std::move(other.thread_);
+  task_ = std::move(other.task_);
   return *this;
 }
 
-inline BackgroundFuture<void>::~BackgroundFuture() {
+inline BackgroundFuture<void>::~BackgroundFuture() { Finish(); }
+
+inline void BackgroundFuture<void>::Finish() {
   if (thread_.Joinable()) {
     thread_.Join();
   }
+  if (task_) {
+    task_->RunOrWait();
+  }
 }
 
 inline void BackgroundFuture<void>::Wait() const {
+  if (task_) {
+    task_->RunOrWait();
+  }
   done_->WaitForNotification();
 }
 
@@ -267,6 +464,14 @@ inline bool BackgroundFuture<void>::Ready() const noexcept {
   return done_->HasBeenNotified();
 }
 
+inline bool BackgroundFuture<void>::Cancel() {
+  if (!task_ || !task_->Cancel()) {
+    return false;
+  }
+  done_->Notify();
+  return true;
+}
+
 }  // namespace mozc
 
 #endif  // MOZC_BASE_THREAD_H_
@@ -33,10 +33,13 @@
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "testing/gmock.h"
 #include "testing/gunit.h"
 
 namespace mozc {
@@ -195,5 +198,137 @@ TEST(BackgroundFutureTest, AssigningToPendingFutureDoesNotCrash) {
   g = BackgroundFuture<void>([] {});
 }
 
+TEST(ThreadPoolTest, RunsAllScheduledTasks) {
+  std::atomic<int> counter = 0;
+  {
+    ThreadPool pool(2);
+    for (int i = 1; i <= 100; ++i) {
+      pool.Schedule([&counter, i] { counter.fetch_add(i); });
+    }
+  }
+  EXPECT_EQ(counter.load(), 5050);
+}
+
+TEST(ThreadPoolTest, RunsHigherPriorityFirst) {
+  absl::Mutex mutex;
+  std::vector<int> order;
+  auto push = [&mutex, &order](int i) {
+    absl::MutexLock lock(&mutex);
+    order.push_back(i);
+  };
+  {
+    ThreadPool pool(1);
+    absl::Notification blocker;
+    pool.Schedule([&blocker] { blocker.WaitForNotification(); });
+    pool.Schedule([&push] { push(3); }, ThreadPool::Priority::kLow);
+    pool.Schedule([&push] { push(2); });
+    pool.Schedule([&push] { push(1); }, ThreadPool::Priority::kHigh);
+    blocker.Notify();
+  }
+  EXPECT_THAT(order, ::testing::ElementsAre(1, 2, 3));
+}
+
+TEST(ThreadPoolTest, CancelsPendingTask) {
+  ThreadPool pool(1);
+  absl::Notification started, blocker;
+  std::atomic<bool> called = false;
+
+  auto first = pool.Schedule([&started, &blocker] {
+    started.Notify();
+    blocker.WaitForNotification();
+  });
+  auto second = pool.Schedule([&called] { called = true; });
+  started.WaitForNotification();
+  EXPECT_TRUE(second->Cancel());
+  EXPECT_TRUE(second->Done());
+  EXPECT_FALSE(first->Cancel());
+
+  blocker.Notify();
+  first->RunOrWait();
+  second->RunOrWait();
+  EXPECT_TRUE(first->Done());
+  EXPECT_FALSE(called.load());
+}
+
+TEST(ThreadPoolTest, RunOrWaitRunsPendingTaskInline) {
+  ThreadPool pool(1);
+  absl::Notification blocker;
+
+  pool.Schedule([&blocker] { blocker.WaitForNotification(); });
+  // The only worker is blocked, so this task must be run by `RunOrWait()`.
+  auto task = pool.Schedule([&blocker] { blocker.Notify(); });
+  task->RunOrWait();
+  EXPECT_TRUE(task->Done());
+  EXPECT_TRUE(blocker.HasBeenNotified());
+}
+
+TEST(BackgroundFutureTest, RunsOnThreadPool) {
+  ThreadPool pool(2);
+  auto future = BackgroundFuture<int>(pool, [] {
+    absl::SleepFor(absl::Milliseconds(100));
+    return 42;
+  });
+  EXPECT_EQ(future.Get(), 42);
+
+  std::atomic<int> counter = 0;
+  {
+    BackgroundFuture<void> f1(pool, ThreadPool::Priority::kLow,
+                              [&counter](int x) { counter.fetch_add(x); }, 1);
+    BackgroundFuture<void> f2(pool, [&counter] { counter.fetch_add(2); });
+    f2.Wait();
+    EXPECT_TRUE(f2.Ready());
+  }
+  EXPECT_EQ(counter.load(), 3);
+}
+
+TEST(BackgroundFutureTest, CancelsPendingFunctionOnThreadPool) {
+  ThreadPool pool(1);
+  absl::Notification started, blocker;
+  std::atomic<bool> called = false;
+
+  BackgroundFuture<void> running(pool, [&started, &blocker] {
+    started.Notify();
+    blocker.WaitForNotification();
+  });
+  BackgroundFuture<void> pending(pool, [&called] { called = true; });
+  started.WaitForNotification();
+  // Waiting for a cancelled future doesn't run the function.
+  EXPECT_TRUE(pending.Cancel());
+  EXPECT_TRUE(pending.Ready());
+  pending.Wait();
+  EXPECT_FALSE(called.load());
+
+  EXPECT_FALSE(running.Cancel());
+  blocker.Notify();
+  running.Wait();
+
+  BackgroundFuture<void> thread([] {});
+  EXPECT_FALSE(thread.Cancel());
+}
+
+TEST(BackgroundFutureTest, NestedWaitOnThreadPoolDoesNotDeadlock) {
+  ThreadPool pool(1);
+  auto outer = BackgroundFuture<int>(pool, [&pool] {
+    auto inner = BackgroundFuture<int>(pool, [] { return 21; });
+    return inner.Get() * 2;
+  });
+  EXPECT_EQ(std::move(outer).Get(), 42);
+}
+
+TEST(BackgroundFutureTest, CopiesThingsAtMostOnceOnThreadPool) {
+  ThreadPool pool(1);
+  CopyCounter counter1;
+  CopyCounter counter2;
+  std::shared_ptr<std::atomic<int>> c2 = counter2.get();
+
+  BackgroundFuture<int>(
+      pool, [](CopyCounter, CopyCounter) { return 42; }, counter1,
+      std::move(counter2))
+      .Wait();
+
+  EXPECT_EQ(counter1.count(), 1);
+  EXPECT_EQ(c2->load(), 0);
+}
+
 }  // namespace
 }  // namespace mozc
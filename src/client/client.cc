@@ -37,6 +37,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -45,15 +46,18 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "base/clock.h"
 #include "base/const.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
 #include "base/process.h"
 #include "base/singleton.h"
 #include "base/system_util.h"
+#include "base/util.h"
 #include "base/version.h"
 #include "base/vlog.h"
 #include "client/client_interface.h"
+#include "composer/key_event_util.h"
 #include "config/config_handler.h"
 #include "ipc/ipc.h"
 #include "protocol/commands.pb.h"
@@ -95,24 +99,69 @@ constexpr absl::Duration kDefaultTimeout = absl::Seconds(30);  // 30 sec for opt
 // called from Destructor. When an application calls DeleteSession
 // explicitly, the default timeout is used.
 constexpr absl::Duration kDeleteSessionOnDestructorTimeout = absl::Seconds(1);
+
+// Unbound keys are skipped only for this period after the last echo-back.
+constexpr absl::Duration kEchoBackValidity = absl::Seconds(10);
+
+// Keeps the last characters of the preceding text and the first characters of
+// the following text within |limit|.
+void TruncateSurroundingText(
+    const commands::Output::SurroundingTextLimit &limit,
+    commands::Context *context) {
+  if (limit.has_max_preceding_length() && context->has_preceding_text()) {
+    const absl::string_view text = context->preceding_text();
+    const size_t length = Util::CharsLen(text);
+    if (length > limit.max_preceding_length()) {
+      std::string truncated(
+          Util::Utf8SubString(text, length - limit.max_preceding_length()));
+      context->set_preceding_text(std::move(truncated));
+    }
+  }
+  if (limit.has_max_following_length() && context->has_following_text()) {
+    const absl::string_view text = context->following_text();
+    if (Util::CharsLen(text) > limit.max_following_length()) {
+      std::string truncated(
+          Util::Utf8SubString(text, 0, limit.max_following_length()));
+      context->set_following_text(std::move(truncated));
+    }
+  }
+}
+
+bool IsSameSurroundingText(const commands::Context &lhs,
+                           const commands::Context &rhs) {
+  return lhs.has_preceding_text() == rhs.has_preceding_text() &&
+         lhs.has_following_text() == rhs.has_following_text() &&
+         lhs.preceding_text() == rhs.preceding_text() &&
+         lhs.following_text() == rhs.following_text();
+}
 }  // namespace
 
-Client::Client()
+ClientConnection::ClientConnection() {
+  response_.reserve(kResultBufferSize);
+
+  // Initialize direct_mode_keys_
+  config::Config config;
+  config::ConfigHandler::GetConfig(&config);
+  direct_mode_keys_ = KeyInfoUtil::ExtractSortedDirectModeKeys(config);
+}
+
+Client::Client() : Client(std::make_shared<ClientConnection>()) {}
+
+Client::Client(std::shared_ptr<ClientConnection> connection)
     : id_(0),
       server_launcher_(new ServerLauncher),
+      connection_(std::move(connection)),
       timeout_(kDefaultTimeout),
       server_status_(SERVER_UNKNOWN),
       server_protocol_version_(0),
       server_process_id_(0),
-      last_mode_(commands::DIRECT) {
-  response_.reserve(kResultBufferSize);
+      last_mode_(commands::DIRECT),
+      has_last_surrounding_text_(false),
+      has_echo_back_output_(false),
+      has_session_snapshot_(false) {
+  DCHECK(connection_);
   client_factory_ = IPCClientFactory::GetIPCClientFactory();
 
-  // Initialize direct_mode_keys_
-  config::Config config;
-  config::ConfigHandler::GetConfig(&config);
-  direct_mode_keys_ = KeyInfoUtil::ExtractSortedDirectModeKeys(config);
-
 #ifdef MOZC_USE_SVS_JAPANESE
   InitRequestForSvsJapanese(true);
 #endif  // MOZC_USE_SVS_JAPANESE
@@ -259,6 +308,23 @@ void Client::PlaybackHistory() {
   }
 }
 
+void Client::RestoreSession() {
+  if (has_session_snapshot_) {
+    commands::Input input;
+    InitInput(&input);
+    input.set_type(commands::Input::SEND_COMMAND);
+    input.mutable_command()->set_type(
+        commands::SessionCommand::RESTORE_SESSION_SNAPSHOT);
+    *input.mutable_command()->mutable_session_snapshot() = session_snapshot_;
+    commands::Output output;
+    if (Call(input, &output) && output.consumed()) {
+      return;
+    }
+    LOG(WARNING) << "Cannot restore the session snapshot";
+  }
+  PlaybackHistory();
+}
+
 void Client::PushHistory(const commands::Input &input,
                          const commands::Output &output) {
   if (!output.has_consumed() || !output.consumed()) {
@@ -318,6 +384,9 @@ void Client::GetHistoryInputs(std::vector<commands::Input> *result) const {
 bool Client::SendKeyWithContext(const commands::KeyEvent &key,
                                 const commands::Context &context,
                                 commands::Output *output) {
+  if (MaybeSkipKey(key, output)) {
+    return true;
+  }
   commands::Input input;
   input.set_type(commands::Input::SEND_KEY);
   *input.mutable_key() = key;
@@ -331,6 +400,9 @@ bool Client::SendKeyWithContext(const commands::KeyEvent &key,
 bool Client::TestSendKeyWithContext(const commands::KeyEvent &key,
                                     const commands::Context &context,
                                     commands::Output *output) {
+  if (MaybeSkipKey(key, output)) {
+    return true;
+  }
   commands::Input input;
   input.set_type(commands::Input::TEST_SEND_KEY);
   // If the pointer of |context| is not the default_instance, update the data.
@@ -354,6 +426,118 @@ bool Client::SendCommandWithContext(const commands::SessionCommand &command,
   return EnsureCallCommand(&input, output);
 }
 
+bool Client::CallWithSurroundingText(commands::Input *input,
+                                     commands::Output *output) {
+  // Servers that do not advertise the limit do not understand
+  // surrounding_text_unchanged either.
+  if (!input->has_context() ||
+      !surrounding_text_limit_.has_max_preceding_length()) {
+    return CallAndCheckVersion(*input, output);
+  }
+
+  commands::Context *context = input->mutable_context();
+  TruncateSurroundingText(surrounding_text_limit_, context);
+  if (!has_last_surrounding_text_ ||
+      !IsSameSurroundingText(*context, last_surrounding_text_)) {
+    has_last_surrounding_text_ = false;
+    if (!CallAndCheckVersion(*input, output)) {
+      return false;
+    }
+    last_surrounding_text_.Clear();
+    if (context->has_preceding_text()) {
+      last_surrounding_text_.set_preceding_text(context->preceding_text());
+    }
+    if (context->has_following_text()) {
+      last_surrounding_text_.set_following_text(context->following_text());
+    }
+    has_last_surrounding_text_ = true;
+    return true;
+  }
+
+  context->clear_preceding_text();
+  context->clear_following_text();
+  context->set_surrounding_text_unchanged(true);
+  const bool result = CallAndCheckVersion(*input, output);
+
+  // Restores the text so that the history playback on a new session sends
+  // the full context.
+  context->clear_surrounding_text_unchanged();
+  if (last_surrounding_text_.has_preceding_text()) {
+    context->set_preceding_text(last_surrounding_text_.preceding_text());
+  }
+  if (last_surrounding_text_.has_following_text()) {
+    context->set_following_text(last_surrounding_text_.following_text());
+  }
+  if (!result) {
+    has_last_surrounding_text_ = false;
+  }
+  return result;
+}
+
+bool Client::IsUnboundKey(const commands::KeyEvent &key) const {
+  if (connection_->key_filter_version_ == 0) {
+    return false;
+  }
+  // The server rewrites these keys before looking up the keymap.
+  if (key.has_key_string() || KeyEventUtil::IsNumpadKey(key)) {
+    return false;
+  }
+  // Turns off the IME regardless of the keymap.
+  if (key.has_activated() && !key.activated()) {
+    return false;
+  }
+  return !KeyInfoUtil::ContainsKeyOrStub(connection_->key_filter_keys_, key);
+}
+
+bool Client::MaybeSkipKey(const commands::KeyEvent &key,
+                          commands::Output *output) const {
+  // Echoing back an unbound key only resets the converter and clears the undo
+  // context, which has already been done for the last key.
+  if (!has_echo_back_output_ || server_status_ != SERVER_OK ||
+      !IsUnboundKey(key)) {
+    return false;
+  }
+  // Sends a key now and then so that the server refreshes the last command
+  // time of the session and the key filter, which can be changed by a reload
+  // or by the config updated from another process.
+  if (Clock::GetAbslTime() - echo_back_time_ >= kEchoBackValidity) {
+    return false;
+  }
+  *output = echo_back_output_;
+  *output->mutable_key() = key;
+  return true;
+}
+
+void Client::UpdateKeyFilter(const commands::Input &input,
+                             const commands::Output &output) {
+  if (output.has_key_filter()) {
+    const commands::KeyFilter &key_filter = output.key_filter();
+    connection_->key_filter_version_ = key_filter.version();
+    connection_->key_filter_keys_.assign(
+        key_filter.precomposition_keys().begin(),
+        key_filter.precomposition_keys().end());
+  }
+
+  if (input.type() == commands::Input::TEST_SEND_KEY) {
+    // TEST_SEND_KEY doesn't change the session state.
+    return;
+  }
+  // A pure modifier key doesn't clear the undo context, so it is not
+  // remembered as an echo-back.
+  const commands::KeyEvent &key = input.key();
+  has_echo_back_output_ =
+      input.type() == commands::Input::SEND_KEY &&
+      (key.has_key_code() || key.has_special_key()) && IsUnboundKey(key) &&
+      !output.consumed() && !output.has_result() && !output.has_preedit() &&
+      !output.has_candidates() && !output.has_callback() &&
+      output.status().activated();
+  if (has_echo_back_output_) {
+    echo_back_output_ = output;
+    echo_back_output_.clear_key_filter();
+    echo_back_time_ = Clock::GetAbslTime();
+  }
+}
+
 bool Client::CheckVersionOrRestartServer() {
   commands::Input input;
   commands::Output output;
@@ -377,9 +561,10 @@ bool Client::EnsureCallCommand(commands::Input *input,
   }
 
   InitInput(input);
+  input->set_key_filter_version(connection_->key_filter_version_);
   output->set_id(0);
 
-  if (!CallAndCheckVersion(*input, output)) {  // server is not running
+  if (!CallWithSurroundingText(input, output)) {  // server is not running
     LOG(ERROR) << "Call command failed";
   } else if (output->id() != input->id()) {  // invalid ID
     LOG(ERROR) << "Session id is void. re-issue session id";
@@ -394,16 +579,17 @@ bool Client::EnsureCallCommand(commands::Input *input,
   if (server_status_ == SERVER_SHUTDOWN ||
       server_status_ == SERVER_INVALID_SESSION) {
     if (EnsureSession()) {
-      // playback the history to restore the previous state.
-      PlaybackHistory();
+      // restore the previous state.
+      RestoreSession();
       InitInput(input);
+      input->set_key_filter_version(connection_->key_filter_version_);
 #ifdef DEBUG
       // The debug binary dumps query of death at the first trial.
       history_inputs_.push_back(*input);
       DumpQueryOfDeath();
 #endif  // DEBUG
       // second trial
-      if (!CallAndCheckVersion(*input, output)) {
+      if (!CallWithSurroundingText(input, output)) {
 #ifndef DEBUG
         // if second trial failed, record the input
         history_inputs_.push_back(*input);
@@ -421,6 +607,12 @@ bool Client::EnsureCallCommand(commands::Input *input,
     }
   }
 
+  UpdateKeyFilter(*input, *output);
+  if (output->has_session_snapshot()) {
+    session_snapshot_.Swap(output->mutable_session_snapshot());
+    output->clear_session_snapshot();
+    has_session_snapshot_ = true;
+  }
   PushHistory(*input, *output);
   return true;
 }
@@ -452,10 +644,15 @@ void Client::set_client_capability(const commands::Capability &capability) {
 
 bool Client::CreateSession() {
   id_ = 0;
+  surrounding_text_limit_.Clear();
+  has_last_surrounding_text_ = false;
+  has_echo_back_output_ = false;
   commands::Input input;
   input.set_type(commands::Input::CREATE_SESSION);
 
   *input.mutable_capability() = client_capability_;
+  // The snapshot is used to restore the session after a server restart.
+  input.mutable_capability()->set_session_snapshot(true);
 
   commands::ApplicationInfo *info = input.mutable_application_info();
   DCHECK(info);
@@ -481,6 +678,9 @@ bool Client::CreateSession() {
   }
 
   id_ = output.id();
+  if (output.has_surrounding_text_limit()) {
+    surrounding_text_limit_ = output.surrounding_text_limit();
+  }
   return true;
 }
 
@@ -500,11 +700,13 @@ bool Client::DeleteSession() {
     return false;
   }
   id_ = 0;
+  has_echo_back_output_ = false;
+  has_session_snapshot_ = false;
   return true;
 }
 
 bool Client::IsDirectModeCommand(const commands::KeyEvent &key) const {
-  return KeyInfoUtil::ContainsKey(direct_mode_keys_, key);
+  return KeyInfoUtil::ContainsKey(connection_->direct_mode_keys_, key);
 }
 
 bool Client::GetConfig(config::Config *config) {
@@ -537,7 +739,10 @@ bool Client::SetConfig(const config::Config &config) {
     return false;
   }
 
-  direct_mode_keys_ = KeyInfoUtil::ExtractSortedDirectModeKeys(config);
+  connection_->direct_mode_keys_ =
+      KeyInfoUtil::ExtractSortedDirectModeKeys(config);
+  // The keymap may have been changed.
+  has_echo_back_output_ = false;
   return true;
 }
 
@@ -564,7 +769,11 @@ bool Client::Shutdown() {
 
 bool Client::SyncData() { return CallCommand(commands::Input::SYNC_DATA); }
 
-bool Client::Reload() { return CallCommand(commands::Input::RELOAD); }
+bool Client::Reload() {
+  // The reloaded config may change the keymap.
+  has_echo_back_output_ = false;
+  return CallCommand(commands::Input::RELOAD);
+}
 
 bool Client::Cleanup() { return CallCommand(commands::Input::CLEANUP); }
 
@@ -691,7 +900,7 @@ bool Client::Call(const commands::Input &input, commands::Output *output) {
     return false;
   }
 
-  if (!client->Call(request, &response_, timeout_)) {
+  if (!client->Call(request, &connection_->response_, timeout_)) {
     LOG(ERROR) << "Call failure" << input.DebugString();
     if (client->GetLastIPCError() == IPC_TIMEOUT_ERROR) {
       server_status_ = SERVER_TIMEOUT;
@@ -702,7 +911,7 @@ bool Client::Call(const commands::Input &input, commands::Output *output) {
     return false;
   }
 
-  if (!output->ParseFromString(response_)) {
+  if (!output->ParseFromString(connection_->response_)) {
     LOG(ERROR) << "Parse failure of the result of the request:"
                << input.DebugString();
     server_status_ = SERVER_BROKEN_MESSAGE;
@@ -816,6 +1025,7 @@ bool Client::CheckVersionOrRestartServerInternal(const commands::Input &input,
 }
 
 void Client::Reset() {
+  has_echo_back_output_ = false;
   server_status_ = SERVER_UNKNOWN;
   server_protocol_version_ = 0;
   server_process_id_ = 0;
@@ -949,6 +1159,15 @@ std::unique_ptr<ClientInterface> ClientFactory::NewClient() {
   }
 }
 
+std::unique_ptr<ClientInterface> ClientFactory::NewClient(
+    std::shared_ptr<ClientConnection> connection) {
+  if (g_client_factory == nullptr) {
+    return std::make_unique<Client>(std::move(connection));
+  } else {
+    return g_client_factory->NewClient();
+  }
+}
+
 void ClientFactory::SetClientFactory(ClientFactoryInterface *client_factory) {
   g_client_factory = client_factory;
 }
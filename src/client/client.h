@@ -90,9 +90,33 @@ class ServerLauncher : public ServerLauncherInterface {
   bool suppress_error_dialog_;
 };
 
+// Data of the connection to the server which doesn't depend on sessions.
+// Clients created with the same ClientConnection share it instead of holding
+// their own copies, e.g. the clients for the input contexts of a frontend.
+// Not thread-safe; the clients sharing it must be used on the same thread.
+class ClientConnection {
+ public:
+  ClientConnection();
+  ClientConnection(const ClientConnection &) = delete;
+  ClientConnection &operator=(const ClientConnection &) = delete;
+
+ private:
+  friend class Client;
+
+  // Buffer for IPC responses.
+  std::string response_;
+  // List of key combinations used in the direct input mode.
+  std::vector<KeyInformation> direct_mode_keys_;
+  // Sorted precomposition keys exported by the server and their version (see
+  // commands::KeyFilter). The version is zero until the server sends one.
+  std::vector<KeyInformation> key_filter_keys_;
+  uint64_t key_filter_version_ = 0;
+};
+
 class Client : public ClientInterface {
  public:
   Client();
+  explicit Client(std::shared_ptr<ClientConnection> connection);
   ~Client() override;
 
   // Initializes `request_` with the flag.
@@ -156,6 +180,10 @@ class Client : public ClientInterface {
   void set_server_program(absl::string_view program_path) override;
   void set_suppress_error_dialog(bool suppress) override;
   void set_client_capability(const commands::Capability &capability) override;
+  commands::Output::SurroundingTextLimit surrounding_text_limit()
+      const override {
+    return surrounding_text_limit_;
+  }
 
   bool LaunchTool(const std::string &mode, absl::string_view arg) override;
   bool LaunchToolWithProtoBuf(const commands::Output &output) override;
@@ -174,6 +202,7 @@ class Client : public ClientInterface {
   FRIEND_TEST(SessionPlaybackTest, PlaybackHistoryTest);
   FRIEND_TEST(SessionPlaybackTest, SetModeInitializerTest);
   FRIEND_TEST(SessionPlaybackTest, ConsumedTest);
+  FRIEND_TEST(SessionPlaybackTest, SessionSnapshotTest);
 
   enum ServerStatus {
     SERVER_UNKNOWN,           // initial status
@@ -227,9 +256,35 @@ class Client : public ClientInterface {
   bool CallAndCheckVersion(const commands::Input &input,
                            commands::Output *output);
 
+  // Invokes CallAndCheckVersion() after truncating the surrounding text in
+  // |input| to |surrounding_text_limit_|. The surrounding text is replaced
+  // with Context::surrounding_text_unchanged when it is the same as the last
+  // one; |input| holds the full text again when this method returns.
+  bool CallWithSurroundingText(commands::Input *input,
+                               commands::Output *output);
+
+  // Returns true if |key| is not bound in the precomposition keymap of the
+  // server, i.e. the session echoes it back without looking at it.
+  bool IsUnboundKey(const commands::KeyEvent &key) const;
+
+  // Fills |output| with the echo-back of |key| and returns true if the session
+  // is known to echo back |key| without any side effect, so that the key
+  // doesn't need to be sent.
+  bool MaybeSkipKey(const commands::KeyEvent &key,
+                    commands::Output *output) const;
+
+  // Updates the key filter and the last echo-back with the result of |input|.
+  void UpdateKeyFilter(const commands::Input &input,
+                       const commands::Output &output);
+
   // Making a journal inputs to restore
   // the current state even when mozc_server crashes
   void PlaybackHistory();
+  // Restores the previous session on the new session from
+  // |session_snapshot_|, or by PlaybackHistory() if it is not available. The
+  // snapshot restores only the IME state and the composition, so a conversion
+  // in progress is back to the composition.
+  void RestoreSession();
   void PushHistory(const commands::Input &input,
                    const commands::Output &output);
   void ResetHistory();
@@ -256,18 +311,34 @@ class Client : public ClientInterface {
   std::unique_ptr<ServerLauncherInterface> server_launcher_;
   std::unique_ptr<config::Config> preferences_;
   std::unique_ptr<commands::Request> request_;
-  std::string response_;
+  std::shared_ptr<ClientConnection> connection_;
   absl::Duration timeout_;
   ServerStatus server_status_;
   uint32_t server_protocol_version_;
   uint32_t server_process_id_;
   std::string server_product_version_;
   std::vector<commands::Input> history_inputs_;
-  // List of key combinations used in the direct input mode.
-  std::vector<KeyInformation> direct_mode_keys_;
   // Remember the composition mode of input session for playback.
   commands::CompositionMode last_mode_;
   commands::Capability client_capability_;
+  // Surrounding text limit advertised by the server on CREATE_SESSION.
+  commands::Output::SurroundingTextLimit surrounding_text_limit_;
+  // Surrounding text the server has seen last in the current session. Valid
+  // only when |has_last_surrounding_text_| is true.
+  commands::Context last_surrounding_text_;
+  bool has_last_surrounding_text_;
+  // Output of the last SEND_KEY if the session echoed back an unbound key in
+  // the precomposition state. Valid only when |has_echo_back_output_| is
+  // true.
+  commands::Output echo_back_output_;
+  bool has_echo_back_output_;
+  // Time when |echo_back_output_| was received.
+  absl::Time echo_back_time_;
+  // Latest snapshot of the current session returned by the server, which
+  // returns it only when it changes. Valid only when |has_session_snapshot_|
+  // is true.
+  commands::SessionSnapshot session_snapshot_;
+  bool has_session_snapshot_;
 };
 
 class ClientFactory {
@@ -278,6 +349,11 @@ class ClientFactory {
   // Return a new client.
   static std::unique_ptr<ClientInterface> NewClient();
 
+  // Returns a new client sharing |connection| with other clients. The
+  // connection is ignored when a ClientFactoryInterface is set.
+  static std::unique_ptr<ClientInterface> NewClient(
+      std::shared_ptr<ClientConnection> connection);
+
   // Set a ClientFactoryInterface for unit testing.
   static void SetClientFactory(ClientFactoryInterface *client_factory);
 };
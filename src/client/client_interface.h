@@ -210,6 +210,11 @@ class ClientInterface {
   virtual void set_client_capability(
       const commands::Capability &capability) = 0;
 
+  // Returns the length of the surrounding text the server consumes. The limit
+  // is known once a session is created; all fields are unset before that.
+  virtual commands::Output::SurroundingTextLimit surrounding_text_limit()
+      const = 0;
+
   // Launches mozc tool. |mode| is the mode of MozcTool,
   // e,g,. "config_dialog", "dictionary_tool".
   virtual bool LaunchTool(const std::string &mode,
@@ -90,6 +90,8 @@ class ClientMock : public client::ClientInterface {
   MOCK_METHOD(void, set_suppress_error_dialog, (bool suppress), (override));
   MOCK_METHOD(void, set_client_capability,
               (const commands::Capability &capability), (override));
+  MOCK_METHOD(commands::Output::SurroundingTextLimit, surrounding_text_limit,
+              (), (const, override));
   MOCK_METHOD(bool, LaunchTool,
               (const std::string &mode, absl::string_view extra_arg),
               (override));
@@ -41,10 +41,13 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "base/clock_mock.h"
 #include "base/number_util.h"
 #include "base/strings/assign.h"
 #include "base/version.h"
 #include "client/client_interface.h"
+#include "composer/key_event_util.h"
 #include "composer/key_parser.h"
 #include "config/config_handler.h"
 #include "ipc/ipc.h"
@@ -302,6 +305,188 @@ TEST_F(ClientTest, SendKeyWithContext) {
   EXPECT_EQ(input.context().suppress_suggestion(), kSuppressSuggestion);
 }
 
+TEST_F(ClientTest, SendKeyWithBoundedContext) {
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  // The same response is returned for CREATE_SESSION and SEND_KEY.
+  commands::Output mock_output;
+  mock_output.set_id(mock_id);
+  mock_output.set_consumed(true);
+  mock_output.mutable_surrounding_text_limit()->set_max_preceding_length(3);
+  mock_output.mutable_surrounding_text_limit()->set_max_following_length(2);
+  SetMockOutput(mock_output);
+
+  commands::KeyEvent key_event;
+  key_event.set_key_code('a');
+  commands::Context context;
+  context.set_preceding_text("あいうえお");
+  context.set_following_text("かきく");
+
+  commands::Output output;
+  commands::Input input;
+  EXPECT_TRUE(client_->SendKeyWithContext(key_event, context, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.type(), commands::Input::SEND_KEY);
+  EXPECT_EQ(input.context().preceding_text(), "うえお");
+  EXPECT_EQ(input.context().following_text(), "かき");
+  EXPECT_FALSE(input.context().surrounding_text_unchanged());
+
+  // The truncated text is the same as the last one.
+  context.set_preceding_text("えあうえお");
+  EXPECT_TRUE(client_->SendKeyWithContext(key_event, context, &output));
+  GetGeneratedInput(&input);
+  EXPECT_FALSE(input.context().has_preceding_text());
+  EXPECT_FALSE(input.context().has_following_text());
+  EXPECT_TRUE(input.context().surrounding_text_unchanged());
+
+  context.set_following_text("");
+  EXPECT_TRUE(client_->SendKeyWithContext(key_event, context, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.context().preceding_text(), "うえお");
+  EXPECT_TRUE(input.context().has_following_text());
+  EXPECT_EQ(input.context().following_text(), "");
+  EXPECT_FALSE(input.context().surrounding_text_unchanged());
+}
+
+TEST_F(ClientTest, SkipUnboundKeys) {
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  commands::KeyEvent bound_key;
+  bound_key.set_key_code('a');
+  KeyInformation bound_key_info;
+  ASSERT_TRUE(KeyEventUtil::GetKeyInformation(bound_key, &bound_key_info));
+
+  commands::Output echo_back_output;
+  echo_back_output.set_id(mock_id);
+  echo_back_output.set_consumed(false);
+  echo_back_output.mutable_status()->set_activated(true);
+  echo_back_output.mutable_key_filter()->set_version(10);
+  echo_back_output.mutable_key_filter()->add_precomposition_keys(
+      bound_key_info);
+  SetMockOutput(echo_back_output);
+
+  commands::KeyEvent enter_key;
+  enter_key.set_special_key(commands::KeyEvent::ENTER);
+  commands::KeyEvent escape_key;
+  escape_key.set_special_key(commands::KeyEvent::ESCAPE);
+
+  // The key filter is not known yet.
+  commands::Output output;
+  commands::Input input;
+  EXPECT_TRUE(client_->SendKey(enter_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key().special_key(), commands::KeyEvent::ENTER);
+  EXPECT_EQ(input.key_filter_version(), 0);
+  EXPECT_FALSE(output.consumed());
+
+  commands::Output consumed_output;
+  consumed_output.set_id(mock_id);
+  consumed_output.set_consumed(true);
+  SetMockOutput(consumed_output);
+
+  // The session has echoed back an unbound key, so the next unbound key is
+  // not sent.
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  EXPECT_FALSE(output.consumed());
+  EXPECT_TRUE(output.status().activated());
+  EXPECT_EQ(output.key().special_key(), commands::KeyEvent::ESCAPE);
+  EXPECT_FALSE(output.has_key_filter());
+  EXPECT_TRUE(client_->TestSendKey(escape_key, &output));
+  EXPECT_FALSE(output.consumed());
+
+  // Bound keys are always sent.
+  EXPECT_TRUE(client_->SendKey(bound_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key().key_code(), 'a');
+  EXPECT_EQ(input.key_filter_version(), 10);
+  EXPECT_TRUE(output.consumed());
+
+  // The last key was consumed.
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key().special_key(), commands::KeyEvent::ESCAPE);
+  EXPECT_TRUE(output.consumed());
+}
+
+TEST_F(ClientTest, SkipUnboundKeysExpires) {
+  ScopedClockMock clock(absl::UnixEpoch() + absl::Hours(24));
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  commands::Output echo_back_output;
+  echo_back_output.set_id(mock_id);
+  echo_back_output.set_consumed(false);
+  echo_back_output.mutable_status()->set_activated(true);
+  echo_back_output.mutable_key_filter()->set_version(10);
+  SetMockOutput(echo_back_output);
+
+  commands::KeyEvent escape_key;
+  escape_key.set_special_key(commands::KeyEvent::ESCAPE);
+  commands::Output output;
+  commands::Input input;
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key_filter_version(), 0);
+
+  // The echo-back is used within the validity period.
+  clock->Advance(absl::Seconds(5));
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key_filter_version(), 0);
+
+  // The key is sent again to keep the session alive and to refresh the key
+  // filter.
+  clock->Advance(absl::Seconds(5));
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key_filter_version(), 10);
+
+  // Reload invalidates the echo-back.
+  EXPECT_TRUE(client_->Reload());
+  EXPECT_TRUE(client_->SendKey(escape_key, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.type(), commands::Input::SEND_KEY);
+}
+
+TEST_F(ClientTest, SharedConnection) {
+  const int mock_id = 123;
+  auto connection = std::make_shared<ClientConnection>();
+  client_ = std::make_unique<Client>(connection);
+  client_->SetIPCClientFactory(client_factory_.get());
+  auto server_launcher =
+      std::make_unique<TestServerLauncher>(client_factory_.get());
+  server_launcher_ = server_launcher.get();
+  client_->SetServerLauncher(std::move(server_launcher));
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  Client other_client(connection);
+  other_client.SetIPCClientFactory(client_factory_.get());
+  auto other_server_launcher =
+      std::make_unique<TestServerLauncher>(client_factory_.get());
+  other_server_launcher->set_start_server_result(true);
+  other_client.SetServerLauncher(std::move(other_server_launcher));
+
+  commands::Output mock_output;
+  mock_output.set_id(mock_id);
+  mock_output.set_consumed(true);
+  mock_output.mutable_key_filter()->set_version(10);
+  SetMockOutput(mock_output);
+
+  commands::KeyEvent key_event;
+  key_event.set_key_code('a');
+  commands::Output output;
+  EXPECT_TRUE(client_->SendKey(key_event, &output));
+
+  // The key filter received by one client is used by the other.
+  commands::Input input;
+  EXPECT_TRUE(other_client.SendKey(key_event, &output));
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.key_filter_version(), 10);
+}
+
 TEST_F(ClientTest, TestSendKey) {
   const int mock_id = 512;
   EXPECT_TRUE(SetupConnection(mock_id));
@@ -1266,5 +1451,43 @@ TEST_F(SessionPlaybackTest, ConsumedTest) {
   client_->GetHistoryInputs(&history);
   EXPECT_EQ(history.size(), 2);
 }
+
+TEST_F(SessionPlaybackTest, SessionSnapshotTest) {
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  commands::KeyEvent key_event;
+  key_event.set_key_code('a');
+
+  commands::Output mock_output;
+  mock_output.set_id(mock_id);
+  mock_output.set_consumed(true);
+  commands::SessionSnapshot *snapshot = mock_output.mutable_session_snapshot();
+  snapshot->set_state(commands::SessionSnapshot::COMPOSITION);
+  snapshot->mutable_composition()->set_position(1);
+  SetMockOutput(mock_output);
+
+  // The snapshot is kept by the client and not returned.
+  commands::Output output;
+  EXPECT_TRUE(client_->SendKey(key_event, &output));
+  EXPECT_FALSE(output.has_session_snapshot());
+  EXPECT_TRUE(client_->has_session_snapshot_);
+  EXPECT_EQ(client_->session_snapshot_.state(),
+            commands::SessionSnapshot::COMPOSITION);
+
+  // The session is restored from the snapshot, and the history is kept for
+  // servers which cannot restore it.
+  mock_output.set_id(456);
+  mock_output.clear_session_snapshot();
+  SetMockOutput(mock_output);
+  EXPECT_TRUE(client_->SendKey(key_event, &output));
+  EXPECT_TRUE(client_->has_session_snapshot_);
+  std::vector<commands::Input> history;
+  client_->GetHistoryInputs(&history);
+  EXPECT_FALSE(history.empty());
+
+  EXPECT_TRUE(client_->DeleteSession());
+  EXPECT_FALSE(client_->has_session_snapshot_);
+}
 }  // namespace client
 }  // namespace mozc
@@ -43,6 +43,7 @@
         'client.gyp:client',
         '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
         '<(mozc_oss_src_dir)/base/base.gyp:version',
+        '<(mozc_oss_src_dir)/base/base_test.gyp:clock_mock',
         '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
       ],
       'variables': {
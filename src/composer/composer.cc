@@ -1218,6 +1218,82 @@ bool Composer::IsToggleable() const {
   return !is_new_input_ && composition_.IsToggleable(position_);
 }
 
+void Composer::SaveSnapshot(
+    commands::SessionSnapshot::Composition *snapshot) const {
+  snapshot->Clear();
+  for (const CharChunk &chunk : composition_.chunks()) {
+    commands::SessionSnapshot::CharChunk *chunk_snapshot =
+        snapshot->add_chunks();
+    chunk_snapshot->set_transliterator(chunk.transliterator());
+    chunk_snapshot->set_raw(chunk.raw());
+    chunk_snapshot->set_conversion(chunk.conversion());
+    chunk_snapshot->set_pending(chunk.pending());
+    chunk_snapshot->set_ambiguous(chunk.ambiguous());
+    chunk_snapshot->set_attributes(chunk.attributes());
+  }
+  snapshot->set_position(position_);
+  snapshot->set_input_mode(input_mode_);
+  snapshot->set_output_mode(output_mode_);
+  snapshot->set_comeback_input_mode(comeback_input_mode_);
+  snapshot->set_shifted_sequence_count(shifted_sequence_count_);
+  snapshot->set_source_text(source_text_);
+  snapshot->set_is_new_input(is_new_input_);
+}
+
+bool Composer::RestoreSnapshot(
+    const commands::SessionSnapshot::Composition &snapshot) {
+  auto is_valid_mode = [](uint32_t mode) {
+    return mode < transliteration::NUM_T13N_TYPES;
+  };
+  if (!is_valid_mode(snapshot.input_mode()) ||
+      !is_valid_mode(snapshot.output_mode()) ||
+      !is_valid_mode(snapshot.comeback_input_mode())) {
+    LOG(ERROR) << "Invalid mode in the snapshot";
+    return false;
+  }
+
+  const auto input_mode =
+      static_cast<transliteration::TransliterationType>(snapshot.input_mode());
+  Composition composition(table_);
+  composition.SetInputMode(GetTransliterator(input_mode));
+  CharChunkList chunks;
+  for (const commands::SessionSnapshot::CharChunk &chunk_snapshot :
+       snapshot.chunks()) {
+    // LOCAL is used only for the input transliterator of the composition.
+    if (chunk_snapshot.transliterator() >= Transliterators::LOCAL) {
+      LOG(ERROR) << "Invalid transliterator in the snapshot";
+      return false;
+    }
+    CharChunk &chunk = chunks.emplace_back(
+        static_cast<Transliterators::Transliterator>(
+            chunk_snapshot.transliterator()),
+        table_);
+    chunk.set_raw(chunk_snapshot.raw());
+    chunk.set_conversion(chunk_snapshot.conversion());
+    chunk.set_pending(chunk_snapshot.pending());
+    chunk.set_ambiguous(chunk_snapshot.ambiguous());
+    chunk.set_attributes(chunk_snapshot.attributes());
+  }
+  composition.set_chunks(std::move(chunks));
+  if (snapshot.position() > composition.GetLength() ||
+      composition.GetLength() > max_length_) {
+    LOG(ERROR) << "Invalid composition in the snapshot";
+    return false;
+  }
+
+  composition_ = std::move(composition);
+  position_ = snapshot.position();
+  input_mode_ = input_mode;
+  output_mode_ = static_cast<transliteration::TransliterationType>(
+      snapshot.output_mode());
+  comeback_input_mode_ = static_cast<transliteration::TransliterationType>(
+      snapshot.comeback_input_mode());
+  shifted_sequence_count_ = snapshot.shifted_sequence_count();
+  source_text_ = snapshot.source_text();
+  is_new_input_ = snapshot.is_new_input();
+  return true;
+}
+
 bool Composer::is_new_input() const { return is_new_input_; }
 
 size_t Composer::shifted_sequence_count() const {
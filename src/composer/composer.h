@@ -242,6 +242,13 @@ class Composer final {
   // Returns true when the current character at cursor position is toggleable.
   bool IsToggleable() const;
 
+  // Saves the composition and the modes to |snapshot|.  The table, the request
+  // and the config are not saved.
+  void SaveSnapshot(commands::SessionSnapshot::Composition *snapshot) const;
+  // Restores the state saved by SaveSnapshot.  Returns false and leaves the
+  // composer unchanged if |snapshot| is invalid.
+  bool RestoreSnapshot(const commands::SessionSnapshot::Composition &snapshot);
+
   bool is_new_input() const;
   size_t shifted_sequence_count() const;
   const std::string &source_text() const;
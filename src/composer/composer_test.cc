@@ -167,6 +167,40 @@ TEST_F(ComposerTest, Empty) {
   EXPECT_TRUE(composer_->Empty());
 }
 
+TEST_F(ComposerTest, SaveAndRestoreSnapshot) {
+  table_->AddRule("ka", "か", "");
+  table_->AddRule("ki", "き", "");
+  composer_->InsertCharacter("kak");
+  composer_->SetTemporaryInputMode(transliteration::FULL_KATAKANA);
+  composer_->MoveCursorLeft();
+
+  commands::SessionSnapshot::Composition snapshot;
+  composer_->SaveSnapshot(&snapshot);
+
+  Composer restored(table_.get(), request_.get(), config_.get());
+  ASSERT_TRUE(restored.RestoreSnapshot(snapshot));
+  EXPECT_EQ(restored.GetStringForPreedit(), composer_->GetStringForPreedit());
+  EXPECT_EQ(restored.GetCursor(), composer_->GetCursor());
+  EXPECT_EQ(restored.GetInputMode(), transliteration::FULL_KATAKANA);
+  EXPECT_EQ(restored.GetComebackInputMode(), transliteration::HIRAGANA);
+
+  // The pending input is restored as well.
+  composer_->MoveCursorToEnd();
+  composer_->InsertCharacter("i");
+  restored.MoveCursorToEnd();
+  restored.InsertCharacter("i");
+  EXPECT_EQ(restored.GetStringForPreedit(), composer_->GetStringForPreedit());
+
+  // An invalid snapshot doesn't change the composer.
+  const std::string preedit = restored.GetStringForPreedit();
+  snapshot.set_position(100);
+  EXPECT_FALSE(restored.RestoreSnapshot(snapshot));
+  snapshot.set_position(0);
+  snapshot.set_input_mode(transliteration::NUM_T13N_TYPES);
+  EXPECT_FALSE(restored.RestoreSnapshot(snapshot));
+  EXPECT_EQ(restored.GetStringForPreedit(), preedit);
+}
+
 TEST_F(ComposerTest, EnableInsert) {
   composer_->set_max_length(6);
 
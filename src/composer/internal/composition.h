@@ -35,6 +35,7 @@
 #include <set>
 #include <string>
 #include <tuple>
+#include <utility>
 
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -198,6 +199,9 @@ class Composition final {
   const CharChunkList &GetCharChunkList() const;
   const Table *table() const { return table_; }
   const CharChunkList &chunks() const { return chunks_; }
+  // Replaces the chunks, e.g. to restore a snapshot.  The chunks should use
+  // table().
+  void set_chunks(CharChunkList chunks) { chunks_ = std::move(chunks); }
   Transliterators::Transliterator input_t12r() const { return input_t12r_; }
 
   friend bool operator==(const Composition &lhs, const Composition &rhs) {
@@ -62,6 +62,45 @@ bool None(uint32_t modifiers_to_be_tested, uint32_t modifiers_to_be_queried) {
   return !Any(modifiers_to_be_tested, modifiers_to_be_queried);
 }
 
+// Modifiers removed by KeyEventUtil::NormalizeModifiers().
+constexpr uint32_t kIgnorableModifierMask =
+    (KeyEvent::CAPS | KeyEvent::LEFT_ALT | KeyEvent::RIGHT_ALT |
+     KeyEvent::LEFT_CTRL | KeyEvent::RIGHT_CTRL | KeyEvent::LEFT_SHIFT |
+     KeyEvent::RIGHT_SHIFT);
+
+// Returns the modifiers of the key event normalized by NormalizeModifiers().
+// Like RemoveModifiers(), only the modifier_keys field is filtered.
+uint32_t GetNormalizedModifiers(const KeyEvent &key_event) {
+  if (key_event.has_modifiers()) {
+    return key_event.modifiers();
+  }
+  uint32_t modifiers = 0;
+  for (const int key : key_event.modifier_keys()) {
+    modifiers |= key;
+  }
+  return Ignore(modifiers, kIgnorableModifierMask);
+}
+
+// Packs the key information in the same layout as GetKeyInformation().
+bool PackKeyInformation(uint32_t modifiers, const KeyEvent &key_event,
+                        uint32_t key_code, KeyInformation *key) {
+  const uint16_t modifier_keys = static_cast<uint16_t>(modifiers);
+  const uint16_t special_key = key_event.has_special_key()
+                                   ? key_event.special_key()
+                                   : KeyEvent::NO_SPECIALKEY;
+
+  // Make sure the translation from the obsolete specification.
+  // key_code should no longer contain control characters.
+  if (0 < key_code && key_code <= 32) {
+    return false;
+  }
+
+  *key = (static_cast<KeyInformation>(modifier_keys) << 48) |
+         (static_cast<KeyInformation>(special_key) << 32) |
+         (static_cast<KeyInformation>(key_code));
+  return true;
+}
+
 }  // namespace
 
 uint32_t KeyEventUtil::GetModifiers(const KeyEvent &key_event) {
@@ -79,24 +118,24 @@ uint32_t KeyEventUtil::GetModifiers(const KeyEvent &key_event) {
 bool KeyEventUtil::GetKeyInformation(const KeyEvent &key_event,
                                      KeyInformation *key) {
   DCHECK(key);
-
-  const uint16_t modifier_keys = static_cast<uint16_t>(GetModifiers(key_event));
-  const uint16_t special_key = key_event.has_special_key()
-                                   ? key_event.special_key()
-                                   : KeyEvent::NO_SPECIALKEY;
   const uint32_t key_code = key_event.has_key_code() ? key_event.key_code() : 0;
+  return PackKeyInformation(GetModifiers(key_event), key_event, key_code, key);
+}
 
-  // Make sure the translation from the obsolete specification.
-  // key_code should no longer contain control characters.
-  if (0 < key_code && key_code <= 32) {
-    return false;
+bool KeyEventUtil::GetNormalizedKeyInformation(const KeyEvent &key_event,
+                                               KeyInformation *key) {
+  DCHECK(key);
+  uint32_t key_code = key_event.has_key_code() ? key_event.key_code() : 0;
+  // Reverts the flip of alphabetical key events caused by CapsLock.
+  if (HasCaps(GetModifiers(key_event))) {
+    if ('A' <= key_code && key_code <= 'Z') {
+      key_code += 'a' - 'A';
+    } else if ('a' <= key_code && key_code <= 'z') {
+      key_code += 'A' - 'a';
+    }
   }
-
-  *key = (static_cast<KeyInformation>(modifier_keys) << 48) |
-         (static_cast<KeyInformation>(special_key) << 32) |
-         (static_cast<KeyInformation>(key_code));
-
-  return true;
+  return PackKeyInformation(GetNormalizedModifiers(key_event), key_event,
+                            key_code, key);
 }
 
 void KeyEventUtil::NormalizeModifiers(const KeyEvent &key_event,
@@ -106,11 +145,6 @@ void KeyEventUtil::NormalizeModifiers(const KeyEvent &key_event,
   // CTRL (or ALT, SHIFT) should be set on modifier_keys when
   // LEFT (or RIGHT) ctrl is set.
   // LEFT_CTRL (or others) is not handled on Japanese, so we remove these.
-  constexpr uint32_t kIgnorableModifierMask =
-      (KeyEvent::CAPS | KeyEvent::LEFT_ALT | KeyEvent::RIGHT_ALT |
-       KeyEvent::LEFT_CTRL | KeyEvent::RIGHT_CTRL | KeyEvent::LEFT_SHIFT |
-       KeyEvent::RIGHT_SHIFT);
-
   RemoveModifiers(key_event, kIgnorableModifierMask, new_key_event);
 
   // Reverts the flip of alphabetical key events caused by CapsLock.
@@ -235,6 +269,22 @@ bool KeyEventUtil::MaybeGetKeyStub(const KeyEvent &key_event,
   return true;
 }
 
+bool KeyEventUtil::MaybeGetNormalizedKeyStub(const KeyEvent &key_event,
+                                             KeyInformation *key) {
+  DCHECK(key);
+  // The normalization doesn't change the conditions below except for the
+  // modifiers; the flip of CapsLock keeps key_code above 32.
+  if (GetNormalizedModifiers(key_event) != 0 || key_event.has_special_key()) {
+    return false;
+  }
+  if ((!key_event.has_key_code() || key_event.key_code() <= 32) &&
+      (!key_event.has_key_string() || key_event.key_string().empty())) {
+    return false;
+  }
+  *key = static_cast<KeyInformation>(KeyEvent::TEXT_INPUT) << 32;
+  return true;
+}
+
 bool KeyEventUtil::HasAlt(uint32_t modifiers) {
   return Any(modifiers, kAltMask);
 }
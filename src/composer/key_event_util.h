@@ -61,6 +61,14 @@ class KeyEventUtil {
   static void NormalizeModifiers(const commands::KeyEvent &key_event,
                                  commands::KeyEvent *new_key_event);
 
+  // Same as GetKeyInformation() and MaybeGetKeyStub() respectively for the
+  // key event normalized by NormalizeModifiers(), but computed without
+  // copying the key event. Used on every key command lookup.
+  static bool GetNormalizedKeyInformation(const commands::KeyEvent &key_event,
+                                          KeyInformation *key);
+  static bool MaybeGetNormalizedKeyStub(const commands::KeyEvent &key_event,
+                                        KeyInformation *key);
+
   // Normalizes a numpad key to a normal key (e.g. NUMPAD0 => '0')
   static void NormalizeNumpadKey(const commands::KeyEvent &key_event,
                                  commands::KeyEvent *new_key_event);
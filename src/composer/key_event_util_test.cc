@@ -266,6 +266,43 @@ TEST(KeyEventUtilTest, MaybeGetKeyStub) {
   EXPECT_EQ(key, static_cast<KeyInformation>(KeyEvent::TEXT_INPUT) << 32);
 }
 
+TEST(KeyEventUtilTest, GetNormalizedKeyInformation) {
+  // Must be the same as the lookup on the normalized copy.
+  constexpr absl::string_view kKeys[] = {
+      "a",           "A",           "CAPS H",      "CAPS h",
+      "LeftShift",   "Ctrl a",      "RightCtrl a", "CAPS LeftShift H",
+      "Shift Space", "CAPS Enter",  "Alt CAPS 1",  "Hankaku",
+  };
+  for (const absl::string_view key : kKeys) {
+    SCOPED_TRACE(key);
+    KeyEvent key_event;
+    ASSERT_TRUE(KeyParser::ParseKey(key, &key_event));
+    KeyEvent normalized_key_event;
+    KeyEventUtil::NormalizeModifiers(key_event, &normalized_key_event);
+
+    KeyInformation expected = 0, actual = 0;
+    EXPECT_EQ(KeyEventUtil::GetNormalizedKeyInformation(key_event, &actual),
+              KeyEventUtil::GetKeyInformation(normalized_key_event, &expected));
+    EXPECT_EQ(actual, expected);
+
+    expected = actual = 0;
+    EXPECT_EQ(KeyEventUtil::MaybeGetNormalizedKeyStub(key_event, &actual),
+              KeyEventUtil::MaybeGetKeyStub(normalized_key_event, &expected));
+    EXPECT_EQ(actual, expected);
+  }
+
+  // The modifiers field is kept as is.
+  KeyEvent key_event;
+  key_event.set_key_code('A');
+  key_event.set_modifiers(KeyEvent::CAPS | KeyEvent::SHIFT);
+  KeyEvent normalized_key_event;
+  KeyEventUtil::NormalizeModifiers(key_event, &normalized_key_event);
+  KeyInformation expected = 0, actual = 0;
+  EXPECT_TRUE(KeyEventUtil::GetNormalizedKeyInformation(key_event, &actual));
+  EXPECT_TRUE(KeyEventUtil::GetKeyInformation(normalized_key_event, &expected));
+  EXPECT_EQ(actual, expected);
+}
+
 TEST(KeyEventUtilTest, RemoveModifiers) {
   constexpr struct RemoveModifiersTestData {
     absl::string_view input;
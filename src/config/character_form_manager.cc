@@ -584,11 +584,17 @@ void CharacterFormManagerImpl::AddRule(const absl::string_view key,
   }
 }
 
+// The instance installed by ScopedCharacterFormManager on this thread.
+CharacterFormManager *&CurrentCharacterFormManager() {
+  thread_local CharacterFormManager *manager = nullptr;
+  return manager;
+}
+
 }  // namespace
 
 class CharacterFormManager::Data {
  public:
-  Data();
+  explicit Data(absl::string_view filename);
   ~Data() = default;
 
   CharacterFormManagerImpl *GetPreeditManager() { return preedit_.get(); }
@@ -602,11 +608,10 @@ class CharacterFormManager::Data {
   std::unique_ptr<LruStorage> storage_;
 };
 
-CharacterFormManager::Data::Data() {
-  const std::string filename = ConfigFileStream::GetFileName(kFileName);
+CharacterFormManager::Data::Data(const absl::string_view filename) {
   const uint32_t key_type = 0;
-  storage_ = LruStorage::Create(filename.c_str(), sizeof(key_type), kLruSize,
-                                kSeedValue);
+  storage_ = LruStorage::Create(std::string(filename).c_str(),
+                                sizeof(key_type), kLruSize, kSeedValue);
   if (!storage_) {
     LOG(ERROR) << "cannot open " << filename;
     storage_ = std::make_unique<LruStorage>();
@@ -620,15 +625,47 @@ CharacterFormManager::Data::Data() {
 }
 
 CharacterFormManager *CharacterFormManager::GetCharacterFormManager() {
+  if (CharacterFormManager *manager = CurrentCharacterFormManager();
+      manager != nullptr) {
+    return manager;
+  }
   return Singleton<CharacterFormManager>::get();
 }
 
-CharacterFormManager::CharacterFormManager() : data_(std::make_unique<Data>()) {
+std::unique_ptr<CharacterFormManager> CharacterFormManager::CreateWithStorage(
+    const Config &config, const absl::string_view storage_filename) {
+  // The constructor is private.
+  std::unique_ptr<CharacterFormManager> manager(
+      new CharacterFormManager(storage_filename));
+  manager->ReloadConfig(config);
+  return manager;
+}
+
+CharacterFormManager::CharacterFormManager()
+    : CharacterFormManager(ConfigFileStream::GetFileName(kFileName)) {
   Config config;
   ConfigHandler::GetConfig(&config);
   ReloadConfig(config);
 }
 
+CharacterFormManager::CharacterFormManager(
+    const absl::string_view storage_filename)
+    : data_(std::make_unique<Data>(storage_filename)) {}
+
+CharacterFormManager::~CharacterFormManager() = default;
+
+ScopedCharacterFormManager::ScopedCharacterFormManager(
+    CharacterFormManager *manager)
+    : prev_manager_(CurrentCharacterFormManager()) {
+  if (manager != nullptr) {
+    CurrentCharacterFormManager() = manager;
+  }
+}
+
+ScopedCharacterFormManager::~ScopedCharacterFormManager() {
+  CurrentCharacterFormManager() = prev_manager_;
+}
+
 void CharacterFormManager::ReloadConfig(const Config &config) {
   Clear();
   if (config.character_form_rules_size() > 0) {
@@ -146,9 +146,18 @@ class CharacterFormManager {
                                          absl::string_view input2,
                                          FormType *form2);
 
-  // Returns the singleton instance.
+  // Returns the instance installed by ScopedCharacterFormManager on this
+  // thread, or the singleton instance if there is none.
   static CharacterFormManager *GetCharacterFormManager();
 
+  // Creates an instance independent of the singleton, which stores the
+  // history in `storage_filename`. Used by the server hosting several users,
+  // so that the rules and the history of a user don't leak to the others.
+  static std::unique_ptr<CharacterFormManager> CreateWithStorage(
+      const Config &config, absl::string_view storage_filename);
+
+  ~CharacterFormManager();
+
  private:
   class Data;
 
@@ -156,11 +165,28 @@ class CharacterFormManager {
   friend class Singleton<CharacterFormManager>;
 
   CharacterFormManager();
-  ~CharacterFormManager() = default;
+  explicit CharacterFormManager(absl::string_view storage_filename);
 
   std::unique_ptr<Data> data_;
 };
 
+// Makes CharacterFormManager::GetCharacterFormManager() return `manager` on
+// the calling thread while this object is alive. Scopes can be nested; the
+// innermost one wins. A null `manager` keeps the current instance.
+class ScopedCharacterFormManager {
+ public:
+  explicit ScopedCharacterFormManager(CharacterFormManager *manager);
+
+  ScopedCharacterFormManager(const ScopedCharacterFormManager &) = delete;
+  ScopedCharacterFormManager &operator=(const ScopedCharacterFormManager &) =
+      delete;
+
+  ~ScopedCharacterFormManager();
+
+ private:
+  CharacterFormManager *prev_manager_;
+};
+
 }  // namespace config
 }  // namespace mozc
 
@@ -29,10 +29,13 @@
 
 #include "config/character_form_manager.h"
 
+#include <memory>
 #include <optional>
 #include <string>
 
+#include "base/file_util.h"
 #include "base/number_util.h"
+#include "base/system_util.h"
 #include "protocol/config.pb.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
@@ -623,6 +626,43 @@ TEST_F(CharacterFormManagerTest, NumberStyle) {
   }
 }
 
+TEST_F(CharacterFormManagerTest, ScopedCharacterFormManager) {
+  CharacterFormManager *singleton =
+      CharacterFormManager::GetCharacterFormManager();
+  singleton->ClearHistory();
+
+  Config config;
+  Config::CharacterFormRule *rule = config.add_character_form_rules();
+  rule->set_group("0");
+  rule->set_preedit_character_form(Config::HALF_WIDTH);
+  rule->set_conversion_character_form(Config::LAST_FORM);
+  std::unique_ptr<CharacterFormManager> manager =
+      CharacterFormManager::CreateWithStorage(
+          config, FileUtil::JoinPath(SystemUtil::GetUserProfileDirectory(),
+                                     "other_cform.db"));
+  ASSERT_NE(manager, nullptr);
+
+  {
+    const ScopedCharacterFormManager scope(manager.get());
+    EXPECT_EQ(CharacterFormManager::GetCharacterFormManager(), manager.get());
+    EXPECT_EQ(CharacterFormManager::GetCharacterFormManager()
+                  ->GetPreeditCharacterForm("0"),
+              Config::HALF_WIDTH);
+    CharacterFormManager::GetCharacterFormManager()->SetCharacterForm(
+        "0", Config::HALF_WIDTH);
+    EXPECT_EQ(manager->GetConversionCharacterForm("0"), Config::HALF_WIDTH);
+
+    // Null keeps the current instance.
+    const ScopedCharacterFormManager nested_scope(nullptr);
+    EXPECT_EQ(CharacterFormManager::GetCharacterFormManager(), manager.get());
+  }
+
+  // Neither the rules nor the history leak to the singleton.
+  EXPECT_EQ(CharacterFormManager::GetCharacterFormManager(), singleton);
+  EXPECT_EQ(singleton->GetPreeditCharacterForm("0"), Config::FULL_WIDTH);
+  EXPECT_EQ(singleton->GetConversionCharacterForm("0"), Config::FULL_WIDTH);
+}
+
 }  // namespace
 }  // namespace config
 }  // namespace mozc
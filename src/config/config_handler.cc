@@ -36,7 +36,6 @@
 #include <string>
 #include <utility>
 
-#include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
@@ -78,88 +77,76 @@ bool GetPlatformSpecificDefaultEmojiSetting() {
   return use_emoji_conversion_default;
 }
 
-class ConfigHandlerImpl final {
- public:
-  ConfigHandlerImpl()
-      :  // <user_profile>/config1.db
-        filename_(absl::StrFormat("%s%d.db", kFileNamePrefix, kConfigVersion)) {
-    Reload();
-    ConfigHandler::GetDefaultConfig(&default_config_);
-  }
+ConfigStore *GetDefaultConfigStore() { return Singleton<ConfigStore>::get(); }
+
+}  // namespace
 
-  void GetConfig(Config *config) const ABSL_LOCKS_EXCLUDED(mutex_);
-  std::unique_ptr<config::Config> GetConfig() const ABSL_LOCKS_EXCLUDED(mutex_);
-  const Config &DefaultConfig() const;
-  void SetConfig(const Config &config) ABSL_LOCKS_EXCLUDED(mutex_);
-  void Reload() ABSL_LOCKS_EXCLUDED(mutex_);
-  void SetConfigFileName(absl::string_view filename)
-      ABSL_LOCKS_EXCLUDED(mutex_);
-  std::string GetConfigFileName() ABSL_LOCKS_EXCLUDED(mutex_);
-
- private:
-  // copy config to config_ and do some
-  // platform dependent hooks/rewrites
-  void SetConfigInternal(Config config) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
-  void ReloadUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
-
-  std::string filename_ ABSL_GUARDED_BY(mutex_);
-  Config config_ ABSL_GUARDED_BY(mutex_);
-  Config default_config_;
-  mutable absl::Mutex mutex_;
-  uint64_t stored_config_hash_ ABSL_GUARDED_BY(mutex_) = 0;
-};
-
-ConfigHandlerImpl *GetConfigHandlerImpl() {
-  return Singleton<ConfigHandlerImpl>::get();
+// <user_profile>/config1.db
+ConfigStore::ConfigStore()
+    : ConfigStore(absl::StrFormat("%s%d.db", kFileNamePrefix, kConfigVersion)) {
+}
+
+ConfigStore::ConfigStore(std::string filename)
+    : filename_(std::move(filename)) {
+  Reload();
+  ConfigHandler::GetDefaultConfig(&default_config_);
 }
 
 // return current Config
-void ConfigHandlerImpl::GetConfig(Config *config) const {
-  absl::MutexLock lock(&mutex_);
-  *config = config_;
+void ConfigStore::GetConfig(Config *config) const {
+  *config = *GetSharedConfig();
 }
 
 // return current Config as a unique_ptr.
-std::unique_ptr<config::Config> ConfigHandlerImpl::GetConfig() const {
-  absl::MutexLock lock(&mutex_);
-  return std::make_unique<config::Config>(config_);
+std::unique_ptr<config::Config> ConfigStore::GetConfig() const {
+  return std::make_unique<config::Config>(*GetSharedConfig());
 }
 
-const Config &ConfigHandlerImpl::DefaultConfig() const {
+std::shared_ptr<const Config> ConfigStore::GetSharedConfig() const {
+  absl::ReaderMutexLock lock(&config_mutex_);
+  return config_;
+}
+
+const Config &ConfigStore::DefaultConfig() const {
   return default_config_;
 }
 
 // set config and rewrite internal data
-void ConfigHandlerImpl::SetConfigInternal(Config config) {
-  config_ = std::move(config);
-
+void ConfigStore::SetConfigInternal(Config config) {
 #ifdef MOZC_NO_LOGGING
   // Delete the optional field from the config.
-  config_.clear_verbose_level();
+  config.clear_verbose_level();
   // Fall back if the default value is not the expected value.
-  if (config_.verbose_level() != 0) {
-    config_.set_verbose_level(0);
+  if (config.verbose_level() != 0) {
+    config.set_verbose_level(0);
   }
 #endif  // MOZC_NO_LOGGING
 
-  mozc::internal::SetConfigVLogLevel(config_.verbose_level());
+  mozc::internal::SetConfigVLogLevel(config.verbose_level());
 
   // Initialize platform specific configuration.
-  if (config_.session_keymap() == Config::NONE) {
-    config_.set_session_keymap(ConfigHandler::GetDefaultKeyMap());
+  if (config.session_keymap() == Config::NONE) {
+    config.set_session_keymap(ConfigHandler::GetDefaultKeyMap());
   }
 
 #if defined(__ANDROID__) && defined(CHANNEL_DEV)
-  stored_config_.mutable_general_config()->set_upload_usage_stats(true);
+  config.mutable_general_config()->set_upload_usage_stats(true);
 #endif  // CHANNEL_DEV && __ANDROID__
 
   if (GetPlatformSpecificDefaultEmojiSetting() &&
-      !config_.has_use_emoji_conversion()) {
-    config_.set_use_emoji_conversion(true);
+      !config.has_use_emoji_conversion()) {
+    config.set_use_emoji_conversion(true);
   }
+
+  // Publishes the new snapshot. Readers holding the previous one keep it alive
+  // until they release it.
+  std::shared_ptr<const Config> snapshot =
+      std::make_shared<const Config>(std::move(config));
+  absl::MutexLock lock(&config_mutex_);
+  config_.swap(snapshot);
 }
 
-void ConfigHandlerImpl::SetConfig(const Config &config) {
+void ConfigStore::SetConfig(const Config &config) {
   uint64_t hash = Fingerprint(config.SerializeAsString());
 
   absl::MutexLock lock(&mutex_);
@@ -193,12 +180,12 @@ void ConfigHandlerImpl::SetConfig(const Config &config) {
 }
 
 // Reload from file
-void ConfigHandlerImpl::Reload() {
+void ConfigStore::Reload() {
   absl::MutexLock lock(&mutex_);
   ReloadUnlocked();
 }
 
-void ConfigHandlerImpl::ReloadUnlocked() {
+void ConfigStore::ReloadUnlocked() {
   MOZC_VLOG(1) << "Reloading config file: " << filename_;
   std::unique_ptr<std::istream> is(ConfigFileStream::OpenReadBinary(filename_));
   Config input_proto;
@@ -214,30 +201,33 @@ void ConfigHandlerImpl::ReloadUnlocked() {
   SetConfigInternal(std::move(input_proto));
 }
 
-void ConfigHandlerImpl::SetConfigFileName(const absl::string_view filename) {
+void ConfigStore::SetConfigFileName(const absl::string_view filename) {
   absl::MutexLock lock(&mutex_);
   MOZC_VLOG(1) << "set new config file name: " << filename;
   strings::Assign(filename_, filename);
   ReloadUnlocked();
 }
 
-std::string ConfigHandlerImpl::GetConfigFileName() {
+std::string ConfigStore::GetConfigFileName() {
   absl::MutexLock lock(&mutex_);
   return filename_;
 }
-}  // namespace
 
 // Returns current Config
 void ConfigHandler::GetConfig(Config *config) {
-  GetConfigHandlerImpl()->GetConfig(config);
+  GetDefaultConfigStore()->GetConfig(config);
 }
 
 std::unique_ptr<config::Config> ConfigHandler::GetConfig() {
-  return GetConfigHandlerImpl()->GetConfig();
+  return GetDefaultConfigStore()->GetConfig();
+}
+
+std::shared_ptr<const Config> ConfigHandler::GetSharedConfig() {
+  return GetDefaultConfigStore()->GetSharedConfig();
 }
 
 void ConfigHandler::SetConfig(const Config &config) {
-  GetConfigHandlerImpl()->SetConfig(config);
+  GetDefaultConfigStore()->SetConfig(config);
 }
 
 // static
@@ -275,18 +265,18 @@ void ConfigHandler::GetDefaultConfig(Config *config) {
 
 // static
 const Config &ConfigHandler::DefaultConfig() {
-  return GetConfigHandlerImpl()->DefaultConfig();
+  return GetDefaultConfigStore()->DefaultConfig();
 }
 
 // Reload from file
-void ConfigHandler::Reload() { GetConfigHandlerImpl()->Reload(); }
+void ConfigHandler::Reload() { GetDefaultConfigStore()->Reload(); }
 
 void ConfigHandler::SetConfigFileName(const absl::string_view filename) {
-  GetConfigHandlerImpl()->SetConfigFileName(filename);
+  GetDefaultConfigStore()->SetConfigFileName(filename);
 }
 
 std::string ConfigHandler::GetConfigFileName() {
-  return GetConfigHandlerImpl()->GetConfigFileName();
+  return GetDefaultConfigStore()->GetConfigFileName();
 }
 
 // static
@@ -32,10 +32,13 @@
 #ifndef MOZC_CONFIG_CONFIG_HANDLER_H_
 #define MOZC_CONFIG_CONFIG_HANDLER_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "protocol/config.pb.h"
 
 namespace mozc {
@@ -43,6 +46,49 @@ namespace config {
 
 inline constexpr int kConfigVersion = 1;
 
+// Config of one user stored in a file. ConfigHandler manages the store of the
+// user running this process, and a server hosting several users creates one
+// store for each of them. All public methods are thread-safe.
+class ConfigStore {
+ public:
+  // Loads the config from "user://config<kConfigVersion>.db".
+  ConfigStore();
+  // Loads the config from `filename`.
+  explicit ConfigStore(std::string filename);
+
+  ConfigStore(const ConfigStore &) = delete;
+  ConfigStore &operator=(const ConfigStore &) = delete;
+
+  void GetConfig(Config *config) const ABSL_LOCKS_EXCLUDED(config_mutex_);
+  std::unique_ptr<config::Config> GetConfig() const
+      ABSL_LOCKS_EXCLUDED(config_mutex_);
+  std::shared_ptr<const Config> GetSharedConfig() const
+      ABSL_LOCKS_EXCLUDED(config_mutex_);
+  const Config &DefaultConfig() const;
+  void SetConfig(const Config &config) ABSL_LOCKS_EXCLUDED(mutex_);
+  void Reload() ABSL_LOCKS_EXCLUDED(mutex_);
+  void SetConfigFileName(absl::string_view filename)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  std::string GetConfigFileName() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // copy config to config_ and do some
+  // platform dependent hooks/rewrites
+  void SetConfigInternal(Config config) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void ReloadUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::string filename_ ABSL_GUARDED_BY(mutex_);
+  Config default_config_;
+  // Serializes updates, which may involve file I/O.
+  mutable absl::Mutex mutex_;
+  // Guards only the swap and the copy of `config_` so readers never wait for
+  // the file I/O in SetConfig() and Reload(). The pointee is never modified
+  // once published.
+  mutable absl::Mutex config_mutex_ ABSL_ACQUIRED_AFTER(mutex_);
+  std::shared_ptr<const Config> config_ ABSL_GUARDED_BY(config_mutex_);
+  uint64_t stored_config_hash_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 // This is pure static class.  All public static methods are thread-safe.
 class ConfigHandler {
  public:
@@ -60,6 +106,12 @@ class ConfigHandler {
   // The same performance note as GetConfig(Config*) applies.
   static std::unique_ptr<config::Config> GetConfig();
 
+  // Returns an immutable snapshot of the current config without copying it.
+  // The snapshot stays valid and unchanged while the caller holds it, even if
+  // the config is updated by SetConfig() or Reload() in the meantime.
+  // Prefer this method on frequently called paths.
+  static std::shared_ptr<const Config> GetSharedConfig();
+
   // Sets config.
   static void SetConfig(const Config &config);
 
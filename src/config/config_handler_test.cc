@@ -135,6 +135,57 @@ TEST_F(ConfigHandlerTest, SetConfig) {
 #endif  // __ANDROID__ && CHANNEL_DEV
 }
 
+TEST_F(ConfigHandlerTest, SharedConfigIsImmutableSnapshot) {
+  TempDirectory temp_dir = testing::MakeTempDirectoryOrDie();
+  const std::string config_file =
+      FileUtil::JoinPath(temp_dir.path(), "mozc_config_test_tmp");
+  ASSERT_OK(FileUtil::UnlinkIfExists(config_file));
+  ConfigHandler::SetConfigFileName(config_file);
+
+  Config input;
+  ConfigHandler::GetDefaultConfig(&input);
+  input.set_incognito_mode(true);
+  ConfigHandler::SetConfig(input);
+  std::shared_ptr<const Config> snapshot1 = ConfigHandler::GetSharedConfig();
+  EXPECT_TRUE(snapshot1->incognito_mode());
+  // Getting the snapshot again without update shares the same instance.
+  EXPECT_EQ(ConfigHandler::GetSharedConfig().get(), snapshot1.get());
+
+  input.set_incognito_mode(false);
+  ConfigHandler::SetConfig(input);
+  std::shared_ptr<const Config> snapshot2 = ConfigHandler::GetSharedConfig();
+  EXPECT_FALSE(snapshot2->incognito_mode());
+  // The previously obtained snapshot is not affected by the update.
+  EXPECT_TRUE(snapshot1->incognito_mode());
+
+  std::unique_ptr<config::Config> copied = ConfigHandler::GetConfig();
+  EXPECT_EQ(absl::StrCat(*copied), absl::StrCat(*snapshot2));
+}
+
+TEST_F(ConfigHandlerTest, ConfigStoreIsIndependentOfConfigHandler) {
+  TempDirectory temp_dir = testing::MakeTempDirectoryOrDie();
+  const std::string config_file =
+      FileUtil::JoinPath(temp_dir.path(), "mozc_config_store_test_tmp");
+  ConfigHandler::SetConfigFileName(
+      FileUtil::JoinPath(temp_dir.path(), "mozc_config_handler_test_tmp"));
+
+  Config input;
+  ConfigHandler::GetDefaultConfig(&input);
+  input.set_incognito_mode(true);
+  {
+    ConfigStore store(config_file);
+    EXPECT_FALSE(store.GetSharedConfig()->incognito_mode());
+    store.SetConfig(input);
+    EXPECT_TRUE(store.GetSharedConfig()->incognito_mode());
+    EXPECT_EQ(store.GetConfigFileName(), config_file);
+  }
+  EXPECT_FALSE(ConfigHandler::GetSharedConfig()->incognito_mode());
+
+  // Another store of the same file loads the stored config.
+  ConfigStore store(config_file);
+  EXPECT_TRUE(store.GetSharedConfig()->incognito_mode());
+}
+
 TEST_F(ConfigHandlerTest, SetMetadata) {
   ClockMock clock1(absl::FromUnixSeconds(1000));
   Clock::SetClockForUnitTest(&clock1);
@@ -41,6 +41,7 @@
 #include "absl/algorithm/container.h"
 #include "absl/base/attributes.h"
 #include "absl/base/const_init.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
@@ -55,6 +56,7 @@ namespace {
 
 constexpr uint32_t kInvalidCacheKey = 0xFFFFFFFF;
 constexpr uint16_t kConnectorMagicNumber = 0xCDAB;
+constexpr uint16_t kBlockedConnectorMagicNumber = 0xCDAC;
 constexpr uint8_t kInvalid1ByteCostValue = 255;
 
 inline uint32_t GetHashValue(uint16_t rid, uint16_t lid, uint32_t hash_mask) {
@@ -97,6 +99,9 @@ struct Metadata {
   // 32-bits boundary.
   size_t ChunkBitsSize() const { return (NumChunkBits() + 31) / 32 * 4; }
 
+  // True if the data starts with the hot block.
+  bool IsBlocked() const { return magic == kBlockedConnectorMagicNumber; }
+
   // True if value is quantized to 1 byte.
   bool Use1ByteValue() const { return resolution != 1; }
 
@@ -125,7 +130,8 @@ absl::StatusOr<Metadata> ParseMetadata(const char *connection_data,
   metadata.rsize = data[2];
   metadata.lsize = data[3];
 
-  if (metadata.magic != kConnectorMagicNumber) {
+  if (metadata.magic != kConnectorMagicNumber &&
+      metadata.magic != kBlockedConnectorMagicNumber) {
     return absl::FailedPreconditionError(absl::StrCat(
         "connector.cc: Unexpected magic number. Expected: ",
         kConnectorMagicNumber, " Actual: ", metadata.DebugString()));
@@ -254,6 +260,34 @@ absl::Status Connector::Init(const char *connection_data,
         num_bytes, ", remaining: ", remaining, ": ", __VA_ARGS__));      \
   } while (false)
 
+  if (metadata->IsBlocked()) {
+    // The blocked format has the following data before the default costs:
+    // +--------------+-----------+------------------------------------------+
+    // |   uint16_t   | uint16_t  |                uint16_t[]                |
+    // | hot_pos_size | tile_size | costs in tiles of tile_size x tile_size  |
+    // +--------------+-----------+------------------------------------------+
+    VALIDATE_SIZE(ptr, 4, "Hot block header");
+    const uint16_t *header = reinterpret_cast<const uint16_t *>(ptr);
+    const uint16_t hot_pos_size = header[0];
+    const uint16_t tile_size = header[1];
+    ptr += 4;
+    if (metadata->Use1ByteValue() || hot_pos_size > metadata->rsize ||
+        tile_size == 0 || (tile_size & (tile_size - 1)) != 0) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "connector.cc: Invalid hot block: ", metadata->DebugString(),
+          ", hot_pos_size: ", hot_pos_size, ", tile_size: ", tile_size));
+    }
+    hot_pos_size_ = hot_pos_size;
+    num_hot_tiles_ = (hot_pos_size + tile_size - 1) / tile_size;
+    tile_shift_ = absl::countr_zero(tile_size);
+    hot_costs_ = reinterpret_cast<const uint16_t *>(ptr);
+    const size_t hot_costs_size =
+        size_t{num_hot_tiles_} * num_hot_tiles_ * tile_size * tile_size * 2;
+    VALIDATE_SIZE(hot_costs_, hot_costs_size, "Hot block");
+    VALIDATE_ALIGNMENT(hot_costs_);
+    ptr += hot_costs_size;
+  }
+
   // Read default cost array and move the read pointer.
   default_cost_ = reinterpret_cast<const uint16_t *>(ptr);
   // Each element of default cost array is 2 bytes.
@@ -311,6 +345,10 @@ absl::Status Connector::Init(const char *connection_data,
 
 
 int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
+  if (IsHot(rid, lid)) {
+    // A single load, which is cheaper than the cache.
+    return GetHotCost(rid, lid);
+  }
   const uint32_t index = EncodeKey(rid, lid);
   const uint32_t bucket = GetHashValue(rid, lid, cache_hash_mask_);
   if (cache_key_[bucket] == index) {
@@ -324,6 +362,14 @@ int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
 
 void Connector::ClearCache() { absl::c_fill(cache_key_, kInvalidCacheKey); }
 
+int Connector::GetHotCost(uint16_t rid, uint16_t lid) const {
+  const uint32_t tile_mask = (1 << tile_shift_) - 1;
+  const uint32_t tile =
+      (rid >> tile_shift_) * num_hot_tiles_ + (lid >> tile_shift_);
+  const uint32_t offset = ((rid & tile_mask) << tile_shift_) | (lid & tile_mask);
+  return hot_costs_[(tile << (2 * tile_shift_)) | offset];
+}
+
 int Connector::LookupCost(uint16_t rid, uint16_t lid) const {
   std::optional<uint16_t> value = rows_[rid].GetValue(lid);
   if (!value.has_value()) {
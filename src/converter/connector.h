@@ -65,8 +65,18 @@ class Connector final {
                     int cache_size);
 
   int LookupCost(uint16_t rid, uint16_t lid) const;
+  bool IsHot(uint16_t rid, uint16_t lid) const {
+    return rid < hot_pos_size_ && lid < hot_pos_size_;
+  }
+  int GetHotCost(uint16_t rid, uint16_t lid) const;
 
   std::vector<Row> rows_;
+  // The uncompressed tiles of the costs between the hot POS ids in the blocked
+  // format. See ConnectionDataBuilder for the layout.
+  const uint16_t *hot_costs_ = nullptr;
+  uint16_t hot_pos_size_ = 0;
+  uint16_t num_hot_tiles_ = 0;
+  int tile_shift_ = 0;
   const uint16_t *default_cost_ = nullptr;
   int resolution_ = 0;
   uint32_t cache_hash_mask_ = 0;
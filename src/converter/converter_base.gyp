@@ -51,6 +51,7 @@
     {
       'target_name': 'connector',
       'type': 'static_library',
+      'toolsets': [ 'target', 'host' ],
       'sources': [
         'connector.cc',
       ],
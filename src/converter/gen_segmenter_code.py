@@ -79,27 +79,16 @@ def GetRange(pos, pattern, name):
     return ""
 
   pat = re.compile(PatternToRegexp(pattern))
-  min_id = -1
-  max_id = -1
-  keys = list(pos.keys())
-  keys.sort()
+  # Group the consecutive ids rather than the consecutive features, as the ids
+  # are not in the order of the features once they are renumbered.
+  ids = sorted(int(id_val) for p, id_val in pos.items() if pat.match(p))
 
   id_range = []
-
-  for p in keys:
-    id_val = pos[p]
-    if pat.match(p):
-      if min_id == -1:
-        min_id = id_val
-        max_id = id_val
-      else:
-        max_id = id_val
+  for id_val in ids:
+    if id_range and id_range[-1][1] + 1 == id_val:
+      id_range[-1][1] = id_val
     else:
-      if min_id != -1:
-        id_range.append([min_id, max_id])
-        min_id = -1
-  if min_id != -1:
-    id_range.append([min_id, max_id])
+      id_range.append([id_val, id_val])
 
   tmp = []
   for r in id_range:
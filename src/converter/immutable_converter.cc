@@ -949,7 +949,8 @@ class CachingConnector final {
   int GetTransitionCost(uint16_t lnode_rid, uint16_t rnode_lid) {
     DCHECK_EQ(cache_lid_, rnode_lid);
     // Values for rid >= kCacheSize cannot be cached. However, frequent PoSs
-    // have smaller IDs, so caching only for rid in [0, kCacheSize) works well.
+    // have smaller IDs (see PosIdRenumberer), so caching only for rid in
+    // [0, kCacheSize) works well.
     if (lnode_rid >= kCacheSize) {
       return connector_.GetTransitionCost(lnode_rid, rnode_lid);
     }
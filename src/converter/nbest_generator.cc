@@ -38,6 +38,7 @@
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "base/container/arena.h"
 #include "base/vlog.h"
 #include "converter/candidate_filter.h"
 #include "converter/connector.h"
@@ -107,7 +108,8 @@ NBestGenerator::NBestGenerator(const SuppressionDictionary *suppression_dic,
       connector_(connector),
       pos_matcher_(pos_matcher),
       lattice_(lattice),
-      freelist_(kFreeListSize),
+      agenda_(GetRequestMemoryResource()),
+      freelist_(kFreeListSize, GetRequestMemoryResource()),
       filter_(suppression_dic, pos_matcher, suggestion_filter) {
   DCHECK(suppression_dictionary_);
   DCHECK(segmenter);
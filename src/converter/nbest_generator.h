@@ -32,6 +32,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -142,7 +143,8 @@ class NBestGenerator {
   // more operations in addition to std::priority_queue.
   class Agenda {
    public:
-    Agenda() = default;
+    explicit Agenda(std::pmr::memory_resource *resource)
+        : priority_queue_(resource) {}
     Agenda(const Agenda &) = delete;
     Agenda &operator=(const Agenda &) = delete;
     ~Agenda() = default;
@@ -156,7 +158,7 @@ class NBestGenerator {
     void Pop();
 
    private:
-    std::vector<const QueueElement *> priority_queue_;
+    std::pmr::vector<const QueueElement *> priority_queue_;
   };
 
   // Iterator:
@@ -211,8 +213,11 @@ class NBestGenerator {
   const Node *begin_node_ = nullptr;
   const Node *end_node_ = nullptr;
 
+  // The search state is discarded after the generator is used, so it is
+  // allocated from the request arena.
   Agenda agenda_;
-  FreeList<QueueElement> freelist_;
+  FreeList<QueueElement, std::pmr::polymorphic_allocator<QueueElement>>
+      freelist_;
   std::vector<const Node *> top_nodes_;
   converter::CandidateFilter filter_;
   bool viterbi_result_checked_ = false;
@@ -0,0 +1,323 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/connection_data_builder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "base/file_util.h"
+
+namespace mozc {
+namespace {
+
+constexpr uint16_t kCompressedMagicNumber = 0xCDAB;
+constexpr uint16_t kBlockedMagicNumber = 0xCDAC;
+constexpr uint16_t kInvalid1ByteCost = 255;
+constexpr uint16_t kResolutionFor1ByteCost = 64;
+
+// Returns the non-comment lines of `text` as gen_connection_data.py reads
+// them.
+std::vector<absl::string_view> GetLines(absl::string_view text) {
+  std::vector<absl::string_view> lines;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    const absl::string_view stripped = absl::StripAsciiWhitespace(line);
+    if (!stripped.empty() && stripped.front() != '#') {
+      lines.push_back(stripped);
+    }
+  }
+  return lines;
+}
+
+absl::StatusOr<size_t> GetPosSize(const std::string &filename) {
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(filename);
+  if (!contents.ok()) {
+    return std::move(contents).status();
+  }
+  return GetLines(*contents).size();
+}
+
+void AppendUint16(uint16_t value, std::string *output) {
+  output->push_back(static_cast<char>(value & 0xFF));
+  output->push_back(static_cast<char>(value >> 8));
+}
+
+// Appends the bits in LSB to MSB order.
+void AppendBits(const std::vector<bool> &bits, std::string *output) {
+  for (size_t i = 0; i < bits.size(); i += 8) {
+    uint8_t byte = 0;
+    for (size_t j = 0; j < 8 && i + j < bits.size(); ++j) {
+      if (bits[i + j]) {
+        byte |= 1 << j;
+      }
+    }
+    output->push_back(static_cast<char>(byte));
+  }
+}
+
+// Returns the most frequent valid cost in the row. Ties are broken by the
+// first occurrence, as in gen_connection_data.py.
+uint16_t GetModeValue(const ConnectionMatrix &matrix, uint16_t rid) {
+  absl::flat_hash_map<uint16_t, size_t> index;
+  std::vector<std::pair<uint16_t, size_t>> counts;
+  for (size_t lid = 0; lid < matrix.size; ++lid) {
+    const uint16_t cost = matrix.cost(rid, lid);
+    if (cost == ConnectionDataBuilder::kInvalidCost) {
+      // Heuristically, we do not compress the invalid cost.
+      continue;
+    }
+    const auto [it, inserted] = index.emplace(cost, counts.size());
+    if (inserted) {
+      counts.emplace_back(cost, 0);
+    }
+    ++counts[it->second].second;
+  }
+  uint16_t mode_value = ConnectionDataBuilder::kInvalidCost;
+  size_t max_count = 0;
+  for (const auto &[cost, count] : counts) {
+    if (count > max_count) {
+      mode_value = cost;
+      max_count = count;
+    }
+  }
+  return mode_value;
+}
+
+// Returns the compressed data after the 8 byte header: the mode values of the
+// rows followed by the rows. See Connector::Init for the row format.
+std::string BuildCompressedRows(const ConnectionMatrix &matrix,
+                                bool use_1byte_cost) {
+  std::vector<uint16_t> mode_values(matrix.size);
+  std::string output;
+  for (size_t rid = 0; rid < matrix.size; ++rid) {
+    mode_values[rid] = GetModeValue(matrix, rid);
+    AppendUint16(mode_values[rid], &output);
+  }
+  // 4 bytes alignment.
+  if (matrix.size % 2) {
+    AppendUint16(0, &output);
+  }
+
+  std::vector<bool> chunk_bits, compact_bits;
+  std::vector<uint16_t> values;
+  for (size_t rid = 0; rid < matrix.size; ++rid) {
+    chunk_bits.clear();
+    compact_bits.clear();
+    values.clear();
+    for (size_t chunk = 0; chunk < matrix.size; chunk += 8) {
+      const size_t chunk_end = std::min(chunk + 8, matrix.size);
+      bool has_value = false;
+      for (size_t lid = chunk; lid < chunk_end; ++lid) {
+        has_value |= matrix.cost(rid, lid) != mode_values[rid];
+      }
+      chunk_bits.push_back(has_value);
+      if (!has_value) {
+        continue;
+      }
+      for (size_t lid = chunk; lid < chunk_end; ++lid) {
+        uint16_t cost = matrix.cost(rid, lid);
+        if (cost == mode_values[rid]) {
+          compact_bits.push_back(false);
+          continue;
+        }
+        compact_bits.push_back(true);
+        if (use_1byte_cost) {
+          cost = cost == ConnectionDataBuilder::kInvalidCost
+                     ? kInvalid1ByteCost
+                     : cost / kResolutionFor1ByteCost;
+        }
+        values.push_back(cost);
+      }
+    }
+
+    // 4 bytes alignment.
+    chunk_bits.resize((chunk_bits.size() + 31) / 32 * 32);
+    compact_bits.resize((compact_bits.size() + 31) / 32 * 32);
+    const size_t value_alignment = use_1byte_cost ? 4 : 2;
+    values.resize((values.size() + value_alignment - 1) / value_alignment *
+                  value_alignment);
+
+    AppendUint16(compact_bits.size() / 8, &output);
+    AppendUint16(values.size() * (use_1byte_cost ? 1 : 2), &output);
+    AppendBits(chunk_bits, &output);
+    AppendBits(compact_bits, &output);
+    for (const uint16_t value : values) {
+      if (use_1byte_cost) {
+        output.push_back(static_cast<char>(value));
+      } else {
+        AppendUint16(value, &output);
+      }
+    }
+  }
+  return output;
+}
+
+// Returns the hot block of the blocked format.
+std::string BuildHotBlock(const ConnectionMatrix &matrix,
+                          uint16_t hot_pos_size) {
+  constexpr size_t kTileSize = ConnectionDataBuilder::kTileSize;
+  const size_t num_tiles = (hot_pos_size + kTileSize - 1) / kTileSize;
+  const size_t padded_size = num_tiles * kTileSize;
+  std::vector<uint16_t> tiles(padded_size * padded_size,
+                              ConnectionDataBuilder::kInvalidCost);
+  for (size_t rid = 0; rid < hot_pos_size; ++rid) {
+    for (size_t lid = 0; lid < hot_pos_size; ++lid) {
+      const size_t tile = rid / kTileSize * num_tiles + lid / kTileSize;
+      tiles[tile * kTileSize * kTileSize + rid % kTileSize * kTileSize +
+            lid % kTileSize] = matrix.cost(rid, lid);
+    }
+  }
+  std::string output;
+  output.reserve(tiles.size() * 2);
+  for (const uint16_t cost : tiles) {
+    AppendUint16(cost, &output);
+  }
+  return output;
+}
+
+}  // namespace
+
+absl::StatusOr<ConnectionMatrix> ConnectionDataBuilder::ReadMatrix(
+    const std::string &connection_file, const std::string &id_file,
+    const std::string &special_pos_file) {
+  absl::StatusOr<size_t> pos_size = GetPosSize(id_file);
+  if (!pos_size.ok()) {
+    return std::move(pos_size).status();
+  }
+  absl::StatusOr<size_t> special_pos_size = GetPosSize(special_pos_file);
+  if (!special_pos_size.ok()) {
+    return std::move(special_pos_size).status();
+  }
+  absl::StatusOr<std::string> text = FileUtil::GetContents(connection_file);
+  if (!text.ok()) {
+    return std::move(text).status();
+  }
+  return ParseMatrix(*text, *pos_size, *special_pos_size);
+}
+
+absl::StatusOr<ConnectionMatrix> ConnectionDataBuilder::ParseMatrix(
+    absl::string_view text, size_t pos_size, size_t special_pos_size) {
+  ConnectionMatrix matrix;
+  matrix.size = pos_size + special_pos_size;
+  if (matrix.size > 0xFFFF) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Too many POS ids: ", matrix.size));
+  }
+  matrix.costs.assign(matrix.size * matrix.size, 0);
+
+  const std::vector<absl::string_view> lines = GetLines(text);
+  size_t header = 0;
+  if (lines.empty() || !absl::SimpleAtoi(lines[0], &header) ||
+      header != pos_size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The matrix size doesn't match ", pos_size));
+  }
+  if (lines.size() - 1 != pos_size * pos_size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected ", pos_size * pos_size,
+                     " costs but found: ", lines.size() - 1));
+  }
+  for (size_t i = 1; i < lines.size(); ++i) {
+    uint32_t cost = 0;
+    if (!absl::SimpleAtoi(lines[i], &cost) || cost > 0xFFFF) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid cost at line ", i, ": ", lines[i]));
+    }
+    const size_t rid = (i - 1) / pos_size;
+    const size_t lid = (i - 1) % pos_size;
+    matrix.costs[rid * matrix.size + lid] = (rid == 0 && lid == 0) ? 0 : cost;
+  }
+
+  // The special POS ids are not connected to anything but BOS/EOS.
+  for (size_t rid = pos_size; rid < matrix.size; ++rid) {
+    for (size_t lid = 1; lid < matrix.size; ++lid) {
+      matrix.costs[rid * matrix.size + lid] = kInvalidCost;
+    }
+  }
+  for (size_t lid = pos_size; lid < matrix.size; ++lid) {
+    for (size_t rid = 1; rid < matrix.size; ++rid) {
+      matrix.costs[rid * matrix.size + lid] = kInvalidCost;
+    }
+  }
+  return matrix;
+}
+
+absl::StatusOr<std::string> ConnectionDataBuilder::Build(
+    const ConnectionMatrix &matrix, const Options &options) {
+  if (matrix.size > 0xFFFF || matrix.costs.size() != matrix.size * matrix.size) {
+    return absl::InvalidArgumentError("Broken matrix");
+  }
+  const bool blocked = options.format == BLOCKED;
+  if (blocked && options.use_1byte_cost) {
+    return absl::InvalidArgumentError(
+        "The blocked format requires 2 byte costs");
+  }
+  if (blocked && options.hot_pos_size > matrix.size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("hot_pos_size ", options.hot_pos_size,
+                     " exceeds the matrix size ", matrix.size));
+  }
+  if (options.use_1byte_cost) {
+    for (const uint16_t cost : matrix.costs) {
+      if (cost != kInvalidCost &&
+          cost / kResolutionFor1ByteCost == kInvalid1ByteCost) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Cost too large for 1 byte: ", cost));
+      }
+    }
+  }
+
+  std::string output;
+  AppendUint16(blocked ? kBlockedMagicNumber : kCompressedMagicNumber,
+               &output);
+  AppendUint16(options.use_1byte_cost ? kResolutionFor1ByteCost : 1, &output);
+  AppendUint16(matrix.size, &output);
+  AppendUint16(matrix.size, &output);
+  if (blocked) {
+    AppendUint16(options.hot_pos_size, &output);
+    AppendUint16(kTileSize, &output);
+    output.append(BuildHotBlock(matrix, options.hot_pos_size));
+  }
+  output.append(BuildCompressedRows(matrix, options.use_1byte_cost));
+  return output;
+}
+
+}  // namespace mozc
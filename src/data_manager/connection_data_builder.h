@@ -0,0 +1,116 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_CONNECTION_DATA_BUILDER_H_
+#define MOZC_DATA_MANAGER_CONNECTION_DATA_BUILDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace mozc {
+
+// A square matrix of the transition costs from the right id of the left node
+// (rid) to the left id of the right node (lid).
+struct ConnectionMatrix {
+  uint16_t cost(uint16_t rid, uint16_t lid) const {
+    return costs[rid * size + lid];
+  }
+
+  size_t size = 0;
+  // Row-major costs; costs[rid * size + lid].
+  std::vector<uint16_t> costs;
+};
+
+// Builds the connection data read by Connector. This is the C++ counterpart
+// of gen_connection_data.py and emits the same bytes for the compressed
+// format.
+//
+// Two formats are supported:
+//
+// * COMPRESSED: every row stores only the costs that differ from the mode of
+//   the row in a two-level succinct bit vector. This is the smallest format.
+//
+// * BLOCKED: the costs between the first `hot_pos_size` POS ids are stored
+//   uncompressed in row-major tiles of kTileSize x kTileSize, followed by the
+//   compressed rows for the other ids. A cost in the hot block is read with a
+//   single load, and the neighboring ids share cache lines. Renumber the POS
+//   ids so that the frequently used ones come first to make the most of it.
+//
+//   +--------+------------+-------+-------+--------------+-----------+
+//   | uint16 |   uint16   |uint16 |uint16 |    uint16    |  uint16   |
+//   | magic  | resolution | rsize | lsize | hot_pos_size | tile_size |
+//   +--------+------------+-------+-------+--------------+-----------+
+//   | uint16[] tiles | the compressed data after its 8 byte header      |
+//   +----------------+--------------------------------------------------+
+//
+//   The hot block holds the final costs, so it requires 2 byte costs.
+class ConnectionDataBuilder {
+ public:
+  enum Format {
+    COMPRESSED,
+    BLOCKED,
+  };
+
+  struct Options {
+    Format format = COMPRESSED;
+    // Quantizes the costs in the compressed rows to 1 byte.
+    bool use_1byte_cost = false;
+    // The number of leading POS ids stored in the hot block of BLOCKED.
+    uint16_t hot_pos_size = 0;
+  };
+
+  static constexpr uint16_t kInvalidCost = 30000;
+  static constexpr uint16_t kTileSize = 8;
+
+  ConnectionDataBuilder() = delete;
+
+  // Reads the matrix from connection_single_column.txt. The POS ids of the
+  // special POS follow the ones in `id_file`, and their costs are invalid
+  // except for BOS/EOS.
+  static absl::StatusOr<ConnectionMatrix> ReadMatrix(
+      const std::string &connection_file, const std::string &id_file,
+      const std::string &special_pos_file);
+
+  // Parses the contents of connection_single_column.txt.
+  static absl::StatusOr<ConnectionMatrix> ParseMatrix(absl::string_view text,
+                                                      size_t pos_size,
+                                                      size_t special_pos_size);
+
+  static absl::StatusOr<std::string> Build(const ConnectionMatrix &matrix,
+                                           const Options &options);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_CONNECTION_DATA_BUILDER_H_
@@ -0,0 +1,155 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/connection_data_builder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "absl/random/random.h"
+#include "absl/status/statusor.h"
+#include "converter/connector.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+constexpr uint16_t kInvalidCost = ConnectionDataBuilder::kInvalidCost;
+
+ConnectionMatrix MakeRandomMatrix(size_t size) {
+  absl::BitGen gen;
+  ConnectionMatrix matrix;
+  matrix.size = size;
+  for (size_t i = 0; i < size * size; ++i) {
+    // Biased to the mode values so that the rows are compressed.
+    matrix.costs.push_back(absl::Bernoulli(gen, 0.3)
+                               ? absl::Uniform<uint16_t>(gen, 0, 10000)
+                               : (i / size) % 7 * 100);
+  }
+  return matrix;
+}
+
+Connector CreateConnector(const std::string &data) {
+  absl::StatusOr<Connector> connector =
+      Connector::Create(data.data(), data.size(), 256);
+  CHECK_OK(connector);
+  return *std::move(connector);
+}
+
+TEST(ConnectionDataBuilderTest, ParseMatrix) {
+  absl::StatusOr<ConnectionMatrix> matrix = ConnectionDataBuilder::ParseMatrix(
+      "# comment\n2\n5\n1\n2\n3\n", 2, 1);
+  ASSERT_OK(matrix);
+  ASSERT_EQ(matrix->size, 3);
+  EXPECT_EQ(matrix->cost(0, 0), 0);  // BOS/EOS is always 0.
+  EXPECT_EQ(matrix->cost(0, 1), 1);
+  EXPECT_EQ(matrix->cost(1, 0), 2);
+  EXPECT_EQ(matrix->cost(1, 1), 3);
+  // Special POS.
+  EXPECT_EQ(matrix->cost(0, 2), 0);
+  EXPECT_EQ(matrix->cost(2, 0), 0);
+  EXPECT_EQ(matrix->cost(1, 2), kInvalidCost);
+  EXPECT_EQ(matrix->cost(2, 1), kInvalidCost);
+  EXPECT_EQ(matrix->cost(2, 2), kInvalidCost);
+
+  EXPECT_FALSE(ConnectionDataBuilder::ParseMatrix("3\n0\n", 2, 1).ok());
+  EXPECT_FALSE(ConnectionDataBuilder::ParseMatrix("2\n0\n1\n", 2, 1).ok());
+  EXPECT_FALSE(
+      ConnectionDataBuilder::ParseMatrix("2\n0\n1\n2\n-3\n", 2, 1).ok());
+}
+
+TEST(ConnectionDataBuilderTest, CompareFormats) {
+  // Not a multiple of the tile size, to test the padding.
+  const ConnectionMatrix matrix = MakeRandomMatrix(123);
+
+  absl::StatusOr<std::string> compressed =
+      ConnectionDataBuilder::Build(matrix, {});
+  ASSERT_OK(compressed);
+  absl::StatusOr<std::string> blocked = ConnectionDataBuilder::Build(
+      matrix, {.format = ConnectionDataBuilder::BLOCKED, .hot_pos_size = 45});
+  ASSERT_OK(blocked);
+  EXPECT_GT(blocked->size(), compressed->size());
+
+  const Connector compressed_connector = CreateConnector(*compressed);
+  const Connector blocked_connector = CreateConnector(*blocked);
+  for (uint16_t rid = 0; rid < matrix.size; ++rid) {
+    for (uint16_t lid = 0; lid < matrix.size; ++lid) {
+      ASSERT_EQ(compressed_connector.GetTransitionCost(rid, lid),
+                matrix.cost(rid, lid));
+      ASSERT_EQ(blocked_connector.GetTransitionCost(rid, lid),
+                matrix.cost(rid, lid));
+    }
+  }
+}
+
+TEST(ConnectionDataBuilderTest, OneByteCost) {
+  ConnectionMatrix matrix = MakeRandomMatrix(40);
+  matrix.costs[1] = kInvalidCost;
+
+  absl::StatusOr<std::string> data =
+      ConnectionDataBuilder::Build(matrix, {.use_1byte_cost = true});
+  ASSERT_OK(data);
+  const Connector connector = CreateConnector(*data);
+  EXPECT_EQ(connector.GetResolution(), 64);
+  EXPECT_GE(connector.GetTransitionCost(0, 1), Connector::kInvalidCost);
+  for (uint16_t rid = 1; rid < matrix.size; ++rid) {
+    for (uint16_t lid = 0; lid < matrix.size; ++lid) {
+      const int cost = connector.GetTransitionCost(rid, lid);
+      EXPECT_LE(cost, matrix.cost(rid, lid));
+      EXPECT_LT(matrix.cost(rid, lid) - cost, 64);
+    }
+  }
+
+  // The hot block holds the final costs, which need 2 bytes.
+  EXPECT_FALSE(ConnectionDataBuilder::Build(
+                   matrix, {.format = ConnectionDataBuilder::BLOCKED,
+                            .use_1byte_cost = true})
+                   .ok());
+}
+
+TEST(ConnectionDataBuilderTest, RejectsBrokenHotBlock) {
+  const ConnectionMatrix matrix = MakeRandomMatrix(16);
+  EXPECT_FALSE(ConnectionDataBuilder::Build(
+                   matrix, {.format = ConnectionDataBuilder::BLOCKED,
+                            .hot_pos_size = 17})
+                   .ok());
+
+  absl::StatusOr<std::string> blocked = ConnectionDataBuilder::Build(
+      matrix, {.format = ConnectionDataBuilder::BLOCKED, .hot_pos_size = 16});
+  ASSERT_OK(blocked);
+  blocked->resize(100);
+  EXPECT_FALSE(Connector::Create(blocked->data(), blocked->size(), 256).ok());
+}
+
+}  // namespace
+}  // namespace mozc
@@ -40,7 +40,9 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -52,10 +54,16 @@
 #include "base/mmap.h"
 #include "base/version.h"
 #include "base/vlog.h"
+#include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_compression.h"
 #include "data_manager/dataset_reader.h"
 #include "data_manager/serialized_dictionary.h"
 #include "protocol/segmenter_data.pb.h"
 
+ABSL_FLAG(bool, record_data_set_page_profile, false,
+          "Records the pages of the data set used in this process to the page "
+          "profile, which is used to warm up the data set on startup.");
+
 namespace mozc {
 namespace {
 
@@ -93,6 +101,18 @@ DataManager::Status InitUserPosManagerDataFromReader(
   return DataManager::Status::OK;
 }
 
+// A serialized string array of no strings, which is returned in place of a
+// broken one.
+alignas(uint32_t) constexpr char kEmptyStringArrayData[4] = {0, 0, 0, 0};
+constexpr absl::string_view kEmptyStringArray(kEmptyStringArrayData, 4);
+
+constexpr DataManager::LazySection kCriticalSections[] = {
+    DataManager::LazySection::kSymbol,
+    DataManager::LazySection::kEmoji,
+    DataManager::LazySection::kSingleKanji,
+    DataManager::LazySection::kZeroQuery,
+};
+
 template <typename T>
 absl::Span<const T> MakeSpanFromAlignedBuffer(const absl::string_view buf) {
   return absl::MakeSpan(std::launder(reinterpret_cast<const T *>(buf.data())),
@@ -296,11 +316,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     LOG(ERROR) << "Cannot find a symbol string array or data is broken";
     return Status::DATA_MISSING;
   }
-  if (!SerializedDictionary::VerifyData(symbol_token_array_data_,
-                                        symbol_string_array_data_)) {
-    LOG(ERROR) << "Symbol dictionary data is broken";
-    return Status::DATA_BROKEN;
-  }
   if (!reader.Get("emoticon_token", &emoticon_token_array_data_)) {
     LOG(ERROR) << "Cannot find an emoticon token array";
     return Status::DATA_MISSING;
@@ -309,11 +324,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     LOG(ERROR) << "Cannot find an emoticon string array or data is broken";
     return Status::DATA_MISSING;
   }
-  if (!SerializedDictionary::VerifyData(emoticon_token_array_data_,
-                                        emoticon_string_array_data_)) {
-    LOG(ERROR) << "Emoticon dictionary data is broken";
-    return Status::DATA_BROKEN;
-  }
   if (!reader.Get("emoji_token", &emoji_token_array_data_)) {
     LOG(ERROR) << "Cannot find an emoji token array";
     return Status::DATA_MISSING;
@@ -322,10 +332,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     LOG(ERROR) << "Cannot find an emoji string array or data is broken";
     return Status::DATA_MISSING;
   }
-  if (!SerializedStringArray::VerifyData(emoji_string_array_data_)) {
-    LOG(ERROR) << "Emoji rewriter string array data is broken";
-    return Status::DATA_BROKEN;
-  }
   if (!reader.Get("single_kanji_token", &single_kanji_token_array_data_) ||
       !reader.Get("single_kanji_string", &single_kanji_string_array_data_) ||
       !reader.Get("single_kanji_variant_type",
@@ -341,16 +347,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     LOG(ERROR) << "Cannot find single Kanji rewriter data";
     return Status::DATA_MISSING;
   }
-  if (!SerializedStringArray::VerifyData(single_kanji_string_array_data_) ||
-      !SerializedStringArray::VerifyData(single_kanji_variant_type_data_) ||
-      !SerializedStringArray::VerifyData(
-          single_kanji_variant_string_array_data_) ||
-      !SerializedDictionary::VerifyData(
-          single_kanji_noun_prefix_token_array_data_,
-          single_kanji_noun_prefix_string_array_data_)) {
-    LOG(ERROR) << "Single Kanji data is broken";
-    return Status::DATA_BROKEN;
-  }
   if (!reader.Get("a11y_description_token",
                   &a11y_description_token_array_data_)) {
     MOZC_VLOG(2) << "A11y description dictionary's token array is not provided";
@@ -364,13 +360,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     a11y_description_string_array_data_ = "";
     // A11y description dictionary is optional, so don't return false here.
   }
-  if (!(a11y_description_token_array_data_.empty() &&
-        a11y_description_string_array_data_.empty()) &&
-      !SerializedDictionary::VerifyData(a11y_description_token_array_data_,
-                                        a11y_description_string_array_data_)) {
-    LOG(ERROR) << "A11y description dictionary data is broken";
-    return Status::DATA_BROKEN;
-  }
   if (!reader.Get("zero_query_token_array", &zero_query_token_array_data_) ||
       !reader.Get("zero_query_string_array", &zero_query_string_array_data_) ||
       !reader.Get("zero_query_number_token_array",
@@ -380,12 +369,6 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
     LOG(ERROR) << "Cannot find zero query data";
     return Status::DATA_MISSING;
   }
-  if (!SerializedStringArray::VerifyData(zero_query_string_array_data_) ||
-      !SerializedStringArray::VerifyData(
-          zero_query_number_string_array_data_)) {
-    LOG(ERROR) << "Zero query data is broken";
-    return Status::DATA_BROKEN;
-  }
 
   if (!reader.Get("usage_item_array", &usage_items_data_)) {
     MOZC_VLOG(2) << "Usage dictionary is not provided";
@@ -401,12 +384,41 @@ DataManager::Status DataManager::InitFromReader(const DataSetReader &reader) {
       LOG(ERROR) << "Cannot find some usage dictionary data components";
       return Status::DATA_MISSING;
     }
-    if (!SerializedStringArray::VerifyData(usage_string_array_data_)) {
-      LOG(ERROR) << "Usage dictionary's string array is broken";
+  }
+
+  // The compressed sections are decompressed on their first use, so only the
+  // lazy sections can be compressed.
+  compressed_sections_.clear();
+  compressed_ = {};
+  decompression_ = std::make_unique<DecompressionState>();
+  for (const DataSetMetadata::Entry &entry : reader.metadata().entries()) {
+    if (entry.compression() == DataSetMetadata::NO_COMPRESSION) {
+      continue;
+    }
+    LazySection section;
+    absl::string_view *data = GetLazySectionData(entry.name(), &section);
+    if (data == nullptr) {
+      LOG(ERROR) << "Section " << entry.name() << " cannot be compressed";
+      return Status::DATA_BROKEN;
+    }
+    // Each byte of the compressed data expands to at most 255 bytes.
+    if (entry.uncompressed_size() / 255 > data->size()) {
+      LOG(ERROR) << "Section " << entry.name() << " has a broken size";
+      return Status::DATA_BROKEN;
+    }
+    compressed_sections_.push_back({section, data, entry.uncompressed_size()});
+    compressed_[static_cast<size_t>(section)] = true;
+  }
+
+  // A broken section fails the whole data set. Only the compressed sections
+  // are verified later, when they are decompressed on their first use.
+  for (size_t i = 0; i < kNumLazySections; ++i) {
+    if (!compressed_[i] && !VerifyLazySection(static_cast<LazySection>(i))) {
       return Status::DATA_BROKEN;
     }
   }
 
+  data_set_checksum_ = reader.GetChecksum();
   if (!reader.Get("version", &data_version_)) {
     LOG(ERROR) << "Cannot find data version";
     return Status::DATA_MISSING;
@@ -434,7 +446,14 @@ DataManager::Status DataManager::InitFromFile(const std::string &path) {
 
 DataManager::Status DataManager::InitFromFile(const std::string &path,
                                               absl::string_view magic) {
-  absl::StatusOr<Mmap> mmap = Mmap::Map(path, Mmap::READ_ONLY);
+  return InitFromFile(path, magic, DefaultSectionLoadPolicies());
+}
+
+DataManager::Status DataManager::InitFromFile(
+    const std::string &path, absl::string_view magic,
+    const SectionLoadPolicies &policies) {
+  absl::StatusOr<Mmap> mmap =
+      Mmap::Map(path, Mmap::READ_ONLY, DataSetMmapOptions());
   if (!mmap.ok()) {
     LOG(ERROR) << mmap.status();
     return Status::MMAP_FAILURE;
@@ -442,7 +461,254 @@ DataManager::Status DataManager::InitFromFile(const std::string &path,
   filename_ = path;
   mmap_ = *std::move(mmap);
   const absl::string_view data(mmap_.begin(), mmap_.size());
-  return InitFromArray(data, magic);
+  DataSetReader reader;
+  if (!reader.Init(data, magic)) {
+    LOG(ERROR) << "Binary data of size " << data.size() << " is broken";
+    return Status::DATA_BROKEN;
+  }
+  // Applies the policies before verifying the sections. kPopulate faults in
+  // the section synchronously, so the verification below finds it resident;
+  // only kWillNeed reads ahead asynchronously, overlapping with it.
+  ApplySectionLoadPolicies(reader, policies);
+  return InitFromReader(reader);
+}
+
+// static
+const DataManager::SectionLoadPolicies &
+DataManager::DefaultSectionLoadPolicies() {
+  static const SectionLoadPolicies *policies = new SectionLoadPolicies({
+      // Consulted for every pair of adjacent nodes in the lattice.
+      {"conn", SectionLoadPolicy::kPopulate},
+      {"segmenter_sizeinfo", SectionLoadPolicy::kPopulate},
+      {"segmenter_ltable", SectionLoadPolicy::kPopulate},
+      {"segmenter_rtable", SectionLoadPolicy::kPopulate},
+      {"segmenter_bitarray", SectionLoadPolicy::kPopulate},
+      {"bdry", SectionLoadPolicy::kPopulate},
+      {"posg", SectionLoadPolicy::kPopulate},
+      {"pos_matcher", SectionLoadPolicy::kPopulate},
+      // Large and looked up at random positions. The system dictionary warms up
+      // its key trie by itself.
+      {"dict", SectionLoadPolicy::kRandom},
+      {"sugg", SectionLoadPolicy::kRandom},
+      {"coll", SectionLoadPolicy::kRandom},
+      {"cols", SectionLoadPolicy::kRandom},
+  });
+  return *policies;
+}
+
+// static
+Mmap::Options DataManager::DataSetMmapOptions() {
+  Mmap::Options options;
+  options.mlock = !absl::GetFlag(FLAGS_record_data_set_page_profile);
+  return options;
+}
+
+void DataManager::ApplySectionLoadPolicies(
+    const DataSetReader &reader, const SectionLoadPolicies &policies) {
+  for (const auto &[name, policy] : policies) {
+    absl::string_view section;
+    if (!reader.Get(name, &section)) {
+      continue;
+    }
+    switch (policy) {
+      case SectionLoadPolicy::kLazy:
+        break;
+      case SectionLoadPolicy::kRandom:
+        Mmap::MaybeAdvise(section.data(), section.size(),
+                          Mmap::Advice::kRandom);
+        break;
+      case SectionLoadPolicy::kWillNeed:
+        Mmap::MaybeAdvise(section.data(), section.size(),
+                          Mmap::Advice::kWillNeed);
+        break;
+      case SectionLoadPolicy::kPopulate:
+        Mmap::Prefetch(section.data(), section.size());
+        break;
+    }
+  }
+}
+
+bool DataManager::WarmUpSections(absl::Span<const LazySection> sections) const {
+  bool valid = true;
+  for (const LazySection section : sections) {
+    valid &= IsLazySectionValid(section);
+  }
+  return valid;
+}
+
+bool DataManager::WarmUpCriticalSections() const {
+  return WarmUpSections(kCriticalSections);
+}
+
+bool DataManager::IsLazySectionValid(LazySection section) const {
+  const size_t index = static_cast<size_t>(section);
+  if (!compressed_[index]) {
+    return true;
+  }
+  DecompressionState &state = *decompression_;
+  absl::call_once(state.once[index], [this, section, index, &state]() {
+    state.valid[index] =
+        DecompressLazySection(section) && VerifyLazySection(section);
+  });
+  return state.valid[index];
+}
+
+absl::string_view *DataManager::GetLazySectionData(absl::string_view name,
+                                                    LazySection *section) {
+  struct LazySectionData {
+    absl::string_view name;
+    LazySection section;
+    absl::string_view DataManager::*data;
+  };
+  static constexpr LazySectionData kLazySectionData[] = {
+      {"symbol_token", LazySection::kSymbol,
+       &DataManager::symbol_token_array_data_},
+      {"symbol_string", LazySection::kSymbol,
+       &DataManager::symbol_string_array_data_},
+      {"emoticon_token", LazySection::kEmoticon,
+       &DataManager::emoticon_token_array_data_},
+      {"emoticon_string", LazySection::kEmoticon,
+       &DataManager::emoticon_string_array_data_},
+      {"emoji_token", LazySection::kEmoji,
+       &DataManager::emoji_token_array_data_},
+      {"emoji_string", LazySection::kEmoji,
+       &DataManager::emoji_string_array_data_},
+      {"single_kanji_token", LazySection::kSingleKanji,
+       &DataManager::single_kanji_token_array_data_},
+      {"single_kanji_string", LazySection::kSingleKanji,
+       &DataManager::single_kanji_string_array_data_},
+      {"single_kanji_variant_type", LazySection::kSingleKanji,
+       &DataManager::single_kanji_variant_type_data_},
+      {"single_kanji_variant_token", LazySection::kSingleKanji,
+       &DataManager::single_kanji_variant_token_array_data_},
+      {"single_kanji_variant_string", LazySection::kSingleKanji,
+       &DataManager::single_kanji_variant_string_array_data_},
+      {"single_kanji_noun_prefix_token", LazySection::kSingleKanji,
+       &DataManager::single_kanji_noun_prefix_token_array_data_},
+      {"single_kanji_noun_prefix_string", LazySection::kSingleKanji,
+       &DataManager::single_kanji_noun_prefix_string_array_data_},
+      {"a11y_description_token", LazySection::kA11yDescription,
+       &DataManager::a11y_description_token_array_data_},
+      {"a11y_description_string", LazySection::kA11yDescription,
+       &DataManager::a11y_description_string_array_data_},
+      {"zero_query_token_array", LazySection::kZeroQuery,
+       &DataManager::zero_query_token_array_data_},
+      {"zero_query_string_array", LazySection::kZeroQuery,
+       &DataManager::zero_query_string_array_data_},
+      {"zero_query_number_token_array", LazySection::kZeroQuery,
+       &DataManager::zero_query_number_token_array_data_},
+      {"zero_query_number_string_array", LazySection::kZeroQuery,
+       &DataManager::zero_query_number_string_array_data_},
+      {"usage_base_conjugation_suffix", LazySection::kUsage,
+       &DataManager::usage_base_conjugation_suffix_data_},
+      {"usage_conjugation_suffix", LazySection::kUsage,
+       &DataManager::usage_conjugation_suffix_data_},
+      {"usage_conjugation_index", LazySection::kUsage,
+       &DataManager::usage_conjugation_index_data_},
+      {"usage_item_array", LazySection::kUsage,
+       &DataManager::usage_items_data_},
+      {"usage_string_array", LazySection::kUsage,
+       &DataManager::usage_string_array_data_},
+  };
+  for (const LazySectionData &lazy_section : kLazySectionData) {
+    if (lazy_section.name == name) {
+      *section = lazy_section.section;
+      return &(this->*lazy_section.data);
+    }
+  }
+  return nullptr;
+}
+
+bool DataManager::DecompressLazySection(LazySection section) const {
+  const size_t index = static_cast<size_t>(section);
+  for (const CompressedSection &compressed : compressed_sections_) {
+    if (compressed.section != section) {
+      continue;
+    }
+    // The size is checked by InitFromReader().
+    const absl::string_view data = *compressed.data;
+    *compressed.data = absl::string_view();
+    auto buffer = std::make_unique<char[]>(compressed.uncompressed_size);
+    if (!DataSetCompression::Decompress(
+            data,
+            absl::MakeSpan(buffer.get(), compressed.uncompressed_size))) {
+      LOG(ERROR) << "Compressed section is broken";
+      return false;
+    }
+    *compressed.data =
+        absl::string_view(buffer.get(), compressed.uncompressed_size);
+    decompression_->buffers[index].push_back(std::move(buffer));
+  }
+  return true;
+}
+
+bool DataManager::VerifyLazySection(LazySection section) const {
+  switch (section) {
+    case LazySection::kSymbol:
+      if (!SerializedDictionary::VerifyData(symbol_token_array_data_,
+                                            symbol_string_array_data_)) {
+        LOG(ERROR) << "Symbol dictionary data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kEmoticon:
+      if (!SerializedDictionary::VerifyData(emoticon_token_array_data_,
+                                            emoticon_string_array_data_)) {
+        LOG(ERROR) << "Emoticon dictionary data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kEmoji:
+      if (!SerializedStringArray::VerifyData(emoji_string_array_data_)) {
+        LOG(ERROR) << "Emoji rewriter string array data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kSingleKanji:
+      if (!SerializedStringArray::VerifyData(single_kanji_string_array_data_) ||
+          !SerializedStringArray::VerifyData(single_kanji_variant_type_data_) ||
+          !SerializedStringArray::VerifyData(
+              single_kanji_variant_string_array_data_) ||
+          !SerializedDictionary::VerifyData(
+              single_kanji_noun_prefix_token_array_data_,
+              single_kanji_noun_prefix_string_array_data_)) {
+        LOG(ERROR) << "Single Kanji data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kA11yDescription:
+      // A11y description dictionary is optional.
+      if (a11y_description_token_array_data_.empty() &&
+          a11y_description_string_array_data_.empty()) {
+        return true;
+      }
+      if (!SerializedDictionary::VerifyData(
+              a11y_description_token_array_data_,
+              a11y_description_string_array_data_)) {
+        LOG(ERROR) << "A11y description dictionary data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kZeroQuery:
+      if (!SerializedStringArray::VerifyData(zero_query_string_array_data_) ||
+          !SerializedStringArray::VerifyData(
+              zero_query_number_string_array_data_)) {
+        LOG(ERROR) << "Zero query data is broken";
+        return false;
+      }
+      return true;
+    case LazySection::kUsage:
+      // Usage dictionary is optional.
+      if (usage_items_data_.empty()) {
+        return true;
+      }
+      if (!SerializedStringArray::VerifyData(usage_string_array_data_)) {
+        LOG(ERROR) << "Usage dictionary's string array is broken";
+        return false;
+      }
+      return true;
+  }
+  return false;
 }
 
 DataManager::Status DataManager::InitUserPosManagerDataFromArray(
@@ -540,6 +806,11 @@ void DataManager::GetReadingCorrectionData(
 void DataManager::GetSymbolRewriterData(
     absl::string_view *token_array_data,
     absl::string_view *string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kSymbol)) {
+    *token_array_data = absl::string_view();
+    *string_array_data = kEmptyStringArray;
+    return;
+  }
   *token_array_data = symbol_token_array_data_;
   *string_array_data = symbol_string_array_data_;
 }
@@ -547,6 +818,11 @@ void DataManager::GetSymbolRewriterData(
 void DataManager::GetEmoticonRewriterData(
     absl::string_view *token_array_data,
     absl::string_view *string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kEmoticon)) {
+    *token_array_data = absl::string_view();
+    *string_array_data = kEmptyStringArray;
+    return;
+  }
   *token_array_data = emoticon_token_array_data_;
   *string_array_data = emoticon_string_array_data_;
 }
@@ -554,6 +830,11 @@ void DataManager::GetEmoticonRewriterData(
 void DataManager::GetEmojiRewriterData(
     absl::string_view *token_array_data,
     absl::string_view *string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kEmoji)) {
+    *token_array_data = absl::string_view();
+    *string_array_data = kEmptyStringArray;
+    return;
+  }
   *token_array_data = emoji_token_array_data_;
   *string_array_data = emoji_string_array_data_;
 }
@@ -565,6 +846,16 @@ void DataManager::GetSingleKanjiRewriterData(
     absl::string_view *variant_string_array_data,
     absl::string_view *noun_prefix_token_array_data,
     absl::string_view *noun_prefix_string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kSingleKanji)) {
+    *token_array_data = absl::string_view();
+    *string_array_data = kEmptyStringArray;
+    *variant_type_array_data = kEmptyStringArray;
+    *variant_token_array_data = absl::string_view();
+    *variant_string_array_data = kEmptyStringArray;
+    *noun_prefix_token_array_data = absl::string_view();
+    *noun_prefix_string_array_data = kEmptyStringArray;
+    return;
+  }
   *token_array_data = single_kanji_token_array_data_;
   *string_array_data = single_kanji_string_array_data_;
   *variant_type_array_data = single_kanji_variant_type_data_;
@@ -577,6 +868,12 @@ void DataManager::GetSingleKanjiRewriterData(
 void DataManager::GetA11yDescriptionRewriterData(
     absl::string_view *token_array_data,
     absl::string_view *string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kA11yDescription)) {
+    // Empty data means that the dictionary is not provided.
+    *token_array_data = absl::string_view();
+    *string_array_data = absl::string_view();
+    return;
+  }
   *token_array_data = a11y_description_token_array_data_;
   *string_array_data = a11y_description_string_array_data_;
 }
@@ -592,6 +889,13 @@ void DataManager::GetZeroQueryData(
     absl::string_view *zero_query_string_array_data,
     absl::string_view *zero_query_number_token_array_data,
     absl::string_view *zero_query_number_string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kZeroQuery)) {
+    *zero_query_token_array_data = absl::string_view();
+    *zero_query_string_array_data = kEmptyStringArray;
+    *zero_query_number_token_array_data = absl::string_view();
+    *zero_query_number_string_array_data = kEmptyStringArray;
+    return;
+  }
   *zero_query_token_array_data = zero_query_token_array_data_;
   *zero_query_string_array_data = zero_query_string_array_data_;
   *zero_query_number_token_array_data = zero_query_number_token_array_data_;
@@ -605,6 +909,15 @@ void DataManager::GetUsageRewriterData(
     absl::string_view *conjugation_index_data,
     absl::string_view *usage_items_data,
     absl::string_view *string_array_data) const {
+  if (!IsLazySectionValid(LazySection::kUsage)) {
+    // The conjugation tables are kept as they are indexed by no usage items.
+    *base_conjugation_suffix_data = usage_base_conjugation_suffix_data_;
+    *conjugation_suffix_data = usage_conjugation_suffix_data_;
+    *conjugation_index_data = usage_conjugation_index_data_;
+    *usage_items_data = absl::string_view();
+    *string_array_data = kEmptyStringArray;
+    return;
+  }
   *base_conjugation_suffix_data = usage_base_conjugation_suffix_data_;
   *conjugation_suffix_data = usage_conjugation_suffix_data_;
   *conjugation_index_data = usage_conjugation_index_data_;
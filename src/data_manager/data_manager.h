@@ -30,6 +30,7 @@
 #ifndef MOZC_DATA_MANAGER_DATA_MANAGER_H_
 #define MOZC_DATA_MANAGER_DATA_MANAGER_H_
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
@@ -38,7 +39,9 @@
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -66,6 +69,34 @@ class DataManager : public DataManagerInterface {
     UNKNOWN = 5,
   };
 
+  // How the pages of a data set section are brought into memory when the data
+  // set is mapped by InitFromFile().
+  enum class SectionLoadPolicy {
+    kLazy,      // Paged in on first access with the default readahead.
+    kRandom,    // Paged in on first access without readahead.
+    kWillNeed,  // Read ahead asynchronously.
+    kPopulate,  // Faulted in before InitFromFile() returns.
+  };
+  // Maps section names to their policies. Unlisted sections are kLazy.
+  using SectionLoadPolicies =
+      absl::flat_hash_map<std::string, SectionLoadPolicy>;
+
+  // Sections used only by particular rewriters and predictors, which may be
+  // compressed. Init*() verifies the uncompressed ones and fails with
+  // DATA_BROKEN if any of them is broken. The compressed ones are decompressed
+  // and verified on the first call of their getters, and one found broken
+  // there is returned as empty data, which disables only its consumer.
+  enum class LazySection {
+    kSymbol,
+    kEmoticon,
+    kEmoji,
+    kSingleKanji,
+    kA11yDescription,
+    kZeroQuery,
+    kUsage,
+  };
+  static constexpr size_t kNumLazySections = 7;
+
   static std::string StatusCodeToString(Status code);
   static absl::string_view GetDataSetMagicNumber(absl::string_view type);
 
@@ -87,9 +118,27 @@ class DataManager : public DataManagerInterface {
   Status InitFromArray(absl::string_view array, absl::string_view magic);
 
   // The same as above InitFromArray() but the data is loaded using mmap, which
-  // is owned in this instance.
+  // is owned in this instance. Sections are paged in according to
+  // DefaultSectionLoadPolicies() unless `policies` is given.
   Status InitFromFile(const std::string &path);
   Status InitFromFile(const std::string &path, absl::string_view magic);
+  Status InitFromFile(const std::string &path, absl::string_view magic,
+                      const SectionLoadPolicies &policies);
+
+  // Returns the default section policies: small tables consulted on every
+  // conversion (e.g., the connection matrix and the segmenter) are populated,
+  // randomly accessed large sections (e.g., the system dictionary) don't read
+  // ahead, and rarely used rewriter data are left lazy.
+  static const SectionLoadPolicies &DefaultSectionLoadPolicies();
+
+  // Returns the options to map the data set in InitFromFile(). The pages are
+  // not locked while --record_data_set_page_profile is set, since locking
+  // makes every page resident and so recorded in the profile.
+  static Mmap::Options DataSetMmapOptions();
+
+  // Decompresses the compressed ones of `sections` ahead of their first use.
+  // Returns false if any of them is broken.
+  bool WarmUpSections(absl::Span<const LazySection> sections) const;
 
   // The same as above InitFromArray() but only parses data set for user pos
   // manager.  For mozc runtime modules, use InitFromArray() because this method
@@ -103,6 +152,13 @@ class DataManager : public DataManagerInterface {
 
   // Implementation of DataManagerInterface.
   std::optional<std::string> GetFilename() const override { return filename_; }
+  absl::Span<const char> GetMappedImage() const override {
+    return filename_.has_value() ? mmap_.span() : absl::Span<const char>();
+  }
+  absl::string_view GetDataSetChecksum() const override {
+    return data_set_checksum_;
+  }
+  bool WarmUpCriticalSections() const override;
   const uint16_t *GetPosMatcherData() const override;
   void GetUserPosData(absl::string_view *token_array_data,
                       absl::string_view *string_array_data) const override;
@@ -165,6 +221,37 @@ class DataManager : public DataManagerInterface {
 
  private:
   Status InitFromReader(const DataSetReader &reader);
+  static void ApplySectionLoadPolicies(const DataSetReader &reader,
+                                       const SectionLoadPolicies &policies);
+
+  // Returns true if `section` is valid. The uncompressed sections are already
+  // verified by Init*(), and a compressed one is decompressed and verified on
+  // the first call.
+  bool IsLazySectionValid(LazySection section) const;
+  bool VerifyLazySection(LazySection section) const;
+
+  // A compressed section, which is decompressed by IsLazySectionValid().
+  struct CompressedSection {
+    LazySection section;
+    // The member pointing to the section data, which is replaced by the
+    // decompressed data.
+    absl::string_view *data;
+    size_t uncompressed_size;
+  };
+
+  // Returns the member holding the lazy section `name` and its group, or
+  // nullptr if `name` is not a lazy section.
+  absl::string_view *GetLazySectionData(absl::string_view name,
+                                        LazySection *section);
+  bool DecompressLazySection(LazySection section) const;
+
+  // The state of the compressed sections, which is replaced by each Init*()
+  // as an absl::once_flag cannot be reset.
+  struct DecompressionState {
+    std::array<absl::once_flag, kNumLazySections> once;
+    std::array<bool, kNumLazySections> valid = {};
+    std::array<std::vector<std::unique_ptr<char[]>>, kNumLazySections> buffers;
+  };
 
   std::optional<std::string> filename_ = std::nullopt;
   Mmap mmap_;
@@ -215,7 +302,12 @@ class DataManager : public DataManagerInterface {
   absl::string_view usage_items_data_;
   absl::string_view usage_string_array_data_;
   absl::string_view data_version_;
+  absl::string_view data_set_checksum_;
   absl::flat_hash_map<std::string, std::pair<size_t, size_t>> offset_and_size_;
+  std::vector<CompressedSection> compressed_sections_;
+  std::array<bool, kNumLazySections> compressed_ = {};
+  // Each section is written only once under its once_flag.
+  std::unique_ptr<DecompressionState> decompression_;
 };
 
 // Print helper for DataManager::Status.  Logging, e.g., CHECK_EQ(), requires
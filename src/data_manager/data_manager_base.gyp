@@ -47,10 +47,63 @@
         '<(mozc_oss_src_dir)/base/base.gyp:serialized_string_array',
         '<(mozc_oss_src_dir)/base/base.gyp:version',
         '<(mozc_oss_src_dir)/protocol/protocol.gyp:segmenter_data_proto',
+        'dataset_compression',
         'dataset_reader',
         'serialized_dictionary',
       ],
     },
+    {
+      'target_name': 'connection_data_builder',
+      'type': 'static_library',
+      'toolsets': [ 'target', 'host' ],
+      'sources': [
+        'connection_data_builder.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_status',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+      ],
+    },
+    {
+      'target_name': 'gen_connection_data_main',
+      'type': 'executable',
+      'toolsets': [ 'host' ],
+      'sources': [
+        'gen_connection_data_main.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/base/base.gyp:base_core',
+        '<(mozc_oss_src_dir)/converter/converter_base.gyp:connector',
+        'connection_data_builder',
+      ],
+    },
+    {
+      'target_name': 'pos_id_renumberer',
+      'type': 'static_library',
+      'toolsets': [ 'target', 'host' ],
+      'sources': [
+        'pos_id_renumberer.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_status',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+      ],
+    },
+    {
+      'target_name': 'renumber_pos_ids_main',
+      'type': 'executable',
+      'toolsets': [ 'host' ],
+      'sources': [
+        'renumber_pos_ids_main.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/base/base.gyp:base_core',
+        'pos_id_renumberer',
+      ],
+    },
     {
       'target_name': 'genproto_dataset_proto',
       'type': 'none',
@@ -78,6 +131,17 @@
         'genproto_dataset_proto#host',
       ],
     },
+    {
+      'target_name': 'dataset_compression',
+      'type': 'static_library',
+      'toolsets': [ 'target', 'host' ],
+      'sources': [
+        'dataset_compression.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+      ],
+    },
     {
       'target_name': 'dataset_writer',
       'type': 'static_library',
@@ -89,6 +153,7 @@
         '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
         '<(mozc_oss_src_dir)/base/base.gyp:base',
         '<(mozc_oss_src_dir)/base/base.gyp:obfuscator_support',
+        'dataset_compression',
         'dataset_proto',
       ],
     },
@@ -117,7 +182,53 @@
         '<(mozc_oss_src_dir)/base/base.gyp:base',
         '<(mozc_oss_src_dir)/base/base.gyp:base_core',
         '<(mozc_oss_src_dir)/base/base.gyp:number_util',
+        'dataset_patcher',
+        'dataset_proto',
+        'dataset_writer',
+      ],
+    },
+    {
+      'target_name': 'dataset_patcher',
+      'type': 'static_library',
+      'toolsets': [ 'target', 'host' ],
+      'sources': [
+        'dataset_patcher.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_status',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        'dataset_compression',
         'dataset_proto',
+        'dataset_reader',
+        'dataset_writer',
+      ],
+    },
+    {
+      'target_name': 'dataset_page_profile',
+      'type': 'static_library',
+      'sources': [
+        'dataset_page_profile.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_status',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+      ],
+    },
+    {
+      'target_name': 'derived_data_cache',
+      'type': 'static_library',
+      'sources': [
+        'derived_data_cache.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_flags',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_random',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_status',
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        'dataset_reader',
         'dataset_writer',
       ],
     },
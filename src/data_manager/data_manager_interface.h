@@ -55,6 +55,19 @@ class DataManagerInterface {
     return std::nullopt;
   }
 
+  // Returns the image of the data set mapped from the file returned by
+  // GetFilename(). This is empty if it is loaded from memory blob.
+  virtual absl::Span<const char> GetMappedImage() const { return {}; }
+
+  // Returns the SHA1 checksum recorded in the data set, which identifies the
+  // data set. This may be empty if it is unknown.
+  virtual absl::string_view GetDataSetChecksum() const { return {}; }
+
+  // Prepares the data sections used on every conversion or prediction ahead of
+  // their first use, e.g., from a background thread after the engine is built.
+  // Returns false if any of them is broken.
+  virtual bool WarmUpCriticalSections() const { return true; }
+
   // Returns data set for UserPos.
   virtual void GetUserPosData(absl::string_view *token_array_data,
                               absl::string_view *string_array_data) const = 0;
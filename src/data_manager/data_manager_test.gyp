@@ -50,6 +50,34 @@
         'data_manager.gyp:connection_file_reader',
       ],
     },
+    {
+      'target_name': 'connection_data_builder_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'connection_data_builder_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_random',
+        '<(mozc_oss_src_dir)/converter/converter_base.gyp:connector',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:connection_data_builder',
+      ],
+    },
+    {
+      'target_name': 'pos_id_renumberer_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'pos_id_renumberer_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:pos_id_renumberer',
+      ],
+    },
     {
       'target_name': 'dataset_writer_test',
       'type': 'executable',
@@ -62,6 +90,7 @@
         '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
         '<(mozc_oss_src_dir)/testing/testing.gyp:mozctest',
         '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:dataset_compression',
         'data_manager_base.gyp:dataset_proto',
         'data_manager_base.gyp:dataset_writer',
       ],
@@ -84,6 +113,66 @@
         'data_manager_base.gyp:dataset_writer',
       ],
     },
+    {
+      'target_name': 'dataset_compression_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'dataset_compression_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:dataset_compression',
+      ],
+    },
+    {
+      'target_name': 'dataset_patcher_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'dataset_patcher_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:dataset_patcher',
+        'data_manager_base.gyp:dataset_proto',
+        'data_manager_base.gyp:dataset_writer',
+      ],
+    },
+    {
+      'target_name': 'dataset_page_profile_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'dataset_page_profile_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:dataset_page_profile',
+      ],
+    },
+    {
+      'target_name': 'derived_data_cache_test',
+      'type': 'executable',
+      'toolsets': [ 'target' ],
+      'sources': [
+        'derived_data_cache_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/data_manager/testing/mock_data_manager.gyp:mock_data_manager',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:testing',
+        'data_manager_base.gyp:derived_data_cache',
+      ],
+    },
     {
       'target_name': 'serialized_dictionary_test',
       'type': 'executable',
@@ -0,0 +1,182 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_compression.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 0xFFFF;
+constexpr size_t kLengthMask = 15;
+constexpr int kHashBits = 16;
+
+uint32_t Load32(absl::string_view data, size_t pos) {
+  uint32_t value;
+  std::memcpy(&value, data.data() + pos, sizeof(value));
+  return value;
+}
+
+size_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+void AppendLength(size_t length, std::string *output) {
+  if (length < kLengthMask) {
+    return;
+  }
+  length -= kLengthMask;
+  for (; length >= 255; length -= 255) {
+    output->push_back(static_cast<char>(255));
+  }
+  output->push_back(static_cast<char>(length));
+}
+
+// Appends a record. `match_length` is zero for the last record.
+void AppendRecord(absl::string_view literals, size_t offset,
+                  size_t match_length, std::string *output) {
+  const size_t match_code = match_length == 0 ? 0 : match_length - kMinMatch;
+  const size_t literal_token = std::min(literals.size(), kLengthMask);
+  const size_t match_token = std::min(match_code, kLengthMask);
+  output->push_back(static_cast<char>(literal_token << 4 | match_token));
+  AppendLength(literals.size(), output);
+  output->append(literals.data(), literals.size());
+  if (match_length == 0) {
+    return;
+  }
+  output->push_back(static_cast<char>(offset & 0xFF));
+  output->push_back(static_cast<char>(offset >> 8));
+  AppendLength(match_code, output);
+}
+
+// Reads the continued length after the token. Returns false on the end of
+// the input.
+bool ReadLength(absl::string_view input, size_t *pos, size_t *length) {
+  if (*length < kLengthMask) {
+    return true;
+  }
+  while (*pos < input.size()) {
+    const uint8_t byte = input[(*pos)++];
+    *length += byte;
+    if (byte < 255) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+std::string DataSetCompression::Compress(absl::string_view data) {
+  std::string output;
+  output.reserve(data.size() / 2);
+  // Positions plus one of the last occurrences of the 4-byte sequences.
+  std::vector<uint32_t> table(size_t{1} << kHashBits, 0);
+
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + kMinMatch <= data.size()) {
+    const uint32_t sequence = Load32(data, pos);
+    uint32_t &entry = table[Hash(sequence)];
+    const size_t candidate = entry;
+    entry = pos + 1;
+    if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+        Load32(data, candidate - 1) != sequence) {
+      ++pos;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t length = kMinMatch;
+    while (pos + length < data.size() &&
+           data[match + length] == data[pos + length]) {
+      ++length;
+    }
+    AppendRecord(data.substr(anchor, pos - anchor), pos - match, length,
+                 &output);
+    pos += length;
+    anchor = pos;
+  }
+  AppendRecord(data.substr(anchor), 0, 0, &output);
+  return output;
+}
+
+bool DataSetCompression::Decompress(absl::string_view compressed,
+                                    absl::Span<char> output) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < compressed.size()) {
+    const uint8_t token = compressed[in++];
+
+    size_t literal_length = token >> 4;
+    if (!ReadLength(compressed, &in, &literal_length) ||
+        literal_length > compressed.size() - in ||
+        literal_length > output.size() - out) {
+      return false;
+    }
+    std::memcpy(output.data() + out, compressed.data() + in, literal_length);
+    in += literal_length;
+    out += literal_length;
+    if (in == compressed.size()) {
+      // The last record.
+      return (token & kLengthMask) == 0 && out == output.size();
+    }
+
+    if (compressed.size() - in < 2) {
+      return false;
+    }
+    const size_t offset = static_cast<uint8_t>(compressed[in]) |
+                          static_cast<uint8_t>(compressed[in + 1]) << 8;
+    in += 2;
+    size_t match_length = token & kLengthMask;
+    if (!ReadLength(compressed, &in, &match_length)) {
+      return false;
+    }
+    match_length += kMinMatch;
+    if (offset == 0 || offset > out || match_length > output.size() - out) {
+      return false;
+    }
+    // The match may overlap the output being written, so copy byte by byte.
+    for (size_t i = 0; i < match_length; ++i, ++out) {
+      output[out] = output[out - offset];
+    }
+  }
+  return false;
+}
+
+}  // namespace mozc
@@ -0,0 +1,68 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_DATASET_COMPRESSION_H_
+#define MOZC_DATA_MANAGER_DATASET_COMPRESSION_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+
+// A byte-oriented LZ77 block codec for the compressed sections of a data set
+// (DataSetMetadata::LZ77_BLOCK). It trades the compression ratio for a small
+// and fast decoder, as the sections are decompressed on the first use in the
+// converter process.
+//
+// The compressed data is a sequence of the following records:
+//
+//   token (1 byte): the upper 4 bits are the number of literals and the lower
+//                   4 bits are the match length minus 4. 15 means that the
+//                   length continues in the following bytes.
+//   [literal length continued]: bytes of 255 terminated by a byte < 255.
+//   literals
+//   offset (2 bytes, little endian): the distance to the match. Omitted in the
+//                                    last record, which has no match.
+//   [match length continued]
+class DataSetCompression {
+ public:
+  DataSetCompression() = delete;
+
+  static std::string Compress(absl::string_view data);
+
+  // Decompresses `compressed` into `output`, whose size must be the size of
+  // the original data. Returns false if the data is broken.
+  static bool Decompress(absl::string_view compressed, absl::Span<char> output);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_DATASET_COMPRESSION_H_
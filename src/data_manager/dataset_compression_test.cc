@@ -0,0 +1,115 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_compression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+std::string RoundTrip(absl::string_view data) {
+  const std::string compressed = DataSetCompression::Compress(data);
+  std::vector<char> output(data.size());
+  EXPECT_TRUE(
+      DataSetCompression::Decompress(compressed, absl::MakeSpan(output)));
+  return std::string(output.begin(), output.end());
+}
+
+TEST(DataSetCompressionTest, RoundTrip) {
+  const std::string inputs[] = {
+      "",
+      "a",
+      "abc",
+      "abcd",
+      "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+      std::string(100000, '\0'),
+      absl::StrCat(std::string(300, 'x'), "literal", std::string(1000, 'y')),
+  };
+  for (const std::string &input : inputs) {
+    EXPECT_EQ(RoundTrip(input), input);
+  }
+
+  std::string text;
+  for (int i = 0; i < 10000; ++i) {
+    absl::StrAppend(&text, "エントリ", i % 97, "\t", i * 31 % 1000, "\n");
+  }
+  const std::string compressed = DataSetCompression::Compress(text);
+  EXPECT_LT(compressed.size(), text.size() / 2);
+  EXPECT_EQ(RoundTrip(text), text);
+
+  // Incompressible data grows only slightly.
+  std::string random;
+  uint32_t x = 12345;
+  for (int i = 0; i < 10000; ++i) {
+    x = x * 1103515245 + 12345;
+    random.push_back(static_cast<char>(x >> 24));
+  }
+  EXPECT_LT(DataSetCompression::Compress(random).size(), random.size() + 100);
+  EXPECT_EQ(RoundTrip(random), random);
+}
+
+TEST(DataSetCompressionTest, BrokenData) {
+  const std::string data = absl::StrCat(std::string(1000, 'a'), "bcdefg",
+                                        std::string(1000, 'a'));
+  const std::string compressed = DataSetCompression::Compress(data);
+  std::vector<char> output(data.size());
+
+  // Wrong output sizes.
+  std::vector<char> shorter(data.size() - 1), longer(data.size() + 1);
+  EXPECT_FALSE(
+      DataSetCompression::Decompress(compressed, absl::MakeSpan(shorter)));
+  EXPECT_FALSE(
+      DataSetCompression::Decompress(compressed, absl::MakeSpan(longer)));
+
+  // Truncated data.
+  for (size_t size = 0; size < compressed.size(); ++size) {
+    EXPECT_FALSE(DataSetCompression::Decompress(compressed.substr(0, size),
+                                                absl::MakeSpan(output)));
+  }
+
+  // Invalid offsets.
+  EXPECT_FALSE(DataSetCompression::Decompress(
+      absl::string_view("\x10" "a" "\x00\x00" "\x00", 5),
+      absl::MakeSpan(output)));
+  EXPECT_FALSE(DataSetCompression::Decompress(
+      absl::string_view("\x10" "a" "\x02\x00" "\x00", 5),
+      absl::MakeSpan(output)));
+}
+
+}  // namespace
+}  // namespace mozc
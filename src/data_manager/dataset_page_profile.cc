@@ -0,0 +1,225 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_page_profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/bits.h"
+#include "base/mmap.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif  // _WIN32
+
+namespace mozc {
+namespace {
+
+// Serialized format (native byte order):
+//   char[4]  magic
+//   uint32_t format version
+//   uint64_t image size
+//   uint32_t page size
+//   uint32_t number of ranges
+//   { uint32_t first page, uint32_t number of pages } * number of ranges
+constexpr absl::string_view kMagic = "MZPP";
+constexpr uint32_t kFormatVersion = 1;
+constexpr size_t kHeaderSize = 4 + 4 + 8 + 4 + 4;
+constexpr size_t kRangeSize = 2 * sizeof(uint32_t);
+
+// Bounds of the header, which is read from a file writable by the user. The
+// page size is a power of two, and the pages of the image are indexed by
+// uint32_t. A data set is far smaller than kMaxImageSize.
+constexpr uint32_t kMinPageSize = 512;
+constexpr uint32_t kMaxPageSize = uint32_t{1} << 30;
+constexpr uint64_t kMaxImageSize = uint64_t{1} << 32;
+
+// WarmUp() checks the cancellation at least once per this many pages.
+constexpr size_t kWarmUpChunkPages = 256;
+
+}  // namespace
+
+absl::StatusOr<DataSetPageProfile> DataSetPageProfile::Parse(
+    absl::string_view data) {
+  if (data.size() < kHeaderSize || !absl::StartsWith(data, kMagic)) {
+    return absl::InvalidArgumentError("Not a data set page profile");
+  }
+  const char *iter = data.data() + kMagic.size();
+  if (LoadUnalignedAdvance<uint32_t>(iter) != kFormatVersion) {
+    return absl::InvalidArgumentError("Unsupported page profile version");
+  }
+  DataSetPageProfile profile;
+  profile.image_size_ = LoadUnalignedAdvance<uint64_t>(iter);
+  profile.page_size_ = LoadUnalignedAdvance<uint32_t>(iter);
+  const uint32_t num_ranges = LoadUnalignedAdvance<uint32_t>(iter);
+  if (profile.page_size_ < kMinPageSize || profile.page_size_ > kMaxPageSize ||
+      !absl::has_single_bit(profile.page_size_) ||
+      profile.image_size_ > kMaxImageSize) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Broken page profile header: %d bytes of %d-byte pages",
+                        profile.image_size_, profile.page_size_));
+  }
+  if ((data.size() - kHeaderSize) % kRangeSize != 0 ||
+      (data.size() - kHeaderSize) / kRangeSize != num_ranges) {
+    return absl::InvalidArgumentError("Broken page profile");
+  }
+  const size_t num_pages =
+      (profile.image_size_ + profile.page_size_ - 1) / profile.page_size_;
+  profile.pages_.assign(num_pages, false);
+  for (uint32_t i = 0; i < num_ranges; ++i) {
+    const uint32_t first = LoadUnalignedAdvance<uint32_t>(iter);
+    const uint32_t size = LoadUnalignedAdvance<uint32_t>(iter);
+    if (first > num_pages || size > num_pages - first) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Page range [%d, +%d) is out of bounds (%d pages)",
+                          first, size, num_pages));
+    }
+    for (size_t page = first; page < first + size; ++page) {
+      if (!profile.pages_[page]) {
+        profile.pages_[page] = true;
+        ++profile.num_recorded_pages_;
+      }
+    }
+  }
+  return profile;
+}
+
+std::string DataSetPageProfile::Serialize() const {
+  const std::vector<std::pair<size_t, size_t>> ranges = GetPageRanges();
+  std::string result(kHeaderSize + ranges.size() * kRangeSize, '\0');
+  auto iter = result.begin();
+  iter = std::copy(kMagic.begin(), kMagic.end(), iter);
+  iter = StoreUnaligned<uint32_t>(kFormatVersion, iter);
+  iter = StoreUnaligned<uint64_t>(image_size_, iter);
+  iter = StoreUnaligned<uint32_t>(page_size_, iter);
+  iter = StoreUnaligned<uint32_t>(static_cast<uint32_t>(ranges.size()), iter);
+  for (const auto &[begin, end] : ranges) {
+    iter = StoreUnaligned<uint32_t>(static_cast<uint32_t>(begin), iter);
+    iter = StoreUnaligned<uint32_t>(static_cast<uint32_t>(end - begin), iter);
+  }
+  return result;
+}
+
+absl::Status DataSetPageProfile::Record(absl::Span<const char> image) {
+#ifdef _WIN32
+  return absl::UnimplementedError("mincore() is not available");
+#else   // _WIN32
+  if (image.empty()) {
+    return absl::InvalidArgumentError("The data set is not mapped");
+  }
+  const long page_size = sysconf(_SC_PAGESIZE);  // NOLINT
+  if (page_size <= 0) {
+    return absl::ErrnoToStatus(errno, "sysconf(_SC_PAGESIZE) failed");
+  }
+  if (reinterpret_cast<uintptr_t>(image.data()) % page_size != 0) {
+    return absl::InvalidArgumentError("The image is not page-aligned");
+  }
+  const size_t num_pages = (image.size() + page_size - 1) / page_size;
+#ifdef __APPLE__
+  std::vector<char> residency(num_pages);
+#else   // __APPLE__
+  std::vector<unsigned char> residency(num_pages);
+#endif  // __APPLE__
+  if (mincore(const_cast<char *>(image.data()), image.size(),
+              residency.data()) != 0) {
+    return absl::ErrnoToStatus(errno, "mincore() failed");
+  }
+
+  if (image_size_ != image.size() || page_size_ != page_size) {
+    // The data set has been replaced.
+    image_size_ = image.size();
+    page_size_ = page_size;
+    num_recorded_pages_ = 0;
+    pages_.assign(num_pages, false);
+  }
+  for (size_t i = 0; i < num_pages; ++i) {
+    if ((residency[i] & 1) && !pages_[i]) {
+      pages_[i] = true;
+      ++num_recorded_pages_;
+    }
+  }
+  return absl::OkStatus();
+#endif  // _WIN32
+}
+
+absl::Status DataSetPageProfile::WarmUp(
+    absl::Span<const char> image, const std::atomic<bool> &cancelled) const {
+  if (image.size() != image_size_) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "The profile is recorded for an image of %d bytes, but got %d bytes",
+        image_size_, image.size()));
+  }
+  for (const auto &[begin, end] : GetPageRanges()) {
+    for (size_t page = begin; page < end; page += kWarmUpChunkPages) {
+      if (cancelled.load(std::memory_order_relaxed)) {
+        return absl::CancelledError("Warm-up is cancelled");
+      }
+      const size_t offset = page * page_size_;
+      const size_t limit = std::min(page + kWarmUpChunkPages, end) * page_size_;
+      Mmap::Prefetch(image.data() + offset,
+                     std::min<size_t>(limit, image.size()) - offset);
+    }
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::pair<size_t, size_t>> DataSetPageProfile::GetPageRanges()
+    const {
+  std::vector<std::pair<size_t, size_t>> ranges;
+  for (size_t i = 0; i < pages_.size();) {
+    if (!pages_[i]) {
+      ++i;
+      continue;
+    }
+    const size_t begin = i;
+    while (i < pages_.size() && pages_[i]) {
+      ++i;
+    }
+    ranges.emplace_back(begin, i);
+  }
+  return ranges;
+}
+
+}  // namespace mozc
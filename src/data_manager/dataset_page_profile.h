@@ -0,0 +1,110 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_DATASET_PAGE_PROFILE_H_
+#define MOZC_DATA_MANAGER_DATASET_PAGE_PROFILE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+
+// Records which pages of a mapped data set are used during a representative
+// session, so that they can be read in file order on later startups instead of
+// being faulted in one by one at random positions.
+//
+// Pages are recorded by sampling the residency of the mapped image with
+// mincore(), so Record() should be called periodically while the engine is
+// used. Recording is not supported on Windows. Note that every page of an
+// mlock()ed image is resident, so the image should be mapped without mlock
+// while recording.
+//
+// Usage:
+//   // While recording (e.g., on every sync).
+//   profile.Record(data_manager.GetMappedImage());
+//   Save(profile.Serialize());
+//
+//   // After the data set is mapped, in the background.
+//   absl::StatusOr<DataSetPageProfile> profile =
+//       DataSetPageProfile::Parse(Load());
+//   profile->WarmUp(data_manager.GetMappedImage());
+class DataSetPageProfile {
+ public:
+  DataSetPageProfile() = default;
+
+  DataSetPageProfile(const DataSetPageProfile &) = default;
+  DataSetPageProfile &operator=(const DataSetPageProfile &) = default;
+  DataSetPageProfile(DataSetPageProfile &&) = default;
+  DataSetPageProfile &operator=(DataSetPageProfile &&) = default;
+
+  // Parses the data returned by Serialize().
+  static absl::StatusOr<DataSetPageProfile> Parse(absl::string_view data);
+  std::string Serialize() const;
+
+  // Adds the currently resident pages of `image` to the profile. `image` must
+  // be an entire data set file mapped at a page boundary. If its size differs
+  // from the recorded one (i.e., the data set has been updated), the previous
+  // records are discarded.
+  absl::Status Record(absl::Span<const char> image);
+
+  // Faults in the recorded pages of `image` in ascending order, which turns the
+  // random reads on the first conversions into a sequential read. Blocks until
+  // all the pages are read, so run it in the background. Stops early when
+  // `cancelled` becomes true. Fails if the profile was recorded for an image of
+  // a different size.
+  absl::Status WarmUp(absl::Span<const char> image,
+                      const std::atomic<bool> &cancelled) const;
+
+  // Returns the recorded pages as pairs of [first page, end page).
+  std::vector<std::pair<size_t, size_t>> GetPageRanges() const;
+
+  bool empty() const { return num_recorded_pages_ == 0; }
+  uint64_t image_size() const { return image_size_; }
+  uint32_t page_size() const { return page_size_; }
+  size_t num_recorded_pages() const { return num_recorded_pages_; }
+
+ private:
+  uint64_t image_size_ = 0;
+  uint32_t page_size_ = 0;
+  size_t num_recorded_pages_ = 0;
+  std::vector<bool> pages_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_DATASET_PAGE_PROFILE_H_
@@ -0,0 +1,183 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_page_profile.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/file/temp_dir.h"
+#include "base/file_util.h"
+#include "base/mmap.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+TEST(DataSetPageProfileTest, ParseInvalidData) {
+  EXPECT_FALSE(DataSetPageProfile::Parse("").ok());
+  EXPECT_FALSE(DataSetPageProfile::Parse("not a profile").ok());
+
+  // A default profile has no page size and cannot be parsed.
+  EXPECT_FALSE(DataSetPageProfile::Parse(DataSetPageProfile().Serialize()).ok());
+}
+
+// Returns a serialized profile with no page ranges.
+std::string MakeHeader(const uint64_t image_size, const uint32_t page_size) {
+  constexpr uint32_t kVersion = 1;
+  constexpr uint32_t kNumRanges = 0;
+  std::string header = "MZPP";
+  header.append(reinterpret_cast<const char *>(&kVersion), sizeof(kVersion));
+  header.append(reinterpret_cast<const char *>(&image_size),
+                sizeof(image_size));
+  header.append(reinterpret_cast<const char *>(&page_size), sizeof(page_size));
+  header.append(reinterpret_cast<const char *>(&kNumRanges),
+                sizeof(kNumRanges));
+  return header;
+}
+
+TEST(DataSetPageProfileTest, ParseCorruptHeader) {
+  absl::StatusOr<DataSetPageProfile> profile =
+      DataSetPageProfile::Parse(MakeHeader(100000, 4096));
+  ASSERT_OK(profile);
+  EXPECT_EQ(profile->image_size(), 100000);
+  EXPECT_EQ(profile->page_size(), 4096);
+
+  // Too many pages to allocate.
+  EXPECT_FALSE(DataSetPageProfile::Parse(MakeHeader(uint64_t{1} << 40, 1024))
+                   .ok());
+  // The number of pages overflows.
+  EXPECT_FALSE(
+      DataSetPageProfile::Parse(MakeHeader(~uint64_t{0}, 4096)).ok());
+  // Broken page sizes.
+  EXPECT_FALSE(DataSetPageProfile::Parse(MakeHeader(100000, 1)).ok());
+  EXPECT_FALSE(DataSetPageProfile::Parse(MakeHeader(100000, 4095)).ok());
+  EXPECT_FALSE(DataSetPageProfile::Parse(MakeHeader(100000, 1u << 31)).ok());
+
+  // The ranges don't match the number in the header.
+  std::string truncated = MakeHeader(100000, 4096);
+  truncated.append(4, '\0');
+  EXPECT_FALSE(DataSetPageProfile::Parse(truncated).ok());
+}
+
+TEST(DataSetPageProfileTest, WarmUpFailsForDifferentImage) {
+  const std::string image(100, 'x');
+  const std::atomic<bool> cancelled = false;
+  DataSetPageProfile profile;
+  EXPECT_EQ(profile.WarmUp(image, cancelled).code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
+#ifndef _WIN32
+class DataSetPageProfileRecordTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    absl::StatusOr<TempFile> temp_file =
+        TempDirectory::Default().CreateTempFile();
+    ASSERT_OK(temp_file);
+    temp_file_ = *std::move(temp_file);
+    const std::string contents(kNumPages * kPageSize - 10, 'x');
+    ASSERT_OK(FileUtil::SetContents(temp_file_->path(), contents));
+    absl::StatusOr<Mmap> mmap = Mmap::Map(temp_file_->path(), Mmap::READ_ONLY,
+                                          {.mlock = false});
+    ASSERT_OK(mmap);
+    mmap_ = *std::move(mmap);
+  }
+
+  // The page size is at least 4KiB on supported platforms, so the image has at
+  // most kNumPages pages.
+  static constexpr size_t kPageSize = 4096;
+  static constexpr size_t kNumPages = 8;
+
+  std::optional<TempFile> temp_file_;
+  Mmap mmap_;
+};
+
+TEST_F(DataSetPageProfileRecordTest, RecordAndSerialize) {
+  Mmap::Prefetch(mmap_.begin(), mmap_.size());
+  DataSetPageProfile profile;
+  ASSERT_OK(profile.Record(mmap_.span()));
+  EXPECT_EQ(profile.image_size(), mmap_.size());
+  EXPECT_FALSE(profile.empty());
+  const size_t num_pages =
+      (mmap_.size() + profile.page_size() - 1) / profile.page_size();
+  EXPECT_EQ(profile.num_recorded_pages(), num_pages);
+  EXPECT_THAT(profile.GetPageRanges(), ElementsAre(Pair(0, num_pages)));
+
+  absl::StatusOr<DataSetPageProfile> parsed =
+      DataSetPageProfile::Parse(profile.Serialize());
+  ASSERT_OK(parsed);
+  EXPECT_EQ(parsed->image_size(), profile.image_size());
+  EXPECT_EQ(parsed->page_size(), profile.page_size());
+  EXPECT_EQ(parsed->num_recorded_pages(), profile.num_recorded_pages());
+  EXPECT_EQ(parsed->GetPageRanges(), profile.GetPageRanges());
+
+  const std::atomic<bool> cancelled = false;
+  EXPECT_OK(parsed->WarmUp(mmap_.span(), cancelled));
+}
+
+TEST_F(DataSetPageProfileRecordTest, WarmUpCancelled) {
+  Mmap::Prefetch(mmap_.begin(), mmap_.size());
+  DataSetPageProfile profile;
+  ASSERT_OK(profile.Record(mmap_.span()));
+  const std::atomic<bool> cancelled = true;
+  EXPECT_EQ(profile.WarmUp(mmap_.span(), cancelled).code(),
+            absl::StatusCode::kCancelled);
+}
+
+TEST_F(DataSetPageProfileRecordTest, RecordResetsForDifferentImage) {
+  Mmap::Prefetch(mmap_.begin(), mmap_.size());
+  DataSetPageProfile profile;
+  ASSERT_OK(profile.Record(mmap_.span()));
+  ASSERT_OK(profile.Record(mmap_.span().subspan(0, 10)));
+  EXPECT_EQ(profile.image_size(), 10);
+  EXPECT_THAT(profile.GetPageRanges(), ElementsAre(Pair(0, 1)));
+}
+
+TEST_F(DataSetPageProfileRecordTest, RecordFailsForUnalignedImage) {
+  DataSetPageProfile profile;
+  EXPECT_FALSE(profile.Record(mmap_.span().subspan(1)).ok());
+  EXPECT_FALSE(profile.Record({}).ok());
+}
+#endif  // _WIN32
+
+}  // namespace
+}  // namespace mozc
@@ -0,0 +1,326 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_patcher.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/numeric/bits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/vlog.h"
+#include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_compression.h"
+#include "data_manager/dataset_reader.h"
+#include "data_manager/dataset_writer.h"
+
+namespace mozc {
+namespace {
+
+// The unit of matching between the base and the target. Shorter blocks find
+// more matches in small edits at the cost of the index size.
+constexpr size_t kBlockSize = 32;
+
+// Returns the smallest alignment in bits with which DataSetWriter places a
+// section ending at `end` to `offset`.
+std::optional<uint32_t> GetAlignment(size_t end, size_t offset) {
+  for (size_t alignment = 1; alignment <= std::max<size_t>(offset, 1);
+       alignment *= 2) {
+    if (offset % alignment == 0 && offset >= end &&
+        offset - end < alignment) {
+      return alignment * 8;
+    }
+  }
+  return std::nullopt;
+}
+
+bool IsValidAlignment(uint32_t a) {
+  return a >= 8 && absl::has_single_bit(a);
+}
+
+void AddCopy(size_t offset, size_t size, DataSetPatch::Section *section) {
+  if (size == 0) {
+    return;
+  }
+  if (section->operations_size() > 0) {
+    DataSetPatch::Operation *last = section->mutable_operations(
+        section->operations_size() - 1);
+    if (last->copy_size() > 0 &&
+        last->copy_offset() + last->copy_size() == offset) {
+      last->set_copy_size(last->copy_size() + size);
+      return;
+    }
+  }
+  DataSetPatch::Operation *op = section->add_operations();
+  op->set_copy_offset(offset);
+  op->set_copy_size(size);
+}
+
+void AddInsert(absl::string_view data, DataSetPatch::Section *section) {
+  if (data.empty()) {
+    return;
+  }
+  if (section->operations_size() > 0) {
+    DataSetPatch::Operation *last = section->mutable_operations(
+        section->operations_size() - 1);
+    if (last->copy_size() == 0) {
+      last->mutable_insert()->append(data.data(), data.size());
+      return;
+    }
+  }
+  section->add_operations()->set_insert(data.data(), data.size());
+}
+
+// Appends the operations building `target` from `base`. The blocks of `base`
+// are indexed, and each match found at a position of `target` is extended in
+// both directions. The bytes between the matches are inserted.
+void AppendDelta(absl::string_view base, absl::string_view target,
+                 DataSetPatch::Section *section) {
+  if (base == target) {
+    AddCopy(0, base.size(), section);
+    return;
+  }
+
+  absl::flat_hash_map<absl::string_view, size_t> blocks;
+  blocks.reserve(base.size() / kBlockSize);
+  for (size_t i = 0; i + kBlockSize <= base.size(); i += kBlockSize) {
+    blocks.try_emplace(base.substr(i, kBlockSize), i);
+  }
+
+  size_t inserted = 0;  // The end of the target already emitted.
+  size_t pos = 0;
+  while (pos + kBlockSize <= target.size()) {
+    const auto it = blocks.find(target.substr(pos, kBlockSize));
+    if (it == blocks.end()) {
+      ++pos;
+      continue;
+    }
+    size_t base_begin = it->second;
+    size_t target_begin = pos;
+    while (target_begin > inserted && base_begin > 0 &&
+           base[base_begin - 1] == target[target_begin - 1]) {
+      --base_begin;
+      --target_begin;
+    }
+    size_t size = pos - target_begin + kBlockSize;
+    while (target_begin + size < target.size() &&
+           base_begin + size < base.size() &&
+           base[base_begin + size] == target[target_begin + size]) {
+      ++size;
+    }
+    AddInsert(target.substr(inserted, target_begin - inserted), section);
+    AddCopy(base_begin, size, section);
+    inserted = pos = target_begin + size;
+  }
+  AddInsert(target.substr(inserted), section);
+}
+
+// Returns the uncompressed data of the section `name`, or an empty data if the
+// section doesn't exist. `buffer` holds the data if decompressed.
+absl::StatusOr<absl::string_view> GetUncompressedData(
+    const DataSetReader &reader, absl::string_view name, std::string *buffer) {
+  absl::string_view data;
+  if (!reader.Get(name, &data)) {
+    return absl::string_view();
+  }
+  for (const DataSetMetadata::Entry &entry : reader.metadata().entries()) {
+    if (entry.name() != name ||
+        entry.compression() == DataSetMetadata::NO_COMPRESSION) {
+      continue;
+    }
+    // Each byte of the compressed data expands to at most 255 bytes.
+    if (entry.uncompressed_size() / 255 > data.size()) {
+      return absl::DataLossError(absl::StrCat("Broken size of ", name));
+    }
+    buffer->resize(entry.uncompressed_size());
+    if (!DataSetCompression::Decompress(data, absl::MakeSpan(*buffer))) {
+      return absl::DataLossError(absl::StrCat("Broken section: ", name));
+    }
+    return absl::string_view(*buffer);
+  }
+  return data;
+}
+
+}  // namespace
+
+absl::StatusOr<DataSetPatch> DataSetPatcher::CreatePatch(
+    absl::string_view base, absl::string_view target,
+    absl::string_view magic) {
+  DataSetReader base_reader, target_reader;
+  if (!base_reader.Init(base, magic)) {
+    return absl::InvalidArgumentError("Broken base data set");
+  }
+  if (!target_reader.Init(target, magic)) {
+    return absl::InvalidArgumentError("Broken target data set");
+  }
+
+  DataSetPatch patch;
+  patch.set_magic(magic.data(), magic.size());
+  patch.set_base_checksum(base_reader.GetChecksum().data(),
+                          base_reader.GetChecksum().size());
+  patch.set_checksum(target_reader.GetChecksum().data(),
+                     target_reader.GetChecksum().size());
+
+  patch.set_page_size(target_reader.metadata().page_size());
+
+  size_t end = magic.size();
+  for (const DataSetMetadata::Entry &entry :
+       target_reader.metadata().entries()) {
+    const std::optional<uint32_t> alignment =
+        GetAlignment(end, entry.offset());
+    if (!alignment.has_value()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unexpected offset of ", entry.name()));
+    }
+    end = entry.offset() + entry.size();
+
+    std::string base_buffer, target_buffer;
+    absl::StatusOr<absl::string_view> base_data =
+        GetUncompressedData(base_reader, entry.name(), &base_buffer);
+    absl::StatusOr<absl::string_view> target_data =
+        GetUncompressedData(target_reader, entry.name(), &target_buffer);
+    if (!base_data.ok()) {
+      return base_data.status();
+    }
+    if (!target_data.ok()) {
+      return target_data.status();
+    }
+
+    DataSetPatch::Section *section = patch.add_sections();
+    section->set_name(entry.name());
+    section->set_alignment(*alignment);
+    section->set_size(target_data->size());
+    if (entry.has_temperature()) {
+      section->set_temperature(entry.temperature());
+    }
+    if (entry.has_compression()) {
+      section->set_compression(entry.compression());
+    }
+    AppendDelta(*base_data, *target_data, section);
+    MOZC_VLOG(1) << entry.name() << ": " << section->operations_size()
+                 << " operations";
+  }
+  return patch;
+}
+
+absl::StatusOr<std::string> DataSetPatcher::ApplyPatch(
+    absl::string_view base, const DataSetPatch &patch) {
+  DataSetReader base_reader;
+  if (!base_reader.Init(base, patch.magic())) {
+    return absl::InvalidArgumentError("Broken base data set");
+  }
+  if (base_reader.GetChecksum() != patch.base_checksum()) {
+    return absl::FailedPreconditionError(
+        "The patch was created for another data set");
+  }
+
+  if (patch.page_size() > 0 && !absl::has_single_bit(patch.page_size())) {
+    return absl::InvalidArgumentError("Invalid page size");
+  }
+  // The sections are already ordered by temperature in the page-aligned
+  // layout, which the writer keeps.
+  DataSetWriter writer(patch.magic(), {.page_size = patch.page_size()});
+  absl::flat_hash_set<absl::string_view> seen_names;
+  for (const DataSetPatch::Section &section : patch.sections()) {
+    if (!seen_names.insert(section.name()).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicated section: ", section.name()));
+    }
+    if (!IsValidAlignment(section.alignment())) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid alignment of ", section.name()));
+    }
+    std::string base_buffer;
+    absl::StatusOr<absl::string_view> base_section =
+        GetUncompressedData(base_reader, section.name(), &base_buffer);
+    if (!base_section.ok()) {
+      return base_section.status();
+    }
+    const absl::string_view base_data = *base_section;
+
+    // Validates the operations before allocating, as `section.size()` comes
+    // from the patch and isn't trusted.
+    uint64_t size = 0;
+    for (const DataSetPatch::Operation &op : section.operations()) {
+      if (op.copy_size() == 0) {
+        size += op.insert().size();
+      } else if (op.copy_offset() <= base_data.size() &&
+                 op.copy_size() <= base_data.size() - op.copy_offset()) {
+        size += op.copy_size();
+      } else {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Out of range copy in ", section.name()));
+      }
+      if (size > section.size()) {
+        break;
+      }
+    }
+    if (size != section.size()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Size mismatch of ", section.name()));
+    }
+
+    std::string data;
+    data.reserve(size);
+    for (const DataSetPatch::Operation &op : section.operations()) {
+      if (op.copy_size() == 0) {
+        data.append(op.insert());
+      } else {
+        data.append(base_data.substr(op.copy_offset(), op.copy_size()));
+      }
+    }
+    writer.Add(section.name(), section.alignment(), data,
+               section.temperature(), section.compression());
+  }
+
+  std::ostringstream output;
+  writer.Finish(&output);
+  std::string image = std::move(output).str();
+
+  DataSetReader reader;
+  if (!DataSetReader::VerifyChecksum(image) ||
+      !reader.Init(image, patch.magic()) ||
+      reader.GetChecksum() != patch.checksum()) {
+    return absl::DataLossError("The patched data set doesn't match the target");
+  }
+  return image;
+}
+
+}  // namespace mozc
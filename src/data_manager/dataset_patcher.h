@@ -0,0 +1,72 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_DATASET_PATCHER_H_
+#define MOZC_DATA_MANAGER_DATASET_PATCHER_H_
+
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "data_manager/dataset.pb.h"
+
+namespace mozc {
+
+// Creates and applies DataSetPatch, the per-section binary diff between two
+// data set files. For the format, see dataset.proto.
+//
+// Usage:
+//   // When releasing `target`.
+//   absl::StatusOr<DataSetPatch> patch =
+//       DataSetPatcher::CreatePatch(base, target, magic);
+//   Ship(patch->SerializeAsString());
+//
+//   // On the machine having `base`, offline.
+//   absl::StatusOr<std::string> image =
+//       DataSetPatcher::ApplyPatch(base, patch);
+class DataSetPatcher {
+ public:
+  DataSetPatcher() = delete;
+
+  // Creates a patch which transforms `base` into `target`. Both must be data
+  // set files with `magic`.
+  static absl::StatusOr<DataSetPatch> CreatePatch(absl::string_view base,
+                                                  absl::string_view target,
+                                                  absl::string_view magic);
+
+  // Returns the target data set file built from `base` and `patch`. Fails if
+  // `base` is not the one the patch was created from, or the result doesn't
+  // match the checksum of the target.
+  static absl::StatusOr<std::string> ApplyPatch(absl::string_view base,
+                                                const DataSetPatch &patch);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_DATASET_PATCHER_H_
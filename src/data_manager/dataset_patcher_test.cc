@@ -0,0 +1,229 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/dataset_patcher.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_writer.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+using ::testing::Lt;
+
+constexpr absl::string_view kTestMagicNumber = {"ma\0gic", 6};
+
+struct Entry {
+  std::string name;
+  int alignment;
+  std::string data;
+};
+
+std::string MakeImage(const std::vector<Entry> &entries,
+                      DataSetWriter::Options options = {}) {
+  DataSetWriter w(kTestMagicNumber, options);
+  for (const Entry &entry : entries) {
+    w.Add(entry.name, entry.alignment, entry.data);
+  }
+  std::stringstream out;
+  w.Finish(&out);
+  return out.str();
+}
+
+std::string MakeData(size_t size, int seed) {
+  std::string data;
+  for (size_t i = 0; i < size; ++i) {
+    data.push_back(static_cast<char>((i * 131 + seed) % 251));
+  }
+  return data;
+}
+
+TEST(DataSetPatcherTest, RoundTrip) {
+  const std::string dictionary = MakeData(10000, 0);
+  std::string updated_dictionary = dictionary;
+  updated_dictionary.insert(5000, "new entry");
+  updated_dictionary.erase(8000, 100);
+  updated_dictionary[100] = 'x';
+
+  const std::string base = MakeImage({
+      {"dictionary", 64, dictionary},
+      {"removed", 8, "removed section"},
+      {"unchanged", 32, MakeData(3000, 1)},
+  });
+  const std::string target = MakeImage({
+      {"dictionary", 64, updated_dictionary},
+      {"unchanged", 128, MakeData(3000, 1)},
+      {"added", 16, "added section"},
+  });
+
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(base, target, kTestMagicNumber);
+  ASSERT_OK(patch);
+  EXPECT_EQ(patch->sections_size(), 3);
+  EXPECT_THAT(patch->ByteSizeLong(), Lt(500));
+
+  // Round trip the serialized patch as it is shipped.
+  DataSetPatch parsed;
+  ASSERT_TRUE(parsed.ParseFromString(patch->SerializeAsString()));
+  absl::StatusOr<std::string> image = DataSetPatcher::ApplyPatch(base, parsed);
+  ASSERT_OK(image);
+  EXPECT_EQ(*image, target);
+}
+
+TEST(DataSetPatcherTest, IdenticalImages) {
+  const std::string image = MakeImage({
+      {"a", 8, MakeData(100, 2)},
+      {"b", 256, MakeData(200, 3)},
+  });
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(image, image, kTestMagicNumber);
+  ASSERT_OK(patch);
+  for (const DataSetPatch::Section &section : patch->sections()) {
+    ASSERT_EQ(section.operations_size(), 1);
+    EXPECT_EQ(section.operations(0).copy_size(), section.size());
+  }
+  absl::StatusOr<std::string> patched =
+      DataSetPatcher::ApplyPatch(image, *patch);
+  ASSERT_OK(patched);
+  EXPECT_EQ(*patched, image);
+}
+
+TEST(DataSetPatcherTest, PageAlignedLayout) {
+  const std::string base = MakeImage({
+      {"emoji_token", 32, MakeData(1000, 9)},
+      {"dict", 32, MakeData(5000, 10)},
+  });
+  const std::string target = MakeImage(
+      {
+          {"emoji_token", 32, MakeData(1000, 9)},
+          {"dict", 32, MakeData(5100, 10)},
+          {"symbol_token", 32, "new"},
+      },
+      {.page_size = 4096});
+
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(base, target, kTestMagicNumber);
+  ASSERT_OK(patch);
+  EXPECT_EQ(patch->page_size(), 4096);
+  absl::StatusOr<std::string> image = DataSetPatcher::ApplyPatch(base, *patch);
+  ASSERT_OK(image);
+  EXPECT_EQ(*image, target);
+}
+
+TEST(DataSetPatcherTest, CompressedSections) {
+  DataSetWriter::Options options;
+  options.compress_cold_sections = true;
+  std::string emoji = MakeData(8000, 11);
+  const std::string base = MakeImage(
+      {
+          {"emoji_token", 32, emoji},
+          {"dict", 32, MakeData(5000, 12)},
+      },
+      options);
+  emoji.insert(4000, "new emoji");
+  const std::string target = MakeImage(
+      {
+          {"emoji_token", 32, emoji},
+          {"dict", 32, MakeData(5000, 12)},
+      },
+      options);
+
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(base, target, kTestMagicNumber);
+  ASSERT_OK(patch);
+  EXPECT_EQ(patch->sections(0).compression(), DataSetMetadata::LZ77_BLOCK);
+  EXPECT_EQ(patch->sections(0).size(), emoji.size());
+  absl::StatusOr<std::string> image = DataSetPatcher::ApplyPatch(base, *patch);
+  ASSERT_OK(image);
+  EXPECT_EQ(*image, target);
+}
+
+TEST(DataSetPatcherTest, RejectsOtherBase) {
+  const std::string base = MakeImage({{"a", 8, MakeData(1000, 4)}});
+  const std::string target = MakeImage({{"a", 8, MakeData(1000, 5)}});
+  const std::string other = MakeImage({{"a", 8, MakeData(1000, 6)}});
+
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(base, target, kTestMagicNumber);
+  ASSERT_OK(patch);
+  EXPECT_EQ(DataSetPatcher::ApplyPatch(other, *patch).status().code(),
+            absl::StatusCode::kFailedPrecondition);
+  EXPECT_FALSE(DataSetPatcher::CreatePatch(base, "broken", kTestMagicNumber)
+                   .ok());
+}
+
+TEST(DataSetPatcherTest, RejectsBrokenPatch) {
+  const std::string base = MakeImage({{"a", 8, MakeData(1000, 7)}});
+  const std::string target = MakeImage({{"a", 8, MakeData(1000, 8)}});
+  absl::StatusOr<DataSetPatch> patch =
+      DataSetPatcher::CreatePatch(base, target, kTestMagicNumber);
+  ASSERT_OK(patch);
+
+  {
+    DataSetPatch broken = *patch;
+    DataSetPatch::Operation *op = broken.mutable_sections(0)->add_operations();
+    op->set_copy_offset(900);
+    op->set_copy_size(200);
+    EXPECT_FALSE(DataSetPatcher::ApplyPatch(base, broken).ok());
+  }
+  {
+    DataSetPatch broken = *patch;
+    broken.mutable_sections(0)->set_alignment(12);
+    EXPECT_FALSE(DataSetPatcher::ApplyPatch(base, broken).ok());
+  }
+  {
+    // A huge size is rejected before allocating the section.
+    DataSetPatch broken = *patch;
+    broken.mutable_sections(0)->set_size(uint64_t{1} << 62);
+    EXPECT_EQ(DataSetPatcher::ApplyPatch(base, broken).status().code(),
+              absl::StatusCode::kInvalidArgument);
+  }
+  {
+    DataSetPatch broken = *patch;
+    broken.set_checksum(std::string(20, 'x'));
+    EXPECT_EQ(DataSetPatcher::ApplyPatch(base, broken).status().code(),
+              absl::StatusCode::kDataLoss);
+  }
+}
+
+}  // namespace
+}  // namespace mozc
@@ -55,6 +55,7 @@ constexpr size_t kFooterSize = 36;
 bool DataSetReader::Init(absl::string_view memblock, absl::string_view magic) {
   memblock_ = memblock;
   name_to_data_map_.clear();
+  metadata_.Clear();
 
   // Initializes |name_to_data_map_| from |memblock|.  For binary data format,
   // see dataset.proto.
@@ -110,18 +111,18 @@ bool DataSetReader::Init(absl::string_view memblock, absl::string_view magic) {
       memblock.size() - kFooterSize - metadata_size;
 
   // Open metadata.
-  DataSetMetadata metadata;
   const absl::string_view metadata_chunk =
       absl::ClippedSubstr(memblock, metadata_offset, metadata_size);
-  if (!metadata.ParseFromArray(metadata_chunk.data(), metadata_chunk.size())) {
+  if (!metadata_.ParseFromArray(metadata_chunk.data(), metadata_chunk.size())) {
     LOG(ERROR) << "Broken: Failed to parse metadata";
+    metadata_.Clear();
     return false;
   }
 
   // Construct a mapping from name to data chunk.
   uint64_t prev_chunk_end = magic.size();
-  for (int i = 0; i < metadata.entries_size(); ++i) {
-    const auto& e = metadata.entries(i);
+  for (int i = 0; i < metadata_.entries_size(); ++i) {
+    const auto& e = metadata_.entries(i);
     if (e.offset() < prev_chunk_end || e.offset() >= metadata_offset) {
       LOG(ERROR) << "Broken: Offset is out of range: " << e
                  << ", metadata offset = " << metadata_offset;
@@ -161,6 +162,14 @@ std::optional<std::pair<size_t, size_t>> DataSetReader::GetOffsetAndSize(
   return std::make_pair(offset, data.size());
 }
 
+absl::string_view DataSetReader::GetChecksum() const {
+  if (memblock_.size() < kFooterSize) {
+    return absl::string_view();
+  }
+  // See dataset.proto for file format.
+  return memblock_.substr(memblock_.size() - 28, 20);
+}
+
 bool DataSetReader::VerifyChecksum(absl::string_view memblock) {
   if (memblock.size() < kFooterSize) {
     return false;
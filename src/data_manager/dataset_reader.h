@@ -37,6 +37,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "data_manager/dataset.pb.h"
 
 namespace mozc {
 
@@ -57,6 +58,10 @@ class DataSetReader {
   std::optional<std::pair<size_t, size_t>> GetOffsetAndSize(
       absl::string_view name) const;
 
+  // Returns the SHA1 checksum stored in the footer, which identifies the data
+  // set. Returns an empty string if Init() hasn't succeeded.
+  absl::string_view GetChecksum() const;
+
   // Verifies the checksum of binary image.
   static bool VerifyChecksum(absl::string_view memblock);
 
@@ -65,8 +70,12 @@ class DataSetReader {
     return name_to_data_map_;
   }
 
+  // Returns the metadata, e.g., the layout of the entries; see dataset.proto.
+  const DataSetMetadata &metadata() const { return metadata_; }
+
  private:
   absl::string_view memblock_;
+  DataSetMetadata metadata_;
 
   // The value points to a block of the specified |memblock|.
   absl::flat_hash_map<std::string, absl::string_view> name_to_data_map_;
@@ -84,6 +84,10 @@ TEST(DataSetReaderTest, ValidData) {
   EXPECT_FALSE(r.Get("foo", &data));
   EXPECT_EQ(r.GetOffsetAndSize(""), std::nullopt);
   EXPECT_EQ(r.GetOffsetAndSize("foo"), std::nullopt);
+
+  // The checksum is placed after the metadata size; see dataset.proto.
+  EXPECT_EQ(r.GetChecksum(),
+            absl::string_view(image).substr(image.size() - 28, 20));
 }
 
 TEST(DataSetReaderTest, InvalidMagicString) {
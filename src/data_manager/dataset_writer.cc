@@ -29,20 +29,27 @@
 
 #include "data_manager/dataset_writer.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <ostream>
 #include <string>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/numeric/bits.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/file_util.h"
 #include "base/unverified_sha1.h"
 #include "base/util.h"
 #include "base/vlog.h"
 #include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_compression.h"
 
 namespace mozc {
 namespace {
@@ -52,17 +59,111 @@ bool IsValidAlignment(int a) {
   return a >= 8 && absl::has_single_bit<unsigned int>(a);
 }
 
+// The prefixes of the names of the data accessed on every conversion: the
+// lattice construction (dict, conn, suffix_*), the segmenter and the rewriters
+// always run (bdry, posg, coll, cols).
+constexpr absl::string_view kHotDataPrefixes[] = {
+    "bdry", "coll",        "cols",       "conn",    "dict",
+    "posg", "pos_matcher", "segmenter_", "suffix_", "version",
+};
+
+// The prefixes of the names of the data only used by the features rarely
+// triggered.
+constexpr absl::string_view kColdDataPrefixes[] = {
+    "a11y_description_",
+    "emoji_",
+    "emoticon_",
+    "usage_",
+};
+
+bool HasPrefixIn(absl::string_view name,
+                 absl::Span<const absl::string_view> prefixes) {
+  return absl::c_any_of(prefixes, [name](absl::string_view prefix) {
+    return absl::StartsWith(name, prefix);
+  });
+}
+
+// Orders UNKNOWN_TEMPERATURE as WARM.
+int GetTemperatureRank(DataSetMetadata::Temperature temperature) {
+  return temperature == DataSetMetadata::UNKNOWN_TEMPERATURE
+             ? DataSetMetadata::WARM
+             : temperature;
+}
+
+// Records the compression of the entry. Nothing is recorded for uncompressed
+// data so that the existing images are unchanged.
+void SetCompression(DataSetMetadata::Compression compression,
+                    size_t uncompressed_size, DataSetMetadata::Entry *entry) {
+  if (compression == DataSetMetadata::NO_COMPRESSION) {
+    return;
+  }
+  entry->set_compression(compression);
+  entry->set_uncompressed_size(uncompressed_size);
+}
+
 }  // namespace
 
+DataSetWriter::DataSetWriter(absl::string_view magic, Options options)
+    : image_(magic), options_(options) {
+  CHECK(options_.page_size == 0 || absl::has_single_bit(options_.page_size))
+      << "Invalid page size: " << options_.page_size;
+  if (options_.page_size > 0) {
+    metadata_.set_page_size(options_.page_size);
+  }
+}
+
 void DataSetWriter::Add(const std::string &name, int alignment,
                         absl::string_view data) {
+  Add(name, alignment, data, GetDefaultTemperature(name));
+}
+
+void DataSetWriter::Add(const std::string &name, int alignment,
+                        absl::string_view data,
+                        DataSetMetadata::Temperature temperature) {
+  if (options_.compress_cold_sections && temperature == DataSetMetadata::COLD) {
+    const std::string compressed = DataSetCompression::Compress(data);
+    if (compressed.size() < data.size()) {
+      AddStoredData(name, alignment, compressed, temperature,
+                    DataSetMetadata::LZ77_BLOCK, data.size());
+      return;
+    }
+  }
+  AddStoredData(name, alignment, data, temperature,
+                DataSetMetadata::NO_COMPRESSION, data.size());
+}
+
+void DataSetWriter::Add(const std::string &name, int alignment,
+                        absl::string_view data,
+                        DataSetMetadata::Temperature temperature,
+                        DataSetMetadata::Compression compression) {
+  switch (compression) {
+    case DataSetMetadata::NO_COMPRESSION:
+      AddStoredData(name, alignment, data, temperature, compression,
+                    data.size());
+      return;
+    case DataSetMetadata::LZ77_BLOCK:
+      AddStoredData(name, alignment, DataSetCompression::Compress(data),
+                    temperature, compression, data.size());
+      return;
+  }
+  LOG(FATAL) << "Unknown compression: " << compression;
+}
+
+void DataSetWriter::AddStoredData(const std::string &name, int alignment,
+                                  absl::string_view data,
+                                  DataSetMetadata::Temperature temperature,
+                                  DataSetMetadata::Compression compression,
+                                  size_t uncompressed_size) {
   CHECK(seen_names_.insert(name).second) << name << " was already added";
-  AppendPadding(alignment);
-  DataSetMetadata::Entry *entry = metadata_.add_entries();
-  entry->set_name(name);
-  entry->set_offset(image_.size());
-  entry->set_size(data.size());
-  image_.append(data.data(), data.size());
+  CHECK(IsValidAlignment(alignment)) << "Invalid alignment: " << alignment;
+  if (options_.page_size == 0) {
+    SetCompression(compression, uncompressed_size,
+                   Append(name, alignment, data));
+    return;
+  }
+  pending_data_.push_back({name, alignment,
+                           std::string(data.data(), data.size()), temperature,
+                           compression, uncompressed_size});
 }
 
 void DataSetWriter::AddFile(const std::string &name, int alignment,
@@ -73,6 +174,23 @@ void DataSetWriter::AddFile(const std::string &name, int alignment,
 }
 
 void DataSetWriter::Finish(std::ostream *output) {
+  // Lays out the pending data from hot to cold, keeping the order of addition
+  // within the same temperature.
+  absl::c_stable_sort(pending_data_,
+                      [](const PendingData &lhs, const PendingData &rhs) {
+                        return GetTemperatureRank(lhs.temperature) <
+                               GetTemperatureRank(rhs.temperature);
+                      });
+  const int page_alignment = options_.page_size * 8;
+  for (const PendingData &pending : pending_data_) {
+    DataSetMetadata::Entry *entry =
+        Append(pending.name, std::max(pending.alignment, page_alignment),
+               pending.data);
+    entry->set_temperature(pending.temperature);
+    SetCompression(pending.compression, pending.uncompressed_size, entry);
+  }
+  pending_data_.clear();
+
   const std::string s = metadata_.SerializeAsString();
   image_.append(s);                                // Metadata
   image_.append(Util::SerializeUint64(s.size()));  // Metadata size
@@ -89,6 +207,29 @@ void DataSetWriter::Finish(std::ostream *output) {
                << metadata_;
 }
 
+DataSetMetadata::Temperature DataSetWriter::GetDefaultTemperature(
+    absl::string_view name) {
+  if (HasPrefixIn(name, kHotDataPrefixes)) {
+    return DataSetMetadata::HOT;
+  }
+  if (HasPrefixIn(name, kColdDataPrefixes)) {
+    return DataSetMetadata::COLD;
+  }
+  return DataSetMetadata::WARM;
+}
+
+DataSetMetadata::Entry *DataSetWriter::Append(const std::string &name,
+                                              int alignment,
+                                              absl::string_view data) {
+  AppendPadding(alignment);
+  DataSetMetadata::Entry *entry = metadata_.add_entries();
+  entry->set_name(name);
+  entry->set_offset(image_.size());
+  entry->set_size(data.size());
+  image_.append(data.data(), data.size());
+  return entry;
+}
+
 void DataSetWriter::AppendPadding(int alignment) {
   CHECK(IsValidAlignment(alignment)) << "Invalid alignment: " << alignment;
   alignment /= 8;  // To byte
@@ -30,8 +30,11 @@
 #ifndef MOZC_DATA_MANAGER_DATASET_WRITER_H_
 #define MOZC_DATA_MANAGER_DATASET_WRITER_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
@@ -43,13 +46,39 @@ namespace mozc {
 // see dataset.proto.
 class DataSetWriter {
  public:
+  struct Options {
+    // If positive, writes the page-aligned layout: every file is aligned at
+    // this page size in bytes, and the files are ordered by temperature. Must
+    // be a power of 2.
+    uint32_t page_size = 0;
+
+    // If true, compresses the COLD files that become smaller. DataManager
+    // decompresses them on the first use, which is supported only for its lazy
+    // sections (all the files COLD by default are).
+    bool compress_cold_sections = false;
+  };
+
   // Creates a writer with specified magic number.
-  explicit DataSetWriter(absl::string_view magic) : image_(magic) {}
+  explicit DataSetWriter(absl::string_view magic)
+      : DataSetWriter(magic, Options()) {}
+  DataSetWriter(absl::string_view magic, Options options);
 
   // Adds a binary image to the packed file so that data is aligned at the
-  // specified bit boundary (8, 16, 32, 64, ...).
+  // specified bit boundary (8, 16, 32, 64, ...). In the page-aligned layout,
+  // the temperature of the data is GetDefaultTemperature(name).
   void Add(const std::string &name, int alignment, absl::string_view data);
 
+  // Same as above with the explicit temperature, which is only used in the
+  // page-aligned layout.
+  void Add(const std::string &name, int alignment, absl::string_view data,
+           DataSetMetadata::Temperature temperature);
+
+  // Same as above with the explicit compression, which is applied even if it
+  // doesn't make the data smaller.
+  void Add(const std::string &name, int alignment, absl::string_view data,
+           DataSetMetadata::Temperature temperature,
+           DataSetMetadata::Compression compression);
+
   // Similar to Add() for absl::string_view but data is read from file.
   void AddFile(const std::string &name, int alignment,
                const std::string &filepath);
@@ -58,14 +87,42 @@ class DataSetWriter {
   // binary mode.
   void Finish(std::ostream *output);
 
+  // Note that the entries are not fixed until Finish() in the page-aligned
+  // layout.
   const DataSetMetadata &metadata() const { return metadata_; }
 
+  // Returns the temperature of the data set files generated by the build rules,
+  // based on how the engine accesses them. Returns WARM for unknown names.
+  static DataSetMetadata::Temperature GetDefaultTemperature(
+      absl::string_view name);
+
  private:
+  struct PendingData {
+    std::string name;
+    int alignment;
+    std::string data;
+    DataSetMetadata::Temperature temperature;
+    DataSetMetadata::Compression compression;
+    size_t uncompressed_size;
+  };
+
+  // Adds `data` stored with `compression`.
+  void AddStoredData(const std::string &name, int alignment,
+                     absl::string_view data,
+                     DataSetMetadata::Temperature temperature,
+                     DataSetMetadata::Compression compression,
+                     size_t uncompressed_size);
+  DataSetMetadata::Entry *Append(const std::string &name, int alignment,
+                                 absl::string_view data);
   void AppendPadding(int alignment);
 
   std::string image_;
   DataSetMetadata metadata_;
   absl::flat_hash_set<std::string> seen_names_;
+  const Options options_;
+
+  // The data held until Finish() in the page-aligned layout.
+  std::vector<PendingData> pending_data_;
 };
 
 }  // namespace mozc
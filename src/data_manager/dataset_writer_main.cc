@@ -42,7 +42,21 @@
 // where alignment must be a power of 2 greater than or equal to 8 (i.e., 8, 16,
 // 32, 64, ...). Each packed file can be retrieved by DataSetReader through its
 // name.
+//
+// With --page_size, the files are aligned at the page boundary and ordered by
+// the temperature. With --compress_cold_sections, the cold files are
+// compressed; see DataSetWriter::Options.
+//
+// With --base and --patch, the tool also writes the patch transforming the base
+// data set into the output; see DataSetPatcher.
+//
+// To apply a patch offline, specify no arguments:
+// $ ./path/to/artifacts/dataset_writer_main
+//   --base=/path/to/base
+//   --patch=/path/to/patch
+//   --output=/path/to/output
 
+#include <cstdint>
 #include <ios>
 #include <string>
 #include <vector>
@@ -50,6 +64,7 @@
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
@@ -59,10 +74,66 @@
 #include "base/init_mozc.h"
 #include "base/number_util.h"
 #include "base/vlog.h"
+#include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_patcher.h"
 #include "data_manager/dataset_writer.h"
 
 ABSL_FLAG(std::string, magic, "", "Hex-encoded magic number to be embedded");
 ABSL_FLAG(std::string, output, "", "Output file");
+ABSL_FLAG(int32_t, page_size, 0,
+          "If positive, writes the page-aligned layout for this page size");
+ABSL_FLAG(bool, compress_cold_sections, false,
+          "Compresses the rarely used files");
+ABSL_FLAG(std::string, base, "", "Base data set of the patch");
+ABSL_FLAG(std::string, patch, "",
+          "Patch file to be written from --base to --output, or to be applied "
+          "to --base if no input is given");
+
+namespace {
+
+// Writes `content` to `filename` via a temporary file so that a failure
+// doesn't leave a partial file.
+void AtomicWrite(const std::string &filename, absl::string_view content) {
+  const std::string tmpfile = filename + ".tmp";
+  CHECK_OK(mozc::FileUtil::SetContents(tmpfile, content));
+  absl::Status s = mozc::FileUtil::AtomicRename(tmpfile, filename);
+  CHECK_OK(s) << ": Atomic rename failed. from: " << tmpfile
+              << " to: " << filename;
+}
+
+void ApplyPatch() {
+  absl::StatusOr<std::string> base =
+      mozc::FileUtil::GetContents(absl::GetFlag(FLAGS_base));
+  CHECK_OK(base);
+  absl::StatusOr<std::string> patch_data =
+      mozc::FileUtil::GetContents(absl::GetFlag(FLAGS_patch));
+  CHECK_OK(patch_data);
+  mozc::DataSetPatch patch;
+  CHECK(patch.ParseFromString(*patch_data))
+      << "Broken patch: " << absl::GetFlag(FLAGS_patch);
+  absl::StatusOr<std::string> image =
+      mozc::DataSetPatcher::ApplyPatch(*base, patch);
+  CHECK_OK(image);
+  AtomicWrite(absl::GetFlag(FLAGS_output), *image);
+}
+
+void WritePatch(absl::string_view magic) {
+  absl::StatusOr<std::string> base =
+      mozc::FileUtil::GetContents(absl::GetFlag(FLAGS_base));
+  CHECK_OK(base);
+  absl::StatusOr<std::string> target =
+      mozc::FileUtil::GetContents(absl::GetFlag(FLAGS_output));
+  CHECK_OK(target);
+  absl::StatusOr<mozc::DataSetPatch> patch =
+      mozc::DataSetPatcher::CreatePatch(*base, *target, magic);
+  CHECK_OK(patch);
+  const std::string patch_data = patch->SerializeAsString();
+  MOZC_VLOG(1) << "Wrote patch of " << patch_data.size() << " bytes for "
+               << target->size() << " bytes of data set";
+  AtomicWrite(absl::GetFlag(FLAGS_patch), patch_data);
+}
+
+}  // namespace
 
 int main(int argc, char **argv) {
   mozc::InitMozc(argv[0], &argc, &argv);
@@ -95,13 +166,24 @@ int main(int argc, char **argv) {
   }
 
   CHECK(!absl::GetFlag(FLAGS_output).empty()) << "--output is required";
+  const bool use_patch =
+      !absl::GetFlag(FLAGS_base).empty() && !absl::GetFlag(FLAGS_patch).empty();
+  if (inputs.empty() && use_patch) {
+    ApplyPatch();
+    return 0;
+  }
 
   // DataSetWriter directly writes to the specified stream, so if it fails for
   // an input, the output contains a partial result.  To avoid such partial file
   // creation, write to a temporary file then rename it.
   const std::string tmpfile = absl::GetFlag(FLAGS_output) + ".tmp";
   {
-    mozc::DataSetWriter writer(magic);
+    CHECK_GE(absl::GetFlag(FLAGS_page_size), 0) << "Invalid --page_size";
+    mozc::DataSetWriter::Options options;
+    options.page_size = absl::GetFlag(FLAGS_page_size);
+    options.compress_cold_sections =
+        absl::GetFlag(FLAGS_compress_cold_sections);
+    mozc::DataSetWriter writer(magic, options);
     for (const auto &input : inputs) {
       MOZC_VLOG(1) << "Writing " << input.name
                    << ", alignment = " << input.alignment
@@ -118,5 +200,9 @@ int main(int argc, char **argv) {
   CHECK_OK(s) << ": Atomic rename failed. from: " << tmpfile
               << " to: " << absl::GetFlag(FLAGS_output);
 
+  if (use_patch) {
+    WritePatch(magic);
+  }
+
   return 0;
 }
@@ -35,11 +35,13 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/file/temp_dir.h"
 #include "base/file_util.h"
 #include "base/unverified_sha1.h"
 #include "base/util.h"
 #include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_compression.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
@@ -135,5 +137,81 @@ TEST(DatasetWriterTest, Write) {
   EXPECT_EQ(actual, expected);
 }
 
+TEST(DatasetWriterTest, PageAlignedLayout) {
+  std::string image;
+  DataSetMetadata metadata;
+  {
+    DataSetWriter w("magic", {.page_size = 64});
+    w.Add("emoji_token", 32, "cold");
+    w.Add("symbol_token", 32, "warm1");
+    w.Add("conn", 32, "hot1");
+    w.Add("symbol_string", 32, "warm2");
+    w.Add("dict", 1024, "hot2");
+    w.Add("explicit", 8, "cold2", DataSetMetadata::COLD);
+
+    std::stringstream out;
+    w.Finish(&out);
+    image = out.str();
+    metadata = w.metadata();
+  }
+
+  EXPECT_EQ(metadata.page_size(), 64);
+  ASSERT_EQ(metadata.entries_size(), 6);
+  // Ordered from hot to cold, keeping the order within each temperature.
+  EXPECT_EQ(metadata.entries(0).name(), "conn");
+  EXPECT_EQ(metadata.entries(0).offset(), 64);
+  EXPECT_EQ(metadata.entries(0).temperature(), DataSetMetadata::HOT);
+  EXPECT_EQ(metadata.entries(1).name(), "dict");
+  EXPECT_EQ(metadata.entries(1).offset(), 128);
+  EXPECT_EQ(metadata.entries(2).name(), "symbol_token");
+  EXPECT_EQ(metadata.entries(2).offset(), 192);
+  EXPECT_EQ(metadata.entries(2).temperature(), DataSetMetadata::WARM);
+  EXPECT_EQ(metadata.entries(3).name(), "symbol_string");
+  EXPECT_EQ(metadata.entries(3).offset(), 256);
+  EXPECT_EQ(metadata.entries(4).name(), "emoji_token");
+  EXPECT_EQ(metadata.entries(4).offset(), 320);
+  EXPECT_EQ(metadata.entries(4).temperature(), DataSetMetadata::COLD);
+  EXPECT_EQ(metadata.entries(5).name(), "explicit");
+  EXPECT_EQ(metadata.entries(5).offset(), 384);
+  for (const DataSetMetadata::Entry &entry : metadata.entries()) {
+    EXPECT_EQ(entry.offset() % 64, 0) << entry.name();
+  }
+  EXPECT_EQ(image.substr(64, 4), "hot1");
+  EXPECT_EQ(image.substr(384, 5), "cold2");
+}
+
+TEST(DatasetWriterTest, CompressColdSections) {
+  const std::string cold(1000, 'a');
+  std::string image;
+  DataSetMetadata metadata;
+  {
+    DataSetWriter w("magic", {.compress_cold_sections = true});
+    w.Add("emoji_token", 32, cold);
+    w.Add("emoji_string", 32, "abc");  // Not compressed as it doesn't shrink.
+    w.Add("dict", 32, cold);
+
+    std::stringstream out;
+    w.Finish(&out);
+    image = out.str();
+    metadata = w.metadata();
+  }
+
+  ASSERT_EQ(metadata.entries_size(), 3);
+  const DataSetMetadata::Entry &compressed = metadata.entries(0);
+  EXPECT_EQ(compressed.compression(), DataSetMetadata::LZ77_BLOCK);
+  EXPECT_EQ(compressed.uncompressed_size(), cold.size());
+  EXPECT_LT(compressed.size(), cold.size());
+  std::string decompressed(cold.size(), '\0');
+  EXPECT_TRUE(DataSetCompression::Decompress(
+      absl::string_view(image).substr(compressed.offset(), compressed.size()),
+      absl::MakeSpan(decompressed)));
+  EXPECT_EQ(decompressed, cold);
+
+  EXPECT_FALSE(metadata.entries(1).has_compression());
+  EXPECT_EQ(metadata.entries(1).size(), 3);
+  EXPECT_FALSE(metadata.entries(2).has_compression());
+  EXPECT_EQ(metadata.entries(2).size(), cold.size());
+}
+
 }  // namespace
 }  // namespace mozc
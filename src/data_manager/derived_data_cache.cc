@@ -0,0 +1,224 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/derived_data_cache.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif  // _WIN32
+
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/file_util.h"
+#include "base/mmap.h"
+#include "base/vlog.h"
+#include "data_manager/data_manager_interface.h"
+#include "data_manager/dataset_reader.h"
+#include "data_manager/dataset_writer.h"
+
+#ifndef _WIN32
+ABSL_FLAG(int32_t, derived_data_cache_trusted_uid, -1,
+          "If non-negative, the derived data cache may also be owned by this "
+          "user, e.g. the administrator sharing the cache with all the users.");
+#endif  // _WIN32
+
+namespace mozc {
+namespace {
+
+constexpr absl::string_view kMagicNumber = "\xEFMOZC\rDERIVED\n";
+
+#ifndef _WIN32
+// Returns true if the files owned by `uid` can be mapped: this user, root and
+// --derived_data_cache_trusted_uid.
+bool IsTrustedOwner(const uid_t uid) {
+  const int32_t trusted_uid =
+      absl::GetFlag(FLAGS_derived_data_cache_trusted_uid);
+  return uid == ::geteuid() || uid == 0 ||
+         (trusted_uid >= 0 && uid == static_cast<uid_t>(trusted_uid));
+}
+#endif  // _WIN32
+
+// Rejects the files and the directories which aren't owned by a trusted user
+// or which the other users can modify, as they may be replaced while being
+// mapped. Symbolic links are rejected rather than followed. As the directory
+// passes the same check, the file cannot be swapped after it is checked.
+absl::Status CheckPermissions(const std::string &path, const bool directory) {
+#ifndef _WIN32
+  struct stat st;
+  if (::lstat(path.c_str(), &st) != 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("lstat failed: ", path));
+  }
+  if (directory ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) {
+    return absl::PermissionDeniedError(absl::StrCat(
+        path, directory ? " is not a directory" : " is not a regular file"));
+  }
+  if (!IsTrustedOwner(st.st_uid)) {
+    return absl::PermissionDeniedError(
+        absl::StrCat(path, " is owned by an untrusted user"));
+  }
+  if ((st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    return absl::PermissionDeniedError(
+        absl::StrCat(path, " is writable by other users"));
+  }
+#endif  // _WIN32
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+// static
+absl::StatusOr<std::string> DerivedDataCache::GetPath(
+    absl::string_view dir, const DataManagerInterface &data_manager) {
+  const absl::string_view checksum = data_manager.GetDataSetChecksum();
+  if (checksum.empty()) {
+    return absl::FailedPreconditionError("The data set has no checksum");
+  }
+  return FileUtil::JoinPath(
+      dir, absl::StrCat("derived_", absl::BytesToHexString(checksum), "_v",
+                        kFormatVersion, ".data"));
+}
+
+// static
+absl::StatusOr<std::unique_ptr<DerivedDataCache>> DerivedDataCache::Open(
+    absl::string_view dir, const DataManagerInterface &data_manager,
+    absl::Span<const Section> sections) {
+  absl::StatusOr<std::string> path = GetPath(dir, data_manager);
+  if (!path.ok()) {
+    return std::move(path).status();
+  }
+  const std::string dir_str(dir);
+  if (!FileUtil::DirectoryExists(dir_str).ok()) {
+    if (absl::Status s = FileUtil::CreateDirectory(dir_str); !s.ok()) {
+      return s;
+    }
+  }
+  if (absl::Status s = CheckPermissions(dir_str, /*directory=*/true);
+      !s.ok()) {
+    return s;
+  }
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache = Map(*path);
+  if (cache.ok() || absl::IsPermissionDenied(cache.status())) {
+    // A file failing the permission check is left for the administrator
+    // rather than replaced.
+    return cache;
+  }
+  MOZC_VLOG(1) << "Building the derived data cache: " << cache.status();
+
+  if (absl::Status s = Write(*path, data_manager, sections); !s.ok()) {
+    return s;
+  }
+  return Map(*path);
+}
+
+// static
+absl::StatusOr<std::unique_ptr<DerivedDataCache>> DerivedDataCache::Map(
+    const std::string &path) {
+  if (absl::Status s = FileUtil::FileExists(path); !s.ok()) {
+    return s;
+  }
+  if (absl::Status s = CheckPermissions(path, /*directory=*/false); !s.ok()) {
+    return s;
+  }
+  absl::StatusOr<Mmap> mmap = Mmap::Map(path, Mmap::READ_ONLY);
+  if (!mmap.ok()) {
+    return std::move(mmap).status();
+  }
+  // The file is small compared to the data set, so it's cheap to verify the
+  // whole image once per process.
+  const absl::string_view image(mmap->begin(), mmap->size());
+  if (!DataSetReader::VerifyChecksum(image)) {
+    return absl::DataLossError(absl::StrCat("Broken checksum: ", path));
+  }
+  auto cache = absl::WrapUnique(new DerivedDataCache());
+  cache->filename_ = path;
+  cache->mmap_ = *std::move(mmap);
+  if (!cache->reader_.Init(
+          absl::string_view(cache->mmap_.begin(), cache->mmap_.size()),
+          kMagicNumber)) {
+    return absl::DataLossError(absl::StrCat("Broken data: ", path));
+  }
+  return cache;
+}
+
+// static
+absl::Status DerivedDataCache::Write(const std::string &path,
+                                     const DataManagerInterface &data_manager,
+                                     absl::Span<const Section> sections) {
+  DataSetWriter writer(kMagicNumber);
+  for (const Section &section : sections) {
+    writer.Add(std::string(section.name), section.alignment,
+               section.build(data_manager));
+  }
+  std::stringstream image;
+  writer.Finish(&image);
+
+  // Writes to a temporary file and renames it so that the concurrent readers
+  // never see a partial file. Concurrent writers produce the same content.
+  absl::BitGen bitgen;
+  const std::string temp_path =
+      absl::StrCat(path, ".", absl::Hex(absl::Uniform<uint64_t>(bitgen)));
+  if (absl::Status s = FileUtil::SetContents(temp_path, image.str());
+      !s.ok()) {
+    FileUtil::UnlinkOrLogError(temp_path);
+    return s;
+  }
+  if (absl::Status s = FileUtil::AtomicRename(temp_path, path); !s.ok()) {
+    FileUtil::UnlinkOrLogError(temp_path);
+    return s;
+  }
+  LOG(INFO) << "Wrote the derived data cache: " << path;
+  return absl::OkStatus();
+}
+
+std::optional<absl::string_view> DerivedDataCache::Get(
+    absl::string_view name) const {
+  absl::string_view data;
+  if (!reader_.Get(name, &data)) {
+    return std::nullopt;
+  }
+  return data;
+}
+
+}  // namespace mozc
@@ -0,0 +1,110 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_DERIVED_DATA_CACHE_H_
+#define MOZC_DATA_MANAGER_DERIVED_DATA_CACHE_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/mmap.h"
+#include "data_manager/data_manager_interface.h"
+#include "data_manager/dataset_reader.h"
+
+namespace mozc {
+
+// Caches the data structures derived from a data set, e.g., lookup indices
+// which the rewriters would otherwise build on the heap, in a file shared by
+// the processes using the same data set. The first process writes the file and
+// the others only map it, so each additional process, e.g., the server hosting
+// several users, adds only its own state.
+//
+// The file has the data set format (see dataset.proto) and its name is derived
+// from the checksum of the source data set and kFormatVersion, so a new data
+// set or a new format never reads a stale cache. Only a regular file in a
+// directory, both not writable by the others and owned by this user, root or
+// --derived_data_cache_trusted_uid, is mapped. So the users share the cache
+// in a directory of the administrator, who writes it in advance, while the
+// other users only read it. The readers still validate the sections as
+// untrusted input and fall back to building the structures by themselves.
+//
+// The reverse lookup index of SystemDictionary isn't cached, as the engine
+// doesn't enable it (ENABLE_REVERSE_LOOKUP_INDEX is only used by tests).
+class DerivedDataCache {
+ public:
+  // Bump this when the content of any section changes.
+  static constexpr int kFormatVersion = 1;
+
+  struct Section {
+    absl::string_view name;
+    // Alignment of the section in bits, e.g., 32.
+    int alignment;
+    // Builds the section from the data set.
+    std::string (*build)(const DataManagerInterface &data_manager);
+  };
+
+  // Opens the cache for `data_manager` in `dir`, or builds `sections` and
+  // writes the cache if it doesn't exist. The cache isn't rebuilt when it
+  // lacks some of `sections`; Get() returns nullopt for them.
+  static absl::StatusOr<std::unique_ptr<DerivedDataCache>> Open(
+      absl::string_view dir, const DataManagerInterface &data_manager,
+      absl::Span<const Section> sections);
+
+  // Returns the path of the cache for `data_manager` in `dir`.
+  static absl::StatusOr<std::string> GetPath(
+      absl::string_view dir, const DataManagerInterface &data_manager);
+
+  DerivedDataCache(const DerivedDataCache &) = delete;
+  DerivedDataCache &operator=(const DerivedDataCache &) = delete;
+
+  std::optional<absl::string_view> Get(absl::string_view name) const;
+
+  const std::string &filename() const { return filename_; }
+
+ private:
+  DerivedDataCache() = default;
+
+  static absl::StatusOr<std::unique_ptr<DerivedDataCache>> Map(
+      const std::string &path);
+  static absl::Status Write(const std::string &path,
+                            const DataManagerInterface &data_manager,
+                            absl::Span<const Section> sections);
+
+  std::string filename_;
+  Mmap mmap_;
+  DataSetReader reader_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_DERIVED_DATA_CACHE_H_
@@ -0,0 +1,185 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/derived_data_cache.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/file/temp_dir.h"
+#include "base/file_util.h"
+#include "data_manager/data_manager_interface.h"
+#include "data_manager/testing/mock_data_manager.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+#ifndef _WIN32
+ABSL_DECLARE_FLAG(int32_t, derived_data_cache_trusted_uid);
+#endif  // _WIN32
+
+namespace mozc {
+namespace {
+
+using ::testing::Optional;
+
+int num_builds = 0;
+
+std::string BuildChecksumSection(const DataManagerInterface &data_manager) {
+  ++num_builds;
+  return std::string(data_manager.GetDataSetChecksum());
+}
+
+constexpr DerivedDataCache::Section kSections[] = {
+    {"checksum", 32, BuildChecksumSection},
+};
+
+class DerivedDataCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    num_builds = 0;
+    absl::StatusOr<TempDirectory> dir =
+        TempDirectory::Default().CreateTempDirectory();
+    ASSERT_OK(dir);
+    dir_.emplace(*std::move(dir));
+  }
+
+  std::string dir() const { return dir_->path(); }
+
+  absl::FlagSaver flag_saver_;
+  testing::MockDataManager data_manager_;
+  std::optional<TempDirectory> dir_;
+};
+
+TEST_F(DerivedDataCacheTest, BuildsOnceAndMaps) {
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  EXPECT_EQ(num_builds, 1);
+  EXPECT_THAT((*cache)->Get("checksum"),
+              Optional(data_manager_.GetDataSetChecksum()));
+  EXPECT_EQ((*cache)->Get("unknown"), std::nullopt);
+
+  // The second process only maps the file.
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache2 =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache2);
+  EXPECT_EQ(num_builds, 1);
+  EXPECT_EQ((*cache2)->filename(), (*cache)->filename());
+  EXPECT_THAT((*cache2)->Get("checksum"),
+              Optional(data_manager_.GetDataSetChecksum()));
+}
+
+TEST_F(DerivedDataCacheTest, RebuildsBrokenFile) {
+  absl::StatusOr<std::string> path =
+      DerivedDataCache::GetPath(dir(), data_manager_);
+  ASSERT_OK(path);
+  ASSERT_OK(FileUtil::SetContents(*path, "broken"));
+#ifndef _WIN32
+  ASSERT_EQ(::chmod(path->c_str(), 0644), 0);
+#endif  // _WIN32
+
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  EXPECT_EQ(num_builds, 1);
+  EXPECT_THAT((*cache)->Get("checksum"),
+              Optional(data_manager_.GetDataSetChecksum()));
+}
+
+#ifndef _WIN32
+TEST_F(DerivedDataCacheTest, RejectsFileWritableByOthers) {
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  ASSERT_EQ(::chmod((*cache)->filename().c_str(), 0666), 0);
+
+  cache = DerivedDataCache::Open(dir(), data_manager_, kSections);
+  EXPECT_TRUE(absl::IsPermissionDenied(cache.status())) << cache.status();
+  EXPECT_EQ(num_builds, 1);
+}
+
+TEST_F(DerivedDataCacheTest, RejectsSymlink) {
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  const std::string target = FileUtil::JoinPath(dir(), "target");
+  ASSERT_OK(FileUtil::AtomicRename((*cache)->filename(), target));
+  ASSERT_EQ(::symlink(target.c_str(), (*cache)->filename().c_str()), 0);
+
+  cache = DerivedDataCache::Open(dir(), data_manager_, kSections);
+  EXPECT_TRUE(absl::IsPermissionDenied(cache.status())) << cache.status();
+}
+
+TEST_F(DerivedDataCacheTest, RejectsDirectoryWritableByOthers) {
+  ASSERT_EQ(::chmod(dir().c_str(), 0777), 0);
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  EXPECT_TRUE(absl::IsPermissionDenied(cache.status())) << cache.status();
+  EXPECT_EQ(num_builds, 0);
+}
+
+TEST_F(DerivedDataCacheTest, MapsCacheOfTrustedUser) {
+  // Only root can give the files to another user.
+  if (::geteuid() != 0) {
+    return;
+  }
+  constexpr uid_t kAdminUid = 12345;
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  ASSERT_EQ(::chown((*cache)->filename().c_str(), kAdminUid, -1), 0);
+  ASSERT_EQ(::chown(dir().c_str(), kAdminUid, -1), 0);
+
+  cache = DerivedDataCache::Open(dir(), data_manager_, kSections);
+  EXPECT_TRUE(absl::IsPermissionDenied(cache.status())) << cache.status();
+
+  absl::SetFlag(&FLAGS_derived_data_cache_trusted_uid, kAdminUid);
+  cache = DerivedDataCache::Open(dir(), data_manager_, kSections);
+  ASSERT_OK(cache);
+  EXPECT_EQ(num_builds, 1);
+  EXPECT_THAT((*cache)->Get("checksum"),
+              Optional(data_manager_.GetDataSetChecksum()));
+}
+#endif  // _WIN32
+
+}  // namespace
+}  // namespace mozc
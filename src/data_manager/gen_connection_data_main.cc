@@ -0,0 +1,173 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Generates the connection data from connection_single_column.txt. This is a
+// faster replacement for gen_connection_data.py.
+//
+// Usage
+// $ ./path/to/artifacts/gen_connection_data_main
+//   --text_connection_file=/path/to/connection_single_column.txt
+//   --id_file=/path/to/id.def
+//   --special_pos_file=/path/to/special_pos.def
+//   --binary_output_file=/path/to/output
+//   [--use_1byte_cost] [--format=blocked --hot_pos_size=N] [--verify]
+//
+// With --verify, the tool also builds the data in every other applicable
+// format, loads them with Connector and checks that every cell has the same
+// cost in all of them and matches the text matrix.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "base/file_util.h"
+#include "base/init_mozc.h"
+#include "converter/connector.h"
+#include "data_manager/connection_data_builder.h"
+
+ABSL_FLAG(std::string, text_connection_file, "",
+          "connection_single_column.txt");
+ABSL_FLAG(std::string, id_file, "", "id.def");
+ABSL_FLAG(std::string, special_pos_file, "", "special_pos.def");
+ABSL_FLAG(bool, use_1byte_cost, false, "Quantizes the costs to 1 byte");
+ABSL_FLAG(std::string, format, "compressed", "compressed or blocked");
+ABSL_FLAG(int32_t, hot_pos_size, 256,
+          "The number of leading POS ids stored uncompressed in the blocked "
+          "format");
+ABSL_FLAG(bool, verify, false, "Compares every cell across the formats");
+ABSL_FLAG(std::string, binary_output_file, "", "Output file");
+
+namespace mozc {
+namespace {
+
+// Returns true if `actual` is the cost decoded from `expected` at the
+// resolution of the data.
+bool MatchesCost(int actual, uint16_t expected, int resolution) {
+  if (expected == ConnectionDataBuilder::kInvalidCost) {
+    return actual >= Connector::kInvalidCost;
+  }
+  return actual <= expected && expected - actual < resolution;
+}
+
+absl::Status Verify(const ConnectionMatrix &matrix,
+                    const std::vector<std::string> &data) {
+  std::vector<Connector> connectors;
+  for (const std::string &binary : data) {
+    absl::StatusOr<Connector> connector =
+        Connector::Create(binary.data(), binary.size(), 1024);
+    if (!connector.ok()) {
+      return std::move(connector).status();
+    }
+    connectors.push_back(*std::move(connector));
+  }
+  for (size_t rid = 0; rid < matrix.size; ++rid) {
+    for (size_t lid = 0; lid < matrix.size; ++lid) {
+      const int cost = connectors[0].GetTransitionCost(rid, lid);
+      if (!MatchesCost(cost, matrix.cost(rid, lid),
+                       connectors[0].GetResolution())) {
+        return absl::DataLossError(absl::StrCat(
+            "(", rid, ", ", lid, "): expected ", matrix.cost(rid, lid),
+            " but got ", cost));
+      }
+      for (size_t i = 1; i < connectors.size(); ++i) {
+        const int other = connectors[i].GetTransitionCost(rid, lid);
+        if (other != cost) {
+          return absl::DataLossError(
+              absl::StrCat("(", rid, ", ", lid, "): format ", i, " has ",
+                           other, " but format 0 has ", cost));
+        }
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  mozc::InitMozc(argv[0], &argc, &argv);
+
+  absl::StatusOr<mozc::ConnectionMatrix> matrix =
+      mozc::ConnectionDataBuilder::ReadMatrix(
+          absl::GetFlag(FLAGS_text_connection_file),
+          absl::GetFlag(FLAGS_id_file), absl::GetFlag(FLAGS_special_pos_file));
+  CHECK_OK(matrix);
+
+  mozc::ConnectionDataBuilder::Options options;
+  options.use_1byte_cost = absl::GetFlag(FLAGS_use_1byte_cost);
+  const std::string format = absl::GetFlag(FLAGS_format);
+  if (format == "blocked") {
+    options.format = mozc::ConnectionDataBuilder::BLOCKED;
+    options.hot_pos_size = std::min<int32_t>(
+        absl::GetFlag(FLAGS_hot_pos_size), matrix->size);
+  } else {
+    CHECK_EQ(format, "compressed") << "Unknown format";
+  }
+  absl::StatusOr<std::string> binary =
+      mozc::ConnectionDataBuilder::Build(*matrix, options);
+  CHECK_OK(binary);
+
+  if (absl::GetFlag(FLAGS_verify)) {
+    std::vector<std::string> data = {*binary};
+    mozc::ConnectionDataBuilder::Options other = options;
+    other.format = options.format == mozc::ConnectionDataBuilder::BLOCKED
+                       ? mozc::ConnectionDataBuilder::COMPRESSED
+                       : mozc::ConnectionDataBuilder::BLOCKED;
+    if (other.format == mozc::ConnectionDataBuilder::BLOCKED) {
+      other.hot_pos_size = std::min<int32_t>(
+          absl::GetFlag(FLAGS_hot_pos_size), matrix->size);
+    }
+    if (!other.use_1byte_cost) {
+      absl::StatusOr<std::string> other_binary =
+          mozc::ConnectionDataBuilder::Build(*matrix, other);
+      CHECK_OK(other_binary);
+      data.push_back(*std::move(other_binary));
+    }
+    CHECK_OK(mozc::Verify(*matrix, data));
+    LOG(INFO) << "Verified " << matrix->size << "x" << matrix->size
+              << " cells in " << data.size() << " formats";
+  }
+
+  if (!absl::GetFlag(FLAGS_binary_output_file).empty()) {
+    CHECK_OK(mozc::FileUtil::SetContents(
+        absl::GetFlag(FLAGS_binary_output_file), *binary));
+  }
+  return 0;
+}
@@ -63,7 +63,12 @@ def mozc_dataset(
         zero_query_number_def,
         suggestion_filter_safe_def_srcs = [],
         usage_dict = None,
-        extra_data = []):
+        extra_data = [],
+        page_size = 0,
+        compress_cold_sections = False,
+        connection_format = "compressed",
+        renumber_pos_ids = False,
+        pos_frequency = None):
     """Macro for Mozc data set.
 
     This macro defines a set of genrules each of which has name "name + @xxx",
@@ -136,7 +141,65 @@ def mozc_dataset(
       suggestion_filter_safe_def_srcs: safe list for suggestion filter.
       usage_dict: usage dictionary data.
       extra_data: a list of any data files to include.
+      page_size: if positive, writes the page-aligned layout for this page size.
+      compress_cold_sections: if true, compresses the rarely used data.
+      connection_format: "compressed" or "blocked"; see ConnectionDataBuilder.
+      renumber_pos_ids: if true, renumbers the POS ids by frequency; see
+        PosIdRenumberer.
+      pos_frequency: POS id frequencies in a corpus for renumber_pos_ids. The
+        dictionary tokens are counted if not specified.
     """
+    if renumber_pos_ids:
+        # The data below are generated from the renumbered sources.
+        reading_correction_srcs = [
+            src
+            for src in dictionary_srcs
+            if src.endswith("reading_correction.tsv")
+        ]
+        token_srcs = [
+            src
+            for src in dictionary_srcs
+            if src not in reading_correction_srcs
+        ]
+        frequency_srcs = [pos_frequency] if pos_frequency else []
+        native.genrule(
+            name = name + "@renumbered_pos",
+            srcs = token_srcs + frequency_srcs + [
+                connection_single_column_src,
+                id_def,
+                suffix,
+            ],
+            outs = [
+                "renumbered_pos/connection_single_column.txt",
+                "renumbered_pos/dictionary.txt",
+                "renumbered_pos/id.def",
+                "renumbered_pos/suffix.txt",
+            ],
+            cmd = (
+                "$(location //data_manager:renumber_pos_ids_main) " +
+                "--id_def=$(location " + id_def + ") " +
+                "--connection_file=" +
+                "$(location " + connection_single_column_src + ") " +
+                "--dictionary_files=\"" +
+                " ".join(["$(locations %s)" % s for s in token_srcs]) + "\" " +
+                "--suffix_file=$(location " + suffix + ") " +
+                "".join([
+                    "--pos_frequency_file=$(location " + src + ") "
+                    for src in frequency_srcs
+                ]) +
+                "--output_dir=$(@D)/renumbered_pos"
+            ),
+            tools = ["//data_manager:renumber_pos_ids_main"],
+        )
+        connection_single_column_src = (
+            ":renumbered_pos/connection_single_column.txt"
+        )
+        dictionary_srcs = [
+            ":renumbered_pos/dictionary.txt",
+        ] + reading_correction_srcs
+        id_def = ":renumbered_pos/id.def"
+        suffix = ":renumbered_pos/suffix.txt"
+
     sources = [
         ":" + name + "@user_pos",
         ":" + name + "@pos_matcher",
@@ -226,7 +289,10 @@ def mozc_dataset(
         outs = [outs[0]],
         cmd = (
             "$(location //data_manager:dataset_writer_main) " +
-            "--magic='" + magic + "' --output=$@ " + arguments
+            "--magic='" + magic + "' --output=$@ " +
+            "--page_size=" + str(page_size) + " " +
+            ("--compress_cold_sections " if compress_cold_sections else "") +
+            arguments
         ),
         tools = ["//data_manager:dataset_writer_main"],
     )
@@ -347,15 +413,16 @@ def mozc_dataset(
         ],
         outs = ["connection.data"],
         cmd = (
-            "$(location //data_manager:gen_connection_data) " +
+            "$(location //data_manager:gen_connection_data_main) " +
             "--text_connection_file=" +
             "$(location " + connection_single_column_src + ") " +
             "--id_file=$(location " + id_def + ") " +
             "--special_pos_file=$(location " + special_pos + ") " +
             "--binary_output_file=$@ " +
-            "--use_1byte_cost=" + use_1byte_cost
+            "--use_1byte_cost=" + use_1byte_cost + " " +
+            "--format=" + connection_format
         ),
-        tools = ["//data_manager:gen_connection_data"],
+        tools = ["//data_manager:gen_connection_data_main"],
     )
 
     native.genrule(
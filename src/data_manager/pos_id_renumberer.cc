@@ -0,0 +1,231 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/pos_id_renumberer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+namespace {
+
+bool IsComment(absl::string_view line) {
+  line = absl::StripAsciiWhitespace(line);
+  return line.empty() || line.front() == '#';
+}
+
+// Returns the non-comment lines of `text`.
+std::vector<absl::string_view> GetLines(absl::string_view text) {
+  std::vector<absl::string_view> lines;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    if (!IsComment(line)) {
+      lines.push_back(absl::StripTrailingAsciiWhitespace(line));
+    }
+  }
+  return lines;
+}
+
+bool ParseId(absl::string_view field, uint16_t *id) {
+  uint32_t value = 0;
+  if (!absl::SimpleAtoi(field, &value) || value > 0xFFFF) {
+    return false;
+  }
+  *id = value;
+  return true;
+}
+
+absl::Status ParseTokenId(absl::string_view field, uint16_t *id) {
+  if (!ParseId(field, id)) {
+    return absl::InvalidArgumentError(absl::StrCat("Invalid POS id: ", field));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+PosIdRenumberer::PosIdRenumberer(absl::Span<const uint64_t> frequencies) {
+  std::vector<uint16_t> order(frequencies.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (!order.empty()) {
+    // BOS/EOS stays at 0.
+    std::stable_sort(order.begin() + 1, order.end(),
+                     [&frequencies](uint16_t lhs, uint16_t rhs) {
+                       return frequencies[lhs] > frequencies[rhs];
+                     });
+  }
+  new_ids_.resize(order.size());
+  for (size_t new_id = 0; new_id < order.size(); ++new_id) {
+    new_ids_[order[new_id]] = new_id;
+  }
+}
+
+absl::Status PosIdRenumberer::CountTokens(absl::string_view text,
+                                          std::vector<uint64_t> *frequencies) {
+  for (absl::string_view line : GetLines(text)) {
+    const std::vector<absl::string_view> fields = absl::StrSplit(line, '\t');
+    if (fields.size() < 5) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid dictionary token: ", line));
+    }
+    for (const absl::string_view field : {fields[1], fields[2]}) {
+      uint16_t id = 0;
+      if (absl::Status status = ParseTokenId(field, &id);
+          !status.ok()) {
+        return status;
+      }
+      // The special POS ids are not renumbered.
+      if (id < frequencies->size()) {
+        ++(*frequencies)[id];
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status PosIdRenumberer::ParseFrequencies(
+    absl::string_view text, std::vector<uint64_t> *frequencies) {
+  for (absl::string_view line : GetLines(text)) {
+    const std::vector<absl::string_view> fields =
+        absl::StrSplit(line, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    uint16_t id = 0;
+    uint64_t frequency = 0;
+    if (fields.size() != 2 || !ParseId(fields[0], &id) ||
+        !absl::SimpleAtoi(fields[1], &frequency)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid frequency: ", line));
+    }
+    if (id < frequencies->size()) {
+      (*frequencies)[id] += frequency;
+    }
+  }
+  return absl::OkStatus();
+}
+
+size_t PosIdRenumberer::GetPosSize(absl::string_view id_def) {
+  return GetLines(id_def).size();
+}
+
+absl::StatusOr<std::string> PosIdRenumberer::RenumberIdDef(
+    absl::string_view text) const {
+  const std::vector<absl::string_view> lines = GetLines(text);
+  if (lines.size() != new_ids_.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", new_ids_.size(), " POS ids but found ", lines.size()));
+  }
+  std::vector<absl::string_view> features(lines.size());
+  for (absl::string_view line : lines) {
+    const std::pair<absl::string_view, absl::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', 1));
+    uint16_t id = 0;
+    if (!ParseId(fields.first, &id) || id >= new_ids_.size() ||
+        fields.second.empty() || !features[new_ids_[id]].empty()) {
+      return absl::InvalidArgumentError(absl::StrCat("Invalid id.def: ", line));
+    }
+    features[new_ids_[id]] = fields.second;
+  }
+  std::string output;
+  for (size_t id = 0; id < features.size(); ++id) {
+    absl::StrAppend(&output, id, " ", features[id], "\n");
+  }
+  return output;
+}
+
+absl::StatusOr<std::string> PosIdRenumberer::RenumberTokens(
+    absl::string_view text) const {
+  std::string output;
+  output.reserve(text.size());
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    if (IsComment(line)) {
+      if (!line.empty()) {
+        absl::StrAppend(&output, line, "\n");
+      }
+      continue;
+    }
+    std::vector<std::string> fields = absl::StrSplit(line, '\t');
+    if (fields.size() < 5) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid dictionary token: ", line));
+    }
+    for (std::string *field : {&fields[1], &fields[2]}) {
+      uint16_t id = 0;
+      if (absl::Status status = ParseTokenId(*field, &id);
+          !status.ok()) {
+        return status;
+      }
+      *field = absl::StrCat(GetNewId(id));
+    }
+    absl::StrAppend(&output, absl::StrJoin(fields, "\t"), "\n");
+  }
+  return output;
+}
+
+absl::StatusOr<std::string> PosIdRenumberer::RenumberConnection(
+    absl::string_view text) const {
+  const std::vector<absl::string_view> lines = GetLines(text);
+  const size_t size = new_ids_.size();
+  size_t header = 0;
+  if (lines.empty() || !absl::SimpleAtoi(lines[0], &header) ||
+      header != size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The matrix size doesn't match ", size));
+  }
+  if (lines.size() - 1 != size * size) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", size * size, " costs but found: ", lines.size() - 1));
+  }
+  std::vector<absl::string_view> costs(size * size);
+  for (size_t rid = 0; rid < size; ++rid) {
+    for (size_t lid = 0; lid < size; ++lid) {
+      costs[new_ids_[rid] * size + new_ids_[lid]] = lines[1 + rid * size + lid];
+    }
+  }
+  std::string output = absl::StrCat(size, "\n");
+  output.reserve(text.size());
+  for (const absl::string_view cost : costs) {
+    absl::StrAppend(&output, cost, "\n");
+  }
+  return output;
+}
+
+}  // namespace mozc
@@ -0,0 +1,101 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DATA_MANAGER_POS_ID_RENUMBERER_H_
+#define MOZC_DATA_MANAGER_POS_ID_RENUMBERER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+
+// Renumbers the POS ids in the data sources so that the frequently used ids
+// are small and dense. The caches in Connector and ImmutableConverter assume
+// this, and the hot block of the blocked connection data holds the costs
+// between the smallest ids.
+//
+// The generators derive everything else (POS matcher, segmenter, boundary,
+// POS group and user POS data) from id.def, so renumbering id.def, the
+// connection matrix and the dictionary tokens consistently gives the same
+// conversion results. The special POS ids follow id.def and are not
+// renumbered.
+//
+// Usage:
+//   std::vector<uint64_t> frequencies(pos_size);
+//   PosIdRenumberer::CountTokens(dictionary, &frequencies);
+//   const PosIdRenumberer renumberer(frequencies);
+//   absl::StatusOr<std::string> id_def = renumberer.RenumberIdDef(text);
+class PosIdRenumberer {
+ public:
+  // `frequencies` is indexed by the original POS id. BOS/EOS (0) keeps its id,
+  // and the other ids are ordered by the descending frequency. Ties keep the
+  // original order.
+  explicit PosIdRenumberer(absl::Span<const uint64_t> frequencies);
+
+  // Adds the occurrences of the ids in the dictionary tokens in `text`
+  // (key, lid, rid, cost, value, ...) to `frequencies`.
+  static absl::Status CountTokens(absl::string_view text,
+                                  std::vector<uint64_t> *frequencies);
+
+  // Adds the frequencies in `text` to `frequencies`. Each line has an id and
+  // its frequency in a corpus separated by white spaces.
+  static absl::Status ParseFrequencies(absl::string_view text,
+                                       std::vector<uint64_t> *frequencies);
+
+  // Returns the number of POS ids in id.def.
+  static size_t GetPosSize(absl::string_view id_def);
+
+  // Returns the new id. The ids not in id.def are returned as is.
+  uint16_t GetNewId(uint16_t id) const {
+    return id < new_ids_.size() ? new_ids_[id] : id;
+  }
+
+  // Returns id.def with the new ids, sorted by them.
+  absl::StatusOr<std::string> RenumberIdDef(absl::string_view text) const;
+
+  // Returns the dictionary tokens with the new lids and rids.
+  absl::StatusOr<std::string> RenumberTokens(absl::string_view text) const;
+
+  // Returns connection_single_column.txt with the rows and columns permuted.
+  absl::StatusOr<std::string> RenumberConnection(absl::string_view text) const;
+
+ private:
+  std::vector<uint16_t> new_ids_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_POS_ID_RENUMBERER_H_
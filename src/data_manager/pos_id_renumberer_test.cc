@@ -0,0 +1,116 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/pos_id_renumberer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr char kIdDef[] =
+    "0 BOS/EOS,*,*,*,*,*,*\n"
+    "1 名詞,一般,*,*,*,*,*\n"
+    "2 名詞,固有名詞,*,*,*,*,*\n"
+    "3 助詞,格助詞,*,*,*,*,*\n";
+
+TEST(PosIdRenumbererTest, OrdersByFrequency) {
+  std::vector<uint64_t> frequencies(PosIdRenumberer::GetPosSize(kIdDef));
+  ASSERT_EQ(frequencies.size(), 4);
+  ASSERT_OK(PosIdRenumberer::CountTokens(
+      "が\t3\t3\t100\tが\n"
+      "を\t3\t3\t100\tを\n"
+      "東京\t2\t2\t3000\t東京\n"
+      "ねこ\t1\t1\t3000\t猫\n"
+      "x\t5\t5\t0\tx\n",  // Special POS.
+      &frequencies));
+  EXPECT_THAT(frequencies, ElementsAre(0, 2, 2, 4));
+
+  const PosIdRenumberer renumberer(frequencies);
+  EXPECT_EQ(renumberer.GetNewId(0), 0);
+  EXPECT_EQ(renumberer.GetNewId(3), 1);
+  // Ties keep the original order.
+  EXPECT_EQ(renumberer.GetNewId(1), 2);
+  EXPECT_EQ(renumberer.GetNewId(2), 3);
+  EXPECT_EQ(renumberer.GetNewId(5), 5);
+
+  absl::StatusOr<std::string> id_def = renumberer.RenumberIdDef(kIdDef);
+  ASSERT_OK(id_def);
+  EXPECT_EQ(*id_def,
+            "0 BOS/EOS,*,*,*,*,*,*\n"
+            "1 助詞,格助詞,*,*,*,*,*\n"
+            "2 名詞,一般,*,*,*,*,*\n"
+            "3 名詞,固有名詞,*,*,*,*,*\n");
+
+  absl::StatusOr<std::string> tokens =
+      renumberer.RenumberTokens("が\t3\t1\t100\tが\textra\n# comment\n");
+  ASSERT_OK(tokens);
+  EXPECT_EQ(*tokens, "が\t1\t2\t100\tが\textra\n# comment\n");
+}
+
+TEST(PosIdRenumbererTest, RenumberConnection) {
+  std::vector<uint64_t> frequencies = {0, 1, 5};
+  ASSERT_OK(PosIdRenumberer::ParseFrequencies("1 2\n2\t1\n9 100\n",
+                                              &frequencies));
+  EXPECT_THAT(frequencies, ElementsAre(0, 3, 6));
+  const PosIdRenumberer renumberer(frequencies);
+
+  // cost(rid, lid) = 10 * rid + lid.
+  absl::StatusOr<std::string> connection =
+      renumberer.RenumberConnection("3\n0\n1\n2\n10\n11\n12\n20\n21\n22\n");
+  ASSERT_OK(connection);
+  // Ids 1 and 2 are swapped.
+  EXPECT_EQ(*connection, "3\n0\n2\n1\n20\n22\n21\n10\n12\n11\n");
+
+  EXPECT_FALSE(renumberer.RenumberConnection("2\n0\n1\n2\n3\n").ok());
+  EXPECT_FALSE(renumberer.RenumberConnection("3\n0\n1\n2\n").ok());
+}
+
+TEST(PosIdRenumbererTest, RejectsBrokenData) {
+  std::vector<uint64_t> frequencies(3);
+  EXPECT_FALSE(PosIdRenumberer::CountTokens("a\t1\t1\n", &frequencies).ok());
+  EXPECT_FALSE(
+      PosIdRenumberer::CountTokens("a\tx\t1\t0\ta\n", &frequencies).ok());
+  EXPECT_FALSE(PosIdRenumberer::ParseFrequencies("1\n", &frequencies).ok());
+
+  const PosIdRenumberer renumberer(frequencies);
+  EXPECT_FALSE(renumberer.RenumberIdDef("0 BOS/EOS\n1 a\n").ok());
+  EXPECT_FALSE(renumberer.RenumberIdDef("0 BOS/EOS\n1 a\n1 b\n").ok());
+}
+
+}  // namespace
+}  // namespace mozc
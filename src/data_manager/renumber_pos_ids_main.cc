@@ -0,0 +1,128 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Renumbers the POS ids in the data sources by frequency; see
+// PosIdRenumberer.
+//
+// Usage
+// $ ./path/to/artifacts/renumber_pos_ids_main
+//   --id_def=/path/to/id.def
+//   --connection_file=/path/to/connection_single_column.txt
+//   --dictionary_files="/path/to/dictionary00.txt /path/to/dictionary01.txt"
+//   --suffix_file=/path/to/suffix.txt
+//   [--pos_frequency_file=/path/to/pos_frequency.txt]
+//   --output_dir=/path/to/output
+//
+// The tool writes id.def, connection_single_column.txt, dictionary.txt (the
+// concatenation of the dictionary files) and suffix.txt to --output_dir.
+//
+// Without --pos_frequency_file, the frequency of an id is the number of
+// dictionary tokens using it.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "base/file_util.h"
+#include "base/init_mozc.h"
+#include "data_manager/pos_id_renumberer.h"
+
+ABSL_FLAG(std::string, id_def, "", "id.def");
+ABSL_FLAG(std::string, connection_file, "", "connection_single_column.txt");
+ABSL_FLAG(std::string, dictionary_files, "",
+          "Space separated dictionary files");
+ABSL_FLAG(std::string, suffix_file, "", "suffix.txt");
+ABSL_FLAG(std::string, pos_frequency_file, "",
+          "Frequencies of the POS ids in a corpus; \"id frequency\" per line");
+ABSL_FLAG(std::string, output_dir, "", "Output directory");
+
+namespace mozc {
+namespace {
+
+std::string ReadFileOrDie(const std::string &filename) {
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(filename);
+  CHECK_OK(contents);
+  return *std::move(contents);
+}
+
+void WriteFileOrDie(absl::string_view basename,
+                    const absl::StatusOr<std::string> &contents) {
+  CHECK_OK(contents);
+  CHECK_OK(FileUtil::SetContents(
+      FileUtil::JoinPath(absl::GetFlag(FLAGS_output_dir), basename),
+      *contents));
+}
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  mozc::InitMozc(argv[0], &argc, &argv);
+
+  const std::string id_def = mozc::ReadFileOrDie(absl::GetFlag(FLAGS_id_def));
+  std::string dictionary;
+  for (absl::string_view filename :
+       absl::StrSplit(absl::GetFlag(FLAGS_dictionary_files), ' ',
+                      absl::SkipWhitespace())) {
+    dictionary += mozc::ReadFileOrDie(std::string(filename));
+    if (!dictionary.empty() && dictionary.back() != '\n') {
+      dictionary += '\n';
+    }
+  }
+  const std::string suffix =
+      mozc::ReadFileOrDie(absl::GetFlag(FLAGS_suffix_file));
+
+  std::vector<uint64_t> frequencies(mozc::PosIdRenumberer::GetPosSize(id_def));
+  if (absl::GetFlag(FLAGS_pos_frequency_file).empty()) {
+    CHECK_OK(mozc::PosIdRenumberer::CountTokens(dictionary, &frequencies));
+    CHECK_OK(mozc::PosIdRenumberer::CountTokens(suffix, &frequencies));
+  } else {
+    CHECK_OK(mozc::PosIdRenumberer::ParseFrequencies(
+        mozc::ReadFileOrDie(absl::GetFlag(FLAGS_pos_frequency_file)),
+        &frequencies));
+  }
+  const mozc::PosIdRenumberer renumberer(frequencies);
+
+  mozc::WriteFileOrDie("id.def", renumberer.RenumberIdDef(id_def));
+  mozc::WriteFileOrDie(
+      "connection_single_column.txt",
+      renumberer.RenumberConnection(
+          mozc::ReadFileOrDie(absl::GetFlag(FLAGS_connection_file))));
+  mozc::WriteFileOrDie("dictionary.txt", renumberer.RenumberTokens(dictionary));
+  mozc::WriteFileOrDie("suffix.txt", renumberer.RenumberTokens(suffix));
+  LOG(INFO) << "Renumbered " << frequencies.size() << " POS ids";
+  return 0;
+}
@@ -29,10 +29,27 @@
 
 #include "data_manager/testing/mock_data_manager.h"
 
+#include <sstream>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "base/container/serialized_string_array.h"
+#include "base/file_util.h"
+#include "data_manager/data_manager.h"
 #include "data_manager/data_manager_test_base.h"
+#include "data_manager/dataset.pb.h"
+#include "data_manager/dataset_reader.h"
+#include "data_manager/dataset_writer.h"
+#include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
 
+ABSL_DECLARE_FLAG(bool, record_data_set_page_profile);
+
 namespace mozc {
 namespace testing {
 namespace {
@@ -60,5 +77,164 @@ class MockDataManagerTest : public DataManagerTestBase {
 
 TEST_F(MockDataManagerTest, AllTests) { RunAllTests(); }
 
+TEST(MockDataManagerLazySectionTest, WarmUpSections) {
+  MockDataManager data_manager;
+  EXPECT_TRUE(data_manager.WarmUpCriticalSections());
+  EXPECT_TRUE(data_manager.WarmUpSections({
+      DataManager::LazySection::kSymbol,
+      DataManager::LazySection::kEmoticon,
+      DataManager::LazySection::kEmoji,
+      DataManager::LazySection::kSingleKanji,
+      DataManager::LazySection::kA11yDescription,
+      DataManager::LazySection::kZeroQuery,
+      DataManager::LazySection::kUsage,
+  }));
+}
+
+TEST(MockDataManagerFileTest, NoMLockWhileRecordingPageProfile) {
+  absl::FlagSaver flag_saver;
+  EXPECT_TRUE(DataManager::DataSetMmapOptions().mlock);
+
+  // Locked pages would all be recorded as used.
+  absl::SetFlag(&FLAGS_record_data_set_page_profile, true);
+  EXPECT_FALSE(DataManager::DataSetMmapOptions().mlock);
+  DataManager data_manager;
+  EXPECT_EQ(data_manager.InitFromFile(
+                mozc::testing::GetSourceFileOrDie(
+                    {MOZC_SRC_COMPONENTS("data_manager"), "testing",
+                     "mock_mozc.data"}),
+                "MOCK"),
+            DataManager::Status::OK);
+}
+
+TEST(MockDataManagerLazySectionTest, BrokenSectionFailsInit) {
+  constexpr absl::string_view kMagic = "MOCK";
+  absl::StatusOr<std::string> image =
+      FileUtil::GetContents(mozc::testing::GetSourceFileOrDie(
+          {MOZC_SRC_COMPONENTS("data_manager"), "testing", "mock_mozc.data"}));
+  ASSERT_OK(image);
+  DataSetReader reader;
+  ASSERT_TRUE(reader.Init(*image, kMagic));
+
+  // Replaces the emoji string array with a broken one.
+  DataSetWriter writer(kMagic);
+  for (const auto &[name, data] : reader.name_to_data_map()) {
+    writer.Add(name, 64, name == "emoji_string" ? "broken" : data);
+  }
+  std::stringstream output;
+  writer.Finish(&output);
+  const std::string broken_image = output.str();
+
+  DataManager data_manager;
+  EXPECT_EQ(data_manager.InitFromArray(broken_image, kMagic),
+            DataManager::Status::DATA_BROKEN);
+}
+
+TEST(MockDataManagerLazySectionTest, CompressedSections) {
+  constexpr absl::string_view kMagic = "MOCK";
+  absl::StatusOr<std::string> image =
+      FileUtil::GetContents(mozc::testing::GetSourceFileOrDie(
+          {MOZC_SRC_COMPONENTS("data_manager"), "testing", "mock_mozc.data"}));
+  ASSERT_OK(image);
+  DataSetReader reader;
+  ASSERT_TRUE(reader.Init(*image, kMagic));
+
+  DataSetWriter::Options options;
+  options.compress_cold_sections = true;
+  DataSetWriter writer(kMagic, options);
+  for (const auto &[name, data] : reader.name_to_data_map()) {
+    writer.Add(name, 64, data);
+  }
+  std::stringstream output;
+  writer.Finish(&output);
+  const std::string compressed_image = output.str();
+  EXPECT_LT(compressed_image.size(), image->size());
+
+  // The compressed sections are decompressed on the first use.
+  DataManager data_manager;
+  ASSERT_EQ(data_manager.InitFromArray(compressed_image, kMagic),
+            DataManager::Status::OK);
+  MockDataManager expected;
+  absl::string_view token_array, string_array;
+  absl::string_view expected_token_array, expected_string_array;
+  data_manager.GetEmojiRewriterData(&token_array, &string_array);
+  expected.GetEmojiRewriterData(&expected_token_array, &expected_string_array);
+  EXPECT_EQ(token_array, expected_token_array);
+  EXPECT_EQ(string_array, expected_string_array);
+  data_manager.GetEmoticonRewriterData(&token_array, &string_array);
+  expected.GetEmoticonRewriterData(&expected_token_array,
+                                   &expected_string_array);
+  EXPECT_EQ(token_array, expected_token_array);
+  EXPECT_EQ(string_array, expected_string_array);
+
+  // Init*() replaces the decompressed sections of the previous data set.
+  ASSERT_EQ(data_manager.InitFromArray(*image, kMagic),
+            DataManager::Status::OK);
+  ASSERT_EQ(data_manager.InitFromArray(compressed_image, kMagic),
+            DataManager::Status::OK);
+  EXPECT_TRUE(data_manager.WarmUpCriticalSections());
+  data_manager.GetEmojiRewriterData(&token_array, &string_array);
+  expected.GetEmojiRewriterData(&expected_token_array, &expected_string_array);
+  EXPECT_EQ(token_array, expected_token_array);
+  EXPECT_EQ(string_array, expected_string_array);
+
+  // Only the lazy sections can be compressed.
+  DataSetWriter hot_writer(kMagic);
+  for (const auto &[name, data] : reader.name_to_data_map()) {
+    hot_writer.Add(name, 64, data, DataSetMetadata::HOT,
+                   name == "conn" ? DataSetMetadata::LZ77_BLOCK
+                                  : DataSetMetadata::NO_COMPRESSION);
+  }
+  std::stringstream hot_output;
+  hot_writer.Finish(&hot_output);
+  DataManager hot_data_manager;
+  EXPECT_EQ(hot_data_manager.InitFromArray(hot_output.str(), kMagic),
+            DataManager::Status::DATA_BROKEN);
+}
+
+TEST(MockDataManagerLazySectionTest, BrokenCompressedSectionIsEmpty) {
+  constexpr absl::string_view kMagic = "MOCK";
+  absl::StatusOr<std::string> image =
+      FileUtil::GetContents(mozc::testing::GetSourceFileOrDie(
+          {MOZC_SRC_COMPONENTS("data_manager"), "testing", "mock_mozc.data"}));
+  ASSERT_OK(image);
+  DataSetReader reader;
+  ASSERT_TRUE(reader.Init(*image, kMagic));
+
+  // Replaces the emoji string array with a broken one, which is compressed
+  // and so verified only on the first use.
+  DataSetWriter writer(kMagic);
+  for (const auto &[name, data] : reader.name_to_data_map()) {
+    if (name == "emoji_string") {
+      writer.Add(name, 64, "broken", DataSetMetadata::COLD,
+                 DataSetMetadata::LZ77_BLOCK);
+    } else {
+      writer.Add(name, 64, data);
+    }
+  }
+  std::stringstream output;
+  writer.Finish(&output);
+
+  // The broken section disables only its consumer.
+  DataManager data_manager;
+  ASSERT_EQ(data_manager.InitFromArray(output.str(), kMagic),
+            DataManager::Status::OK);
+  EXPECT_FALSE(data_manager.WarmUpSections({
+      DataManager::LazySection::kSymbol,
+      DataManager::LazySection::kEmoji,
+  }));
+  EXPECT_TRUE(data_manager.WarmUpSections({
+      DataManager::LazySection::kSymbol,
+      DataManager::LazySection::kSingleKanji,
+  }));
+
+  absl::string_view token_array, string_array;
+  data_manager.GetEmojiRewriterData(&token_array, &string_array);
+  EXPECT_TRUE(token_array.empty());
+  SerializedStringArray strings;
+  ASSERT_TRUE(strings.Init(string_array));
+  EXPECT_EQ(strings.size(), 0);
+}
+
 }  // namespace testing
 }  // namespace mozc
@@ -42,8 +42,11 @@
         'mock_data_manager_test.cc',
       ],
       'dependencies': [
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
         '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
         '<(mozc_oss_src_dir)/testing/testing.gyp:mozctest',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:dataset_proto',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:dataset_writer',
         '<(mozc_oss_src_dir)/data_manager/data_manager_test.gyp:data_manager_test_base',
         'install_test_connection_txt',
         'mock_data_manager.gyp:mock_data_manager',
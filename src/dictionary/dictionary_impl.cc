@@ -48,8 +48,8 @@ namespace mozc {
 namespace dictionary {
 
 DictionaryImpl::DictionaryImpl(
-    std::unique_ptr<const DictionaryInterface> system_dictionary,
-    std::unique_ptr<const DictionaryInterface> value_dictionary,
+    std::shared_ptr<const DictionaryInterface> system_dictionary,
+    std::shared_ptr<const DictionaryInterface> value_dictionary,
     DictionaryInterface *user_dictionary,
     const SuppressionDictionary *suppression_dictionary,
     const PosMatcher *pos_matcher)
@@ -46,16 +46,18 @@ namespace dictionary {
 class DictionaryImpl : public DictionaryInterface {
  public:
   // Initializes a dictionary with given dictionaries and POS data.  The system
-  // and value dictionaries are owned by this class but the user dictionary is
-  // just a reference and to be deleted by the caller. Note that the user
+  // and value dictionaries are shared with the other instances built on the
+  // same data, e.g., those of the other users in a server hosting several
+  // users, but the user dictionary is just a reference and to be deleted by the
+  // caller. Note that the user
   // dictionary is not a const reference because this class may reload the user
   // dictionary.
   // TODO(noriyukit): Currently DictionaryInterface::Reload() is not used and
   // thus user_dictionary can be const as well. We can make it const after
   // clarifying the ownership of the user dictionary and changing code so that
   // the owner reloads it.
-  DictionaryImpl(std::unique_ptr<const DictionaryInterface> system_dictionary,
-                 std::unique_ptr<const DictionaryInterface> value_dictionary,
+  DictionaryImpl(std::shared_ptr<const DictionaryInterface> system_dictionary,
+                 std::shared_ptr<const DictionaryInterface> value_dictionary,
                  DictionaryInterface *user_dictionary,
                  const SuppressionDictionary *suppression_dictionary,
                  const PosMatcher *pos_matcher);
@@ -101,8 +103,8 @@ class DictionaryImpl : public DictionaryInterface {
   const PosMatcher *pos_matcher_;
 
   // Main three dictionaries.
-  std::unique_ptr<const DictionaryInterface> system_dictionary_;
-  std::unique_ptr<const DictionaryInterface> value_dictionary_;
+  std::shared_ptr<const DictionaryInterface> system_dictionary_;
+  std::shared_ptr<const DictionaryInterface> value_dictionary_;
   DictionaryInterface *user_dictionary_;
 
   // Convenient container to handle the above three dictionaries as one
@@ -43,6 +43,7 @@ class PosDataBase(object):
 
   def __init__(self):
     self.id_list = []
+    self.sorted_id_list = []
 
   def Parse(self, id_file, special_pos_file):
     id_list = []
@@ -53,16 +54,21 @@ class PosDataBase(object):
         id_list.append((feature, int(pos_id)))
 
     max_id = max(pos_id for _, pos_id in id_list)
+    sorted_id_list = sorted(id_list)
     with codecs.open(special_pos_file, 'r', encoding='utf-8') as stream:
       stream = code_generator_util.SkipLineComment(stream)
       for pos_id, line in enumerate(stream, start=max_id + 1):
         id_list.append((line, pos_id))
+        sorted_id_list.append((line, pos_id))
     self.id_list = id_list
+    self.sorted_id_list = sorted_id_list
 
   def GetPosId(self, feature):
     """Returns id for the feature if found. Otherwise None."""
     assert feature
-    for line, pos_id in self.id_list:
+    # Look up in the order of the features rather than the ids, so that the
+    # result doesn't depend on the numbering of the ids.
+    for line, pos_id in self.sorted_id_list:
       # Return by prefix match.
       if line.startswith(feature): return pos_id
 
@@ -79,6 +85,12 @@ class PosDataBase(object):
     if result:
       yield result
 
+  def GetFirstId(self, pattern):
+    """Returns the id of the first feature matching the pattern."""
+    for line, pos_id in self.sorted_id_list:
+      if pattern.match(line):
+        return pos_id
+
   def GetRange(self, pattern):
     id_list = [
         pos_id for line, pos_id in self.id_list if pattern.match(line)]
@@ -111,7 +123,7 @@ class PosMatcher(object):
     return self.pos_database.GetRange(self._match_rule_map[name][1])
 
   def GetId(self, name):
-    return self.pos_database.GetRange(self._match_rule_map[name][1])[0][0]
+    return self.pos_database.GetFirstId(self._match_rule_map[name][1])
 
   def GetOriginalPattern(self, name):
     return self._match_rule_map[name][0]
@@ -271,8 +271,7 @@ class UserDictionary::UserDictionaryReloader {
     }
 
     absl::StatusOr<FileTimeStamp> modification_time =
-        FileUtil::GetModificationTime(
-            Singleton<UserDictionaryFileManager>::get()->GetFileName());
+        FileUtil::GetModificationTime(dic_->GetFileName());
     if (!modification_time.ok()) {
       // If the file doesn't exist, return doing nothing.
       // Therefore if the file is deleted after first reload,
@@ -286,8 +285,8 @@ class UserDictionary::UserDictionaryReloader {
       return false;
     }
     modified_at_ = *modification_time;
-    // Runs `ThreadMain()` in a background thread.
-    reload_.emplace([this] { ThreadMain(); });
+    // Runs `ThreadMain()` on the shared background thread pool.
+    reload_.emplace(ThreadPool::Default(), [this] { ThreadMain(); });
     return true;
   }
 
@@ -299,8 +298,7 @@ class UserDictionary::UserDictionaryReloader {
 
  private:
   void ThreadMain() {
-    UserDictionaryStorage storage(
-        Singleton<UserDictionaryFileManager>::get()->GetFileName());
+    UserDictionaryStorage storage(dic_->GetFileName());
 
     // Load from file
     if (absl::Status s = storage.Load(); !s.ok()) {
@@ -331,7 +329,15 @@ class UserDictionary::UserDictionaryReloader {
 UserDictionary::UserDictionary(std::unique_ptr<const UserPosInterface> user_pos,
                                PosMatcher pos_matcher,
                                SuppressionDictionary *suppression_dictionary)
-    : reloader_(std::make_unique<UserDictionaryReloader>(this)),
+    : UserDictionary(std::move(user_pos), pos_matcher, suppression_dictionary,
+                     "") {}
+
+UserDictionary::UserDictionary(std::unique_ptr<const UserPosInterface> user_pos,
+                               PosMatcher pos_matcher,
+                               SuppressionDictionary *suppression_dictionary,
+                               std::string filename)
+    : filename_(std::move(filename)),
+      reloader_(std::make_unique<UserDictionaryReloader>(this)),
       user_pos_(std::move(user_pos)),
       pos_matcher_(pos_matcher),
       suppression_dictionary_(suppression_dictionary),
@@ -608,6 +614,13 @@ void UserDictionary::SetUserDictionaryName(const absl::string_view filename) {
   Singleton<UserDictionaryFileManager>::get()->SetFileName(filename);
 }
 
+std::string UserDictionary::GetFileName() const {
+  if (!filename_.empty()) {
+    return filename_;
+  }
+  return Singleton<UserDictionaryFileManager>::get()->GetFileName();
+}
+
 void UserDictionary::PopulateTokenFromUserPosToken(
     const UserPosInterface::Token &user_pos_token, RequestType request_type,
     Token *token) const {
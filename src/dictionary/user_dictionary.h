@@ -53,6 +53,12 @@ class UserDictionary : public UserDictionaryInterface {
   UserDictionary(std::unique_ptr<const UserPosInterface> user_pos,
                  PosMatcher pos_matcher,
                  SuppressionDictionary *suppression_dictionary);
+  // Loads the dictionary from `filename` instead of the file of the user
+  // running this process. Used by the server hosting several users.
+  UserDictionary(std::unique_ptr<const UserPosInterface> user_pos,
+                 PosMatcher pos_matcher,
+                 SuppressionDictionary *suppression_dictionary,
+                 std::string filename);
 
   UserDictionary(const UserDictionary &) = delete;
   UserDictionary &operator=(const UserDictionary &) = delete;
@@ -116,6 +122,11 @@ class UserDictionary : public UserDictionaryInterface {
   // Swaps internal tokens index to |new_tokens|.
   void Swap(std::unique_ptr<TokensIndex> new_tokens);
 
+  // Returns the file name of the dictionary.
+  std::string GetFileName() const;
+
+  // Empty if the file of the user running this process is used.
+  const std::string filename_;
   std::unique_ptr<UserDictionaryReloader> reloader_;
   std::unique_ptr<const UserPosInterface> user_pos_;
   const PosMatcher pos_matcher_;
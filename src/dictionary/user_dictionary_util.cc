@@ -60,7 +60,6 @@ constexpr size_t kMaxKeySize = 300;
 constexpr size_t kMaxValueSize = 300;
 constexpr size_t kMaxCommentSize = 300;
 constexpr char kInvalidChars[] = "\n\r\t";
-constexpr char kUserDictionaryFile[] = "user://user_dictionary.db";
 
 // Maximum string length for dictionary name.
 constexpr size_t kMaxDictionaryNameSize = 300;
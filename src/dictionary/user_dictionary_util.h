@@ -128,6 +128,9 @@ class UserDictionaryUtil {
       const user_dictionary::UserDictionaryStorage &storage,
       uint64_t dictionary_id);
 
+  // The file of UserDictionary in the user profile directory.
+  static constexpr char kUserDictionaryFile[] = "user://user_dictionary.db";
+
   // Returns the file name of UserDictionary.
   static std::string GetUserDictionaryFileName();
 
@@ -184,7 +184,7 @@ DataLoader::ResponseFuture DataLoader::Build(uint64_t id) const {
       std::find_if(requests_.begin(), requests_.end(),
                    [id](const RequestData &v) { return v.id == id; });
   if (it == requests_.end()) {
-    return DataLoader::ResponseFuture([id]() {
+    return DataLoader::ResponseFuture(ThreadPool::Default(), [id]() {
       Response response;
       response.id = id;
       response.response.set_status(EngineReloadResponse::DATA_MISSING);
@@ -193,9 +193,10 @@ DataLoader::ResponseFuture DataLoader::Build(uint64_t id) const {
   }
 
   EngineReloadRequest request = it->request;
-  return DataLoader::ResponseFuture([id, request = std::move(request)]() {
-    return BuildResponse(id, request);
-  });
+  return DataLoader::ResponseFuture(
+      ThreadPool::Default(), [id, request = std::move(request)]() {
+        return BuildResponse(id, request);
+      });
 }
 
 bool DataLoader::StartNewDataBuildTask() {
@@ -30,19 +30,29 @@
 #include "engine/engine.h"
 
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 
 #include "absl/base/optimization.h"
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/config_file_stream.h"
+#include "base/file_util.h"
+#include "base/thread.h"
 #include "base/vlog.h"
 #include "converter/converter.h"
 #include "converter/immutable_converter.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/dataset_page_profile.h"
+#include "data_manager/derived_data_cache.h"
 #include "engine/data_loader.h"
 #include "engine/modules.h"
 #include "engine/supplemental_model_interface.h"
@@ -55,11 +65,30 @@
 #include "rewriter/rewriter.h"
 #include "rewriter/rewriter_interface.h"
 
+ABSL_DECLARE_FLAG(bool, record_data_set_page_profile);  // in DataManager
+ABSL_FLAG(std::string, derived_data_cache_dir, "",
+          "Directory of the cache of the data structures derived from the data "
+          "set, which is shared by the servers. It must not be writable by the "
+          "others and be owned by this user, root or "
+          "--derived_data_cache_trusted_uid. Disabled if empty.");
+
 namespace mozc {
 namespace {
 
 using ::mozc::prediction::PredictorInterface;
 
+constexpr char kDataSetPageProfileFile[] = "user://data_set_pages.db";
+
+absl::StatusOr<DataSetPageProfile> LoadDataSetPageProfile() {
+  const std::string filename =
+      ConfigFileStream::GetFileName(kDataSetPageProfileFile);
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(filename);
+  if (!contents.ok()) {
+    return contents.status();
+  }
+  return DataSetPageProfile::Parse(*contents);
+}
+
 class UserDataManager final : public UserDataManagerInterface {
  public:
   UserDataManager(PredictorInterface *predictor, RewriterInterface *rewriter)
@@ -161,7 +190,20 @@ std::unique_ptr<Engine> Engine::CreateEngine() {
 
 Engine::Engine()
     : loader_(std::make_unique<DataLoader>()),
-      modules_(std::make_unique<engine::Modules>()) {}
+      components_(std::make_shared<Components>()) {
+  components_->modules = std::make_unique<engine::Modules>();
+}
+
+Engine::~Engine() { StopDataSetWarmUp(); }
+
+std::shared_ptr<ConverterInterface> Engine::GetSharedConverter() const {
+  if (!initialized_) {
+    return minimal_engine_.GetSharedConverter();
+  }
+  // Shares the ownership of the whole stack the converter depends on.
+  return std::shared_ptr<ConverterInterface>(components_,
+                                             components_->converter.get());
+}
 
 absl::Status Engine::ReloadModules(std::unique_ptr<engine::Modules> modules,
                                    bool is_mobile) {
@@ -171,6 +213,17 @@ absl::Status Engine::ReloadModules(std::unique_ptr<engine::Modules> modules,
 
 absl::Status Engine::Init(std::unique_ptr<engine::Modules> modules,
                           bool is_mobile) {
+  absl::StatusOr<std::shared_ptr<Components>> components =
+      BuildComponents(std::move(modules), is_mobile);
+  if (!components.ok()) {
+    return components.status();
+  }
+  InstallComponents(*std::move(components));
+  return absl::Status();
+}
+
+absl::StatusOr<std::shared_ptr<Engine::Components>> Engine::BuildComponents(
+    std::unique_ptr<engine::Modules> modules, bool is_mobile) {
 #define RETURN_IF_NULL(ptr)                                               \
   do {                                                                    \
     if (!(ptr))                                                           \
@@ -179,15 +232,28 @@ absl::Status Engine::Init(std::unique_ptr<engine::Modules> modules,
 
   RETURN_IF_NULL(modules);
 
-  // Keeps the previous supplemental_model if exists.
-  const engine::SupplementalModelInterface *supplemental_model =
-      modules_->GetSupplementalModel();
+  // The modules of a user in a server hosting several users already share the
+  // cache.
+  if (const std::string dir = absl::GetFlag(FLAGS_derived_data_cache_dir);
+      !dir.empty() && modules->GetDerivedDataCache() == nullptr) {
+    absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+        DerivedDataCache::Open(dir, modules->GetDataManager(),
+                               Rewriter::GetDerivedDataSections());
+    if (cache.ok()) {
+      modules->SetDerivedDataCache(*std::move(cache));
+    } else {
+      LOG(WARNING) << "Derived data cache is not available: "
+                   << cache.status();
+    }
+  }
 
-  modules_ = std::move(modules);
-  modules_->SetSupplementalModel(supplemental_model);
+  auto components = std::make_shared<Components>();
+  components->modules = std::move(modules);
+  const engine::Modules &modules_ref = *components->modules;
 
-  immutable_converter_ = std::make_unique<ImmutableConverter>(*modules_);
-  RETURN_IF_NULL(immutable_converter_);
+  components->immutable_converter =
+      std::make_unique<ImmutableConverter>(modules_ref);
+  RETURN_IF_NULL(components->immutable_converter);
 
   // Since predictor and rewriter require a pointer to a converter instance,
   // allocate it first without initialization. It is initialized at the end of
@@ -195,8 +261,9 @@ absl::Status Engine::Init(std::unique_ptr<engine::Modules> modules,
   // TODO(noriyukit): This circular dependency is a bad design as careful
   // handling is necessary to avoid infinite loop. Find more beautiful design
   // and fix it!
-  converter_ = std::make_unique<Converter>();
-  RETURN_IF_NULL(converter_);
+  components->converter = std::make_unique<Converter>();
+  RETURN_IF_NULL(components->converter);
+  Converter *converter = components->converter.get();
 
   std::unique_ptr<PredictorInterface> predictor;
   {
@@ -204,65 +271,150 @@ absl::Status Engine::Init(std::unique_ptr<engine::Modules> modules,
     // history predictor, and extra predictor.
     auto dictionary_predictor =
         std::make_unique<prediction::DictionaryPredictor>(
-            *modules_, converter_.get(), immutable_converter_.get());
+            modules_ref, converter, components->immutable_converter.get());
     RETURN_IF_NULL(dictionary_predictor);
 
     const bool enable_content_word_learning = is_mobile;
     auto user_history_predictor =
         std::make_unique<prediction::UserHistoryPredictor>(
-            *modules_, enable_content_word_learning);
+            modules_ref, enable_content_word_learning);
     RETURN_IF_NULL(user_history_predictor);
 
     if (is_mobile) {
       predictor = prediction::MobilePredictor::CreateMobilePredictor(
           std::move(dictionary_predictor), std::move(user_history_predictor),
-          converter_.get());
+          converter);
     } else {
       predictor = prediction::DefaultPredictor::CreateDefaultPredictor(
           std::move(dictionary_predictor), std::move(user_history_predictor),
-          converter_.get());
+          converter);
     }
     RETURN_IF_NULL(predictor);
   }
-  predictor_ = predictor.get();  // Keep the reference
+  components->predictor = predictor.get();  // Keep the reference
 
-  auto rewriter = std::make_unique<Rewriter>(*modules_, *converter_);
+  auto rewriter = std::make_unique<Rewriter>(modules_ref, *converter);
   RETURN_IF_NULL(rewriter);
-  rewriter_ = rewriter.get();  // Keep the reference
+  components->rewriter = rewriter.get();  // Keep the reference
 
-  converter_->Init(*modules_, std::move(predictor), std::move(rewriter),
-                   immutable_converter_.get());
+  converter->Init(modules_ref, std::move(predictor), std::move(rewriter),
+                  components->immutable_converter.get());
 
-  user_data_manager_ = std::make_unique<UserDataManager>(predictor_, rewriter_);
+  components->user_data_manager = std::make_unique<UserDataManager>(
+      components->predictor, components->rewriter);
+  return components;
+
+#undef RETURN_IF_NULL
+}
+
+void Engine::InstallComponents(std::shared_ptr<Components> components) {
+  // The warm-up reads the image owned by the current modules.
+  StopDataSetWarmUp();
+
+  // Keeps the previous supplemental_model if exists.
+  components->modules->SetSupplementalModel(supplemental_model_);
 
+  // The previous components are released here, or when the last session using
+  // them moves to the new ones.
+  components_ = std::move(components);
   initialized_ = true;
-  return absl::Status();
+  StartDataSetWarmUp();
+}
 
-#undef RETURN_IF_NULL
+void Engine::StartDataSetWarmUp() {
+  const DataManagerInterface *data_manager =
+      &components_->modules->GetDataManager();
+  const Rewriter *rewriter = components_->rewriter;
+  const absl::Span<const char> image = data_manager->GetMappedImage();
+  std::optional<DataSetPageProfile> profile;
+  // Warming up while recording would record every page of the profile.
+  if (!image.empty() && !absl::GetFlag(FLAGS_record_data_set_page_profile)) {
+    absl::StatusOr<DataSetPageProfile> loaded = LoadDataSetPageProfile();
+    if (loaded.ok() && !loaded->empty()) {
+      profile = *std::move(loaded);
+    } else {
+      MOZC_VLOG(1) << "No page profile of the data set: " << loaded.status();
+    }
+  }
+  cancel_warm_up_ = false;
+  warm_up_.emplace(
+      ThreadPool::Default(), ThreadPool::Priority::kLow,
+      [this, data_manager, rewriter, image, profile = std::move(profile)]() {
+        // The sections and the rewriters used on every conversion are prepared
+        // here rather than on the first key event.
+        if (cancel_warm_up_) {
+          return;
+        }
+        LOG_IF(ERROR, !data_manager->WarmUpCriticalSections())
+            << "Some sections of the data set are broken";
+        if (rewriter != nullptr && !cancel_warm_up_) {
+          rewriter->WarmUp();
+        }
+        if (!profile.has_value() || cancel_warm_up_) {
+          return;
+        }
+        absl::Status status = profile->WarmUp(image, cancel_warm_up_);
+        MOZC_VLOG(1) << "Warmed up " << profile->num_recorded_pages()
+                     << " pages of the data set: " << status;
+      });
+}
+
+void Engine::StopDataSetWarmUp() {
+  if (!warm_up_.has_value()) {
+    return;
+  }
+  // Waiting for the pending task would run it on this thread.
+  cancel_warm_up_ = true;
+  warm_up_->Cancel();
+  warm_up_->Wait();
+  warm_up_.reset();
+}
+
+void Engine::MaybeRecordDataSetPageProfile() {
+  if (!absl::GetFlag(FLAGS_record_data_set_page_profile) || !initialized_) {
+    return;
+  }
+  const absl::Span<const char> image =
+      components_->modules->GetDataManager().GetMappedImage();
+  if (image.empty()) {
+    return;
+  }
+  DataSetPageProfile profile =
+      LoadDataSetPageProfile().value_or(DataSetPageProfile());
+  if (absl::Status status = profile.Record(image); !status.ok()) {
+    LOG(WARNING) << "Failed to record the page profile: " << status;
+    return;
+  }
+  const std::string filename =
+      ConfigFileStream::GetFileName(kDataSetPageProfileFile);
+  if (!ConfigFileStream::AtomicUpdate(filename, profile.Serialize())) {
+    LOG(WARNING) << "Failed to save the page profile: " << filename;
+  }
 }
 
 bool Engine::Reload() {
-  if (!modules_->GetUserDictionary()) {
+  if (!components_->modules->GetUserDictionary()) {
     return true;
   }
   MOZC_VLOG(1) << "Reloading user dictionary";
-  bool result_dictionary = modules_->GetUserDictionary()->Reload();
+  bool result_dictionary = components_->modules->GetUserDictionary()->Reload();
   MOZC_VLOG(1) << "Reloading UserDataManager";
   bool result_user_data = GetUserDataManager()->Reload();
   return result_dictionary && result_user_data;
 }
 
 bool Engine::Sync() {
+  MaybeRecordDataSetPageProfile();
   GetUserDataManager()->Sync();
-  if (!modules_->GetUserDictionary()) {
+  if (!components_->modules->GetUserDictionary()) {
     return true;
   }
-  return modules_->GetUserDictionary()->Sync();
+  return components_->modules->GetUserDictionary()->Sync();
 }
 
 bool Engine::Wait() {
-  if (modules_->GetUserDictionary()) {
-    modules_->GetUserDictionary()->WaitForReloader();
+  if (components_->modules->GetUserDictionary()) {
+    components_->modules->GetUserDictionary()->WaitForReloader();
   }
   return GetUserDataManager()->Wait();
 }
@@ -283,52 +435,83 @@ bool Engine::MaybeReloadEngine(EngineReloadResponse *response) {
   // In the while loop, tries to reload the new data. If the new data is broken,
   // tries it again as a next round of this while loop.
   while (true) {
-    if (!loader_->StartNewDataBuildTask()) {
-      // No new build process is running or ready.
-      return false;
+    if (!pending_build_.has_value()) {
+      if (!loader_->StartNewDataBuildTask()) {
+        // No new build process is running or ready.
+        return false;
+      }
+
+      std::unique_ptr<DataLoader::Response> loader_response =
+          loader_->MaybeMoveDataLoaderResponse();
+      if (!loader_response) {
+        // No new data is available. The build process is still running.
+        return false;
+      }
+
+      *response = loader_response->response;
+      LOG(INFO) << "New data is ready (install_location="
+                << response->request().install_location() << ")";
+
+      if (!loader_response->modules ||
+          response->status() != EngineReloadResponse::RELOAD_READY) {
+        // The loader_response does not contain a valid result.
+
+        // This request id causes a critical error.
+        LOG(ERROR) << "Failure in loading response: " << *response;
+
+        // Unregisters the invalid ID and continues to rebuild a new data
+        // loader.
+        loader_->ReportLoadFailure(loader_response->id);
+        continue;
+      }
+
+      // Builds the converter stack on the new modules in the background, so
+      // that the command doesn't wait for it.
+      const bool is_mobile =
+          response->request().engine_type() == EngineReloadRequest::MOBILE;
+      pending_build_.emplace(PendingBuild{
+          .id = loader_response->id,
+          .response = loader_response->response,
+          .components =
+              BackgroundFuture<absl::StatusOr<std::shared_ptr<Components>>>(
+                  ThreadPool::Default(), &Engine::BuildComponents,
+                  std::move(loader_response->modules), is_mobile),
+      });
     }
 
-    std::unique_ptr<DataLoader::Response> loader_response =
-        loader_->MaybeMoveDataLoaderResponse();
-    if (!loader_response) {
-      // No new data is available. The build process is still running.
+    // Nothing can be used until the first engine is ready.
+    if (!initialized_ || always_wait_for_testing_) {
+      pending_build_->components.Wait();
+    }
+    if (!pending_build_->components.Ready()) {
       return false;
     }
 
-    *response = loader_response->response;
-    LOG(INFO) << "New data is ready (install_location="
-              << response->request().install_location() << ")";
-
-    if (!loader_response->modules ||
-        response->status() != EngineReloadResponse::RELOAD_READY) {
-      // The loader_response does not contain a valid result.
-
-      // This request id causes a critical error.
-      LOG(ERROR) << "Failure in loading response: " << *response;
+    const uint64_t id = pending_build_->id;
+    *response = std::move(pending_build_->response);
+    absl::StatusOr<std::shared_ptr<Components>> components =
+        std::move(pending_build_->components).Get();
+    pending_build_.reset();
+    if (!components.ok()) {
+      LOG(ERROR) << components.status();
 
       // Unregisters the invalid ID and continues to rebuild a new data loader.
-      loader_->ReportLoadFailure(loader_response->id);
+      loader_->ReportLoadFailure(id);
       continue;
     }
 
-    if (user_data_manager_) {
-      user_data_manager_->Wait();
+    // Hands the user data over. The new stack read it when the build started,
+    // and the current one has kept learning since then, so it's saved here
+    // and read again by the new stack. SessionHandler moves the sessions to
+    // the new stack before they run another command, so the previous one
+    // doesn't learn after this.
+    if (initialized_) {
+      Sync();
+      Wait();
     }
-
-    // Reloads DataManager.
-    const bool is_mobile =
-        response->request().engine_type() == EngineReloadRequest::MOBILE;
-    absl::Status reload_status =
-        ReloadModules(std::move(loader_response->modules), is_mobile);
-    if (!reload_status.ok()) {
-      LOG(ERROR) << reload_status;
-
-      // Unregisters the invalid ID and continues to rebuild a new data loader.
-      loader_->ReportLoadFailure(loader_response->id);
-      continue;
-    }
-
-    loader_->ReportLoadSuccess(loader_response->id);
+    InstallComponents(*std::move(components));
+    ReloadAndWait();
+    loader_->ReportLoadSuccess(id);
     response->set_status(EngineReloadResponse::RELOADED);
     return true;
   }
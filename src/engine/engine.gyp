@@ -63,6 +63,8 @@
         '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
         '<(mozc_oss_src_dir)/base/base.gyp:base',
         '<(mozc_oss_src_dir)/converter/converter.gyp:converter',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:dataset_page_profile',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:derived_data_cache',
         '<(mozc_oss_src_dir)/dictionary/dictionary_base.gyp:pos_matcher',
         '<(mozc_oss_src_dir)/dictionary/dictionary_base.gyp:user_dictionary',
         '<(mozc_oss_src_dir)/engine/engine_base.gyp:modules',
@@ -30,7 +30,10 @@
 #ifndef MOZC_ENGINE_ENGINE_H_
 #define MOZC_ENGINE_ENGINE_H_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -38,6 +41,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "base/thread.h"
 #include "converter/converter.h"
 #include "converter/converter_interface.h"
 #include "converter/immutable_converter_interface.h"
@@ -50,6 +54,8 @@
 #include "engine/supplemental_model_interface.h"
 #include "engine/user_data_manager_interface.h"
 #include "prediction/predictor_interface.h"
+#include "protocol/engine_builder.pb.h"
+#include "rewriter/rewriter.h"
 #include "rewriter/rewriter_interface.h"
 
 namespace mozc {
@@ -95,20 +101,26 @@ class Engine : public EngineInterface {
 
   Engine(const Engine &) = delete;
   Engine &operator=(const Engine &) = delete;
+  ~Engine() override;
 
   ConverterInterface *GetConverter() const override {
-    return initialized_ ? converter_.get() : minimal_engine_.GetConverter();
+    return initialized_ ? components_->converter.get()
+                        : minimal_engine_.GetConverter();
   }
+  std::shared_ptr<ConverterInterface> GetSharedConverter() const override;
   absl::string_view GetPredictorName() const override {
     if (initialized_) {
-      return predictor_ ? predictor_->GetPredictorName() : absl::string_view();
+      return components_->predictor
+                 ? components_->predictor->GetPredictorName()
+                 : absl::string_view();
     } else {
       return minimal_engine_.GetPredictorName();
     }
   }
   dictionary::SuppressionDictionary *GetSuppressionDictionary() override {
-    return initialized_ ? modules_->GetMutableSuppressionDictionary()
-                        : minimal_engine_.GetSuppressionDictionary();
+    return initialized_
+               ? components_->modules->GetMutableSuppressionDictionary()
+               : minimal_engine_.GetSuppressionDictionary();
   }
 
   // Functions for Reload, Sync, Wait return true if successfully operated
@@ -122,7 +134,7 @@ class Engine : public EngineInterface {
                              bool is_mobile) override;
 
   UserDataManagerInterface *GetUserDataManager() override {
-    return initialized_ ? user_data_manager_.get()
+    return initialized_ ? components_->user_data_manager.get()
                         : minimal_engine_.GetUserDataManager();
   }
 
@@ -131,7 +143,7 @@ class Engine : public EngineInterface {
   }
 
   const DataManagerInterface *GetDataManager() const override {
-    return initialized_ ? &modules_->GetDataManager()
+    return initialized_ ? &components_->modules->GetDataManager()
                         : minimal_engine_.GetDataManager();
   }
 
@@ -140,17 +152,21 @@ class Engine : public EngineInterface {
   // Since the POS set may differ per LM, this function returns
   // available POS items. In practice, the POS items are rarely changed.
   std::vector<std::string> GetPosList() const override {
-    return initialized_ ? modules_->GetUserDictionary()->GetPosList()
-                        : minimal_engine_.GetPosList();
+    return initialized_
+               ? components_->modules->GetUserDictionary()->GetPosList()
+               : minimal_engine_.GetPosList();
   }
 
   void SetSupplementalModel(
       const engine::SupplementalModelInterface *supplemental_model) override {
-    modules_->SetSupplementalModel(supplemental_model);
+    supplemental_model_ = supplemental_model;
+    components_->modules->SetSupplementalModel(supplemental_model);
   }
 
   // For testing only.
-  engine::Modules *GetModulesForTesting() const { return modules_.get(); }
+  engine::Modules *GetModulesForTesting() const {
+    return components_->modules.get();
+  }
 
   // Maybe reload a new data manager. Returns true if reloaded.
   bool MaybeReloadEngine(EngineReloadResponse *response) override;
@@ -159,32 +175,74 @@ class Engine : public EngineInterface {
     loader_ = std::move(loader);
   }
   void SetAlwaysWaitForLoaderResponseFutureForTesting(bool value) override {
+    always_wait_for_testing_ = value;
     loader_->SetAlwaysWaitForLoaderResponseFutureForTesting(value);
   }
 
  private:
+  // The conversion stack built on a set of modules. It is shared with the
+  // sessions through GetSharedConverter(), so that the previous stack stays
+  // alive after a reload until every session has moved to the new one.
+  struct Components {
+    // Members are destroyed in the reverse order, so the modules outlive the
+    // converters referring to them.
+    std::unique_ptr<engine::Modules> modules;
+    std::unique_ptr<ImmutableConverterInterface> immutable_converter;
+    // TODO(noriyukit): Currently predictor and rewriter are created by this
+    // class but owned by converter. Since this class creates these two, it'd
+    // be better if Engine class owns these two instances.
+    prediction::PredictorInterface *predictor = nullptr;
+    Rewriter *rewriter = nullptr;
+    std::unique_ptr<Converter> converter;
+    std::unique_ptr<UserDataManagerInterface> user_data_manager;
+  };
+
+  // The result of the background build started by MaybeReloadEngine().
+  struct PendingBuild {
+    uint64_t id = 0;
+    EngineReloadResponse response;
+    BackgroundFuture<absl::StatusOr<std::shared_ptr<Components>>> components;
+  };
+
   Engine();
 
+  // Builds the converter, predictor and rewriter on `modules`. The
+  // is_mobile flag is used to select DefaultPredictor and MobilePredictor.
+  // This doesn't touch the engine, so it can run on any thread.
+  static absl::StatusOr<std::shared_ptr<Components>> BuildComponents(
+      std::unique_ptr<engine::Modules> modules, bool is_mobile);
+
   // Initializes the engine object by the given modules and is_mobile flag.
-  // The is_mobile flag is used to select DefaultPredictor and MobilePredictor.
   absl::Status Init(std::unique_ptr<engine::Modules> modules, bool is_mobile);
 
+  // Replaces the current components with `components`.
+  void InstallComponents(std::shared_ptr<Components> components);
+
+  // Prepares the critical data set sections and the lazy rewriters, and reads
+  // the pages of the mapped data set recorded in the page profile in the
+  // background, so that the first conversions don't wait for them.
+  void StartDataSetWarmUp();
+  // Cancels the warm-up and waits for it. Must be called before the data set
+  // is released.
+  void StopDataSetWarmUp();
+  // Records the currently resident pages of the data set to the page profile
+  // if --record_data_set_page_profile is set.
+  void MaybeRecordDataSetPageProfile();
+
   // If initialized_ is false, minimal_engine_ is used as a fallback engine.
   bool initialized_ = false;
   MinimalEngine minimal_engine_;
 
   std::unique_ptr<DataLoader> loader_;
-  std::unique_ptr<engine::Modules> modules_;
-  std::unique_ptr<ImmutableConverterInterface> immutable_converter_;
+  std::optional<PendingBuild> pending_build_;
+  bool always_wait_for_testing_ = false;
 
-  // TODO(noriyukit): Currently predictor and rewriter are created by this class
-  // but owned by converter_. Since this class creates these two, it'd be better
-  // if Engine class owns these two instances.
-  prediction::PredictorInterface *predictor_ = nullptr;
-  RewriterInterface *rewriter_ = nullptr;
+  // Never null. Only has empty modules until initialized.
+  std::shared_ptr<Components> components_;
+  const engine::SupplementalModelInterface *supplemental_model_ = nullptr;
 
-  std::unique_ptr<Converter> converter_;
-  std::unique_ptr<UserDataManagerInterface> user_data_manager_;
+  std::atomic<bool> cancel_warm_up_ = false;
+  std::optional<BackgroundFuture<void>> warm_up_;
 };
 
 }  // namespace mozc
@@ -46,6 +46,7 @@
         '<(mozc_oss_src_dir)/base/base.gyp:base',
         '<(mozc_oss_src_dir)/converter/converter_base.gyp:connector',
         '<(mozc_oss_src_dir)/converter/converter_base.gyp:segmenter',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:derived_data_cache',
         '<(mozc_oss_src_dir)/dictionary/dictionary.gyp:dictionary_impl',
         '<(mozc_oss_src_dir)/dictionary/dictionary.gyp:suffix_dictionary',
         '<(mozc_oss_src_dir)/dictionary/dictionary_base.gyp:pos_matcher',
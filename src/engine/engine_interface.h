@@ -62,6 +62,14 @@ class EngineInterface {
   // engine class and should not be deleted by callers.
   virtual ConverterInterface *GetConverter() const = 0;
 
+  // Returns the converter with a shared ownership of everything it depends on,
+  // which stays valid even after the engine is reloaded. The default
+  // implementation doesn't own it; it's valid as long as GetConverter() is.
+  virtual std::shared_ptr<ConverterInterface> GetSharedConverter() const {
+    return std::shared_ptr<ConverterInterface>(std::shared_ptr<void>(),
+                                               GetConverter());
+  }
+
   // Returns the predictor name.
   virtual absl::string_view GetPredictorName() const = 0;
 
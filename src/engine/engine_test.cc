@@ -32,14 +32,22 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/log/check.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "converter/converter_interface.h"
+#include "converter/segments.h"
 #include "data_manager/data_manager.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "engine/modules.h"
 #include "engine/supplemental_model_interface.h"
+#include "prediction/user_history_predictor.h"
 #include "protocol/engine_builder.pb.h"
+#include "request/conversion_request.h"
+#include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
 
@@ -54,9 +62,25 @@ class SupplementalModelForTesting : public engine::SupplementalModelInterface {
 constexpr absl::string_view kMockMagicNumber = "MOCK";
 constexpr absl::string_view kOssMagicNumber = "\xEFMOZC\x0D\x0A";
 constexpr int kMiddlePriority = 50;
+
+// Converts `key` and learns the first candidate of the first segment. Returns
+// its value.
+std::string Learn(Engine &engine, absl::string_view key) {
+  // The user history doesn't learn while it's loaded.
+  CHECK(engine.Wait());
+  ConverterInterface *converter = engine.GetConverter();
+  Segments segments;
+  CHECK(converter->StartConversionWithKey(&segments, key));
+  std::string value = segments.conversion_segment(0).candidate(0).value;
+  CHECK(converter->CommitSegmentValue(&segments, 0, 0));
+  const ConversionRequest default_request;
+  converter->FinishConversion(default_request, &segments);
+  return value;
+}
+
 }  // namespace
 
-class EngineTest : public ::testing::Test {
+class EngineTest : public testing::TestWithTempUserProfile {
  protected:
   EngineTest() {
     const std::string mock_path = testing::GetSourcePath(
@@ -147,6 +171,75 @@ TEST_F(EngineTest, DataLoadSuccessfulScenarioTest) {
   EXPECT_EQ(engine_->GetDataVersion(), mock_version_);
 }
 
+// Tests that the converter shared before a reload stays alive.
+TEST_F(EngineTest, SharedConverterOutlivesReload) {
+  EngineReloadResponse response;
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(mock_request_));
+  EXPECT_TRUE(engine_->MaybeReloadEngine(&response));
+  std::shared_ptr<ConverterInterface> converter =
+      engine_->GetSharedConverter();
+  ASSERT_NE(converter, nullptr);
+  EXPECT_EQ(converter.get(), engine_->GetConverter());
+
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(oss_request_));
+  EXPECT_TRUE(engine_->MaybeReloadEngine(&response));
+  EXPECT_EQ(engine_->GetDataVersion(), oss_version_);
+  EXPECT_NE(converter.get(), engine_->GetConverter());
+
+  // The previous converter still works on the previous data.
+  Segments segments;
+  EXPECT_TRUE(converter->StartConversionWithKey(&segments, "わたしのなまえ"));
+}
+
+// Tests that the new stack is built without blocking MaybeReloadEngine() once
+// the engine is initialized, and installed by a later call.
+TEST_F(EngineTest, BuildInBackground) {
+  EngineReloadResponse response;
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(mock_request_));
+  EXPECT_TRUE(engine_->MaybeReloadEngine(&response));
+
+  engine_->SetAlwaysWaitForLoaderResponseFutureForTesting(false);
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(oss_request_));
+  const absl::Time deadline = absl::Now() + absl::Seconds(60);
+  bool reloaded = false;
+  while (!reloaded && absl::Now() < deadline) {
+    // The current stack is used until the new one is installed.
+    EXPECT_EQ(engine_->GetDataVersion(), mock_version_);
+    reloaded = engine_->MaybeReloadEngine(&response);
+    if (!reloaded) {
+      absl::SleepFor(absl::Milliseconds(10));
+    }
+  }
+  ASSERT_TRUE(reloaded);
+  EXPECT_EQ(response.status(), EngineReloadResponse::RELOADED);
+  EXPECT_EQ(response.request().file_path(), oss_request_.file_path());
+  EXPECT_EQ(engine_->GetDataVersion(), oss_version_);
+}
+
+// Tests that the user history learned on the previous stack is handed over to
+// the new one, which read the history when its build started.
+TEST_F(EngineTest, ReloadHandsUserHistoryOver) {
+  EngineReloadResponse response;
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(mock_request_));
+  EXPECT_TRUE(engine_->MaybeReloadEngine(&response));
+  const std::string value1 = Learn(*engine_, "わたしの");
+
+  EXPECT_TRUE(engine_->SendEngineReloadRequest(oss_request_));
+  EXPECT_TRUE(engine_->MaybeReloadEngine(&response));
+  const std::string value2 = Learn(*engine_, "なまえ");
+  EXPECT_TRUE(engine_->Sync());
+  EXPECT_TRUE(engine_->Wait());
+
+  prediction::UserHistoryStorage storage(
+      prediction::UserHistoryPredictor::GetUserHistoryFileName());
+  ASSERT_TRUE(storage.Load());
+  std::vector<std::string> values;
+  for (const auto &entry : storage.GetProto().entries()) {
+    values.push_back(entry.value());
+  }
+  EXPECT_THAT(values, ::testing::IsSupersetOf({value1, value2}));
+}
+
 // Tests situations to handle multiple new requests.
 TEST_F(EngineTest, DataUpdateSuccessfulScenarioTest) {
   EngineReloadResponse response;
@@ -36,11 +36,15 @@
 #include <string>
 #include <utility>
 
+#include "absl/base/call_once.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "base/config_file_stream.h"
+#include "base/file_util.h"
 #include "converter/connector.h"
 #include "converter/segmenter.h"
 #include "data_manager/data_manager_interface.h"
@@ -53,10 +57,12 @@
 #include "dictionary/system/system_dictionary.h"
 #include "dictionary/system/value_dictionary.h"
 #include "dictionary/user_dictionary.h"
+#include "dictionary/user_dictionary_util.h"
 #include "dictionary/user_pos.h"
 #include "prediction/single_kanji_prediction_aggregator.h"
 #include "prediction/suggestion_filter.h"
 
+using ::mozc::UserDictionaryUtil;
 using ::mozc::dictionary::DictionaryImpl;
 using ::mozc::dictionary::PosGroup;
 using ::mozc::dictionary::SuffixDictionary;
@@ -69,40 +75,25 @@ using ::mozc::dictionary::ValueDictionary;
 namespace mozc {
 namespace engine {
 
-absl::Status Modules::Init(
-    std::unique_ptr<const DataManagerInterface> data_manager) {
 #define RETURN_IF_NULL(ptr)                                                \
   do {                                                                     \
     if (!(ptr))                                                            \
       return absl::ResourceExhaustedError("modules.cc: " #ptr " is null"); \
   } while (false)
 
+absl::Status Modules::Init(
+    std::unique_ptr<const DataManagerInterface> data_manager) {
   DCHECK(!initialized_) << "Modules already initialized";
   DCHECK(data_manager) << "data_manager is null";
   RETURN_IF_NULL(data_manager);
   data_manager_ = std::move(data_manager);
 
-  if (!suppression_dictionary_) {
-    suppression_dictionary_ = std::make_unique<SuppressionDictionary>();
-    RETURN_IF_NULL(suppression_dictionary_);
-  }
-
   if (!pos_matcher_) {
-    pos_matcher_ = std::make_unique<dictionary::PosMatcher>(
+    pos_matcher_ = std::make_shared<dictionary::PosMatcher>(
         data_manager_->GetPosMatcherData());
     RETURN_IF_NULL(pos_matcher_);
   }
 
-  if (!user_dictionary_) {
-    std::unique_ptr<UserPos> user_pos =
-        UserPos::CreateFromDataManager(*data_manager_);
-    RETURN_IF_NULL(user_pos);
-
-    user_dictionary_ = std::make_unique<UserDictionary>(
-        std::move(user_pos), *pos_matcher_, suppression_dictionary_.get());
-    RETURN_IF_NULL(user_dictionary_);
-  }
-
   if (!dictionary_) {
     const char *dictionary_data = nullptr;
     int dictionary_size = 0;
@@ -113,12 +104,9 @@ absl::Status Modules::Init(
     if (!sysdic.ok()) {
       return std::move(sysdic).status();
     }
-    auto value_dic = std::make_unique<ValueDictionary>(
+    value_dictionary_ = std::make_shared<ValueDictionary>(
         *pos_matcher_, &(*sysdic)->value_trie());
-    dictionary_ = std::make_unique<DictionaryImpl>(
-        *std::move(sysdic), std::move(value_dic), user_dictionary_.get(),
-        suppression_dictionary_.get(), pos_matcher_.get());
-    RETURN_IF_NULL(dictionary_);
+    system_dictionary_ = *std::move(sysdic);
   }
 
   if (!suffix_dictionary_) {
@@ -126,7 +114,7 @@ absl::Status Modules::Init(
     const uint32_t *token_array = nullptr;
     data_manager_->GetSuffixDictionaryData(
         &suffix_key_array_data, &suffix_value_array_data, &token_array);
-    suffix_dictionary_ = std::make_unique<SuffixDictionary>(
+    suffix_dictionary_ = std::make_shared<SuffixDictionary>(
         suffix_key_array_data, suffix_value_array_data, token_array);
     RETURN_IF_NULL(suffix_dictionary_);
   }
@@ -135,12 +123,13 @@ absl::Status Modules::Init(
   if (!status_or_connector.ok()) {
     return std::move(status_or_connector).status();
   }
-  connector_ = *std::move(status_or_connector);
+  connector_ =
+      std::make_shared<const Connector>(*std::move(status_or_connector));
 
   segmenter_ = Segmenter::CreateFromDataManager(*data_manager_);
   RETURN_IF_NULL(segmenter_);
 
-  pos_group_ = std::make_unique<PosGroup>(data_manager_->GetPosGroupData());
+  pos_group_ = std::make_shared<PosGroup>(data_manager_->GetPosGroupData());
   RETURN_IF_NULL(pos_group_);
 
   {
@@ -152,13 +141,6 @@ absl::Status Modules::Init(
     suggestion_filter_ = *std::move(status_or_suggestion_filter);
   }
 
-  if (!single_kanji_prediction_aggregator_) {
-    single_kanji_prediction_aggregator_ =
-        std::make_unique<prediction::SingleKanjiPredictionAggregator>(
-            *data_manager_);
-    RETURN_IF_NULL(single_kanji_prediction_aggregator_);
-  }
-
   absl::string_view zero_query_token_array_data;
   absl::string_view zero_query_string_array_data;
   absl::string_view zero_query_number_token_array_data;
@@ -172,9 +154,112 @@ absl::Status Modules::Init(
   zero_query_number_dict_.Init(zero_query_number_token_array_data,
                                zero_query_number_string_array_data);
 
+  if (absl::Status s = InitUserModules(); !s.ok()) {
+    return s;
+  }
+  initialized_ = true;
+  return absl::Status();
+}
+
+absl::Status Modules::InitWithSharedModules(const Modules &shared) {
+  DCHECK(!initialized_) << "Modules already initialized";
+  if (!shared.initialized_) {
+    return absl::FailedPreconditionError(
+        "modules.cc: shared modules are not initialized");
+  }
+  data_manager_ = shared.data_manager_;
+  derived_data_cache_ = shared.derived_data_cache_;
+  if (!pos_matcher_) {
+    pos_matcher_ = shared.pos_matcher_;
+  }
+  if (!dictionary_) {
+    system_dictionary_ = shared.system_dictionary_;
+    value_dictionary_ = shared.value_dictionary_;
+  }
+  if (!suffix_dictionary_) {
+    suffix_dictionary_ = shared.suffix_dictionary_;
+  }
+  connector_ = shared.connector_;
+  segmenter_ = shared.segmenter_;
+  pos_group_ = shared.pos_group_;
+  suggestion_filter_ = shared.suggestion_filter_;
+  if (!single_kanji_prediction_aggregator_) {
+    // Built here so that the aggregator is shared rather than built for each
+    // user on the first use.
+    shared.GetSingleKanjiPredictionAggregator();
+    single_kanji_prediction_aggregator_ =
+        shared.single_kanji_prediction_aggregator_;
+  }
+  zero_query_dict_ = shared.zero_query_dict_;
+  zero_query_number_dict_ = shared.zero_query_number_dict_;
+  supplemental_model_ = shared.supplemental_model_;
+
+  if (absl::Status s = InitUserModules(); !s.ok()) {
+    return s;
+  }
   initialized_ = true;
   return absl::Status();
+}
+
+absl::Status Modules::InitUserModules() {
+  if (!suppression_dictionary_) {
+    suppression_dictionary_ = std::make_unique<SuppressionDictionary>();
+    RETURN_IF_NULL(suppression_dictionary_);
+  }
+
+  if (!user_dictionary_) {
+    std::unique_ptr<UserPos> user_pos =
+        UserPos::CreateFromDataManager(*data_manager_);
+    RETURN_IF_NULL(user_pos);
+
+    // An empty file name stands for the file of the user running the process.
+    std::string filename;
+    if (!user_profile_directory_.empty()) {
+      filename = GetUserDataFileName(UserDictionaryUtil::kUserDictionaryFile);
+    }
+    user_dictionary_ = std::make_unique<UserDictionary>(
+        std::move(user_pos), *pos_matcher_, suppression_dictionary_.get(),
+        std::move(filename));
+    RETURN_IF_NULL(user_dictionary_);
+  }
+
+  if (!dictionary_) {
+    RETURN_IF_NULL(system_dictionary_);
+    RETURN_IF_NULL(value_dictionary_);
+    dictionary_ = std::make_unique<DictionaryImpl>(
+        system_dictionary_, value_dictionary_, user_dictionary_.get(),
+        suppression_dictionary_.get(), pos_matcher_.get());
+    RETURN_IF_NULL(dictionary_);
+  }
+  return absl::Status();
+}
+
 #undef RETURN_IF_NULL
+
+std::string Modules::GetUserDataFileName(absl::string_view filename) const {
+  if (user_profile_directory_.empty()) {
+    return ConfigFileStream::GetFileName(filename);
+  }
+  return FileUtil::JoinPath(user_profile_directory_,
+                            absl::StripPrefix(filename, "user://"));
+}
+
+const prediction::SingleKanjiPredictionAggregator *
+Modules::GetSingleKanjiPredictionAggregator() const {
+  DCHECK(initialized_) << "Modules is not initialized";
+  absl::call_once(single_kanji_prediction_aggregator_once_, [this]() {
+    if (!single_kanji_prediction_aggregator_) {
+      single_kanji_prediction_aggregator_ =
+          std::make_unique<prediction::SingleKanjiPredictionAggregator>(
+              *data_manager_);
+    }
+  });
+  return single_kanji_prediction_aggregator_.get();
+}
+
+void Modules::PresetUserProfileDirectory(std::string user_profile_directory) {
+  DCHECK(!initialized_) << "Module is already initialized";
+  user_profile_directory_ = std::move(user_profile_directory);
 }
 
 void Modules::PresetPosMatcher(
@@ -31,13 +31,17 @@
 #define MOZC_ENGINE_MODULES_H_
 
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "absl/base/call_once.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "converter/connector.h"
 #include "converter/segmenter.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/derived_data_cache.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_group.h"
 #include "dictionary/pos_matcher.h"
@@ -58,7 +62,19 @@ class Modules {
 
   absl::Status Init(std::unique_ptr<const DataManagerInterface> data_manager);
 
-  // Preset functions must be called before Init.
+  // Initializes the modules of another user sharing the immutable modules of
+  // `shared`, e.g., the data manager, the system dictionary and the connector,
+  // so that a server can host many users in one process. Only the user
+  // dictionary, the suppression dictionary and the dictionary composing them
+  // are created for this instance. `shared` must be initialized by Init() and
+  // may be destroyed before this instance.
+  absl::Status InitWithSharedModules(const Modules &shared);
+
+  // Preset functions must be called before Init or InitWithSharedModules.
+  // Stores the user data, e.g., the user dictionary and the user history, in
+  // `user_profile_directory` instead of the profile directory of the user
+  // running this process.
+  void PresetUserProfileDirectory(std::string user_profile_directory);
   void PresetPosMatcher(
       std::unique_ptr<const dictionary::PosMatcher> pos_matcher);
   void PresetSuppressionDictionary(
@@ -89,7 +105,7 @@ class Modules {
   dictionary::SuppressionDictionary *GetMutableSuppressionDictionary() {
     return suppression_dictionary_.get();
   }
-  const Connector &GetConnector() const { return connector_; }
+  const Connector &GetConnector() const { return *connector_; }
   const Segmenter *GetSegmenter() const { return segmenter_.get(); }
   dictionary::UserDictionaryInterface *GetUserDictionary() const {
     return user_dictionary_.get();
@@ -104,15 +120,29 @@ class Modules {
   const SuggestionFilter &GetSuggestionFilter() const {
     return suggestion_filter_;
   }
+  // The aggregator is only used by mixed conversion, so it is constructed on
+  // the first call unless preset.
   const prediction::SingleKanjiPredictionAggregator *
-  GetSingleKanjiPredictionAggregator() const {
-    return single_kanji_prediction_aggregator_.get();
-  }
+  GetSingleKanjiPredictionAggregator() const;
   const ZeroQueryDict &GetZeroQueryDict() const { return zero_query_dict_; }
   const ZeroQueryDict &GetZeroQueryNumberDict() const {
     return zero_query_number_dict_;
   }
 
+  // Returns the path of the user data file `filename`, e.g.,
+  // "user://history.db", in the profile directory of the user of the modules.
+  std::string GetUserDataFileName(absl::string_view filename) const;
+
+  // Returns the cache of the data derived from the data set shared with other
+  // processes, or nullptr if it isn't available.
+  const DerivedDataCache *GetDerivedDataCache() const {
+    return derived_data_cache_.get();
+  }
+  void SetDerivedDataCache(
+      std::unique_ptr<const DerivedDataCache> derived_data_cache) {
+    derived_data_cache_ = std::move(derived_data_cache);
+  }
+
   const engine::SupplementalModelInterface *GetSupplementalModel() const {
     return supplemental_model_;
   }
@@ -122,18 +152,32 @@ class Modules {
   }
 
  private:
+  // Creates the user dictionary, the suppression dictionary and the dictionary
+  // unless preset.
+  absl::Status InitUserModules();
+
   bool initialized_ = false;
-  std::unique_ptr<const DataManagerInterface> data_manager_;
-  std::unique_ptr<const dictionary::PosMatcher> pos_matcher_;
+  // Empty if the profile directory of the user running this process is used.
+  std::string user_profile_directory_;
+  // The immutable modules are shared by InitWithSharedModules().
+  std::shared_ptr<const DataManagerInterface> data_manager_;
+  std::shared_ptr<const DerivedDataCache> derived_data_cache_;
+  std::shared_ptr<const dictionary::PosMatcher> pos_matcher_;
   std::unique_ptr<dictionary::SuppressionDictionary> suppression_dictionary_;
-  Connector connector_;
-  std::unique_ptr<const Segmenter> segmenter_;
+  std::shared_ptr<const Connector> connector_ =
+      std::make_shared<const Connector>();
+  std::shared_ptr<const Segmenter> segmenter_;
   std::unique_ptr<dictionary::UserDictionaryInterface> user_dictionary_;
-  std::unique_ptr<dictionary::DictionaryInterface> suffix_dictionary_;
+  std::shared_ptr<const dictionary::DictionaryInterface> suffix_dictionary_;
+  // The system and value dictionaries composed into `dictionary_`. Null if the
+  // dictionary is preset.
+  std::shared_ptr<const dictionary::DictionaryInterface> system_dictionary_;
+  std::shared_ptr<const dictionary::DictionaryInterface> value_dictionary_;
   std::unique_ptr<dictionary::DictionaryInterface> dictionary_;
-  std::unique_ptr<const dictionary::PosGroup> pos_group_;
+  std::shared_ptr<const dictionary::PosGroup> pos_group_;
   SuggestionFilter suggestion_filter_;
-  std::unique_ptr<const prediction::SingleKanjiPredictionAggregator>
+  mutable absl::once_flag single_kanji_prediction_aggregator_once_;
+  mutable std::shared_ptr<const prediction::SingleKanjiPredictionAggregator>
       single_kanji_prediction_aggregator_;
   ZeroQueryDict zero_query_dict_;
   ZeroQueryDict zero_query_number_dict_;
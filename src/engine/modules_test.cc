@@ -32,6 +32,8 @@
 #include <memory>
 #include <utility>
 
+#include "base/file_util.h"
+#include "data_manager/data_manager_interface.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_mock.h"
@@ -110,5 +112,45 @@ TEST(ModulesTest, Preset) {
   EXPECT_EQ(modules.GetDictionary(), dictionary_ptr);
 }
 
+TEST(ModulesTest, InitWithSharedModules) {
+  Modules uninitialized;
+  Modules user_modules;
+  EXPECT_FALSE(user_modules.InitWithSharedModules(uninitialized).ok());
+
+  auto shared = std::make_unique<Modules>();
+  ASSERT_OK(shared->Init(std::make_unique<testing::MockDataManager>()));
+
+  Modules modules;
+  modules.PresetUserProfileDirectory("/tmp/mozc_user");
+  ASSERT_OK(modules.InitWithSharedModules(*shared));
+
+  // The immutable modules are shared.
+  EXPECT_EQ(&modules.GetDataManager(), &shared->GetDataManager());
+  EXPECT_EQ(modules.GetPosMatcher(), shared->GetPosMatcher());
+  EXPECT_EQ(&modules.GetConnector(), &shared->GetConnector());
+  EXPECT_EQ(modules.GetSegmenter(), shared->GetSegmenter());
+  EXPECT_EQ(modules.GetSuffixDictionary(), shared->GetSuffixDictionary());
+  EXPECT_EQ(modules.GetPosGroup(), shared->GetPosGroup());
+  EXPECT_EQ(modules.GetSingleKanjiPredictionAggregator(),
+            shared->GetSingleKanjiPredictionAggregator());
+
+  // The user dependent modules are not.
+  EXPECT_NE(modules.GetUserDictionary(), nullptr);
+  EXPECT_NE(modules.GetUserDictionary(), shared->GetUserDictionary());
+  EXPECT_NE(modules.GetSuppressionDictionary(),
+            shared->GetSuppressionDictionary());
+  EXPECT_NE(modules.GetDictionary(), nullptr);
+  EXPECT_NE(modules.GetDictionary(), shared->GetDictionary());
+
+  EXPECT_EQ(modules.GetUserDataFileName("user://history.db"),
+            FileUtil::JoinPath("/tmp/mozc_user", "history.db"));
+
+  // The shared modules stay alive while they are used.
+  const DataManagerInterface *data_manager = &shared->GetDataManager();
+  shared.reset();
+  EXPECT_EQ(&modules.GetDataManager(), data_manager);
+  EXPECT_TRUE(modules.GetDictionary()->HasKey("わたし"));
+}
+
 }  // namespace engine
 }  // namespace mozc
@@ -32,9 +32,11 @@
 
 #include <memory>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "data_manager/oss/oss_data_manager.h"
 #include "engine/engine.h"
+#include "engine/modules.h"
 
 namespace mozc {
 
@@ -49,6 +51,18 @@ class OssEngineFactory {
     return Engine::CreateDesktopEngineHelper<oss::OssDataManager>();
 #endif  // __ANDROID__
   }
+
+  // Creates the modules equipped with the data set for OSS. Used by the server
+  // hosting several users, where the engines of the users share the modules.
+  static absl::StatusOr<std::unique_ptr<engine::Modules>> CreateModules() {
+    auto modules = std::make_unique<engine::Modules>();
+    if (absl::Status s =
+            modules->Init(std::make_unique<const oss::OssDataManager>());
+        !s.ok()) {
+      return s;
+    }
+    return modules;
+  }
 };
 
 }  // namespace mozc
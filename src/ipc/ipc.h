@@ -70,6 +70,12 @@ enum IPCErrorType {
   IPC_ERROR_TYPE_SIZE
 };
 
+// Credentials of the client process connected to IPCServer.
+struct IPCPeerCredentials {
+  uint32_t uid = 0;
+  uint32_t pid = 0;
+};
+
 class IPCClientInterface {
  public:
   virtual ~IPCClientInterface() = default;
@@ -237,6 +243,20 @@ class IPCServer {
   // If 'Process' return false, server finishes select loop
   virtual bool Process(absl::string_view request, std::string *response) = 0;
 
+  // Same as Process() with the credentials of the client. Override this method
+  // to tell the users apart when AcceptOtherUsers() is called. The default
+  // implementation calls Process(). Only called on Linux.
+  virtual bool ProcessFromPeer(const IPCPeerCredentials &peer,
+                               absl::string_view request,
+                               std::string *response) {
+    return Process(request, response);
+  }
+
+  // Accepts the clients run by the other users as well as the user running
+  // this server, e.g., to host several users in one server. Only supported on
+  // Linux.
+  void AcceptOtherUsers() { accept_other_users_ = true; }
+
   // Start select loop. It goes into infinite loop.
   void Loop();
 
@@ -261,6 +281,7 @@ class IPCServer {
 
  private:
   bool connected_;
+  bool accept_other_users_ = false;
 #ifdef _WIN32
   wil::unique_event_nothrow quit_event_;
 #else   // _WIN32
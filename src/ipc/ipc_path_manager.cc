@@ -36,10 +36,12 @@
 #include <ctime>
 #include <ios>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
@@ -86,6 +88,12 @@
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifndef _WIN32
+ABSL_FLAG(int32_t, ipc_trusted_server_uid, -1,
+          "If non-negative, clients also connect to the server run by this "
+          "user, e.g. root running the server hosting several users.");
+#endif  // !_WIN32
+
 namespace mozc {
 namespace {
 
@@ -101,6 +109,47 @@ std::string GetIPCKeyFileName(const std::string &name) {
   return FileUtil::JoinPath(SystemUtil::GetUserProfileDirectory(), basename);
 }
 
+#ifndef _WIN32
+// Returns the user running the server of the ipc key file, or nullopt if the
+// file is not trusted. The file must be a regular file owned by this user or
+// by --ipc_trusted_server_uid. The latter may be reached through a symbolic
+// link owned by this user, which is how a user opts in to the server hosting
+// several users.
+std::optional<uid_t> GetTrustedServerUserId(const std::string &filename) {
+  const uid_t euid = ::geteuid();
+  const int32_t trusted_uid = absl::GetFlag(FLAGS_ipc_trusted_server_uid);
+  struct stat filestat;
+  if (::lstat(filename.c_str(), &filestat) != 0) {
+    return std::nullopt;
+  }
+  if (S_ISLNK(filestat.st_mode)) {
+    if (filestat.st_uid != euid) {
+      LOG(ERROR) << "ipc key link is not owned by this user: " << filename;
+      return std::nullopt;
+    }
+    if (trusted_uid < 0 || ::stat(filename.c_str(), &filestat) != 0 ||
+        !S_ISREG(filestat.st_mode) ||
+        filestat.st_uid != static_cast<uid_t>(trusted_uid)) {
+      LOG(ERROR) << "ipc key link doesn't point to the trusted server's file: "
+                 << filename;
+      return std::nullopt;
+    }
+    return filestat.st_uid;
+  }
+  if (!S_ISREG(filestat.st_mode)) {
+    LOG(ERROR) << "ipc key file is not a regular file: " << filename;
+    return std::nullopt;
+  }
+  if (filestat.st_uid == euid ||
+      (trusted_uid >= 0 &&
+       filestat.st_uid == static_cast<uid_t>(trusted_uid))) {
+    return filestat.st_uid;
+  }
+  LOG(ERROR) << "ipc key file is owned by an untrusted user: " << filename;
+  return std::nullopt;
+}
+#endif  // !_WIN32
+
 bool IsValidKey(const std::string &name) {
   if (kKeySize != name.size()) {
     LOG(ERROR) << "IPCKey is invalid length";
@@ -307,6 +356,22 @@ uint32_t IPCPathManager::GetServerProcessId() const {
   return ipc_path_info_.process_id();
 }
 
+#ifndef _WIN32
+bool IPCPathManager::ShareWithOtherUsers() {
+  absl::MutexLock l(&mutex_);
+  if (!path_mutex_) {
+    LOG(ERROR) << "ipc key file is not saved";
+    return false;
+  }
+  const std::string filename = GetIPCKeyFileName(name_);
+  if (::chmod(filename.c_str(), 0644) != 0) {
+    LOG(ERROR) << "chmod failed: " << filename << ": " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+#endif  // !_WIN32
+
 void IPCPathManager::Clear() {
   absl::MutexLock l(&mutex_);
   ipc_path_info_.Clear();
@@ -511,6 +576,12 @@ bool IPCPathManager::LoadPathNameInternal() {
 
 #else   // _WIN32
 
+  const std::optional<uid_t> server_uid = GetTrustedServerUserId(filename);
+  if (!server_uid.has_value()) {
+    return false;
+  }
+  server_uid_ = *server_uid;
+
   InputFileStream is(filename, std::ios::binary | std::ios::in);
   if (!is) {
     LOG(ERROR) << "cannot open: " << filename;
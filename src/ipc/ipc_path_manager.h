@@ -44,6 +44,8 @@
 
 #ifdef _WIN32
 #include "absl/container/flat_hash_map.h"
+#else  // _WIN32
+#include <unistd.h>
 #endif  // _WIN32
 
 namespace mozc {
@@ -109,12 +111,26 @@ class IPCPathManager {
   // having no support of getting peer's pid, you can set 0 pid.
   bool IsValidServer(uint32_t pid, absl::string_view server_path);
 
+#ifndef _WIN32
+  // Returns the owner of the ipc key file loaded by LoadPathName(), i.e., the
+  // user running the server. It is this user unless --ipc_trusted_server_uid
+  // is set and the key file of this user is a link to the file of that user,
+  // i.e., the server hosting several users.
+  uint32_t GetServerUserId() const { return server_uid_; }
+
+  // Makes the ipc key file saved by SavePathName() readable by the other users
+  // so that their clients can connect to the server hosting several users.
+  // The clients only trust it with --ipc_trusted_server_uid.
+  bool ShareWithOtherUsers();
+#endif  // !_WIN32
+
   // clear ipc_key;
   void Clear();
 
  private:
   FRIEND_TEST(IPCPathManagerTest, ReloadTest);
   FRIEND_TEST(IPCPathManagerTest, PathNameTest);
+  FRIEND_TEST(IPCPathManagerTest, UntrustedKeyFileTest);
 
   bool LoadPathNameInternal();
 
@@ -133,6 +149,9 @@ class IPCPathManager {
   std::string server_path_;  // cache for server_path
   uint32_t server_pid_;      // cache for pid of server_path
   time_t last_modified_;
+#ifndef _WIN32
+  uint32_t server_uid_ = ::geteuid();
+#endif  // !_WIN32
 #ifdef _WIN32
   // std::less<> is a transparent comparator that's necessary to pass
   // absl::string_view to map::find(), etc.
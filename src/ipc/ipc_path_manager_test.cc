@@ -33,6 +33,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/flags/flag.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "base/file_util.h"
@@ -51,6 +52,12 @@
 #error "This platform is not supported."
 #endif  // __ANDROID__ || __wasm__
 
+#ifndef _WIN32
+#include <unistd.h>
+
+ABSL_DECLARE_FLAG(int32_t, ipc_trusted_server_uid);
+#endif  // !_WIN32
+
 namespace mozc {
 
 class IPCPathManagerTest : public testing::TestWithTempUserProfile {};
@@ -146,4 +153,36 @@ TEST_F(IPCPathManagerTest, PathNameTest) {
   EXPECT_EQ(loaded_path.process_id(), original_path.process_id());
   EXPECT_EQ(loaded_path.thread_id(), original_path.thread_id());
 }
+
+#ifndef _WIN32
+TEST_F(IPCPathManagerTest, UntrustedKeyFileTest) {
+  IPCPathManager *manager =
+      IPCPathManager::GetIPCPathManager("untrusted_key_test");
+  EXPECT_TRUE(manager->CreateNewPathName());
+  EXPECT_TRUE(manager->SavePathName());
+  EXPECT_TRUE(manager->LoadPathName());
+  EXPECT_EQ(manager->GetServerUserId(), ::geteuid());
+
+  // Replaces the key file with a link to a copy of it.
+  const std::string filename = FileUtil::JoinPath(
+      SystemUtil::GetUserProfileDirectory(), ".untrusted_key_test.ipc");
+  const std::string shared_filename = filename + ".shared";
+  ASSERT_EQ(::rename(filename.c_str(), shared_filename.c_str()), 0);
+  ASSERT_EQ(::symlink(shared_filename.c_str(), filename.c_str()), 0);
+
+  // Links are followed only to the file of the configured user.
+  manager->ipc_path_info_.Clear();
+  EXPECT_FALSE(manager->LoadPathNameInternal());
+  absl::SetFlag(&FLAGS_ipc_trusted_server_uid, ::geteuid());
+  EXPECT_TRUE(manager->LoadPathNameInternal());
+  absl::SetFlag(&FLAGS_ipc_trusted_server_uid, -1);
+
+  // Only regular files are accepted.
+  ASSERT_EQ(::unlink(filename.c_str()), 0);
+  ASSERT_EQ(::mkdir(filename.c_str(), 0700), 0);
+  manager->ipc_path_info_.Clear();
+  EXPECT_FALSE(manager->LoadPathNameInternal());
+  ASSERT_EQ(::rmdir(filename.c_str()), 0);
+}
+#endif  // !_WIN32
 }  // namespace mozc
@@ -118,9 +118,7 @@ bool IsWriteTimeout(int socket, absl::Duration timeout) {
   return true;
 }
 
-bool IsPeerValid(int socket, pid_t *pid) {
-  *pid = 0;
-
+bool GetPeerCredentials(int socket, IPCPeerCredentials *peer) {
   struct ucred peer_cred;
   int peer_cred_len = sizeof(peer_cred);
   if (getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &peer_cred,
@@ -128,13 +126,27 @@ bool IsPeerValid(int socket, pid_t *pid) {
     LOG(ERROR) << "cannot get peer credential. Not a Unix socket?";
     return false;
   }
+  peer->uid = peer_cred.uid;
+  peer->pid = peer_cred.pid;
+  return true;
+}
+
+// Returns true if the peer is run by this user or `uid`, e.g., the owner of
+// the ipc key file of the server.
+bool IsPeerValid(int socket, uid_t uid, pid_t *pid) {
+  *pid = 0;
+
+  IPCPeerCredentials peer;
+  if (!GetPeerCredentials(socket, &peer)) {
+    return false;
+  }
 
-  if (peer_cred.uid != ::geteuid()) {
-    LOG(WARNING) << "uid mismatch." << peer_cred.uid << "!=" << ::geteuid();
+  if (peer.uid != ::geteuid() && peer.uid != uid) {
+    LOG(WARNING) << "uid mismatch." << peer.uid << "!=" << ::geteuid();
     return false;
   }
 
-  *pid = peer_cred.pid;
+  *pid = peer.pid;
 
   return true;
 }
@@ -269,7 +281,7 @@ void IPCClient::Init(const absl::string_view name,
     pid_t pid = 0;
     if (::connect(socket_, reinterpret_cast<const sockaddr *>(&address),
                   sun_len) != 0 ||
-        !IsPeerValid(socket_, &pid)) {
+        !IsPeerValid(socket_, manager->GetServerUserId(), &pid)) {
       if ((errno == ENOTSOCK || errno == ECONNREFUSED) &&
           !IsAbstractSocket(server_address)) {
         // If abstract namepace is not enabled, recreate server_addresss path.
@@ -421,7 +433,7 @@ bool IPCServer::Connected() const { return connected_; }
 void IPCServer::Loop() {
   // The most portable and straightforward single-thread server
   bool error = false;
-  pid_t pid = 0;
+  IPCPeerCredentials peer;
   std::string request;
   std::string response;
   while (!error && !terminate_.HasBeenNotified()) {
@@ -430,7 +442,10 @@ void IPCServer::Loop() {
       LOG(FATAL) << "accept() failed: " << strerror(errno);
       return;
     }
-    if (!IsPeerValid(new_sock, &pid)) {
+    if (!GetPeerCredentials(new_sock, &peer) ||
+        (!accept_other_users_ && peer.uid != ::geteuid())) {
+      LOG(WARNING) << "Connection from invalid peer: uid=" << peer.uid;
+      ::close(new_sock);
       continue;
     }
 
@@ -440,7 +455,7 @@ void IPCServer::Loop() {
       continue;
     }
 
-    if (!Process(request, &response)) {
+    if (!ProcessFromPeer(peer, request, &response)) {
       LOG(WARNING) << "Process() failed";
       ::close(new_sock);
       error = true;
@@ -317,6 +317,8 @@ bool IsBannedApplication(const std::set<std::string, std::less<>> *bundleIdSet,
   [self setupClientBundle:sender];
   checkInputMode_ = YES;
   if (rendererCommand_->visible() && candidateController_) {
+    // Another controller may have updated the renderer while inactive.
+    candidateController_->InvalidateLastUpdate();
     candidateController_->ExecCommand(*rendererCommand_);
   }
   [self handleConfig];
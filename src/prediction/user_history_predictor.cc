@@ -344,6 +344,7 @@ UserHistoryPredictor::UserHistoryPredictor(const engine::Modules &modules,
       pos_matcher_(modules.GetPosMatcher()),
       suppression_dictionary_(modules.GetSuppressionDictionary()),
       predictor_name_("UserHistoryPredictor"),
+      filename_(modules.GetUserDataFileName(kFileName)),
       content_word_learning_enabled_(enable_content_word_learning),
       updated_(false),
       dic_(new DicCache(UserHistoryPredictor::cache_size())) {
@@ -403,7 +404,7 @@ bool UserHistoryPredictor::AsyncLoad() {
     return true;
   }
 
-  sync_.emplace([this] {
+  sync_.emplace(ThreadPool::Default(), [this] {
     MOZC_VLOG(1) << "Executing Reload method";
     Load();
   });
@@ -420,7 +421,8 @@ bool UserHistoryPredictor::AsyncSave() {
     return true;
   }
 
-  sync_.emplace([this] {
+  // Saving is not urgent, so it yields to the other background tasks.
+  sync_.emplace(ThreadPool::Default(), ThreadPool::Priority::kLow, [this] {
     MOZC_VLOG(1) << "Executing Sync method";
     Save();
   });
@@ -429,9 +431,7 @@ bool UserHistoryPredictor::AsyncSave() {
 }
 
 bool UserHistoryPredictor::Load() {
-  const std::string filename = GetUserHistoryFileName();
-
-  UserHistoryStorage history(filename);
+  UserHistoryStorage history(filename_);
   if (!history.Load()) {
     LOG(ERROR) << "UserHistoryStorage::Load() failed";
     return false;
@@ -470,9 +470,7 @@ bool UserHistoryPredictor::Save() {
     return true;
   }
 
-  const std::string filename = GetUserHistoryFileName();
-
-  UserHistoryStorage history(filename);
+  UserHistoryStorage history(filename_);
   for (const DicElement *elm = tail; elm != nullptr; elm = elm->prev) {
     *history.GetProto().add_entries() = elm->value;
   }
@@ -135,7 +135,7 @@ class UserHistoryPredictor : public PredictorInterface {
   // Implements PredictorInterface.
   bool Wait() override;
 
-  // Gets user history filename.
+  // Gets user history filename of the user running this process.
   static std::string GetUserHistoryFileName();
 
   const std::string &GetPredictorName() const override {
@@ -491,6 +491,8 @@ class UserHistoryPredictor : public PredictorInterface {
   const dictionary::PosMatcher *pos_matcher_;
   const dictionary::SuppressionDictionary *suppression_dictionary_;
   const std::string predictor_name_;
+  // The user history file of the user of the modules.
+  const std::string filename_;
 
   bool content_word_learning_enabled_;
   mutable std::atomic<bool> updated_;
@@ -42,6 +42,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "base/clock.h"
+#include "base/hash.h"
 #include "base/process.h"
 #include "base/system_util.h"
 #include "base/thread.h"
@@ -71,17 +72,21 @@ constexpr size_t kMaxErrorTimes = 5;
 constexpr absl::Duration kRetryIntervalTime = absl::Seconds(30);
 constexpr char kServiceName[] = "renderer";
 
-inline void CallCommand(IPCClientInterface *client,
-                        const commands::RendererCommand &command) {
-  std::string buf;
-  command.SerializeToString(&buf);
-
+inline bool CallCommand(IPCClientInterface *client,
+                        const std::string &request) {
   // basically, we don't need to get the result
   std::string result;
 
-  if (!client->Call(buf, &result, kIpcTimeout)) {
+  if (!client->Call(request, &result, kIpcTimeout)) {
     LOG(ERROR) << "Cannot send the request: ";
+    return false;
   }
+  return true;
+}
+
+inline bool CallCommand(IPCClientInterface *client,
+                        const commands::RendererCommand &command) {
+  return CallCommand(client, command.SerializeAsString());
 }
 }  // namespace
 
@@ -431,6 +436,10 @@ void RendererClient::set_suppress_error_dialog(bool suppress) {
   renderer_launcher_interface_->set_suppress_error_dialog(suppress);
 }
 
+void RendererClient::InvalidateLastUpdate() {
+  last_update_fingerprint_.reset();
+}
+
 bool RendererClient::ExecCommand(const commands::RendererCommand &command) {
   if (renderer_launcher_interface_ == nullptr) {
     LOG(ERROR) << "RendererLauncher is nullptr";
@@ -443,6 +452,9 @@ bool RendererClient::ExecCommand(const commands::RendererCommand &command) {
   }
 
   if (!renderer_launcher_interface_->CanConnect()) {
+    // The renderer is being (re)launched, and gets the first pending command
+    // rather than the last one.
+    last_update_fingerprint_.reset();
     renderer_launcher_interface_->SetPendingCommand(command);
     // Check CanConnect() again, as the status might be changed
     // after SetPendingCommand().
@@ -458,6 +470,24 @@ bool RendererClient::ExecCommand(const commands::RendererCommand &command) {
     return true;
   }
 
+  // Key events often leave the output unchanged (e.g. modifier keys), and
+  // resending the same UPDATE only makes the renderer redraw. The previous
+  // fingerprint is kept only while the renderer is known to have that state.
+  // It covers the application info, so an update for another receiver is
+  // always sent.
+  const std::string request = command.SerializeAsString();
+  std::optional<uint64_t> update_fingerprint;
+  if (command.type() == commands::RendererCommand::UPDATE) {
+    update_fingerprint = Fingerprint(request);
+    if (update_fingerprint == last_update_fingerprint_) {
+      MOZC_VLOG(2) << "Skipping the unchanged update";
+      return true;
+    }
+  }
+  // Kept cleared unless the renderer accepts this command, i.e., also when the
+  // renderer is launched or fails the version checks below.
+  last_update_fingerprint_.reset();
+
   MOZC_VLOG(2) << "Sending: " << command;
 
   std::unique_ptr<IPCClientInterface> client(CreateIPCClient());
@@ -518,7 +548,9 @@ bool RendererClient::ExecCommand(const commands::RendererCommand &command) {
     return true;
   }
 
-  CallCommand(client.get(), command);
+  if (CallCommand(client.get(), request)) {
+    last_update_fingerprint_ = update_fingerprint;
+  }
 
   return true;
 }
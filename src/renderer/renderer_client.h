@@ -30,7 +30,9 @@
 #ifndef MOZC_RENDERER_RENDERER_CLIENT_H_
 #define MOZC_RENDERER_RENDERER_CLIENT_H_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "client/client_interface.h"
@@ -112,6 +114,11 @@ class RendererClient : public RendererInterface {
 
   bool ExecCommand(const commands::RendererCommand &command) override;
 
+  // Makes the next UPDATE sent even if it is the same as the last one. Call it
+  // when the focus moves, as another client may have updated the renderer
+  // since then.
+  void InvalidateLastUpdate() override;
+
   // Don't check the renderer server path.
   // DO NOT call it except for testing
   void DisableRendererServerCheck();
@@ -125,6 +132,9 @@ class RendererClient : public RendererInterface {
   bool is_window_visible_;
   bool disable_renderer_path_check_;
   int version_mismatch_nums_;
+  // Fingerprint of the last UPDATE command delivered to the renderer. Reset
+  // whenever the renderer may not have the same state.
+  std::optional<uint64_t> last_update_fingerprint_;
   std::string name_;
   std::string renderer_path_;
 
@@ -365,6 +365,60 @@ TEST_F(RendererClientTest, ConnectionTest) {
   }
 }
 
+TEST_F(RendererClientTest, SkipUnchangedUpdateTest) {
+  RendererClient client = NewClient();
+  launcher_.Reset();
+  launcher_.set_can_connect(true);
+  client_params_.connected = true;
+  Reset();
+
+  commands::RendererCommand command;
+  command.set_type(commands::RendererCommand::UPDATE);
+  command.set_visible(true);
+  command.mutable_output()->set_id(1);
+
+  // The same update is sent only once.
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 1);
+
+  // A changed update is sent.
+  command.mutable_output()->set_id(2);
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 2);
+
+  // Any other command forgets the last update.
+  commands::RendererCommand noop;
+  noop.set_type(commands::RendererCommand::NOOP);
+  EXPECT_TRUE(client.ExecCommand(noop));
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 4);
+
+  // So does a lost connection, as the renderer may be restarted.
+  client_params_.connected = false;
+  EXPECT_TRUE(client.ExecCommand(noop));
+  client_params_.connected = true;
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 5);
+
+  // After a focus change, the same update is sent again as another client may
+  // have updated the renderer.
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 5);
+  client.InvalidateLastUpdate();
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 6);
+
+  // While the renderer is relaunched, the update is left pending, and the
+  // relaunched renderer may show another pending one.
+  launcher_.set_can_connect(false);
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 6);
+  launcher_.set_can_connect(true);
+  EXPECT_TRUE(client.ExecCommand(command));
+  EXPECT_EQ(client_params_.counter, 7);
+}
+
 TEST_F(RendererClientTest, ShutdownTest) {
   RendererClient client = NewClient();
 
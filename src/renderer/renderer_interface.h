@@ -57,6 +57,11 @@ class RendererInterface {
   // TODO(taku): RendererCommand should be stateless.
   virtual bool ExecCommand(const commands::RendererCommand &command) = 0;
 
+  // Makes the next command executed even if it repeats the last one, e.g.,
+  // when the focus comes back and another client may have updated the
+  // renderer. default implementation is empty
+  virtual void InvalidateLastUpdate() {}
+
   // set mouse callback handler.
   // default implementation is empty
   virtual void SetSendCommandInterface(
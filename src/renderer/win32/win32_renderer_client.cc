@@ -89,6 +89,11 @@ class SenderThread {
     command_event_.SetEvent();
   }
 
+  void InvalidateLastUpdate() {
+    absl::MutexLock lock(&mutex_);
+    invalidate_last_update_ = true;
+  }
+
   void RenderLoop() {
     // Wait until desktop name is ready. b/10403163
     while (SystemUtil::GetDesktopNameAsString().empty()) {
@@ -126,10 +131,15 @@ class SenderThread {
       }
       // handles[1], that is, renderer event is signaled.
       RendererCommand command;
+      bool invalidate_last_update = false;
       {
         absl::MutexLock lock(&mutex_);
         command.Swap(&renderer_command_);
         command_event_.ResetEvent();
+        std::swap(invalidate_last_update, invalidate_last_update_);
+      }
+      if (invalidate_last_update) {
+        renderer_client.InvalidateLastUpdate();
       }
       if (!renderer_client.ExecCommand(command)) {
         DLOG(ERROR) << "RendererClient::ExecCommand failed.";
@@ -141,6 +151,8 @@ class SenderThread {
   wil::unique_event_nothrow command_event_;
   wil::unique_event_nothrow quit_event_;
   RendererCommand renderer_command_;
+  // Another process may have updated the renderer since the last command.
+  bool invalidate_last_update_ = false;
   absl::Mutex mutex_;
 };
 
@@ -305,6 +317,20 @@ void Win32RendererClient::OnUpdated(const RendererCommand &command) {
   }
 }
 
+void Win32RendererClient::OnFocusChanged() {
+  if (!EnsureUIThreadInitialized()) {
+    return;
+  }
+  SenderThread *thread = nullptr;
+  {
+    absl::MutexLock lock(&g_mutex);
+    thread = g_sender_thread;
+  }
+  if (thread != nullptr) {
+    thread->InvalidateLastUpdate();
+  }
+}
+
 }  // namespace win32
 }  // namespace renderer
 }  // namespace mozc
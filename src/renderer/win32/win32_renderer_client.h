@@ -55,6 +55,9 @@ class Win32RendererClient {
   // Passes the |command| to the renderer. This function returns
   // asynchronously and only the last call will be used.
   static void OnUpdated(const commands::RendererCommand &command);
+  // Must be called when the focus moves, so that the next command is sent
+  // even if it is the same as the last one of this process.
+  static void OnFocusChanged();
 };
 
 }  // namespace win32
@@ -221,12 +221,19 @@ void A11yDescriptionRewriter::AddA11yDescription(
   candidate->a11y_description = std::move(buf);
 }
 
+// static
+int A11yDescriptionRewriter::GetCapability(const ConversionRequest &request) {
+  return request.request().enable_a11y_description()
+             ? RewriterInterface::ALL
+             : RewriterInterface::NOT_AVAILABLE;
+}
+
 int A11yDescriptionRewriter::capability(
     const ConversionRequest &request) const {
-  if (description_map_ && request.request().enable_a11y_description()) {
-    return RewriterInterface::ALL;
+  if (!description_map_) {
+    return RewriterInterface::NOT_AVAILABLE;
   }
-  return RewriterInterface::NOT_AVAILABLE;
+  return GetCapability(request);
 }
 
 bool A11yDescriptionRewriter::Rewrite(const ConversionRequest &request,
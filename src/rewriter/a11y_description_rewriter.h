@@ -52,6 +52,10 @@ class A11yDescriptionRewriter : public RewriterInterface {
 
   ~A11yDescriptionRewriter() override = default;
 
+  // Returns the capability requested by `request`. capability() is
+  // NOT_AVAILABLE instead if the data set has no descriptions.
+  static int GetCapability(const ConversionRequest &request);
+
   int capability(const ConversionRequest &request) const override;
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
@@ -148,7 +148,8 @@ EmojiRewriter::EmojiRewriter(const DataManagerInterface &data_manager) {
   string_array_.Set(string_array_data);
 }
 
-int EmojiRewriter::capability(const ConversionRequest &request) const {
+// static
+int EmojiRewriter::GetCapability(const ConversionRequest &request) {
   // The capability of the EmojiRewriter is up to the client's request.
   // Note that the bit representation of RewriterInterface::CapabilityType
   // and Request::RewriterCapability should exactly same, so it is ok
@@ -75,7 +75,13 @@ class EmojiRewriter : public RewriterInterface {
   EmojiRewriter(const EmojiRewriter &) = delete;
   EmojiRewriter &operator=(const EmojiRewriter &) = delete;
 
-  int capability(const ConversionRequest &request) const override;
+  // Returns capability() without an instance, which is independent of the
+  // data.
+  static int GetCapability(const ConversionRequest &request);
+
+  int capability(const ConversionRequest &request) const override {
+    return GetCapability(request);
+  }
 
   // Returns true if emoji candidates are added.  When user settings are set
   // not to use EmojiRewriter, does nothing other than returning false.
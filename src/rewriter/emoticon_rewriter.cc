@@ -228,7 +228,8 @@ EmoticonRewriter::EmoticonRewriter(absl::string_view token_array_data,
                                    absl::string_view string_array_data)
     : dic_(token_array_data, string_array_data) {}
 
-int EmoticonRewriter::capability(const ConversionRequest &request) const {
+// static
+int EmoticonRewriter::GetCapability(const ConversionRequest &request) {
   if (request.request().mixed_conversion()) {
     return RewriterInterface::ALL;
   }
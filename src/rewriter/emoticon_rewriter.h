@@ -50,7 +50,13 @@ class EmoticonRewriter : public RewriterInterface {
   EmoticonRewriter(absl::string_view token_array_data,
                    absl::string_view string_array_data);
 
-  int capability(const ConversionRequest &request) const override;
+  // Returns capability() without an instance, which is independent of the
+  // data.
+  static int GetCapability(const ConversionRequest &request);
+
+  int capability(const ConversionRequest &request) const override {
+    return GetCapability(request);
+  }
 
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
@@ -0,0 +1,140 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_REWRITER_LAZY_REWRITER_H_
+#define MOZC_REWRITER_LAZY_REWRITER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/base/call_once.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/log/check.h"
+#include "converter/segments.h"
+#include "request/conversion_request.h"
+#include "rewriter/rewriter_interface.h"
+
+namespace mozc {
+
+// Defers the construction of a rewriter to its first Rewrite() or WarmUp(),
+// so that rewriters don't index their data while the engine is built.
+//
+// Until the rewriter is constructed, capability() is answered by
+// `capability`, typically the static GetCapability() of the wrapped class,
+// which must not touch the data loaded by `factory`. Focus(),
+// Finish() and the other hooks are no-ops, as the rewriter has no state yet.
+class LazyRewriter : public RewriterInterface {
+ public:
+  using Factory = absl::AnyInvocable<std::unique_ptr<RewriterInterface>()>;
+  using CapabilityFunc =
+      absl::AnyInvocable<int(const ConversionRequest &) const>;
+
+  LazyRewriter(Factory factory, CapabilityFunc capability)
+      : factory_(std::move(factory)), capability_(std::move(capability)) {
+    DCHECK(factory_);
+    DCHECK(capability_);
+  }
+
+  LazyRewriter(const LazyRewriter &) = delete;
+  LazyRewriter &operator=(const LazyRewriter &) = delete;
+
+  int capability(const ConversionRequest &request) const override {
+    if (const RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      return rewriter->capability(request);
+    }
+    return capability_(request);
+  }
+
+  bool Rewrite(const ConversionRequest &request,
+               Segments *segments) const override {
+    return GetOrCreate().Rewrite(request, segments);
+  }
+
+  bool Focus(Segments *segments, size_t segment_index,
+             int candidate_index) const override {
+    if (const RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      return rewriter->Focus(segments, segment_index, candidate_index);
+    }
+    return true;
+  }
+
+  void Finish(const ConversionRequest &request, Segments *segments) override {
+    if (RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      rewriter->Finish(request, segments);
+    }
+  }
+
+  bool Sync() override {
+    if (RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      return rewriter->Sync();
+    }
+    return true;
+  }
+
+  bool Reload() override {
+    if (RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      return rewriter->Reload();
+    }
+    return true;
+  }
+
+  void Clear() override {
+    if (RewriterInterface *rewriter = rewriter_ptr_.load()) {
+      rewriter->Clear();
+    }
+  }
+
+  // Constructs the rewriter now if it hasn't been. Thread-safe.
+  void WarmUp() const { GetOrCreate(); }
+
+  bool constructed() const { return rewriter_ptr_.load() != nullptr; }
+
+ private:
+  RewriterInterface &GetOrCreate() const {
+    absl::call_once(once_, [this]() {
+      rewriter_ = factory_();
+      DCHECK(rewriter_);
+      factory_ = nullptr;  // Releases the captured references.
+      rewriter_ptr_.store(rewriter_.get());
+    });
+    return *rewriter_;
+  }
+
+  mutable Factory factory_;
+  const CapabilityFunc capability_;
+  mutable absl::once_flag once_;
+  mutable std::unique_ptr<RewriterInterface> rewriter_;
+  mutable std::atomic<RewriterInterface *> rewriter_ptr_ = nullptr;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_REWRITER_LAZY_REWRITER_H_
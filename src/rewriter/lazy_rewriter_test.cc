@@ -0,0 +1,113 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rewriter/lazy_rewriter.h"
+
+#include <memory>
+
+#include "converter/segments.h"
+#include "request/conversion_request.h"
+#include "rewriter/rewriter_interface.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+class CountingRewriter : public RewriterInterface {
+ public:
+  explicit CountingRewriter(int *num_rewrites) : num_rewrites_(num_rewrites) {}
+
+  int capability(const ConversionRequest &request) const override {
+    return RewriterInterface::PREDICTION;
+  }
+
+  bool Rewrite(const ConversionRequest &request,
+               Segments *segments) const override {
+    ++*num_rewrites_;
+    return true;
+  }
+
+  bool Sync() override { return false; }
+
+ private:
+  int *num_rewrites_;
+};
+
+TEST(LazyRewriterTest, ConstructsOnFirstRewrite) {
+  int num_constructions = 0;
+  int num_rewrites = 0;
+  LazyRewriter rewriter(
+      [&]() -> std::unique_ptr<RewriterInterface> {
+        ++num_constructions;
+        return std::make_unique<CountingRewriter>(&num_rewrites);
+      },
+      [](const ConversionRequest &) { return RewriterInterface::CONVERSION; });
+
+  const ConversionRequest request;
+  Segments segments;
+  // The hooks don't construct the rewriter.
+  EXPECT_EQ(rewriter.capability(request), RewriterInterface::CONVERSION);
+  EXPECT_TRUE(rewriter.Focus(&segments, 0, 0));
+  rewriter.Finish(request, &segments);
+  EXPECT_TRUE(rewriter.Sync());
+  EXPECT_TRUE(rewriter.Reload());
+  rewriter.Clear();
+  EXPECT_FALSE(rewriter.constructed());
+  EXPECT_EQ(num_constructions, 0);
+
+  EXPECT_TRUE(rewriter.Rewrite(request, &segments));
+  EXPECT_TRUE(rewriter.Rewrite(request, &segments));
+  EXPECT_TRUE(rewriter.constructed());
+  EXPECT_EQ(num_constructions, 1);
+  EXPECT_EQ(num_rewrites, 2);
+
+  // Delegates to the constructed rewriter.
+  EXPECT_EQ(rewriter.capability(request), RewriterInterface::PREDICTION);
+  EXPECT_FALSE(rewriter.Sync());
+}
+
+TEST(LazyRewriterTest, WarmUp) {
+  int num_constructions = 0;
+  int num_rewrites = 0;
+  LazyRewriter rewriter(
+      [&]() -> std::unique_ptr<RewriterInterface> {
+        ++num_constructions;
+        return std::make_unique<CountingRewriter>(&num_rewrites);
+      },
+      [](const ConversionRequest &) { return RewriterInterface::CONVERSION; });
+
+  rewriter.WarmUp();
+  rewriter.WarmUp();
+  EXPECT_TRUE(rewriter.constructed());
+  EXPECT_EQ(num_constructions, 1);
+  EXPECT_EQ(num_rewrites, 0);
+}
+
+}  // namespace
+}  // namespace mozc
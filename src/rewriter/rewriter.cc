@@ -30,14 +30,19 @@
 #include "rewriter/rewriter.h"
 
 #include <memory>
+#include <utility>
 
 #include "absl/flags/flag.h"
+#include "absl/types/span.h"
 #include "converter/converter_interface.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/derived_data_cache.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_group.h"
 #include "dictionary/pos_matcher.h"
 #include "engine/modules.h"
+#include "protocol/commands.pb.h"
+#include "request/conversion_request.h"
 #include "rewriter/a11y_description_rewriter.h"
 #include "rewriter/calculator_rewriter.h"
 #include "rewriter/collocation_rewriter.h"
@@ -50,9 +55,11 @@
 #include "rewriter/focus_candidate_rewriter.h"
 #include "rewriter/ivs_variants_rewriter.h"
 #include "rewriter/language_aware_rewriter.h"
+#include "rewriter/lazy_rewriter.h"
 #include "rewriter/number_rewriter.h"
 #include "rewriter/order_rewriter.h"
 #include "rewriter/remove_redundant_candidate_rewriter.h"
+#include "rewriter/rewriter_interface.h"
 #include "rewriter/single_kanji_rewriter.h"
 #include "rewriter/small_letter_rewriter.h"
 #include "rewriter/symbol_rewriter.h"
@@ -85,6 +92,18 @@ ABSL_FLAG(bool, use_history_rewriter, true, "Use history rewriter or not.");
 
 namespace mozc {
 
+// static
+absl::Span<const DerivedDataCache::Section> Rewriter::GetDerivedDataSections() {
+#ifndef NO_USAGE_REWRITER
+  static const DerivedDataCache::Section kSections[] = {
+      UsageRewriter::kDerivedIndexSection,
+  };
+  return kSections;
+#else   // NO_USAGE_REWRITER
+  return {};
+#endif  // NO_USAGE_REWRITER
+}
+
 Rewriter::Rewriter(const engine::Modules &modules,
                    const ConverterInterface &parent_converter) {
   const DataManagerInterface *data_manager = &modules.GetDataManager();
@@ -101,11 +120,32 @@ Rewriter::Rewriter(const engine::Modules &modules,
   AddRewriter(CollocationRewriter::Create(*data_manager));
   AddRewriter(std::make_unique<SingleKanjiRewriter>(*data_manager));
   AddRewriter(std::make_unique<IvsVariantsRewriter>());
-  AddRewriter(std::make_unique<EmojiRewriter>(*data_manager));
-  AddRewriter(EmoticonRewriter::CreateFromDataManager(*data_manager));
+  // The rewriters below index their data on their first use or on WarmUp(),
+  // not when the engine is built.
+  AddLazyRewriter(
+      std::make_unique<LazyRewriter>(
+          [data_manager]() -> std::unique_ptr<RewriterInterface> {
+            return std::make_unique<EmojiRewriter>(*data_manager);
+          },
+          EmojiRewriter::GetCapability),
+      /*warm_up=*/true);
+  AddLazyRewriter(
+      std::make_unique<LazyRewriter>(
+          [data_manager]() -> std::unique_ptr<RewriterInterface> {
+            return EmoticonRewriter::CreateFromDataManager(*data_manager);
+          },
+          EmoticonRewriter::GetCapability),
+      /*warm_up=*/true);
   AddRewriter(std::make_unique<CalculatorRewriter>(&parent_converter));
-  AddRewriter(
-      std::make_unique<SymbolRewriter>(&parent_converter, data_manager));
+  AddLazyRewriter(
+      std::make_unique<LazyRewriter>(
+          [&parent_converter,
+           data_manager]() -> std::unique_ptr<RewriterInterface> {
+            return std::make_unique<SymbolRewriter>(&parent_converter,
+                                                    data_manager);
+          },
+          SymbolRewriter::GetCapability),
+      /*warm_up=*/true);
   AddRewriter(std::make_unique<UnicodeRewriter>(&parent_converter));
   AddRewriter(std::make_unique<VariantsRewriter>(pos_matcher));
   AddRewriter(std::make_unique<ZipcodeRewriter>(pos_matcher));
@@ -113,10 +153,12 @@ Rewriter::Rewriter(const engine::Modules &modules,
   AddRewriter(std::make_unique<SmallLetterRewriter>(&parent_converter));
 
   if (absl::GetFlag(FLAGS_use_history_rewriter)) {
-    AddRewriter(
-        std::make_unique<UserBoundaryHistoryRewriter>(&parent_converter));
-    AddRewriter(
-        std::make_unique<UserSegmentHistoryRewriter>(&pos_matcher, pos_group));
+    AddRewriter(std::make_unique<UserBoundaryHistoryRewriter>(
+        &parent_converter,
+        modules.GetUserDataFileName(UserBoundaryHistoryRewriter::kFileName)));
+    AddRewriter(std::make_unique<UserSegmentHistoryRewriter>(
+        &pos_matcher, pos_group,
+        modules.GetUserDataFileName(UserSegmentHistoryRewriter::kFileName)));
   }
 
   AddRewriter(std::make_unique<DateRewriter>(&parent_converter, dictionary));
@@ -128,7 +170,16 @@ Rewriter::Rewriter(const engine::Modules &modules,
   AddRewriter(std::make_unique<CommandRewriter>());
 #endif  // !(__ANDROID__ || TARGET_OS_IPHONE)
 #ifndef NO_USAGE_REWRITER
-  AddRewriter(std::make_unique<UsageRewriter>(data_manager, dictionary));
+  AddLazyRewriter(
+      std::make_unique<LazyRewriter>(
+          [data_manager, dictionary,
+           derived_data_cache = modules.GetDerivedDataCache()]()
+              -> std::unique_ptr<RewriterInterface> {
+            return std::make_unique<UsageRewriter>(data_manager, dictionary,
+                                                   derived_data_cache);
+          },
+          UsageRewriter::GetCapability),
+      /*warm_up=*/true);
 #endif  // NO_USAGE_REWRITER
   AddRewriter(
       std::make_unique<VersionRewriter>(data_manager->GetDataVersion()));
@@ -137,7 +188,28 @@ Rewriter::Rewriter(const engine::Modules &modules,
   AddRewriter(std::make_unique<EnvironmentalFilterRewriter>(*data_manager));
   AddRewriter(std::make_unique<RemoveRedundantCandidateRewriter>());
   AddRewriter(std::make_unique<OrderRewriter>());
-  AddRewriter(std::make_unique<A11yDescriptionRewriter>(data_manager));
+  // Only used by accessibility clients, so not warmed up.
+  AddLazyRewriter(
+      std::make_unique<LazyRewriter>(
+          [data_manager]() -> std::unique_ptr<RewriterInterface> {
+            return std::make_unique<A11yDescriptionRewriter>(data_manager);
+          },
+          A11yDescriptionRewriter::GetCapability),
+      /*warm_up=*/false);
+}
+
+void Rewriter::WarmUp() const {
+  for (const LazyRewriter *rewriter : warm_up_rewriters_) {
+    rewriter->WarmUp();
+  }
+}
+
+void Rewriter::AddLazyRewriter(std::unique_ptr<LazyRewriter> rewriter,
+                               const bool warm_up) {
+  if (warm_up) {
+    warm_up_rewriters_.push_back(rewriter.get());
+  }
+  AddRewriter(std::move(rewriter));
 }
 
 }  // namespace mozc
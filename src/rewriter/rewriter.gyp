@@ -93,6 +93,7 @@
         '<(mozc_oss_src_dir)/config/config.gyp:character_form_manager',
         '<(mozc_oss_src_dir)/config/config.gyp:config_handler',
         '<(mozc_oss_src_dir)/converter/immutable_converter.gyp:immutable_converter',
+        '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:derived_data_cache',
         '<(mozc_oss_src_dir)/data_manager/data_manager_base.gyp:serialized_dictionary',
         '<(mozc_oss_src_dir)/dictionary/dictionary.gyp:dictionary',
         '<(mozc_oss_src_dir)/dictionary/dictionary_base.gyp:pos_matcher',
@@ -30,8 +30,14 @@
 #ifndef MOZC_REWRITER_REWRITER_H_
 #define MOZC_REWRITER_REWRITER_H_
 
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
 #include "converter/converter_interface.h"
+#include "data_manager/derived_data_cache.h"
 #include "engine/modules.h"
+#include "rewriter/lazy_rewriter.h"
 #include "rewriter/merger_rewriter.h"
 
 namespace mozc {
@@ -42,6 +48,19 @@ class Rewriter : public MergerRewriter {
            const ConverterInterface &parent_converter);
   Rewriter(const Rewriter &) = delete;
   Rewriter &operator=(const Rewriter &) = delete;
+
+  // Returns the sections of the derived data cache used by the rewriters.
+  static absl::Span<const DerivedDataCache::Section> GetDerivedDataSections();
+
+  // Constructs the lazy rewriters used on every conversion, so that the first
+  // key event doesn't wait for them. Thread-safe; called from a background
+  // thread after the engine is built.
+  void WarmUp() const;
+
+ private:
+  void AddLazyRewriter(std::unique_ptr<LazyRewriter> rewriter, bool warm_up);
+
+  std::vector<const LazyRewriter *> warm_up_rewriters_;
 };
 
 }  // namespace mozc
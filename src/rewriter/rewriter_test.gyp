@@ -53,6 +53,7 @@
         'environmental_filter_rewriter_test.cc',
         'focus_candidate_rewriter_test.cc',
         'fortune_rewriter_test.cc',
+        'lazy_rewriter_test.cc',
         'merger_rewriter_test.cc',
         'number_compound_util_test.cc',
         'number_rewriter_test.cc',
@@ -366,7 +366,8 @@ SymbolRewriter::SymbolRewriter(const ConverterInterface *parent_converter,
                                                        string_array_data);
 }
 
-int SymbolRewriter::capability(const ConversionRequest &request) const {
+// static
+int SymbolRewriter::GetCapability(const ConversionRequest &request) {
   if (request.request().mixed_conversion()) {
     return RewriterInterface::ALL;
   }
@@ -53,7 +53,13 @@ class SymbolRewriter : public RewriterInterface {
                           const DataManagerInterface *data_manager);
   ~SymbolRewriter() override = default;
 
-  int capability(const ConversionRequest &request) const override;
+  // Returns capability() without an instance, which is independent of the
+  // data.
+  static int GetCapability(const ConversionRequest &request);
+
+  int capability(const ConversionRequest &request) const override {
+    return GetCapability(request);
+  }
 
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
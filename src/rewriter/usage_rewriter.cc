@@ -30,20 +30,28 @@
 #include "rewriter/usage_rewriter.h"
 
 #ifndef NO_USAGE_REWRITER
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
 #include <string>
-#include <utility>
+#include <vector>
 
+#include "absl/container/btree_map.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/container/serialized_string_array.h"
 #include "base/util.h"
 #include "base/vlog.h"
 #include "converter/segments.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/derived_data_cache.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_matcher.h"
 #include "protocol/config.pb.h"
@@ -53,51 +61,154 @@ namespace mozc {
 
 using ::mozc::dictionary::DictionaryInterface;
 
+namespace {
+
+constexpr char kKeyValueSeparator = '\0';
+
+std::string MakeIndexKey(absl::string_view key, absl::string_view value) {
+  return absl::StrCat(key, absl::string_view(&kKeyValueSeparator, 1), value);
+}
+
+}  // namespace
+
+// static
+const DerivedDataCache::Section UsageRewriter::kDerivedIndexSection = {
+    "usage_rewriter_index", 32, &UsageRewriter::BuildIndex};
+
 UsageRewriter::UsageRewriter(const DataManagerInterface *data_manager,
-                             const DictionaryInterface *dictionary)
+                             const DictionaryInterface *dictionary,
+                             const DerivedDataCache *derived_data_cache)
     : pos_matcher_(data_manager->GetPosMatcherData()),
       dictionary_(dictionary),
       base_conjugation_suffix_(nullptr) {
   absl::string_view base_conjugation_suffix_data;
   absl::string_view conjugation_suffix_data;
   absl::string_view conjugation_suffix_index_data;
-  absl::string_view usage_items_data;
   absl::string_view string_array_data;
   data_manager->GetUsageRewriterData(
       &base_conjugation_suffix_data, &conjugation_suffix_data,
-      &conjugation_suffix_index_data, &usage_items_data, &string_array_data);
+      &conjugation_suffix_index_data, &usage_items_data_, &string_array_data);
   base_conjugation_suffix_ =
       reinterpret_cast<const uint32_t *>(base_conjugation_suffix_data.data());
+
+  DCHECK(SerializedStringArray::VerifyData(string_array_data));
+  string_array_.Set(string_array_data);
+
+  if (derived_data_cache != nullptr) {
+    const std::optional<absl::string_view> index =
+        derived_data_cache->Get(kDerivedIndexSection.name);
+    if (index.has_value() && InitIndex(*index)) {
+      return;
+    }
+    LOG(WARNING) << "No valid usage index in "
+                 << derived_data_cache->filename();
+  }
+  const bool valid = InitIndexFromCopy(BuildIndex(*data_manager));
+  DCHECK(valid);
+}
+
+// static
+std::string UsageRewriter::BuildIndex(
+    const DataManagerInterface &data_manager) {
+  absl::string_view base_conjugation_suffix_data;
+  absl::string_view conjugation_suffix_data;
+  absl::string_view conjugation_suffix_index_data;
+  absl::string_view usage_items_data;
+  absl::string_view string_array_data;
+  data_manager.GetUsageRewriterData(
+      &base_conjugation_suffix_data, &conjugation_suffix_data,
+      &conjugation_suffix_index_data, &usage_items_data, &string_array_data);
   const uint32_t *conjugation_suffix =
       reinterpret_cast<const uint32_t *>(conjugation_suffix_data.data());
   const uint32_t *conjugation_suffix_data_index =
       reinterpret_cast<const uint32_t *>(conjugation_suffix_index_data.data());
+  SerializedStringArray string_array;
+  string_array.Set(string_array_data);
 
-  DCHECK(SerializedStringArray::VerifyData(string_array_data));
-  string_array_.Set(string_array_data);
-
+  // The later items win as the original hash map did.
+  absl::btree_map<std::string, uint32_t> index;
   UsageDictItemIterator begin(usage_items_data.data());
   UsageDictItemIterator end(usage_items_data.data() + usage_items_data.size());
-
-  // TODO(taku): To reduce memory footprint, better to replace it with
-  // binary search over the conjugation_suffix_data directly.
-  for (; begin != end; ++begin) {
+  for (uint32_t item = 0; begin != end; ++begin, ++item) {
     for (size_t i = conjugation_suffix_data_index[begin.conjugation_id()];
          i < conjugation_suffix_data_index[begin.conjugation_id() + 1]; ++i) {
-      const absl::string_view key = string_array_[begin.key_index()];
-      const absl::string_view value = string_array_[begin.value_index()];
+      const absl::string_view key = string_array[begin.key_index()];
+      const absl::string_view value = string_array[begin.value_index()];
       const absl::string_view key_suffix =
-          string_array_[conjugation_suffix[2 * i + 1]];
+          string_array[conjugation_suffix[2 * i + 1]];
       const absl::string_view value_suffix =
-          string_array_[conjugation_suffix[2 * i]];
-      const StrPair key_value1(absl::StrCat(key, key_suffix),
-                               absl::StrCat(value, value_suffix));
-      key_value_usageitem_map_[key_value1] = begin;
+          string_array[conjugation_suffix[2 * i]];
+      const std::string conjugated_value = absl::StrCat(value, value_suffix);
+      index[MakeIndexKey(absl::StrCat(key, key_suffix), conjugated_value)] =
+          item;
+      index[MakeIndexKey("", conjugated_value)] = item;
+    }
+  }
+
+  std::vector<absl::string_view> keys;
+  keys.reserve(index.size());
+  std::string result(sizeof(uint32_t) * (index.size() + 1), '\0');
+  uint32_t *header = reinterpret_cast<uint32_t *>(result.data());
+  header[0] = index.size();
+  for (const auto &[key, item] : index) {
+    header[keys.size() + 1] = item;
+    keys.push_back(key);
+  }
+  std::unique_ptr<uint32_t[]> buffer;
+  const absl::string_view keys_image =
+      SerializedStringArray::SerializeToBuffer(keys, &buffer);
+  result.append(keys_image.data(), keys_image.size());
+  return result;
+}
 
-      const StrPair key_value2("", key_value1.second);
-      key_value_usageitem_map_[key_value2] = begin;
+bool UsageRewriter::InitIndex(absl::string_view data) {
+  const size_t num_items = usage_items_data_.size() /
+                           (kUsageItemSize * sizeof(uint32_t));
+  if (data.size() < sizeof(uint32_t)) {
+    return false;
+  }
+  const uint32_t *header = reinterpret_cast<const uint32_t *>(data.data());
+  const size_t size = header[0];
+  if (size >= data.size() / sizeof(uint32_t)) {
+    return false;
+  }
+  const absl::Span<const uint32_t> items(header + 1, size);
+  SerializedStringArray keys;
+  if (!keys.Init(data.substr(sizeof(uint32_t) * (size + 1))) ||
+      keys.size() != size) {
+    return false;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    if (items[i] >= num_items || (i > 0 && !(keys[i - 1] < keys[i]))) {
+      return false;
     }
   }
+  index_items_ = items;
+  index_keys_.swap(keys);
+  return true;
+}
+
+bool UsageRewriter::InitIndexFromCopy(absl::string_view data) {
+  // The keys serialized at the end aren't padded, so the last word may be
+  // partially used.
+  index_buffer_.assign(
+      (data.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t), 0);
+  std::memcpy(index_buffer_.data(), data.data(), data.size());
+  return InitIndex(absl::string_view(
+      reinterpret_cast<const char *>(index_buffer_.data()), data.size()));
+}
+
+UsageRewriter::UsageDictItemIterator UsageRewriter::Find(
+    absl::string_view key, absl::string_view value) const {
+  const std::string index_key = MakeIndexKey(key, value);
+  const auto iter =
+      std::lower_bound(index_keys_.begin(), index_keys_.end(), index_key);
+  if (iter == index_keys_.end() || *iter != index_key) {
+    return UsageDictItemIterator();
+  }
+  const size_t item = index_items_[iter - index_keys_.begin()];
+  return UsageDictItemIterator(usage_items_data_.data() +
+                               item * kUsageItemSize * sizeof(uint32_t));
 }
 
 // static
@@ -153,15 +264,14 @@ UsageRewriter::LookupUnmatchedUsageHeuristically(
   }
 
   // key is empty;
-  StrPair key_value("", value);
-  const auto itr = key_value_usageitem_map_.find(key_value);
-  if (itr == key_value_usageitem_map_.end()) {
+  const UsageDictItemIterator iter = Find("", value);
+  if (!iter.IsValid()) {
     return UsageDictItemIterator();
   }
   // Check result key part is a prefix of the content_key.
-  const absl::string_view key = string_array_[itr->second.key_index()];
+  const absl::string_view key = string_array_[iter.key_index()];
   if (absl::StartsWith(candidate.content_key, key)) {
-    return itr->second;
+    return iter;
   }
 
   return UsageDictItemIterator();
@@ -169,12 +279,10 @@ UsageRewriter::LookupUnmatchedUsageHeuristically(
 
 UsageRewriter::UsageDictItemIterator UsageRewriter::LookupUsage(
     const Segment::Candidate &candidate) const {
-  const absl::string_view key = candidate.content_key;
-  const absl::string_view value = candidate.content_value;
-  StrPair key_value(key, value);
-  const auto itr = key_value_usageitem_map_.find(key_value);
-  if (itr != key_value_usageitem_map_.end()) {
-    return itr->second;
+  const UsageDictItemIterator iter =
+      Find(candidate.content_key, candidate.content_value);
+  if (iter.IsValid()) {
+    return iter;
   }
 
   return LookupUnmatchedUsageHeuristically(candidate);
@@ -201,7 +309,7 @@ bool UsageRewriter::Rewrite(const ConversionRequest &request,
   // dictionary.  Since just the uniqueness in one Segments is sufficient, for
   // usage from the user dictionary, we simply assign sequential numbers larger
   // than the maximum ID of the embedded usage dictionary.
-  int32_t usage_id_for_user_comment = key_value_usageitem_map_.size();
+  int32_t usage_id_for_user_comment = index_keys_.size();
   std::string comment;  // LookupComment rarely returns true.
   for (size_t i = 0; i < segments->conversion_segments_size(); ++i) {
     Segment *segment = segments->mutable_conversion_segment(i);
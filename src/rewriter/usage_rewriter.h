@@ -36,13 +36,14 @@
 #include <iterator>
 #include <new>
 #include <string>
-#include <utility>
+#include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/container/serialized_string_array.h"
 #include "converter/segments.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/derived_data_cache.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_matcher.h"
 #include "request/conversion_request.h"
@@ -53,19 +54,35 @@ namespace mozc {
 
 class UsageRewriter : public RewriterInterface {
  public:
+  // The lookup index of the usage dictionary is mapped from
+  // `derived_data_cache` if it has one, or built on the heap otherwise.
   UsageRewriter(const DataManagerInterface *data_manager,
-                const dictionary::DictionaryInterface *dictionary);
+                const dictionary::DictionaryInterface *dictionary,
+                const DerivedDataCache *derived_data_cache = nullptr);
   ~UsageRewriter() override = default;
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
 
   // better to show usage when user type "tab" key.
-  int capability(const ConversionRequest &request) const override {
+  static int GetCapability(const ConversionRequest &request) {
     return CONVERSION | PREDICTION;
   }
 
+  int capability(const ConversionRequest &request) const override {
+    return GetCapability(request);
+  }
+
+  // The section of the derived data cache holding the lookup index.
+  static const DerivedDataCache::Section kDerivedIndexSection;
+
+  // Builds the lookup index. Its format is a uint32_t N followed by N uint32_t
+  // item indices and a SerializedStringArray of N sorted keys, each of which
+  // is "key\0value" of the usage item (the key may be empty).
+  static std::string BuildIndex(const DataManagerInterface &data_manager);
+
  private:
   FRIEND_TEST(UsageRewriterTest, GetKanjiPrefixAndOneHiragana);
+  FRIEND_TEST(UsageRewriterTest, IndexOfUnalignedSize);
 
   static constexpr size_t kUsageItemSize = 5;
 
@@ -103,14 +120,23 @@ class UsageRewriter : public RewriterInterface {
     const uint32_t *ptr_;
   };
 
-  using StrPair = std::pair<std::string, std::string>;
   static std::string GetKanjiPrefixAndOneHiragana(absl::string_view word);
 
+  // Sets the index if `data` is a valid index of the usage items.
+  bool InitIndex(absl::string_view data);
+  // Same as InitIndex() but copies `data` to an aligned buffer first.
+  bool InitIndexFromCopy(absl::string_view data);
+  UsageDictItemIterator Find(absl::string_view key,
+                             absl::string_view value) const;
+
   UsageDictItemIterator LookupUnmatchedUsageHeuristically(
       const Segment::Candidate &candidate) const;
   UsageDictItemIterator LookupUsage(const Segment::Candidate &candidate) const;
 
-  absl::flat_hash_map<StrPair, UsageDictItemIterator> key_value_usageitem_map_;
+  absl::string_view usage_items_data_;
+  std::vector<uint32_t> index_buffer_;  // Empty if mapped from the cache.
+  absl::Span<const uint32_t> index_items_;
+  SerializedStringArray index_keys_;
   const dictionary::PosMatcher pos_matcher_;
   const dictionary::DictionaryInterface *dictionary_;
   const uint32_t *base_conjugation_suffix_;
@@ -30,12 +30,16 @@
 #ifndef NO_USAGE_REWRITER
 #include "rewriter/usage_rewriter.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "base/file/temp_dir.h"
 #include "config/config_handler.h"
 #include "converter/segments.h"
+#include "data_manager/derived_data_cache.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/pos_matcher.h"
 #include "dictionary/suppression_dictionary.h"
@@ -47,6 +51,7 @@
 #include "protocol/user_dictionary_storage.pb.h"
 #include "request/conversion_request.h"
 #include "rewriter/rewriter_interface.h"
+#include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
 
@@ -129,6 +134,49 @@ TEST_F(UsageRewriterTest, ConjugationTest) {
   EXPECT_NE(segments.conversion_segment(0).candidate(1).usage_description, "");
 }
 
+TEST_F(UsageRewriterTest, IndexFromDerivedDataCache) {
+  absl::StatusOr<TempDirectory> dir =
+      TempDirectory::Default().CreateTempDirectory();
+  ASSERT_OK(dir);
+  absl::StatusOr<std::unique_ptr<DerivedDataCache>> cache =
+      DerivedDataCache::Open(dir->path(), *data_manager_,
+                             {UsageRewriter::kDerivedIndexSection});
+  ASSERT_OK(cache);
+  EXPECT_EQ((*cache)->Get(UsageRewriter::kDerivedIndexSection.name),
+            UsageRewriter::BuildIndex(*data_manager_));
+
+  UsageRewriter rewriter(data_manager_.get(), user_dictionary_.get(),
+                         cache->get());
+  Segments segments;
+  Segment *seg = segments.push_back_segment();
+  seg->set_key("うたえば");
+  AddCandidate("うたえば", "歌えば", "うたえ", "歌え", seg);
+  AddCandidate("うたえば", "唱えば", "うたえ", "唄え", seg);
+  EXPECT_TRUE(rewriter.Rewrite(convreq_, &segments));
+  EXPECT_EQ(segments.conversion_segment(0).candidate(0).usage_title, "歌う");
+  EXPECT_EQ(segments.conversion_segment(0).candidate(1).usage_title, "唄う");
+}
+
+TEST_F(UsageRewriterTest, IndexOfUnalignedSize) {
+  // The serialized keys aren't padded to 4 bytes. Trailing bytes are allowed
+  // after them.
+  std::string index = UsageRewriter::BuildIndex(*data_manager_);
+  while (index.size() % sizeof(uint32_t) != 3) {
+    index.push_back('\0');
+  }
+
+  UsageRewriter rewriter(data_manager_.get(), user_dictionary_.get());
+  ASSERT_TRUE(rewriter.InitIndexFromCopy(index));
+  EXPECT_GE(rewriter.index_buffer_.size() * sizeof(uint32_t), index.size());
+
+  Segments segments;
+  Segment *seg = segments.push_back_segment();
+  seg->set_key("うたえば");
+  AddCandidate("うたえば", "歌えば", "うたえ", "歌え", seg);
+  EXPECT_TRUE(rewriter.Rewrite(convreq_, &segments));
+  EXPECT_EQ(segments.conversion_segment(0).candidate(0).usage_title, "歌う");
+}
+
 TEST_F(UsageRewriterTest, SingleSegmentSingleCandidateTest) {
   Segments segments;
   std::unique_ptr<UsageRewriter> rewriter(CreateUsageRewriter());
@@ -62,8 +62,6 @@ constexpr int kValueSize = 4;
 constexpr uint32_t kLruSize = 5000;
 constexpr uint32_t kSeedValue = 0x761fea81;
 
-constexpr char kFileName[] = "user://boundary.db";
-
 enum { INSERT, RESIZE };
 
 class LengthArray {
@@ -112,7 +110,13 @@ class LengthArray {
 
 UserBoundaryHistoryRewriter::UserBoundaryHistoryRewriter(
     const ConverterInterface *parent_converter)
+    : UserBoundaryHistoryRewriter(parent_converter,
+                                  ConfigFileStream::GetFileName(kFileName)) {}
+
+UserBoundaryHistoryRewriter::UserBoundaryHistoryRewriter(
+    const ConverterInterface *parent_converter, std::string filename)
     : parent_converter_(parent_converter),
+      filename_(std::move(filename)),
       storage_(std::make_unique<LruStorage>()) {
   DCHECK(parent_converter_);
   Reload();
@@ -204,8 +208,7 @@ bool UserBoundaryHistoryRewriter::Sync() {
 }
 
 bool UserBoundaryHistoryRewriter::Reload() {
-  const std::string filename = ConfigFileStream::GetFileName(kFileName);
-  if (!storage_->OpenOrCreate(filename.c_str(), kValueSize, kLruSize,
+  if (!storage_->OpenOrCreate(filename_.c_str(), kValueSize, kLruSize,
                               kSeedValue)) {
     LOG(WARNING) << "cannot initialize UserBoundaryHistoryRewriter";
     storage_.reset();
@@ -213,7 +216,7 @@ bool UserBoundaryHistoryRewriter::Reload() {
   }
 
   constexpr absl::string_view kFileSuffix = ".merge_pending";
-  const std::string merge_pending_file = absl::StrCat(filename, kFileSuffix);
+  const std::string merge_pending_file = absl::StrCat(filename_, kFileSuffix);
 
   // merge pending file does not always exist.
   if (absl::Status s = FileUtil::FileExists(merge_pending_file); s.ok()) {
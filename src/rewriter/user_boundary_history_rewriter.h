@@ -31,6 +31,7 @@
 #define MOZC_REWRITER_USER_BOUNDARY_HISTORY_REWRITER_H_
 
 #include <memory>
+#include <string>
 
 #include "converter/converter_interface.h"
 #include "converter/segments.h"
@@ -42,8 +43,14 @@ namespace mozc {
 
 class UserBoundaryHistoryRewriter : public RewriterInterface {
  public:
+  // The history file of the user running this process.
+  static constexpr char kFileName[] = "user://boundary.db";
+
   explicit UserBoundaryHistoryRewriter(
       const ConverterInterface *parent_converter);
+  // Stores the history in `filename` instead of kFileName.
+  UserBoundaryHistoryRewriter(const ConverterInterface *parent_converter,
+                              std::string filename);
 
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
@@ -58,6 +65,7 @@ class UserBoundaryHistoryRewriter : public RewriterInterface {
                       int type) const;
 
   const ConverterInterface *parent_converter_;
+  const std::string filename_;
   std::unique_ptr<mozc::storage::LruStorage> storage_;
 };
 
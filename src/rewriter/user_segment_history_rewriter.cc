@@ -37,6 +37,7 @@
 #include <memory>
 #include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_set.h"
@@ -81,8 +82,6 @@ constexpr uint32_t kMaxCandidatesSize = 255;
 // could be reranked in total.
 constexpr size_t kMaxRerankSize = 5;
 
-constexpr char kFileName[] = "user://segment.db";
-
 bool IsNumberStyleLearningEnabled(const ConversionRequest &request) {
   // Enabled in mobile (software keyboard & hardware keyboard)
   return request.request().kana_modifier_insensitive_conversion();
@@ -505,7 +504,14 @@ bool UserSegmentHistoryRewriter::SortCandidates(
 
 UserSegmentHistoryRewriter::UserSegmentHistoryRewriter(
     const PosMatcher *pos_matcher, const PosGroup *pos_group)
-    : storage_(std::make_unique<LruStorage>()),
+    : UserSegmentHistoryRewriter(pos_matcher, pos_group,
+                                 ConfigFileStream::GetFileName(kFileName)) {}
+
+UserSegmentHistoryRewriter::UserSegmentHistoryRewriter(
+    const PosMatcher *pos_matcher, const PosGroup *pos_group,
+    std::string filename)
+    : filename_(std::move(filename)),
+      storage_(std::make_unique<LruStorage>()),
       pos_matcher_(pos_matcher),
       pos_group_(pos_group) {
   Reload();
@@ -825,8 +831,7 @@ bool UserSegmentHistoryRewriter::Sync() {
 }
 
 bool UserSegmentHistoryRewriter::Reload() {
-  const std::string filename = ConfigFileStream::GetFileName(kFileName);
-  if (!storage_->OpenOrCreate(filename.c_str(), kValueSize, kLruSize,
+  if (!storage_->OpenOrCreate(filename_.c_str(), kValueSize, kLruSize,
                               kSeedValue)) {
     LOG(WARNING) << "cannot initialize UserSegmentHistoryRewriter";
     storage_.reset();
@@ -834,7 +839,7 @@ bool UserSegmentHistoryRewriter::Reload() {
   }
 
   constexpr char kFileSuffix[] = ".merge_pending";
-  const std::string merge_pending_file = filename + kFileSuffix;
+  const std::string merge_pending_file = filename_ + kFileSuffix;
 
   // merge pending file does not always exist.
   if (absl::Status s = FileUtil::FileExists(merge_pending_file); s.ok()) {
@@ -34,6 +34,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -48,8 +49,15 @@ namespace mozc {
 
 class UserSegmentHistoryRewriter : public RewriterInterface {
  public:
+  // The history file of the user running this process.
+  static constexpr char kFileName[] = "user://segment.db";
+
   UserSegmentHistoryRewriter(const dictionary::PosMatcher *pos_matcher,
                              const dictionary::PosGroup *pos_group);
+  // Stores the history in `filename` instead of kFileName.
+  UserSegmentHistoryRewriter(const dictionary::PosMatcher *pos_matcher,
+                             const dictionary::PosGroup *pos_group,
+                             std::string filename);
 
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override;
@@ -108,6 +116,7 @@ class UserSegmentHistoryRewriter : public RewriterInterface {
   Score Fetch(absl::string_view key, uint32_t weight) const;
   void Insert(absl::string_view key, bool force);
 
+  const std::string filename_;
   std::unique_ptr<storage::LruStorage> storage_;
   const dictionary::PosMatcher *pos_matcher_;
   const dictionary::PosGroup *pos_group_;
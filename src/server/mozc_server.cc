@@ -47,12 +47,22 @@
 #include "config/stats_config_util.h"
 #include "session/session_server.h"
 
+#ifdef __linux__
+#include "session/multi_user_session_server.h"
+#endif  // __linux__
+
 #ifdef _WIN32
 #include <windows.h>
 #endif  // _WIN32
 
 ABSL_DECLARE_FLAG(bool, restricted);  // in SessionHandler
 
+ABSL_FLAG(std::string, multi_user_profile_root, "",
+          "If set, serves all the users of this machine in one process, "
+          "storing the data of each user in <multi_user_profile_root>/<uid>. "
+          "The requests of all the users are evaluated on one thread, so a "
+          "slow request of a user delays the others. Only supported on Linux.");
+
 namespace {
 mozc::SessionServer *g_session_server = nullptr;
 }
@@ -104,6 +114,21 @@ int MozcServer::Run() {
     return -1;
   }
 
+#ifdef __linux__
+  if (const std::string profile_root =
+          absl::GetFlag(FLAGS_multi_user_profile_root);
+      !profile_root.empty()) {
+    MultiUserSessionServer server(profile_root);
+    if (!server.Connected()) {
+      LOG(ERROR) << "MultiUserSessionServer initialization failed";
+      return -1;
+    }
+    server.LoopAndReturn();
+    server.Wait();
+    return 0;
+  }
+#endif  // __linux__
+
   {
     std::unique_ptr<mozc::SessionServer> session_server(
         new mozc::SessionServer);
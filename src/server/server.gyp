@@ -105,6 +105,13 @@
         '<(mozc_oss_src_dir)/protocol/protocol.gyp:state_proto',
         '<(mozc_oss_src_dir)/usage_stats/usage_stats_base.gyp:usage_stats',
       ],
+      'conditions': [
+        ['target_platform=="Linux"', {
+          'dependencies': [
+            '<(mozc_oss_src_dir)/session/session.gyp:multi_user_session_server',
+          ],
+        }],
+      ],
     },
     {
       'target_name': 'mozc_rpc_server_main',
@@ -48,6 +48,7 @@ const composer::Composer &ImeContext::composer() const {
 
 composer::Composer *ImeContext::mutable_composer() {
   DCHECK(composer_.get());
+  snapshot_dirty_ = true;
   return composer_.get();
 }
 
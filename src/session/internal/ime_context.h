@@ -72,6 +72,7 @@ class ImeContext final {
   composer::Composer *mutable_composer();
   void set_composer(std::unique_ptr<composer::Composer> composer) {
     composer_ = std::move(composer);
+    snapshot_dirty_ = true;
   }
 
   const SessionConverterInterface &converter() const { return *converter_; }
@@ -92,7 +93,16 @@ class ImeContext final {
     CONVERSION = 8,
   };
   State state() const { return state_; }
-  void set_state(State state) { state_ = state; }
+  void set_state(State state) {
+    snapshot_dirty_ |= state != state_;
+    state_ = state;
+  }
+
+  // Returns true if the state or the composer may have changed since the last
+  // clear_snapshot_dirty(), i.e., a new session snapshot may differ. Any call
+  // of mutable_composer() is taken as a change.
+  bool snapshot_dirty() const { return snapshot_dirty_; }
+  void clear_snapshot_dirty() { snapshot_dirty_ = false; }
 
   void SetRequest(const commands::Request *request);
   const commands::Request &GetRequest() const;
@@ -148,6 +158,7 @@ class ImeContext final {
   const keymap::KeyMapManager *key_map_manager_;
 
   State state_ = NONE;
+  bool snapshot_dirty_ = true;
   commands::Capability client_capability_;
   commands::ApplicationInfo application_info_;
   commands::Context client_context_;
@@ -99,6 +99,26 @@ TEST(ImeContextTest, BasicTest) {
   EXPECT_EQ(context.output().id(), 1414);
 }
 
+TEST(ImeContextTest, SnapshotDirty) {
+  ImeContext context;
+  config::Config config;
+  const commands::Request request;
+  context.set_composer(std::make_unique<Composer>(nullptr, &request, &config));
+  EXPECT_TRUE(context.snapshot_dirty());
+
+  context.clear_snapshot_dirty();
+  context.composer();
+  context.set_state(ImeContext::NONE);
+  EXPECT_FALSE(context.snapshot_dirty());
+
+  context.set_state(ImeContext::PRECOMPOSITION);
+  EXPECT_TRUE(context.snapshot_dirty());
+
+  context.clear_snapshot_dirty();
+  context.mutable_composer();
+  EXPECT_TRUE(context.snapshot_dirty());
+}
+
 TEST(ImeContextTest, CopyContext) {
   composer::Table table;
   table.AddRule("a", "あ", "");
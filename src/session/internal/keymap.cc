@@ -675,6 +675,14 @@ bool KeyMapManager::GetCommandPrecomposition(
   return keymap_precomposition_.GetCommand(key_event, command);
 }
 
+std::vector<KeyInformation> KeyMapManager::GetSortedKeysPrecomposition()
+    const {
+  std::vector<KeyInformation> keys;
+  keymap_precomposition_.AppendKeys(&keys);
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
 bool KeyMapManager::GetCommandComposition(
     const commands::KeyEvent &key_event,
     CompositionState::Commands *command) const {
@@ -208,6 +208,9 @@ class KeyMap {
   bool AddRule(const commands::KeyEvent &key_event, CommandsType command);
   void Clear();
 
+  // Appends the KeyInformation of all the bound keys, including key stubs.
+  void AppendKeys(std::vector<KeyInformation> *keys) const;
+
  private:
   using KeyToCommandMap = absl::flat_hash_map<KeyInformation, CommandsType>;
   KeyToCommandMap keymap_;
@@ -273,6 +276,10 @@ class KeyMapManager {
   void AppendAvailableCommandNamePrediction(
       absl::flat_hash_set<std::string> &command_names) const;
 
+  // Returns a sorted list of KeyInformation bound in the precomposition
+  // state.  Keys not in the list are echoed back by the session.
+  std::vector<KeyInformation> GetSortedKeysPrecomposition() const;
+
   // Return the file name bound with the keymap enum.
   static const char *GetKeyMapFileName(config::Config::SessionKeymap keymap);
 
@@ -375,10 +382,10 @@ bool KeyMap<T>::GetCommand(const commands::KeyEvent &key_event,
                            CommandsType *command) const {
   // Shortcut keys should be available as if CapsLock was not enabled like
   // other IMEs such as MS-IME or ATOK. b/5627459
-  commands::KeyEvent normalized_key_event;
-  KeyEventUtil::NormalizeModifiers(key_event, &normalized_key_event);
+  // This runs for every key event, so the key information is normalized
+  // without copying the key event.
   KeyInformation key;
-  if (!KeyEventUtil::GetKeyInformation(normalized_key_event, &key)) {
+  if (!KeyEventUtil::GetNormalizedKeyInformation(key_event, &key)) {
     return false;
   }
 
@@ -387,7 +394,7 @@ bool KeyMap<T>::GetCommand(const commands::KeyEvent &key_event,
     return true;
   }
 
-  if (KeyEventUtil::MaybeGetKeyStub(normalized_key_event, &key)) {
+  if (KeyEventUtil::MaybeGetNormalizedKeyStub(key_event, &key)) {
     const auto it = keymap_.find(key);
     if (it != keymap_.end()) {
       *command = it->second;
@@ -415,6 +422,14 @@ void KeyMap<T>::Clear() {
   keymap_.clear();
 }
 
+template <typename T>
+void KeyMap<T>::AppendKeys(std::vector<KeyInformation> *keys) const {
+  keys->reserve(keys->size() + keymap_.size());
+  for (const auto &[key, command] : keymap_) {
+    keys->push_back(key);
+  }
+}
+
 }  // namespace keymap
 }  // namespace mozc
 
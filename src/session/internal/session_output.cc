@@ -34,6 +34,8 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -127,26 +129,55 @@ void FillCandidateWord(const Segment::Candidate &segment_candidate,
 #endif  // NDEBUG
 }
 
+// Finds the flattened index of the focused candidate in the same order as
+// FillAllCandidateWordsInternal without filling any candidate words.
+void FindFocusedCandidateWord(const CandidateList &candidate_list,
+                              const int focused_id, size_t *index,
+                              std::optional<size_t> *focused_index) {
+  for (size_t i = 0; i < candidate_list.size(); ++i) {
+    const Candidate &candidate = candidate_list.candidate(i);
+    if (candidate.HasSubcandidateList()) {
+      FindFocusedCandidateWord(candidate.subcandidate_list(), focused_id, index,
+                               focused_index);
+      continue;
+    }
+    if (candidate.id() == focused_id && candidate_list.focused()) {
+      *focused_index = *index;
+    }
+    ++*index;
+  }
+}
+
+// Fills the candidate words whose flattened index is in [begin, end).
+// |index| is the flattened index of the next candidate, and |focused_index| is
+// set to the flattened index of the focused candidate if any.
 void FillAllCandidateWordsInternal(
     const Segment &segment, const CandidateList &candidate_list,
-    const int focused_id, commands::CandidateList *candidate_list_proto) {
+    const int focused_id, const size_t begin, const size_t end, size_t *index,
+    std::optional<size_t> *focused_index,
+    commands::CandidateList *candidate_list_proto) {
   for (size_t i = 0; i < candidate_list.size(); ++i) {
     const Candidate &candidate = candidate_list.candidate(i);
     if (candidate.HasSubcandidateList()) {
       FillAllCandidateWordsInternal(segment, candidate.subcandidate_list(),
-                                    focused_id, candidate_list_proto);
+                                    focused_id, begin, end, index,
+                                    focused_index, candidate_list_proto);
       continue;
     }
 
-    commands::CandidateWord *candidate_word_proto =
-        candidate_list_proto->add_candidates();
     const int id = candidate.id();
-    const int index = candidate_list_proto->candidates_size() - 1;
+    const size_t current_index = (*index)++;
 
     // check focused id
     if (id == focused_id && candidate_list.focused()) {
-      candidate_list_proto->set_focused_index(index);
+      *focused_index = current_index;
+    }
+
+    if (current_index < begin || current_index >= end) {
+      continue;
     }
+    commands::CandidateWord *candidate_word_proto =
+        candidate_list_proto->add_candidates();
 
     if (!segment.is_valid_index(id)) {
       LOG(ERROR) << "Inconsistency between segment and candidate_list was "
@@ -156,7 +187,7 @@ void FillAllCandidateWordsInternal(
       return;
     }
     const Segment::Candidate &segment_candidate = segment.candidate(id);
-    FillCandidateWord(segment_candidate, id, index, segment.key(),
+    FillCandidateWord(segment_candidate, id, current_index, segment.key(),
                       candidate_word_proto);
   }
 }
@@ -239,9 +270,50 @@ void SessionOutput::FillAllCandidateWords(
     const commands::Category category,
     commands::CandidateList *candidate_list_proto) {
   candidate_list_proto->set_category(category);
+  size_t index = 0;
+  std::optional<size_t> focused_index;
+  FillAllCandidateWordsInternal(
+      segment, candidate_list, candidate_list.focused_id(), 0,
+      std::numeric_limits<size_t>::max(), &index, &focused_index,
+      candidate_list_proto);
+  if (focused_index.has_value()) {
+    candidate_list_proto->set_focused_index(*focused_index);
+  }
+}
+
+// static
+void SessionOutput::FillCandidateWordsInRange(
+    const Segment &segment, const CandidateList &candidate_list,
+    const commands::Category category, const size_t offset, const size_t size,
+    commands::CandidateList *candidate_list_proto) {
+  candidate_list_proto->set_category(category);
+  size_t index = 0;
+  std::optional<size_t> focused_index;
   FillAllCandidateWordsInternal(segment, candidate_list,
-                                candidate_list.focused_id(),
+                                candidate_list.focused_id(), offset,
+                                offset + size, &index, &focused_index,
                                 candidate_list_proto);
+  candidate_list_proto->set_size(index);
+  candidate_list_proto->set_offset(offset);
+  if (focused_index.has_value() && *focused_index >= offset &&
+      *focused_index < offset + size) {
+    candidate_list_proto->set_focused_index(*focused_index - offset);
+  }
+}
+
+// static
+void SessionOutput::FillCandidateWordsPage(
+    const Segment &segment, const CandidateList &candidate_list,
+    const commands::Category category, const size_t page_size,
+    commands::CandidateList *candidate_list_proto) {
+  DCHECK_GT(page_size, 0);
+  size_t index = 0;
+  std::optional<size_t> focused_index;
+  FindFocusedCandidateWord(candidate_list, candidate_list.focused_id(), &index,
+                           &focused_index);
+  const size_t offset = focused_index.value_or(0) / page_size * page_size;
+  FillCandidateWordsInRange(segment, candidate_list, category, offset,
+                            page_size, candidate_list_proto);
 }
 
 // static
@@ -69,6 +69,21 @@ class SessionOutput {
       commands::Category category,
       commands::CandidateList *candidate_list_proto);
 
+  // Same as FillAllCandidateWords, but fills only |size| candidate words from
+  // |offset| of the flatten candidates.  The total number of the candidate
+  // words and |offset| are also stored.
+  static void FillCandidateWordsInRange(
+      const Segment &segment, const CandidateList &candidate_list,
+      commands::Category category, size_t offset, size_t size,
+      commands::CandidateList *candidate_list_proto);
+
+  // Fills the page of |page_size| candidate words containing the focused
+  // candidate with FillCandidateWordsInRange.
+  static void FillCandidateWordsPage(
+      const Segment &segment, const CandidateList &candidate_list,
+      commands::Category category, size_t page_size,
+      commands::CandidateList *candidate_list_proto);
+
   // For debug. Fill the CandidateList protobuf with the
   // removed_candidates_for_debug in the segment.
   static void FillRemovedCandidates(
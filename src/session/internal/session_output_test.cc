@@ -34,6 +34,7 @@
 #include <iterator>
 #include <string>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "base/text_normalizer.h"
 #include "base/util.h"
@@ -887,6 +888,49 @@ TEST(SessionOutputTest, FillAllCandidateWords_NonFocused) {
   }
 }
 
+TEST(SessionOutputTest, FillCandidateWordsPage) {
+  constexpr size_t kCandidateSize = 20;
+  constexpr size_t kPageSize = 9;
+  Segment segment;
+  segment.set_key("key");
+  CandidateList main_list(true);
+  main_list.set_page_size(kPageSize);
+  for (size_t i = 0; i < kCandidateSize; ++i) {
+    Segment::Candidate *candidate = segment.push_back_candidate();
+    candidate->content_key = "key";
+    candidate->value = absl::StrCat("value", i);
+    main_list.AddCandidate(i, candidate->value);
+  }
+  main_list.set_focused(true);
+  main_list.MoveToId(12);
+
+  {
+    // The page of the focused candidate.
+    commands::CandidateList candidates_proto;
+    SessionOutput::FillCandidateWordsPage(segment, main_list,
+                                          commands::CONVERSION, kPageSize,
+                                          &candidates_proto);
+    EXPECT_EQ(candidates_proto.size(), kCandidateSize);
+    EXPECT_EQ(candidates_proto.offset(), 9);
+    ASSERT_EQ(candidates_proto.candidates_size(), kPageSize);
+    EXPECT_EQ(candidates_proto.candidates(0).index(), 9);
+    EXPECT_EQ(candidates_proto.candidates(0).value(), "value9");
+    EXPECT_EQ(candidates_proto.focused_index(), 3);
+  }
+  {
+    // The last page doesn't contain the focused candidate.
+    commands::CandidateList candidates_proto;
+    SessionOutput::FillCandidateWordsInRange(segment, main_list,
+                                             commands::CONVERSION, 18,
+                                             kPageSize, &candidates_proto);
+    EXPECT_EQ(candidates_proto.size(), kCandidateSize);
+    EXPECT_EQ(candidates_proto.offset(), 18);
+    ASSERT_EQ(candidates_proto.candidates_size(), 2);
+    EXPECT_EQ(candidates_proto.candidates(1).value(), "value19");
+    EXPECT_FALSE(candidates_proto.has_focused_index());
+  }
+}
+
 TEST(SessionOutputTest, FillRemovedCandidateWords) {
   commands::CandidateList candidates_proto;
 
@@ -130,4 +130,18 @@ bool KeyInfoUtil::ContainsKey(const std::vector<KeyInformation> &sorted_keys,
   return std::binary_search(sorted_keys.begin(), sorted_keys.end(), key_info);
 }
 
+bool KeyInfoUtil::ContainsKeyOrStub(
+    const std::vector<KeyInformation> &sorted_keys,
+    const commands::KeyEvent &key_event) {
+  KeyInformation key_info;
+  if (!KeyEventUtil::GetNormalizedKeyInformation(key_event, &key_info)) {
+    return false;
+  }
+  if (std::binary_search(sorted_keys.begin(), sorted_keys.end(), key_info)) {
+    return true;
+  }
+  return KeyEventUtil::MaybeGetNormalizedKeyStub(key_event, &key_info) &&
+         std::binary_search(sorted_keys.begin(), sorted_keys.end(), key_info);
+}
+
 }  // namespace mozc
@@ -52,6 +52,12 @@ class KeyInfoUtil {
   // sorted.
   static bool ContainsKey(const std::vector<KeyInformation> &sorted_keys,
                           const commands::KeyEvent &key_event);
+
+  // Returns true if |sorted_keys| contains |key_event| in the same way as
+  // keymap::KeyMap::GetCommand, i.e. ignoring CapsLock and falling back to
+  // the key stub.  |sorted_keys| must be sorted.
+  static bool ContainsKeyOrStub(const std::vector<KeyInformation> &sorted_keys,
+                                const commands::KeyEvent &key_event);
 };
 
 }  // namespace mozc
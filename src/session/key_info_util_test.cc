@@ -39,6 +39,7 @@
 #include "config/config_handler.h"
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
+#include "session/internal/keymap.h"
 #include "testing/gunit.h"
 
 namespace mozc {
@@ -128,5 +129,33 @@ TEST(KeyInfoUtilTest, ContainsKey) {
   }
 }
 
+TEST(KeyInfoUtilTest, ContainsKeyOrStub) {
+  const keymap::KeyMapManager manager;
+  const std::vector<KeyInformation> precomposition_keys =
+      manager.GetSortedKeysPrecomposition();
+  EXPECT_TRUE(std::is_sorted(precomposition_keys.begin(),
+                             precomposition_keys.end()));
+
+  // ContainsKeyOrStub must agree with the keymap lookup.
+  for (const char *key_string :
+       {"a", "A", "Shift a", "CapsLock a", "Space", "Shift Space", "Enter",
+        "Backspace", "Ctrl Backspace", "Left", "Ctrl a", "Alt a", "F1", "F10",
+        "Hiragana", "Henkan", "Shift", "Ctrl"}) {
+    SCOPED_TRACE(key_string);
+    KeyEvent key;
+    ASSERT_TRUE(KeyParser::ParseKey(key_string, &key));
+    keymap::PrecompositionState::Commands command;
+    EXPECT_EQ(KeyInfoUtil::ContainsKeyOrStub(precomposition_keys, key),
+              manager.GetCommandPrecomposition(key, &command));
+  }
+
+  KeyEvent key;
+  KeyParser::ParseKey("a", &key);
+  EXPECT_TRUE(KeyInfoUtil::ContainsKeyOrStub(precomposition_keys, key));
+  KeyParser::ParseKey("Enter", &key);
+  EXPECT_FALSE(KeyInfoUtil::ContainsKeyOrStub(precomposition_keys, key));
+  EXPECT_FALSE(KeyInfoUtil::ContainsKeyOrStub({}, key));
+}
+
 }  // namespace
 }  // namespace mozc
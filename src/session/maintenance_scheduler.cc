@@ -0,0 +1,99 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/maintenance_scheduler.h"
+
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "base/vlog.h"
+
+namespace mozc {
+namespace session {
+
+MaintenanceScheduler::MaintenanceScheduler(absl::Duration idle_threshold,
+                                           absl::Duration max_deferral)
+    : idle_threshold_(idle_threshold), max_deferral_(max_deferral) {}
+
+void MaintenanceScheduler::AddTask(absl::string_view name,
+                                   absl::Duration interval,
+                                   absl::AnyInvocable<void()> task) {
+  tasks_.push_back(Task{
+      .name = std::string(name),
+      .interval = interval,
+      .run = std::move(task),
+  });
+}
+
+bool MaintenanceScheduler::IsIdle(absl::Time now) const {
+  // A negative duration means the clock was altered. Treats it as idle so as
+  // not to block the maintenance until the clock catches up.
+  const absl::Duration elapsed = now - last_activity_time_;
+  return elapsed < absl::ZeroDuration() || elapsed >= idle_threshold_;
+}
+
+int MaintenanceScheduler::MaybeRun(absl::Time now) {
+  const bool idle = IsIdle(now);
+  int num_run = 0;
+  for (Task &task : tasks_) {
+    if (now - task.last_run_time < task.interval) {
+      continue;
+    }
+    if (!idle) {
+      if (task.first_deferred_time == absl::InfinitePast()) {
+        task.first_deferred_time = now;
+      }
+      if (now - task.first_deferred_time < max_deferral_) {
+        MOZC_VLOG(1) << "Deferred maintenance: " << task.name;
+        ++stats_.deferred_count;
+        continue;
+      }
+      MOZC_VLOG(1) << "Maintenance deferred too long: " << task.name;
+      ++stats_.forced_count;
+    } else {
+      ++stats_.run_count;
+    }
+    MOZC_VLOG(2) << "Running maintenance: " << task.name;
+    task.run();
+    task.last_run_time = now;
+    task.first_deferred_time = absl::InfinitePast();
+    ++num_run;
+  }
+  if (num_run > 0) {
+    MOZC_VLOG(1) << "Maintenance stats: run=" << stats_.run_count
+                 << " deferred=" << stats_.deferred_count
+                 << " forced=" << stats_.forced_count;
+  }
+  return num_run;
+}
+
+}  // namespace session
+}  // namespace mozc
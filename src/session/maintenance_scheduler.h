@@ -0,0 +1,103 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Runs the periodic maintenance of the server (syncing user data, preparing
+// spare sessions, ...) only while the user is not typing.
+
+#ifndef MOZC_SESSION_MAINTENANCE_SCHEDULER_H_
+#define MOZC_SESSION_MAINTENANCE_SCHEDULER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace session {
+
+class MaintenanceScheduler final {
+ public:
+  struct Stats {
+    // The number of tasks run while the server was idle.
+    int64_t run_count = 0;
+    // The number of due tasks put off because the user was typing.
+    int64_t deferred_count = 0;
+    // The number of tasks run despite the activity, because they had been
+    // deferred for max_deferral.
+    int64_t forced_count = 0;
+  };
+
+  // The server is idle when no activity has been notified for
+  // |idle_threshold|. A due task is not deferred more than |max_deferral|.
+  MaintenanceScheduler(absl::Duration idle_threshold,
+                       absl::Duration max_deferral);
+  MaintenanceScheduler(const MaintenanceScheduler &) = delete;
+  MaintenanceScheduler &operator=(const MaintenanceScheduler &) = delete;
+
+  // Registers |task| to run at most once per |interval|. Tasks run in the
+  // order they are added.
+  void AddTask(absl::string_view name, absl::Duration interval,
+               absl::AnyInvocable<void()> task);
+
+  // Records the user activity (e.g. key events) at |time|.
+  void NotifyActivity(absl::Time time) { last_activity_time_ = time; }
+
+  bool IsIdle(absl::Time now) const;
+
+  // Runs the tasks due at |now| if the server is idle, and defers them
+  // otherwise. Logs the stats when any task has run. Returns the number of
+  // tasks run.
+  int MaybeRun(absl::Time now);
+
+  const Stats &stats() const { return stats_; }
+
+ private:
+  struct Task {
+    std::string name;
+    absl::Duration interval;
+    absl::AnyInvocable<void()> run;
+    absl::Time last_run_time = absl::InfinitePast();
+    // The time the task was deferred first since it was run last.
+    absl::Time first_deferred_time = absl::InfinitePast();
+  };
+
+  const absl::Duration idle_threshold_;
+  const absl::Duration max_deferral_;
+  absl::Time last_activity_time_ = absl::InfinitePast();
+  std::vector<Task> tasks_;
+  Stats stats_;
+};
+
+}  // namespace session
+}  // namespace mozc
+
+#endif  // MOZC_SESSION_MAINTENANCE_SCHEDULER_H_
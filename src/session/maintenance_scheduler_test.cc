@@ -0,0 +1,112 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/maintenance_scheduler.h"
+
+#include "absl/time/time.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace session {
+namespace {
+
+constexpr absl::Duration kIdleThreshold = absl::Seconds(5);
+constexpr absl::Duration kMaxDeferral = absl::Minutes(10);
+
+TEST(MaintenanceSchedulerTest, RunsOnlyWhenIdle) {
+  MaintenanceScheduler scheduler(kIdleThreshold, kMaxDeferral);
+  int sync_count = 0;
+  scheduler.AddTask("Sync", absl::ZeroDuration(), [&] { ++sync_count; });
+
+  absl::Time now = absl::FromUnixSeconds(1000);
+  EXPECT_TRUE(scheduler.IsIdle(now));
+  EXPECT_EQ(scheduler.MaybeRun(now), 1);
+  EXPECT_EQ(sync_count, 1);
+
+  // The user is typing.
+  scheduler.NotifyActivity(now);
+  now += absl::Seconds(1);
+  EXPECT_FALSE(scheduler.IsIdle(now));
+  EXPECT_EQ(scheduler.MaybeRun(now), 0);
+  EXPECT_EQ(sync_count, 1);
+  EXPECT_EQ(scheduler.stats().deferred_count, 1);
+
+  now += kIdleThreshold;
+  EXPECT_TRUE(scheduler.IsIdle(now));
+  EXPECT_EQ(scheduler.MaybeRun(now), 1);
+  EXPECT_EQ(sync_count, 2);
+  EXPECT_EQ(scheduler.stats().run_count, 2);
+
+  // The clock went backward.
+  EXPECT_TRUE(scheduler.IsIdle(now - absl::Hours(1)));
+}
+
+TEST(MaintenanceSchedulerTest, Interval) {
+  MaintenanceScheduler scheduler(kIdleThreshold, kMaxDeferral);
+  int sync_count = 0;
+  int trim_count = 0;
+  scheduler.AddTask("Sync", absl::ZeroDuration(), [&] { ++sync_count; });
+  scheduler.AddTask("Trim", absl::Hours(1), [&] { ++trim_count; });
+
+  absl::Time now = absl::FromUnixSeconds(1000);
+  EXPECT_EQ(scheduler.MaybeRun(now), 2);
+  now += absl::Minutes(1);
+  EXPECT_EQ(scheduler.MaybeRun(now), 1);
+  now += absl::Hours(1);
+  EXPECT_EQ(scheduler.MaybeRun(now), 2);
+  EXPECT_EQ(sync_count, 3);
+  EXPECT_EQ(trim_count, 2);
+}
+
+TEST(MaintenanceSchedulerTest, MaxDeferral) {
+  MaintenanceScheduler scheduler(kIdleThreshold, kMaxDeferral);
+  int sync_count = 0;
+  scheduler.AddTask("Sync", absl::ZeroDuration(), [&] { ++sync_count; });
+
+  // The user keeps typing.
+  absl::Time now = absl::FromUnixSeconds(1000);
+  scheduler.NotifyActivity(now);
+  EXPECT_EQ(scheduler.MaybeRun(now), 0);
+  now += kMaxDeferral / 2;
+  scheduler.NotifyActivity(now);
+  EXPECT_EQ(scheduler.MaybeRun(now), 0);
+  now += kMaxDeferral / 2;
+  scheduler.NotifyActivity(now);
+  EXPECT_EQ(scheduler.MaybeRun(now), 1);
+  EXPECT_EQ(sync_count, 1);
+  EXPECT_EQ(scheduler.stats().deferred_count, 2);
+  EXPECT_EQ(scheduler.stats().forced_count, 1);
+
+  // The deferral restarts after the run.
+  EXPECT_EQ(scheduler.MaybeRun(now), 0);
+}
+
+}  // namespace
+}  // namespace session
+}  // namespace mozc
@@ -0,0 +1,261 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/multi_user_session_server.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "base/file_util.h"
+#include "base/vlog.h"
+#include "config/character_form_manager.h"
+#include "config/config_handler.h"
+#include "dictionary/user_dictionary_util.h"
+#include "engine/engine.h"
+#include "engine/engine_factory.h"
+#include "engine/modules.h"
+#include "ipc/ipc.h"
+#include "ipc/ipc_path_manager.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler.h"
+#include "session/session_usage_observer.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif  // !_WIN32
+
+ABSL_FLAG(int32_t, max_users, 256,
+          "The maximum number of users hosted by the multi-user server.");
+
+ABSL_DECLARE_FLAG(int32_t, watch_dog_interval);  // in session_handler.cc
+
+namespace mozc {
+namespace {
+
+// The clients of many users connect to the server.
+constexpr int kNumConnections = 128;
+constexpr absl::Duration kTimeOut = absl::Milliseconds(5000);
+constexpr char kSessionName[] = "session";
+// The same name as the history of the singleton CharacterFormManager.
+constexpr char kCharacterFormFile[] = "cform.db";
+
+uint32_t GetServerUserId() {
+#ifdef _WIN32
+  return 0;
+#else   // _WIN32
+  return ::geteuid();
+#endif  // _WIN32
+}
+
+}  // namespace
+
+MultiUserSessionServer::MultiUserSessionServer(std::string profile_root)
+    : IPCServer(kSessionName, kNumConnections, kTimeOut),
+      profile_root_(std::move(profile_root)),
+      usage_observer_(std::make_unique<session::SessionUsageObserver>()) {
+  if (absl::Status s = FileUtil::CreateDirectory(profile_root_); !s.ok()) {
+    LOG(ERROR) << "Cannot create " << profile_root_ << ": " << s;
+    return;
+  }
+  absl::StatusOr<std::unique_ptr<engine::Modules>> modules =
+      EngineFactory::CreateModules();
+  if (!modules.ok()) {
+    LOG(ERROR) << "Failed to initialize the shared modules: "
+               << modules.status();
+    return;
+  }
+  shared_modules_ = *std::move(modules);
+
+  AcceptOtherUsers();
+#ifndef _WIN32
+  if (!IPCPathManager::GetIPCPathManager(kSessionName)->ShareWithOtherUsers()) {
+    LOG(WARNING) << "The clients of the other users cannot find the server";
+  }
+#endif  // !_WIN32
+
+#ifndef MOZC_DISABLE_SESSION_WATCHDOG
+  session_watch_dog_.emplace(
+      absl::Seconds(absl::GetFlag(FLAGS_watch_dog_interval)));
+#endif  // MOZC_DISABLE_SESSION_WATCHDOG
+}
+
+bool MultiUserSessionServer::Connected() const {
+  return shared_modules_ != nullptr && IPCServer::Connected();
+}
+
+bool MultiUserSessionServer::Process(absl::string_view request,
+                                     std::string *response) {
+  return ProcessFromPeer({.uid = GetServerUserId()}, request, response);
+}
+
+bool MultiUserSessionServer::ProcessFromPeer(const IPCPeerCredentials &peer,
+                                             absl::string_view request,
+                                             std::string *response) {
+  if (!shared_modules_) {
+    LOG(WARNING) << "shared modules are not available";
+    return false;  // shutdown the server if modules don't exist
+  }
+
+  commands::Command command;
+  if (!command.mutable_input()->ParseFromArray(request.data(),
+                                               request.size())) {
+    LOG(WARNING) << "Invalid request";
+    response->clear();
+    return true;
+  }
+
+  if (peer.uid == GetServerUserId()) {
+    if (!EvalAdminCommand(&command)) {
+      LOG(WARNING) << "Shutting down the multi-user server.";
+      response->clear();
+      return false;
+    }
+  } else {
+    SessionHandler *handler = GetSessionHandler(peer.uid);
+    if (handler == nullptr) {
+      // Closes the connection without response.
+      response->clear();
+      return true;
+    }
+    if (!handler->EvalCommand(&command)) {
+      // Only the user is shut down, and the other users are kept served.
+      MOZC_VLOG(1) << "Releasing the session handler of user " << peer.uid;
+      session_handlers_.erase(peer.uid);
+      response->clear();
+      return true;
+    }
+  }
+
+  if (!command.output().SerializeToString(response)) {
+    LOG(WARNING) << "SerializeToString() failed";
+    response->clear();
+    return true;
+  }
+
+  // debug message
+  MOZC_VLOG(2) << command;
+
+  return true;
+}
+
+bool MultiUserSessionServer::EvalAdminCommand(commands::Command *command) {
+  command->mutable_output()->set_id(command->input().id());
+  switch (command->input().type()) {
+    case commands::Input::CLEANUP:
+    case commands::Input::SYNC_DATA:
+    case commands::Input::SHUTDOWN:
+      break;
+    case commands::Input::NO_OPERATION:
+      return true;
+    default:
+      command->mutable_output()->set_error_code(
+          commands::Output::SESSION_FAILURE);
+      return true;
+  }
+
+  // Sends the command to all the users, releasing those no longer available.
+  for (auto it = session_handlers_.begin(); it != session_handlers_.end();) {
+    commands::Command user_command;
+    *user_command.mutable_input() = command->input();
+    if (it->second->EvalCommand(&user_command)) {
+      ++it;
+    } else {
+      MOZC_VLOG(1) << "Releasing the session handler of user " << it->first;
+      session_handlers_.erase(it++);
+    }
+  }
+  return command->input().type() != commands::Input::SHUTDOWN;
+}
+
+SessionHandler *MultiUserSessionServer::GetSessionHandler(uint32_t uid) {
+  if (auto it = session_handlers_.find(uid); it != session_handlers_.end()) {
+    return it->second.get();
+  }
+  if (session_handlers_.size() >=
+      static_cast<size_t>(absl::GetFlag(FLAGS_max_users))) {
+    LOG(WARNING) << "Too many users. Rejected user " << uid;
+    return nullptr;
+  }
+
+  const std::string user_profile_directory =
+      FileUtil::JoinPath(profile_root_, absl::StrCat(uid));
+  if (absl::Status s = FileUtil::CreateDirectory(user_profile_directory);
+      !s.ok()) {
+    LOG(ERROR) << "Cannot create " << user_profile_directory << ": " << s;
+    return nullptr;
+  }
+
+  auto modules = std::make_unique<engine::Modules>();
+  modules->PresetUserProfileDirectory(user_profile_directory);
+  if (absl::Status s = modules->InitWithSharedModules(*shared_modules_);
+      !s.ok()) {
+    LOG(ERROR) << "Failed to initialize the modules of user " << uid << ": "
+               << s;
+    return nullptr;
+  }
+  auto config_store = std::make_unique<config::ConfigStore>(
+      modules->GetUserDataFileName(config::ConfigHandler::GetConfigFileName()));
+  const std::string user_dictionary_file =
+      modules->GetUserDataFileName(UserDictionaryUtil::kUserDictionaryFile);
+  std::unique_ptr<config::CharacterFormManager> character_form_manager =
+      config::CharacterFormManager::CreateWithStorage(
+          *config_store->GetSharedConfig(),
+          modules->GetUserDataFileName(kCharacterFormFile));
+
+  absl::StatusOr<std::unique_ptr<Engine>> engine =
+      Engine::CreateEngine(std::move(modules), /*is_mobile=*/false);
+  if (!engine.ok()) {
+    LOG(ERROR) << "Failed to create the engine of user " << uid << ": "
+               << engine.status();
+    return nullptr;
+  }
+  auto handler = std::make_unique<SessionHandler>(
+      *std::move(engine), std::move(config_store), user_dictionary_file,
+      std::move(character_form_manager));
+  if (!handler->IsAvailable()) {
+    return nullptr;
+  }
+  handler->AddObserver(usage_observer_.get());
+  MOZC_VLOG(1) << "Created the session handler of user " << uid;
+  return session_handlers_.emplace(uid, std::move(handler))
+      .first->second.get();
+}
+
+}  // namespace mozc
@@ -0,0 +1,120 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// MultiUserSessionServer is a SessionServer hosting many users in one process
+// for thin client and terminal server deployments. The users are identified by
+// the credentials of the IPC peers.
+
+#ifndef MOZC_SESSION_MULTI_USER_SESSION_SERVER_H_
+#define MOZC_SESSION_MULTI_USER_SESSION_SERVER_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "engine/modules.h"
+#include "ipc/ipc.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler.h"
+#include "session/session_usage_observer.h"
+
+#ifndef MOZC_DISABLE_SESSION_WATCHDOG
+#include "session/session_watch_dog.h"
+#endif  // MOZC_DISABLE_SESSION_WATCHDOG
+
+namespace mozc {
+
+// The immutable modules, e.g., the data set, the dictionaries and the
+// connector, are loaded once and shared by all the users. Each user has an
+// engine built on them with the user dictionary, the user history and the
+// config stored in <profile_root>/<uid>, so that an additional user costs a
+// few MB instead of a whole server process. The character form rules and
+// their history are also kept per user. UsageStats is still process-wide and
+// aggregates the counters of all the users.
+//
+// The clients of the other users connect to this server only if they are run
+// with --ipc_trusted_server_uid set to the user running it, and their ipc key
+// file is a link owned by them to the key file of this server.
+//
+// The requests from the user running this server are administrative: CLEANUP
+// is sent to all the users, and SHUTDOWN stops the server. The session
+// handler of a user is released when it becomes unavailable, e.g., by SHUTDOWN
+// from the user or by --timeout without sessions. The session handlers don't
+// run watch dogs of their own; the watch dog of the server sends CLEANUP as
+// the user running it, so that the idle sessions of all the users are deleted
+// and their data is synced periodically.
+//
+// The requests of all the users are evaluated one at a time on the IPC server
+// thread, as in SessionServer, so a slow request of a user, e.g., a conversion
+// of a long sentence or an import to the user dictionary, delays the requests
+// of the others. They are not dispatched to ThreadPool, as the engines still
+// share process-wide state, e.g., UsageStats and the singletons used by the
+// rewriters, which is not safe to use from several threads. Hence the server
+// is only run with --multi_user_profile_root, for deployments with a moderate
+// number of users, bounded by --max_users.
+//
+// Only supported on Linux, where the IPC peer credentials are available.
+class MultiUserSessionServer : public IPCServer {
+ public:
+  explicit MultiUserSessionServer(std::string profile_root);
+  MultiUserSessionServer(const MultiUserSessionServer &) = delete;
+  MultiUserSessionServer &operator=(const MultiUserSessionServer &) = delete;
+
+  bool Connected() const;
+
+  bool Process(absl::string_view request, std::string *response) override;
+  bool ProcessFromPeer(const IPCPeerCredentials &peer,
+                       absl::string_view request,
+                       std::string *response) override;
+
+ private:
+  // Evaluates the command from the user running this server.
+  bool EvalAdminCommand(commands::Command *command);
+
+  // Returns the session handler of `uid`, which is created on the first
+  // request of the user. Returns nullptr if it cannot be created.
+  SessionHandler *GetSessionHandler(uint32_t uid);
+
+  const std::string profile_root_;
+  std::unique_ptr<const engine::Modules> shared_modules_;
+  std::unique_ptr<session::SessionUsageObserver> usage_observer_;
+  absl::flat_hash_map<uint32_t, std::unique_ptr<SessionHandler>>
+      session_handlers_;
+#ifndef MOZC_DISABLE_SESSION_WATCHDOG
+  // Declared last to be stopped before the session handlers are released.
+  std::optional<SessionWatchDog> session_watch_dog_;
+#endif  // MOZC_DISABLE_SESSION_WATCHDOG
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_SESSION_MULTI_USER_SESSION_SERVER_H_
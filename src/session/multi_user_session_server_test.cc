@@ -0,0 +1,220 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/multi_user_session_server.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "base/clock_mock.h"
+#include "base/file/temp_dir.h"
+#include "base/file_util.h"
+#include "ipc/ipc.h"
+#include "protocol/commands.pb.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+#include "testing/mozctest.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif  // !_WIN32
+
+ABSL_DECLARE_FLAG(int32_t, max_users);
+ABSL_DECLARE_FLAG(int32_t, last_command_timeout);
+
+namespace mozc {
+namespace {
+
+#ifdef _WIN32
+constexpr uint32_t kServerUid = 0;
+#else   // _WIN32
+const uint32_t kServerUid = ::geteuid();
+#endif  // _WIN32
+
+const uint32_t kUser1 = kServerUid + 1;
+const uint32_t kUser2 = kServerUid + 2;
+
+class MultiUserSessionServerTest : public testing::TestWithTempUserProfile {
+ protected:
+  MultiUserSessionServerTest()
+      : profile_root_(testing::MakeTempDirectoryOrDie()) {}
+
+  // Sends `input` as `uid`. Returns false if the server is shut down. The
+  // output is cleared if the server closes the connection without response.
+  bool Send(MultiUserSessionServer &server, const uint32_t uid,
+            const commands::Input &input, commands::Output *output) {
+    std::string response;
+    const bool result = server.ProcessFromPeer(
+        {.uid = uid}, input.SerializeAsString(), &response);
+    output->Clear();
+    if (!response.empty()) {
+      EXPECT_TRUE(output->ParseFromString(response));
+    }
+    return result;
+  }
+
+  static commands::Input MakeInput(const commands::Input::CommandType type) {
+    commands::Input input;
+    input.set_type(type);
+    return input;
+  }
+
+  std::string GetUserProfileDirectory(const uint32_t uid) const {
+    return FileUtil::JoinPath(profile_root_.path(), absl::StrCat(uid));
+  }
+
+  absl::FlagSaver flag_saver_;
+  TempDirectory profile_root_;
+};
+
+TEST_F(MultiUserSessionServerTest, RoutesByUid) {
+  MultiUserSessionServer server(profile_root_.path());
+  ASSERT_TRUE(server.Connected());
+
+  commands::Output output;
+  ASSERT_TRUE(Send(server, kUser1,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_SUCCESS);
+  const uint64_t id = output.id();
+  ASSERT_NE(id, 0);
+
+  // Each user has a profile directory of its own.
+  EXPECT_OK(FileUtil::DirectoryExists(GetUserProfileDirectory(kUser1)));
+  EXPECT_FALSE(FileUtil::DirectoryExists(GetUserProfileDirectory(kUser2)).ok());
+
+  commands::Input send_key = MakeInput(commands::Input::SEND_KEY);
+  send_key.set_id(id);
+  send_key.mutable_key()->set_key_code('a');
+  ASSERT_TRUE(Send(server, kUser1, send_key, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_SUCCESS);
+  EXPECT_EQ(output.id(), id);
+
+  // The session of user 1 is not visible to user 2.
+  ASSERT_TRUE(Send(server, kUser2, send_key, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_FAILURE);
+  EXPECT_OK(FileUtil::DirectoryExists(GetUserProfileDirectory(kUser2)));
+}
+
+TEST_F(MultiUserSessionServerTest, AdminCommandsOnlyFromServerUid) {
+  MultiUserSessionServer server(profile_root_.path());
+  ASSERT_TRUE(server.Connected());
+
+  commands::Output output;
+  ASSERT_TRUE(Send(server, kUser1,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  const uint64_t id = output.id();
+
+  // SHUTDOWN from a user only releases the session handler of the user.
+  ASSERT_TRUE(
+      Send(server, kUser1, MakeInput(commands::Input::SHUTDOWN), &output));
+  commands::Input send_key = MakeInput(commands::Input::SEND_KEY);
+  send_key.set_id(id);
+  send_key.mutable_key()->set_key_code('a');
+  ASSERT_TRUE(Send(server, kUser1, send_key, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_FAILURE);
+
+  // The user running the server cannot have sessions.
+  ASSERT_TRUE(Send(server, kServerUid,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_FAILURE);
+  EXPECT_FALSE(
+      FileUtil::DirectoryExists(GetUserProfileDirectory(kServerUid)).ok());
+
+  EXPECT_TRUE(Send(server, kServerUid, MakeInput(commands::Input::CLEANUP),
+                   &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_SUCCESS);
+  EXPECT_FALSE(Send(server, kServerUid, MakeInput(commands::Input::SHUTDOWN),
+                    &output));
+}
+
+TEST_F(MultiUserSessionServerTest, CleanupDeletesIdleSessionsOfAllUsers) {
+  absl::SetFlag(&FLAGS_last_command_timeout, 60);
+  ScopedClockMock clock(absl::FromUnixSeconds(1000));
+  MultiUserSessionServer server(profile_root_.path());
+  ASSERT_TRUE(server.Connected());
+
+  commands::Output output;
+  commands::Input send_key1 = MakeInput(commands::Input::SEND_KEY);
+  send_key1.mutable_key()->set_key_code('a');
+  commands::Input send_key2 = send_key1;
+  ASSERT_TRUE(Send(server, kUser1,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  send_key1.set_id(output.id());
+  ASSERT_TRUE(Send(server, kUser2,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  send_key2.set_id(output.id());
+  ASSERT_TRUE(Send(server, kUser1, send_key1, &output));
+  ASSERT_TRUE(Send(server, kUser2, send_key2, &output));
+
+  // User 2 keeps typing.
+  clock->Advance(absl::Seconds(40));
+  ASSERT_TRUE(Send(server, kUser2, send_key2, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_SUCCESS);
+
+  // The watch dog sends CLEANUP as the user running the server.
+  clock->Advance(absl::Seconds(40));
+  ASSERT_TRUE(Send(server, kServerUid, MakeInput(commands::Input::CLEANUP),
+                   &output));
+  ASSERT_TRUE(Send(server, kUser1, send_key1, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_FAILURE);
+  ASSERT_TRUE(Send(server, kUser2, send_key2, &output));
+  EXPECT_EQ(output.error_code(), commands::Output::SESSION_SUCCESS);
+}
+
+TEST_F(MultiUserSessionServerTest, MaxUsers) {
+  absl::SetFlag(&FLAGS_max_users, 1);
+  MultiUserSessionServer server(profile_root_.path());
+  ASSERT_TRUE(server.Connected());
+
+  commands::Output output;
+  ASSERT_TRUE(Send(server, kUser1,
+                   MakeInput(commands::Input::CREATE_SESSION), &output));
+  EXPECT_NE(output.id(), 0);
+
+  // The connection is closed without response, but the server keeps running.
+  EXPECT_TRUE(Send(server, kUser2, MakeInput(commands::Input::CREATE_SESSION),
+                   &output));
+  EXPECT_FALSE(output.has_id());
+  EXPECT_FALSE(FileUtil::DirectoryExists(GetUserProfileDirectory(kUser2)).ok());
+
+  // A slot becomes available when user 1 is released.
+  ASSERT_TRUE(
+      Send(server, kUser1, MakeInput(commands::Input::SHUTDOWN), &output));
+  EXPECT_TRUE(Send(server, kUser2, MakeInput(commands::Input::CREATE_SESSION),
+                   &output));
+  EXPECT_NE(output.id(), 0);
+}
+
+}  // namespace
+}  // namespace mozc
@@ -213,7 +213,9 @@ ImeContext::State GetEffectiveStateForTestSendKey(const commands::KeyEvent &key,
 
 // TODO(komatsu): Remove these argument by using/making singletons.
 Session::Session(EngineInterface *engine)
-    : engine_(engine), context_(new ImeContext) {
+    : engine_(engine),
+      converter_(engine->GetSharedConverter()),
+      context_(new ImeContext) {
   InitContext(context_.get());
 }
 
@@ -224,7 +226,7 @@ void Session::InitContext(ImeContext *context) const {
       &composer::Table::GetDefaultTable(), &context->GetRequest(),
       &context->GetConfig()));
   context->set_converter(std::make_unique<SessionConverter>(
-      engine_->GetConverter(), &context->GetRequest(), &context->GetConfig()));
+      converter_.get(), &context->GetRequest(), &context->GetConfig()));
 #ifdef _WIN32
   // On Windows session is started with direct mode.
   // FIXME(toshiyuki): Ditto for Mac after verifying on Mac.
@@ -246,6 +248,19 @@ void Session::InitContext(ImeContext *context) const {
 #endif  // TARGET_OS_IPHONE || __linux__ || __wasm__
 }
 
+void Session::MaybeUpdateConverter() {
+  if (converter_.get() == engine_->GetConverter()) {
+    return;
+  }
+  // The engine was reloaded since the last command. Releases the previous
+  // converter so that the previous stack doesn't learn anymore.
+  converter_ = engine_->GetSharedConverter();
+  context_->mutable_converter()->set_converter(converter_.get());
+  for (std::unique_ptr<ImeContext> &undo_context : undo_contexts_) {
+    undo_context->mutable_converter()->set_converter(converter_.get());
+  }
+}
+
 void Session::PushUndoContext() {
   // Copy the current context and push it to the undo stack.
   auto prev_context = std::make_unique<ImeContext>();
@@ -285,6 +300,7 @@ void Session::EnsureIMEIsOn() {
 
 bool Session::SendCommand(commands::Command *command) {
   UpdateTime();
+  MaybeUpdateConverter();
   UpdatePreferences(command);
   if (!command->input().has_command()) {
     return false;
@@ -323,6 +339,7 @@ bool Session::SendCommand(commands::Command *command) {
         break;
     }
     MaybeSetUndoStatus(command);
+    MaybeOutputSessionSnapshot(command);
     return result;
   }
 
@@ -397,17 +414,25 @@ bool Session::SendCommand(commands::Command *command) {
     case commands::SessionCommand::UPDATE_COMPOSITION:
       result = UpdateComposition(command);
       break;
+    case commands::SessionCommand::GET_CANDIDATE_WORDS:
+      result = GetCandidateWords(command);
+      break;
+    case commands::SessionCommand::RESTORE_SESSION_SNAPSHOT:
+      result = RestoreSessionSnapshot(command);
+      break;
     default:
       LOG(WARNING) << "Unknown command" << *command;
       result = DoNothing(command);
       break;
   }
   MaybeSetUndoStatus(command);
+  MaybeOutputSessionSnapshot(command);
   return result;
 }
 
 bool Session::TestSendKey(commands::Command *command) {
   UpdateTime();
+  MaybeUpdateConverter();
   UpdatePreferences(command);
   TransformInput(command->mutable_input());
 
@@ -504,6 +529,7 @@ bool Session::TestSendKey(commands::Command *command) {
 
 bool Session::SendKey(commands::Command *command) {
   UpdateTime();
+  MaybeUpdateConverter();
   UpdatePreferences(command);
   TransformInput(command->mutable_input());
   // To support indirect IME on/off by using KeyEvent::activated, use effective
@@ -538,6 +564,7 @@ bool Session::SendKey(commands::Command *command) {
   SessionUsageStatsUtil::AddSendKeyOutputStats(command->output());
 
   MaybeSetUndoStatus(command);
+  MaybeOutputSessionSnapshot(command);
   return result;
 }
 
@@ -1008,7 +1035,7 @@ void Session::UpdatePreferences(commands::Command *command) {
   DCHECK(command);
   const config::Config &config = command->input().config();
   if (command->input().has_capability()) {
-    *context_->mutable_client_capability() = command->input().capability();
+    set_client_capability(command->input().capability());
   }
 
   // Update config values modified temporarily.
@@ -1206,6 +1233,88 @@ bool Session::GetStatus(commands::Command *command) {
   return true;
 }
 
+bool Session::GetCandidateWords(commands::Command *command) {
+  // The session state is not changed, so the client doesn't need to update
+  // anything but the candidate words it requested.
+  command->mutable_output()->set_consumed(false);
+  const commands::SessionCommand::CandidateWordsRange &range =
+      command->input().command().candidate_words_range();
+  if (!context_->converter().FillCandidateWordsInRange(
+          range.candidate_list_id(), range.offset(), range.size(),
+          command->mutable_output()->mutable_all_candidate_words())) {
+    command->mutable_output()->clear_all_candidate_words();
+    return false;
+  }
+  return true;
+}
+
+bool Session::RestoreSessionSnapshot(commands::Command *command) {
+  const commands::SessionSnapshot &snapshot =
+      command->input().command().session_snapshot();
+  if (!context_->mutable_composer()->RestoreSnapshot(snapshot.composition())) {
+    command->mutable_output()->set_consumed(false);
+    return false;
+  }
+  context_->mutable_converter()->Reset();
+  ClearUndoContext();
+
+  switch (snapshot.state()) {
+    case commands::SessionSnapshot::DIRECT:
+      context_->set_state(ImeContext::DIRECT);
+      break;
+    case commands::SessionSnapshot::COMPOSITION:
+      context_->set_state(context_->composer().Empty()
+                              ? ImeContext::PRECOMPOSITION
+                              : ImeContext::COMPOSITION);
+      break;
+    default:
+      context_->set_state(ImeContext::PRECOMPOSITION);
+      break;
+  }
+  if (context_->state() != ImeContext::COMPOSITION) {
+    context_->mutable_composer()->EditErase();
+  }
+
+  command->mutable_output()->set_consumed(true);
+  Output(command);
+  return true;
+}
+
+void Session::SaveSessionSnapshot(commands::SessionSnapshot *snapshot) const {
+  switch (context_->state()) {
+    case ImeContext::DIRECT:
+      snapshot->set_state(commands::SessionSnapshot::DIRECT);
+      break;
+    case ImeContext::COMPOSITION:
+    case ImeContext::CONVERSION:
+      // The conversion is redone by the user after the restore.
+      snapshot->set_state(commands::SessionSnapshot::COMPOSITION);
+      break;
+    default:
+      snapshot->set_state(commands::SessionSnapshot::PRECOMPOSITION);
+      break;
+  }
+  context_->composer().SaveSnapshot(snapshot->mutable_composition());
+}
+
+void Session::MaybeOutputSessionSnapshot(commands::Command *command) {
+  // Most keys, e.g. cursor moves in the conversion, don't touch the state or
+  // the composer, so the snapshot is not even built for them.
+  if (!context_->client_capability().session_snapshot() ||
+      !command->output().consumed() || !context_->snapshot_dirty()) {
+    return;
+  }
+  context_->clear_snapshot_dirty();
+  commands::SessionSnapshot snapshot;
+  SaveSessionSnapshot(&snapshot);
+  std::string serialized = snapshot.SerializeAsString();
+  if (serialized == last_session_snapshot_) {
+    return;
+  }
+  last_session_snapshot_ = std::move(serialized);
+  *command->mutable_output()->mutable_session_snapshot() = std::move(snapshot);
+}
+
 bool Session::RequestConvertReverse(commands::Command *command) {
   if (context_->state() != ImeContext::PRECOMPOSITION &&
       context_->state() != ImeContext::DIRECT) {
@@ -1463,6 +1572,8 @@ bool Session::MaybeSelectCandidate(commands::Command *command) {
 
 void Session::set_client_capability(const commands::Capability &capability) {
   *context_->mutable_client_capability() = capability;
+  context_->mutable_converter()->set_paged_candidate_words(
+      capability.paged_candidate_words());
 }
 
 void Session::set_application_info(
@@ -1478,6 +1589,10 @@ absl::Time Session::create_session_time() const {
   return context_->create_time();
 }
 
+void Session::ResetCreateSessionTime() {
+  context_->set_create_time(Clock::GetAbslTime());
+}
+
 absl::Time Session::last_command_time() const {
   return context_->last_command_time();
 }
@@ -2901,6 +3016,30 @@ void Session::TransformInput(commands::Input *input) {
   if (input->has_key()) {
     context_->key_event_transformer().TransformKeyEvent(input->mutable_key());
   }
+  if (input->has_context()) {
+    ExpandSurroundingText(input->mutable_context());
+  }
+}
+
+void Session::ExpandSurroundingText(commands::Context *context) {
+  if (context->surrounding_text_unchanged()) {
+    context->clear_surrounding_text_unchanged();
+    if (last_surrounding_text_.has_preceding_text()) {
+      context->set_preceding_text(last_surrounding_text_.preceding_text());
+    }
+    if (last_surrounding_text_.has_following_text()) {
+      context->set_following_text(last_surrounding_text_.following_text());
+    }
+    return;
+  }
+
+  last_surrounding_text_.Clear();
+  if (context->has_preceding_text()) {
+    last_surrounding_text_.set_preceding_text(context->preceding_text());
+  }
+  if (context->has_following_text()) {
+    last_surrounding_text_.set_following_text(context->following_text());
+  }
 }
 
 bool Session::SwitchInputFieldType(commands::Command *command) {
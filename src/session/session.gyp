@@ -97,6 +97,7 @@
       'target_name': 'session_handler',
       'type': 'static_library',
       'sources': [
+        'maintenance_scheduler.cc',
         'session_handler.cc',
         'session_observer_handler.cc',
       ],
@@ -177,6 +178,23 @@
         'session_usage_observer',
       ],
     },
+    {
+      'target_name': 'multi_user_session_server',
+      'type': 'static_library',
+      'sources': [
+        'multi_user_session_server.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/absl.gyp:absl_strings',
+        '<(mozc_oss_src_dir)/base/base.gyp:base',
+        '<(mozc_oss_src_dir)/engine/engine.gyp:engine_factory',
+        '<(mozc_oss_src_dir)/ipc/ipc.gyp:ipc',
+        '<(mozc_oss_src_dir)/protocol/protocol.gyp:commands_proto',
+        'session_handler',
+        'session_usage_observer',
+        'session_watch_dog',
+      ],
+    },
     {
       'target_name': 'random_keyevents_generator',
       'type': 'static_library',
@@ -40,6 +40,7 @@
 #include "absl/time/time.h"
 #include "composer/composer.h"
 #include "composer/table.h"
+#include "converter/converter_interface.h"
 #include "engine/engine_interface.h"
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
@@ -54,6 +55,12 @@ namespace session {
 
 class Session : public SessionInterface {
  public:
+  // Maximum lengths of the surrounding text, in Unicode characters, that the
+  // session consumes. They are advertised to clients on CREATE_SESSION so
+  // that frontends do not send the whole document on every key event.
+  static constexpr size_t kMaxPrecedingTextLength = 64;
+  static constexpr size_t kMaxFollowingTextLength = 32;
+
   explicit Session(EngineInterface *engine);
   Session(const Session &) = delete;
   Session &operator=(const Session &) = delete;
@@ -107,6 +114,20 @@ class Session : public SessionInterface {
   // Returns the current status such as a composition string, input mode, etc.
   bool GetStatus(mozc::commands::Command *command);
 
+  // Fills Output::all_candidate_words with the range of the candidate words
+  // specified by SessionCommand::candidate_words_range.  Returns false if the
+  // candidate list has been changed since the range was requested.
+  bool GetCandidateWords(mozc::commands::Command *command);
+
+  // Restores the IME state and the composition from
+  // SessionCommand::session_snapshot.  The conversion, the undo context and
+  // the other states are not restored.  Returns false and leaves the session
+  // unchanged if the snapshot is invalid.
+  bool RestoreSessionSnapshot(mozc::commands::Command *command);
+
+  // Saves the state of the session to |snapshot|.
+  void SaveSessionSnapshot(mozc::commands::SessionSnapshot *snapshot) const;
+
   // Fills Output::Callback with the CONVERT_REVERSE SessionCommand to
   // ask the client to send back the SessionCommand to the server.
   // This function is called when the key event representing the
@@ -257,6 +278,9 @@ class Session : public SessionInterface {
 
   // Return the time when this instance was created.
   absl::Time create_session_time() const override;
+  // Restarts create_session_time() from now. Used when a session constructed
+  // in advance is handed out to a client.
+  void ResetCreateSessionTime();
 
   // return 0 (default value) if no command is executed in this session.
   absl::Time last_command_time() const override;
@@ -279,12 +303,28 @@ class Session : public SessionInterface {
   //      history, user dictionary, etc.
   mozc::EngineInterface *engine_;
 
+  // Converter used by the contexts. It's shared with the engine, so it stays
+  // valid after the engine is reloaded until MaybeUpdateConverter() moves the
+  // contexts to the new one.
+  std::shared_ptr<ConverterInterface> converter_;
+
   std::unique_ptr<ImeContext> context_;
 
   // Undo stack. *begin is the oldest, and *back is the newest.
   std::deque<std::unique_ptr<ImeContext>> undo_contexts_;
 
+  // Surrounding text (preceding_text and following_text only) received with
+  // the last input, used to expand Context::surrounding_text_unchanged.
+  commands::Context last_surrounding_text_;
+
+  // Serialized snapshot returned last by MaybeOutputSessionSnapshot(). The
+  // client keeps it, so it's not returned again until the session changes.
+  std::string last_session_snapshot_;
+
   void InitContext(ImeContext *context) const;
+  // Moves the contexts to the current converter of the engine if it was
+  // reloaded.
+  void MaybeUpdateConverter();
 
   void PushUndoContext();
   void PopUndoContext();
@@ -300,6 +340,11 @@ class Session : public SessionInterface {
   // we don't want to create a new Status instance if not required.
   void MaybeSetUndoStatus(commands::Command *command) const;
 
+  // Fills Output::session_snapshot if the client requested it by
+  // Capability::session_snapshot, the output is consumed, and the snapshot
+  // differs from the one returned last.
+  void MaybeOutputSessionSnapshot(commands::Command *command);
+
   // Return true if full width space is preferred in the given new input
   // state than half width space. When |input| does not have new input mode,
   // the current mode will be considered.
@@ -380,6 +425,10 @@ class Session : public SessionInterface {
   // Modify input of SendKey, TestSendKey, and SendCommand.
   void TransformInput(mozc::commands::Input *input);
 
+  // Restores the surrounding text omitted by
+  // Context::surrounding_text_unchanged, or remembers it for later inputs.
+  void ExpandSurroundingText(mozc::commands::Context *context);
+
   // ensure session status is not DIRECT.
   // if session status is DIRECT, set the status to PRECOMPOSITION.
   void EnsureIMEIsOn();
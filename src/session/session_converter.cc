@@ -32,6 +32,7 @@
 #include "session/session_converter.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -69,6 +70,14 @@ namespace mozc {
 namespace session {
 namespace {
 
+// Returns a new id of the candidate list.  The ids are unique in the process
+// so that they never collide even when a cloned converter is restored by
+// undo.
+uint64_t NewCandidateListId() {
+  static std::atomic<uint64_t> next_id = 1;
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
 using ::mozc::commands::Request;
 using ::mozc::config::Config;
 using ::mozc::usage_stats::UsageStats;
@@ -147,11 +156,13 @@ SessionConverter::SessionConverter(const ConverterInterface *converter,
       segment_index_(0),
       result_(),
       candidate_list_(true),
+      candidate_list_id_(0),
       request_(request),
       state_(COMPOSITION),
       request_type_(ConversionRequest::CONVERSION),
       client_revision_(0),
-      candidate_list_visible_(false) {
+      candidate_list_visible_(false),
+      paged_candidate_words_(false) {
   conversion_preferences_.use_history = true;
   conversion_preferences_.max_history_size = kDefaultMaxHistorySize;
   conversion_preferences_.request_suggestion = true;
@@ -1194,6 +1205,7 @@ SessionConverter *SessionConverter::Clone() const {
   session_converter->request_ = request_;
   session_converter->config_ = config_;
   session_converter->use_cascading_window_ = use_cascading_window_;
+  session_converter->paged_candidate_words_ = paged_candidate_words_;
   session_converter->selected_candidate_indices_ = selected_candidate_indices_;
   session_converter->request_type_ = request_type_;
 
@@ -1201,6 +1213,7 @@ SessionConverter *SessionConverter::Clone() const {
     // UpdateCandidateList() is not simple setter and it uses some members.
     session_converter->UpdateCandidateList();
     session_converter->candidate_list_.MoveToId(candidate_list_.focused_id());
+    session_converter->candidate_list_id_ = candidate_list_id_;
     session_converter->SetCandidateListVisible(candidate_list_visible_);
   }
 
@@ -1483,6 +1496,7 @@ void SessionConverter::AppendCandidateList() {
 void SessionConverter::UpdateCandidateList() {
   DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
   candidate_list_.Clear();
+  candidate_list_id_ = NewCandidateListId();
   AppendCandidateList();
 }
 
@@ -1609,32 +1623,29 @@ void SessionConverter::FillCandidates(commands::Candidates *candidates) const {
   SessionOutput::FillFooter(candidates->category(), candidates);
 }
 
-void SessionConverter::FillAllCandidateWords(
-    commands::CandidateList *candidates) const {
-  DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
-  commands::Category category;
+commands::Category SessionConverter::GetAllCandidateWordsCategory() const {
   switch (request_type_) {
     case ConversionRequest::CONVERSION:
-      category = commands::CONVERSION;
-      break;
+      return commands::CONVERSION;
     case ConversionRequest::PREDICTION:
-      category = commands::PREDICTION;
-      break;
+      return commands::PREDICTION;
     case ConversionRequest::SUGGESTION:
-      category = commands::SUGGESTION;
-      break;
+      return commands::SUGGESTION;
     case ConversionRequest::PARTIAL_PREDICTION:
       // Not PREDICTION because we do not want to get focused candidate.
-      category = commands::SUGGESTION;
-      break;
+      return commands::SUGGESTION;
     case ConversionRequest::PARTIAL_SUGGESTION:
-      category = commands::SUGGESTION;
-      break;
+      return commands::SUGGESTION;
     default:
       LOG(WARNING) << "Unknown request type: " << request_type_;
-      category = commands::CONVERSION;
-      break;
+      return commands::CONVERSION;
   }
+}
+
+void SessionConverter::FillAllCandidateWords(
+    commands::CandidateList *candidates) const {
+  DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
+  const commands::Category category = GetAllCandidateWordsCategory();
 
   if (segment_index_ >= segments_.conversion_segments_size()) {
     LOG(WARNING) << "Invalid segment_index_: " << segment_index_
@@ -1642,10 +1653,33 @@ void SessionConverter::FillAllCandidateWords(
     return;
   }
   const Segment &segment = segments_.conversion_segment(segment_index_);
+  if (paged_candidate_words_) {
+    SessionOutput::FillCandidateWordsPage(segment, candidate_list_, category,
+                                          candidate_list_.page_size(),
+                                          candidates);
+    candidates->set_id(candidate_list_id_);
+    return;
+  }
   SessionOutput::FillAllCandidateWords(segment, candidate_list_, category,
                                        candidates);
 }
 
+bool SessionConverter::FillCandidateWordsInRange(
+    const uint64_t candidate_list_id, const size_t offset, const size_t size,
+    commands::CandidateList *candidates) const {
+  if (!CheckState(SUGGESTION | PREDICTION | CONVERSION) ||
+      candidate_list_id != candidate_list_id_ ||
+      segment_index_ >= segments_.conversion_segments_size()) {
+    return false;
+  }
+  const Segment &segment = segments_.conversion_segment(segment_index_);
+  SessionOutput::FillCandidateWordsInRange(segment, candidate_list_,
+                                           GetAllCandidateWordsCategory(),
+                                           offset, size, candidates);
+  candidates->set_id(candidate_list_id_);
+  return true;
+}
+
 void SessionConverter::FillIncognitoCandidateWords(
     commands::CandidateList *candidates) const {
   const Segment &segment =
@@ -250,6 +250,10 @@ class SessionConverter : public SessionConverterInterface {
   // Currently, converter_ is not copied.
   SessionConverter *Clone() const override;
 
+  void set_converter(const ConverterInterface *converter) override {
+    converter_ = converter;
+  }
+
   void set_selection_shortcut(
       config::Config::SelectionShortcut selection_shortcut) override {
     selection_shortcut_ = selection_shortcut;
@@ -259,6 +263,14 @@ class SessionConverter : public SessionConverterInterface {
     use_cascading_window_ = use_cascading_window;
   }
 
+  void set_paged_candidate_words(bool paged_candidate_words) override {
+    paged_candidate_words_ = paged_candidate_words;
+  }
+
+  bool FillCandidateWordsInRange(
+      uint64_t candidate_list_id, size_t offset, size_t size,
+      commands::CandidateList *candidates) const override;
+
   // Meaning that all the composition characters are consumed.
   // c.f. CommitSuggestionInternal
   static constexpr size_t kConsumedAllCharacters =
@@ -343,6 +355,7 @@ class SessionConverter : public SessionConverterInterface {
 
   // Fills protocol buffers with all flatten candidate words.
   void FillAllCandidateWords(commands::CandidateList *candidates) const;
+  commands::Category GetAllCandidateWordsCategory() const;
   void FillIncognitoCandidateWords(commands::CandidateList *candidates) const;
 
   bool IsEmptySegment(const Segment &segment) const;
@@ -382,6 +395,9 @@ class SessionConverter : public SessionConverterInterface {
 
   // Component of the candidate list converted from segments_to result_.
   CandidateList candidate_list_;
+  // Identifier of the content of |candidate_list_|, renewed whenever the list
+  // is rebuilt.
+  uint64_t candidate_list_id_;
 
   const commands::Request *request_;
   const config::Config *config_;
@@ -414,6 +430,9 @@ class SessionConverter : public SessionConverterInterface {
   // Mutable values of |config_|.  These values may be changed temporaliry per
   // session.
   bool use_cascading_window_;
+
+  // Mirrors Capability::paged_candidate_words of the client.
+  bool paged_candidate_words_;
 };
 
 }  // namespace session
@@ -33,6 +33,7 @@
 #define MOZC_SESSION_SESSION_CONVERTER_INTERFACE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -236,10 +237,25 @@ class SessionConverterInterface {
   // Callee object doesn't have the ownership of the cloned instance.
   virtual SessionConverterInterface *Clone() const = 0;
 
+  // Replaces the converter used by the following operations, e.g. after the
+  // engine is reloaded. The current segments are kept.
+  virtual void set_converter(const ConverterInterface *converter) = 0;
+
   virtual void set_selection_shortcut(
       config::Config::SelectionShortcut selection_shortcut) = 0;
 
   virtual void set_use_cascading_window(bool use_cascading_window) = 0;
+
+  // If true, FillOutput fills only the page of the focused candidate into
+  // Output::all_candidate_words.
+  virtual void set_paged_candidate_words(bool paged_candidate_words) = 0;
+
+  // Fills |size| candidate words from |offset| of the candidate list
+  // identified by |candidate_list_id|.  Returns false if the id does not
+  // match the current candidate list.
+  virtual bool FillCandidateWordsInRange(
+      uint64_t candidate_list_id, size_t offset, size_t size,
+      commands::CandidateList *candidates) const = 0;
 };
 
 }  // namespace session
@@ -43,11 +43,15 @@
 #include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/random/random.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/clock.h"
+#include "base/container/arena.h"
+#include "base/hash.h"
 #include "base/stopwatch.h"
 #include "base/version.h"
 #include "base/vlog.h"
+#include "composer/key_event_util.h"
 #include "composer/table.h"
 #include "config/character_form_manager.h"
 #include "config/config_handler.h"
@@ -60,6 +64,7 @@
 #include "protocol/engine_builder.pb.h"
 #include "protocol/user_dictionary_storage.pb.h"
 #include "session/common.h"
+#include "session/internal/ime_context.h"
 #include "session/internal/keymap.h"
 #include "session/session.h"
 #include "session/session_observer_handler.h"
@@ -109,6 +114,14 @@ namespace {
 
 using mozc::usage_stats::UsageStats;
 
+// The number of sessions constructed in advance for CreateSession.
+constexpr size_t kMaxSpareSessions = 2;
+
+// The maintenance on Cleanup waits until no key event has been sent for
+// kMaintenanceIdleThreshold, but not longer than kMaintenanceMaxDeferral.
+constexpr absl::Duration kMaintenanceIdleThreshold = absl::Seconds(5);
+constexpr absl::Duration kMaintenanceMaxDeferral = absl::Minutes(10);
+
 bool IsApplicationAlive(const session::Session *session) {
 #ifndef MOZC_DISABLE_SESSION_WATCHDOG
   const commands::ApplicationInfo &info = session->application_info();
@@ -134,7 +147,18 @@ bool IsApplicationAlive(const session::Session *session) {
 }  // namespace
 
 SessionHandler::SessionHandler(std::unique_ptr<EngineInterface> engine)
-    : engine_(std::move(engine)) {
+    : SessionHandler(std::move(engine), nullptr, "", nullptr) {}
+
+SessionHandler::SessionHandler(
+    std::unique_ptr<EngineInterface> engine,
+    std::unique_ptr<config::ConfigStore> config_store,
+    const absl::string_view user_dictionary_path,
+    std::unique_ptr<config::CharacterFormManager> character_form_manager)
+    : maintenance_scheduler_(kMaintenanceIdleThreshold,
+                             kMaintenanceMaxDeferral),
+      engine_(std::move(engine)),
+      config_store_(std::move(config_store)),
+      character_form_manager_(std::move(character_form_manager)) {
   is_available_ = false;
   max_session_size_ = 0;
   last_session_empty_time_ = Clock::GetAbslTime();
@@ -143,10 +167,14 @@ SessionHandler::SessionHandler(std::unique_ptr<EngineInterface> engine)
   observer_handler_ = std::make_unique<session::SessionObserverHandler>();
   user_dictionary_session_handler_ =
       std::make_unique<user_dictionary::UserDictionarySessionHandler>();
+  if (!user_dictionary_path.empty()) {
+    user_dictionary_session_handler_->set_dictionary_path(user_dictionary_path);
+  }
   table_manager_ = std::make_unique<composer::TableManager>();
   request_ = std::make_unique<commands::Request>();
-  config_ = config::ConfigHandler::GetConfig();
+  config_ = GetStoredConfig();
   key_map_manager_ = std::make_unique<keymap::KeyMapManager>(*config_);
+  UpdateKeyFilter();
 
   if (absl::GetFlag(FLAGS_restricted)) {
     MOZC_VLOG(1) << "Server starts with restricted mode";
@@ -171,6 +199,14 @@ SessionHandler::SessionHandler(std::unique_ptr<EngineInterface> engine)
     return;
   }
 
+  // Sync all data. This is a regression bug fix http://b/3033708
+  maintenance_scheduler_.AddTask("Sync", absl::ZeroDuration(),
+                                 [this] { engine_->Sync(); });
+  maintenance_scheduler_.AddTask("SpareSessions", absl::ZeroDuration(),
+                                 [this] { ReplenishSpareSessions(); });
+  // The user dictionaries need no compaction task: the dictionary tool saves
+  // the whole storage on each edit, and the server rebuilds the dictionary
+  // from it on reload.
 
   // everything is OK
   is_available_ = true;
@@ -187,16 +223,27 @@ void SessionHandler::StartWatchDog() {
 #endif  // MOZC_DISABLE_SESSION_WATCHDOG
 }
 
+std::shared_ptr<const config::Config> SessionHandler::GetStoredConfig() const {
+  return config_store_ ? config_store_->GetSharedConfig()
+                       : config::ConfigHandler::GetSharedConfig();
+}
+
 void SessionHandler::UpdateSessions(const config::Config &config,
                                     const commands::Request &request) {
+  UpdateSessions(std::make_shared<const config::Config>(config), request);
+}
+
+void SessionHandler::UpdateSessions(
+    std::shared_ptr<const config::Config> config,
+    const commands::Request &request) {
   // Since sessions internally use config_, request_ and key_map_manager_,
   // they are moved to prev_ variables to avoid releasing until sessions switch
   // those values.
-  std::unique_ptr<const config::Config> prev_config = std::move(config_);
+  std::shared_ptr<const config::Config> prev_config = std::move(config_);
   std::unique_ptr<const commands::Request> prev_request = std::move(request_);
   std::unique_ptr<keymap::KeyMapManager> prev_key_map_manager;
 
-  config_ = std::make_unique<config::Config>(config);
+  config_ = std::move(config);
   request_ = std::make_unique<commands::Request>(request);
   const composer::Table *table = nullptr;
   table = table_manager_->GetTable(*request_, *config_);
@@ -205,6 +252,7 @@ void SessionHandler::UpdateSessions(const config::Config &config,
                                                             *config_)) {
     prev_key_map_manager = std::move(key_map_manager_);
     key_map_manager_ = std::make_unique<keymap::KeyMapManager>(*config_);
+    UpdateKeyFilter();
   }
 
   for (SessionElement &element : *session_map_) {
@@ -212,15 +260,17 @@ void SessionHandler::UpdateSessions(const config::Config &config,
     if (!session) {
       continue;
     }
-    session->SetConfig(config_.get());
-    session->SetKeyMapManager(key_map_manager_.get());
-    session->SetRequest(request_.get());
-    if (table != nullptr) {
-      session->SetTable(table);
-    }
+    InitSession(session.get(), table);
+  }
+  for (std::unique_ptr<session::Session> &session : spare_sessions_) {
+    InitSession(session.get(), table);
+  }
+  if (character_form_manager_) {
+    character_form_manager_->ReloadConfig(*config_);
+  } else {
+    config::CharacterFormManager::GetCharacterFormManager()->ReloadConfig(
+        *config_);
   }
-  config::CharacterFormManager::GetCharacterFormManager()->ReloadConfig(
-      *config_);
 }
 
 bool SessionHandler::SyncData(commands::Command *command) {
@@ -240,14 +290,14 @@ bool SessionHandler::Shutdown(commands::Command *command) {
 
 bool SessionHandler::Reload(commands::Command *command) {
   MOZC_VLOG(1) << "Reloading server";
-  UpdateSessions(*config::ConfigHandler::GetConfig(), *request_);
+  UpdateSessions(GetStoredConfig(), *request_);
   engine_->Reload();
   return true;
 }
 
 bool SessionHandler::ReloadAndWait(commands::Command *command) {
   MOZC_VLOG(1) << "Reloading server and wait for reloader";
-  UpdateSessions(*config::ConfigHandler::GetConfig(), *request_);
+  UpdateSessions(GetStoredConfig(), *request_);
   engine_->ReloadAndWait();
   return true;
 }
@@ -275,10 +325,11 @@ bool SessionHandler::ClearUnusedUserPrediction(commands::Command *command) {
 
 bool SessionHandler::GetConfig(commands::Command *command) {
   MOZC_VLOG(1) << "Getting config";
-  config::ConfigHandler::GetConfig(command->mutable_output()->mutable_config());
+  std::shared_ptr<const config::Config> config = GetStoredConfig();
+  *command->mutable_output()->mutable_config() = *config;
   // Ensure the on-memory config is same as the locally stored one
   // because the local data could be changed by sync.
-  UpdateSessions(command->output().config(), *request_);
+  UpdateSessions(std::move(config), *request_);
   return true;
 }
 
@@ -302,7 +353,7 @@ bool SessionHandler::SetRequest(commands::Command *command) {
     LOG(WARNING) << "request is empty";
     return false;
   }
-  UpdateSessions(*config_, command->input().request());
+  UpdateSessions(config_, command->input().request());
   return true;
 }
 
@@ -316,6 +367,11 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
   Stopwatch stopwatch;
   stopwatch.Start();
 
+  // Temporary objects allocated during this command are released at once.
+  const RequestArenaScope arena_scope;
+  const config::ScopedCharacterFormManager character_form_scope(
+      character_form_manager_.get());
+
   switch (command->input().type()) {
     case commands::Input::CREATE_SESSION:
       eval_succeeded = CreateSession(command);
@@ -324,12 +380,15 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
       eval_succeeded = DeleteSession(command);
       break;
     case commands::Input::SEND_KEY:
+      maintenance_scheduler_.NotifyActivity(Clock::GetAbslTime());
       eval_succeeded = SendKey(command);
       break;
     case commands::Input::TEST_SEND_KEY:
+      maintenance_scheduler_.NotifyActivity(Clock::GetAbslTime());
       eval_succeeded = TestSendKey(command);
       break;
     case commands::Input::SEND_COMMAND:
+      maintenance_scheduler_.NotifyActivity(Clock::GetAbslTime());
       eval_succeeded = SendCommand(command);
       break;
     case commands::Input::SYNC_DATA:
@@ -418,6 +477,43 @@ std::unique_ptr<session::Session> SessionHandler::NewSession() {
   return std::make_unique<session::Session>(engine_.get());
 }
 
+void SessionHandler::InitSession(session::Session *session,
+                                 const composer::Table *table) const {
+  session->SetConfig(config_.get());
+  session->SetKeyMapManager(key_map_manager_.get());
+  session->SetRequest(request_.get());
+  if (table != nullptr) {
+    session->SetTable(table);
+  }
+}
+
+std::unique_ptr<session::Session> SessionHandler::AcquireSession() {
+  if (spare_sessions_.empty()) {
+    return NewSession();
+  }
+  std::unique_ptr<session::Session> session = std::move(spare_sessions_.back());
+  spare_sessions_.pop_back();
+  // Otherwise Cleanup() would take it for a session left unused since then.
+  session->ResetCreateSessionTime();
+  return session;
+}
+
+void SessionHandler::ReplenishSpareSessions() {
+  if (spare_sessions_.size() >= kMaxSpareSessions) {
+    return;
+  }
+  const composer::Table *table = table_manager_->GetTable(*request_, *config_);
+  while (spare_sessions_.size() < kMaxSpareSessions) {
+    std::unique_ptr<session::Session> session = NewSession();
+    if (!session) {
+      LOG(ERROR) << "Cannot allocate new Session";
+      return;
+    }
+    InitSession(session.get(), table);
+    spare_sessions_.push_back(std::move(session));
+  }
+}
+
 void SessionHandler::AddObserver(session::SessionObserverInterface *observer) {
   observer_handler_->AddObserver(observer);
 }
@@ -427,7 +523,11 @@ void SessionHandler::MaybeUpdateConfig(commands::Command *command) {
     return;
   }
 
-  config::ConfigHandler::SetConfig(command->output().config());
+  if (config_store_) {
+    config_store_->SetConfig(command->output().config());
+  } else {
+    config::ConfigHandler::SetConfig(command->output().config());
+  }
   Reload(command);
 }
 
@@ -440,6 +540,7 @@ bool SessionHandler::SendKey(commands::Command *command) {
   }
   (*session)->SendKey(command);
   MaybeUpdateConfig(command);
+  MaybeFillKeyFilter(command);
   return true;
 }
 
@@ -451,6 +552,7 @@ bool SessionHandler::TestSendKey(commands::Command *command) {
     return false;
   }
   (*session)->TestSendKey(command);
+  MaybeFillKeyFilter(command);
   return true;
 }
 
@@ -463,14 +565,41 @@ bool SessionHandler::SendCommand(commands::Command *command) {
   }
   (*session)->SendCommand(command);
   MaybeUpdateConfig(command);
+  MaybeFillKeyFilter(command);
   return true;
 }
 
-void SessionHandler::MaybeReloadEngine(commands::Command *command) {
-  if (session_map_->Size() > 0) {
-    // Some sessions still use the current engine_.
+void SessionHandler::UpdateKeyFilter() {
+  const std::vector<KeyInformation> keys =
+      key_map_manager_->GetSortedKeysPrecomposition();
+  key_filter_.Clear();
+  key_filter_.mutable_precomposition_keys()->Add(keys.begin(), keys.end());
+  // The version is derived from the contents so that it stays valid across
+  // server restarts.  Zero is reserved for clients without a filter.
+  const absl::string_view data(reinterpret_cast<const char *>(keys.data()),
+                               keys.size() * sizeof(KeyInformation));
+  key_filter_.set_version(std::max<uint64_t>(Fingerprint(data), 1));
+}
+
+void SessionHandler::MaybeFillKeyFilter(commands::Command *command) const {
+  if (!command->input().has_key_filter_version() ||
+      command->input().key_filter_version() == key_filter_.version()) {
     return;
   }
+  *command->mutable_output()->mutable_key_filter() = key_filter_;
+}
+
+void SessionHandler::MaybeReloadEngine(commands::Command *command) {
+  // Sessions move to the new converter on their next command. A composition
+  // in flight was made on the previous data, so waits until it's finished.
+  constexpr int kComposing =
+      session::ImeContext::COMPOSITION | session::ImeContext::CONVERSION;
+  for (const SessionElement &element : *session_map_) {
+    if (element.value != nullptr &&
+        (element.value->context().state() & kComposing)) {
+      return;
+    }
+  }
 
   EngineReloadResponse engine_reload_response;
   if (!engine_->MaybeReloadEngine(&engine_reload_response)) {
@@ -479,6 +608,8 @@ void SessionHandler::MaybeReloadEngine(commands::Command *command) {
   }
 
   LOG(INFO) << "Engine reloaded";
+  // Spare sessions would keep the previous converter alive until handed out.
+  spare_sessions_.clear();
   *command->mutable_output()->mutable_engine_reload_response() =
       engine_reload_response;
   table_manager_->ClearCaches();
@@ -529,7 +660,7 @@ bool SessionHandler::CreateSession(commands::Command *command) {
   // CreateSession is called on a relatively safer timing to reload engine_.
   MaybeReloadEngine(command);
 
-  std::unique_ptr<session::Session> session = NewSession();
+  std::unique_ptr<session::Session> session = AcquireSession();
   if (!session) {
     LOG(ERROR) << "Cannot allocate new Session";
     return false;
@@ -548,11 +679,23 @@ bool SessionHandler::CreateSession(commands::Command *command) {
   element->value = std::move(session);
   command->mutable_output()->set_id(new_id);
 
-  // The created session has not been fully initialized yet.
-  // SetConfig() will complete the initialization by setting information
-  // (e.g., config, request, keymap, ...) to all the sessions,
-  // including the newly created one.
-  UpdateSessions(*config::ConfigHandler::GetConfig(), *request_);
+  commands::Output::SurroundingTextLimit *limit =
+      command->mutable_output()->mutable_surrounding_text_limit();
+  limit->set_max_preceding_length(session::Session::kMaxPrecedingTextLength);
+  limit->set_max_following_length(session::Session::kMaxFollowingTextLength);
+
+  // The created session may not have been fully initialized yet.
+  // When the stored config has been changed, UpdateSessions() completes the
+  // initialization by setting information (e.g., config, request, keymap, ...)
+  // to all the sessions, including the newly created one. Otherwise only the
+  // new session needs them.
+  std::shared_ptr<const config::Config> stored_config = GetStoredConfig();
+  if (stored_config == config_) {
+    InitSession(element->value.get(),
+                table_manager_->GetTable(*request_, *config_));
+  } else {
+    UpdateSessions(std::move(stored_config), *request_);
+  }
 
   // session is not empty.
   last_session_empty_time_ = absl::InfinitePast();
@@ -631,8 +774,7 @@ bool SessionHandler::Cleanup(commands::Command *command) {
     MOZC_VLOG(1) << "Session ID " << remove_ids[i] << " is removed by server";
   }
 
-  // Sync all data. This is a regression bug fix http://b/3033708
-  engine_->Sync();
+  maintenance_scheduler_.MaybeRun(current_time);
 
   // timeout is enabled.
   if (absl::GetFlag(FLAGS_timeout) > 0 &&
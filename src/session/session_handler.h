@@ -35,11 +35,14 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include "absl/random/random.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "composer/table.h"
+#include "config/character_form_manager.h"
+#include "config/config_handler.h"
 #include "dictionary/user_dictionary_session_handler.h"
 #include "engine/engine_interface.h"
 #include "engine/supplemental_model_interface.h"
@@ -47,6 +50,7 @@
 #include "protocol/config.pb.h"
 #include "session/common.h"
 #include "session/internal/keymap.h"
+#include "session/maintenance_scheduler.h"
 #include "session/session.h"
 #include "session/session_handler_interface.h"
 #include "session/session_observer_handler.h"
@@ -63,6 +67,16 @@ namespace mozc {
 class SessionHandler : public SessionHandlerInterface {
  public:
   explicit SessionHandler(std::unique_ptr<EngineInterface> engine);
+  // Uses the config in `config_store`, the user dictionary in
+  // `user_dictionary_path` and `character_form_manager` instead of those of
+  // the user running this process. Used by the server hosting several users.
+  // `character_form_manager` is installed while a command is evaluated, so it
+  // is used instead of the singleton by the composer and the rewriters.
+  SessionHandler(
+      std::unique_ptr<EngineInterface> engine,
+      std::unique_ptr<config::ConfigStore> config_store,
+      absl::string_view user_dictionary_path,
+      std::unique_ptr<config::CharacterFormManager> character_form_manager);
   SessionHandler(const SessionHandler &) = delete;
   SessionHandler &operator=(const SessionHandler &) = delete;
   ~SessionHandler() override = default;
@@ -90,6 +104,8 @@ class SessionHandler : public SessionHandlerInterface {
   FRIEND_TEST(SessionHandlerTest, EngineUpdateSuccessfulScenarioTest);
   FRIEND_TEST(SessionHandlerTest, EngineRollbackDataTest);
   FRIEND_TEST(SessionHandlerTest, CheckSpellingTest);
+  FRIEND_TEST(SessionHandlerTest, SpareSessionTest);
+  FRIEND_TEST(SessionHandlerTest, MaintenanceTest);
 
   using SessionMap =
       mozc::storage::LruCache<SessionID, std::unique_ptr<session::Session>>;
@@ -97,6 +113,9 @@ class SessionHandler : public SessionHandlerInterface {
 
   // Updates the config, if the |command| contains the config.
   void MaybeUpdateConfig(commands::Command *command);
+  // Returns the config stored in config_store_, or the config of the user
+  // running this process if config_store_ is null.
+  std::shared_ptr<const config::Config> GetStoredConfig() const;
 
   bool CreateSession(commands::Command *command);
   bool DeleteSession(commands::Command *command);
@@ -124,6 +143,9 @@ class SessionHandler : public SessionHandlerInterface {
   // This method doesn't reload the sessions.
   void UpdateSessions(const config::Config &config,
                       const commands::Request &request);
+  // Same as above, but shares the given config snapshot without copying it.
+  void UpdateSessions(std::shared_ptr<const config::Config> config,
+                      const commands::Request &request);
 
   bool Cleanup(commands::Command *command);
   bool SendUserDictionaryCommand(commands::Command *command);
@@ -136,10 +158,28 @@ class SessionHandler : public SessionHandlerInterface {
   // Replaces engine_ with a new instance if it is ready.
   void MaybeReloadEngine(commands::Command *command);
 
+  // Sets config_, key_map_manager_, request_ and |table| to |session|.
+  void InitSession(session::Session *session,
+                   const composer::Table *table) const;
+  // Returns a session from spare_sessions_, or NewSession() if it is empty.
+  std::unique_ptr<session::Session> AcquireSession();
+  // Fills spare_sessions_ up to kMaxSpareSessions. Run by
+  // maintenance_scheduler_ while no client is waiting for the server.
+  void ReplenishSpareSessions();
+
+  // Rebuilds key_filter_ from key_map_manager_.
+  void UpdateKeyFilter();
+  // Attaches key_filter_ to the output if the client sent an outdated
+  // Input::key_filter_version.
+  void MaybeFillKeyFilter(commands::Command *command) const;
+
   SessionID CreateNewSessionID();
   bool DeleteSessionID(SessionID id);
 
   std::unique_ptr<SessionMap> session_map_;
+  // Sessions constructed in advance and kept up to date by UpdateSessions(),
+  // so that CreateSession() can hand them out without constructing one.
+  std::vector<std::unique_ptr<session::Session>> spare_sessions_;
 #ifndef MOZC_DISABLE_SESSION_WATCHDOG
   std::optional<SessionWatchDog> session_watch_dog_;
 #endif  // MOZC_DISABLE_SESSION_WATCHDOG
@@ -148,15 +188,22 @@ class SessionHandler : public SessionHandlerInterface {
   absl::Time last_session_empty_time_ = absl::InfinitePast();
   absl::Time last_cleanup_time_ = absl::InfinitePast();
   absl::Time last_create_session_time_ = absl::InfinitePast();
+  // Runs the maintenance on Cleanup() unless the user is typing.
+  session::MaintenanceScheduler maintenance_scheduler_;
 
   std::unique_ptr<EngineInterface> engine_;
+  std::unique_ptr<config::ConfigStore> config_store_;
+  // Null if the singleton is used.
+  std::unique_ptr<config::CharacterFormManager> character_form_manager_;
   std::unique_ptr<session::SessionObserverHandler> observer_handler_;
   std::unique_ptr<user_dictionary::UserDictionarySessionHandler>
       user_dictionary_session_handler_;
   std::unique_ptr<composer::TableManager> table_manager_;
   std::unique_ptr<const commands::Request> request_;
-  std::unique_ptr<const config::Config> config_;
+  std::shared_ptr<const config::Config> config_;
   std::unique_ptr<keymap::KeyMapManager> key_map_manager_;
+  // Precomposition keys of key_map_manager_ exported to clients.
+  commands::KeyFilter key_filter_;
   std::unique_ptr<engine::SupplementalModelInterface> supplemental_model_;
 
   absl::BitGen bitgen_;
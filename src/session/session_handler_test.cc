@@ -612,6 +612,114 @@ TEST_F(SessionHandlerTest, KeyMapTest) {
   }
 }
 
+TEST_F(SessionHandlerTest, KeyFilterTest) {
+  config::Config config;
+  config::ConfigHandler::GetConfig(&config);
+  config.set_session_keymap(config::Config::MSIME);
+  config::ConfigHandler::SetConfig(config);
+
+  SessionHandler handler(CreateMockDataEngine());
+
+  uint64_t session_id = 0;
+  EXPECT_TRUE(CreateSession(handler, &session_id));
+
+  auto send_key = [&](uint64_t key_filter_version) {
+    commands::Command command;
+    commands::Input *input = command.mutable_input();
+    input->set_id(session_id);
+    input->set_type(commands::Input::SEND_KEY);
+    input->mutable_key()->set_special_key(commands::KeyEvent::ENTER);
+    if (key_filter_version != 0) {
+      input->set_key_filter_version(key_filter_version);
+    }
+    EXPECT_TRUE(handler.EvalCommand(&command));
+    return command.output();
+  };
+
+  // Clients without the filter never receive it.
+  EXPECT_FALSE(send_key(0).has_key_filter());
+
+  const commands::Output output = send_key(1);
+  ASSERT_TRUE(output.has_key_filter());
+  const commands::KeyFilter &key_filter = output.key_filter();
+  EXPECT_NE(key_filter.version(), 0);
+  EXPECT_FALSE(key_filter.precomposition_keys().empty());
+  EXPECT_TRUE(std::is_sorted(key_filter.precomposition_keys().begin(),
+                             key_filter.precomposition_keys().end()));
+
+  // Up-to-date clients don't receive it again.
+  EXPECT_FALSE(send_key(key_filter.version()).has_key_filter());
+
+  // Changing the keymap changes the version.
+  {
+    commands::Command command;
+    commands::Input *input = command.mutable_input();
+    input->set_id(session_id);
+    input->set_type(commands::Input::SET_CONFIG);
+    input->mutable_config()->set_session_keymap(config::Config::KOTOERI);
+    EXPECT_TRUE(handler.EvalCommand(&command));
+  }
+  const commands::Output updated_output = send_key(key_filter.version());
+  ASSERT_TRUE(updated_output.has_key_filter());
+  EXPECT_NE(updated_output.key_filter().version(), key_filter.version());
+}
+
+TEST_F(SessionHandlerTest, SpareSessionTest) {
+  ClockMock clock(absl::FromUnixSeconds(1000));
+  Clock::SetClockForUnitTest(&clock);
+  absl::SetFlag(&FLAGS_create_session_min_interval, 0);
+
+  SessionHandler handler(CreateMockDataEngine());
+  EXPECT_TRUE(handler.spare_sessions_.empty());
+
+  uint64_t id = 0;
+  EXPECT_TRUE(CleanUp(handler, id));
+  ASSERT_FALSE(handler.spare_sessions_.empty());
+  const size_t num_spare_sessions = handler.spare_sessions_.size();
+  const session::Session *spare_session = handler.spare_sessions_.back().get();
+
+  clock.Advance(absl::Seconds(10));
+  EXPECT_TRUE(CreateSession(handler, &id));
+  EXPECT_EQ(handler.spare_sessions_.size(), num_spare_sessions - 1);
+  // The spare session is handed out with a fresh creation time.
+  const std::unique_ptr<session::Session> *session =
+      handler.session_map_->Lookup(id);
+  ASSERT_NE(session, nullptr);
+  EXPECT_EQ(session->get(), spare_session);
+  EXPECT_EQ((*session)->create_session_time(), Clock::GetAbslTime());
+  EXPECT_TRUE(IsGoodSession(handler, id));
+
+  // Cleanup refills the pool once the user stops typing.
+  clock.Advance(absl::Seconds(10));
+  EXPECT_TRUE(CleanUp(handler, id));
+  EXPECT_EQ(handler.spare_sessions_.size(), num_spare_sessions);
+
+  Clock::SetClockForUnitTest(nullptr);
+}
+
+TEST_F(SessionHandlerTest, MaintenanceTest) {
+  ClockMock clock(absl::FromUnixSeconds(1000));
+  Clock::SetClockForUnitTest(&clock);
+
+  SessionHandler handler(CreateMockDataEngine());
+  uint64_t id = 0;
+  EXPECT_TRUE(CreateSession(handler, &id));
+
+  // Cleanup right after a key event doesn't run the maintenance.
+  EXPECT_TRUE(IsGoodSession(handler, id));
+  EXPECT_TRUE(CleanUp(handler, id));
+  EXPECT_TRUE(handler.spare_sessions_.empty());
+  EXPECT_EQ(handler.maintenance_scheduler_.stats().run_count, 0);
+  EXPECT_GT(handler.maintenance_scheduler_.stats().deferred_count, 0);
+
+  clock.Advance(absl::Seconds(10));
+  EXPECT_TRUE(CleanUp(handler, id));
+  EXPECT_FALSE(handler.spare_sessions_.empty());
+  EXPECT_GT(handler.maintenance_scheduler_.stats().run_count, 0);
+
+  Clock::SetClockForUnitTest(nullptr);
+}
+
 TEST_F(SessionHandlerTest, VerifySyncIsCalledTest) {
   // Tests if sync is called for the following input commands.
   commands::Input::CommandType command_types[] = {
@@ -762,29 +870,55 @@ TEST_F(SessionHandlerTest, EngineReloadSessionExistsTest) {
   ASSERT_TRUE(CreateSession(*handler_, &id1));
   EXPECT_EQ(handler_->GetDataVersion(), initial_version);
   EXPECT_EQ(&handler_->engine(), old_engine_ptr);
+  {
+    // Starts a composition in id1. On Windows, its initial mode is DIRECT.
+    commands::Command command;
+    commands::Input *input = command.mutable_input();
+    input->set_id(id1);
+    input->set_type(commands::Input::SEND_KEY);
+    input->mutable_key()->set_special_key(commands::KeyEvent::ON);
+    ASSERT_TRUE(handler_->EvalCommand(&command));
+    command.Clear();
+    input->set_id(id1);
+    input->set_type(commands::Input::SEND_KEY);
+    input->mutable_key()->set_key_code('a');
+    ASSERT_TRUE(handler_->EvalCommand(&command));
+    EXPECT_TRUE(command.output().has_preedit());
+  }
 
   ASSERT_EQ(SendMockEngineReloadRequest(*handler_, mock_request_),
             EngineReloadResponse::ACCEPTED);
 
-  // Another session is created. Since the handler already holds one session
-  // (id1), new data manager is not used.
+  // Another session is created. Since id1 has a composition in flight, new
+  // data manager is not used.
   uint64_t id2 = 0;
   ASSERT_TRUE(CreateSession(*handler_, &id2));
   EXPECT_EQ(&handler_->engine(), old_engine_ptr);
   EXPECT_EQ(handler_->GetDataVersion(), initial_version);
   EXPECT_NE(handler_->GetDataVersion(), mock_version_);
 
-  // All the sessions were deleted.
-  ASSERT_TRUE(DeleteSession(*handler_, id1));
-  ASSERT_TRUE(DeleteSession(*handler_, id2));
+  {
+    // Cancels the composition of id1.
+    commands::Command command;
+    commands::Input *input = command.mutable_input();
+    input->set_id(id1);
+    input->set_type(commands::Input::SEND_COMMAND);
+    input->mutable_command()->set_type(commands::SessionCommand::REVERT);
+    ASSERT_TRUE(handler_->EvalCommand(&command));
+  }
 
-  // A new session is created. Since the handler holds no session, engine
-  // reloads the new data manager.
+  // A new session is created. Since no session is composing, engine reloads
+  // the new data manager while id1 and id2 are alive.
   uint64_t id3 = 0;
   ASSERT_TRUE(CreateSession(*handler_, &id3));
   // New data is reloaded, but the engine is the same object.
   EXPECT_EQ(&handler_->engine(), old_engine_ptr);
   EXPECT_EQ(handler_->GetDataVersion(), mock_version_);
+
+  // The sessions created before the reload move to the new data.
+  EXPECT_TRUE(IsGoodSession(*handler_, id1));
+  EXPECT_TRUE(IsGoodSession(*handler_, id2));
+  EXPECT_TRUE(IsGoodSession(*handler_, id3));
 }
 
 TEST_F(SessionHandlerTest, GetServerVersionTest) {
@@ -49,6 +49,7 @@
 #include "composer/key_parser.h"
 #include "composer/table.h"
 #include "config/config_handler.h"
+#include "converter/converter_interface.h"
 #include "converter/converter_mock.h"
 #include "converter/segments.h"
 #include "data_manager/testing/mock_data_manager.h"
@@ -774,6 +775,42 @@ TEST_F(SessionTest, TestSendKey) {
   EXPECT_TRUE(command.output().consumed());
 }
 
+TEST_F(SessionTest, SurroundingTextUnchanged) {
+  MockEngine engine;
+  MockConverter converter;
+  EXPECT_CALL(engine, GetConverter()).WillRepeatedly(Return(&converter));
+
+  Session session(&engine);
+  InitSessionToPrecomposition(&session);
+
+  commands::Command command;
+  ASSERT_TRUE(SetSendKeyCommand("G", &command));
+  command.mutable_input()->mutable_context()->set_preceding_text("前");
+  command.mutable_input()->mutable_context()->set_following_text("後");
+  session.TestSendKey(&command);
+
+  // The omitted surrounding text is restored from the last input.
+  ASSERT_TRUE(SetSendKeyCommand("G", &command));
+  command.mutable_input()->mutable_context()->set_surrounding_text_unchanged(
+      true);
+  session.SendKey(&command);
+  EXPECT_FALSE(command.input().context().surrounding_text_unchanged());
+  EXPECT_EQ(command.input().context().preceding_text(), "前");
+  EXPECT_EQ(command.input().context().following_text(), "後");
+  EXPECT_EQ(session.context().client_context().preceding_text(), "前");
+
+  // A context without surrounding text resets the remembered one.
+  ASSERT_TRUE(SetSendKeyCommand("G", &command));
+  command.mutable_input()->mutable_context();
+  session.TestSendKey(&command);
+  ASSERT_TRUE(SetSendKeyCommand("G", &command));
+  command.mutable_input()->mutable_context()->set_surrounding_text_unchanged(
+      true);
+  session.TestSendKey(&command);
+  EXPECT_FALSE(command.input().context().has_preceding_text());
+  EXPECT_FALSE(command.input().context().has_following_text());
+}
+
 TEST_F(SessionTest, UpdateComposition) {
   MockEngine engine;
   MockConverter converter;
@@ -850,7 +887,7 @@ TEST_F(SessionTest, SendCommand) {
   {
     MockEngine engine;
     MockConverter converter;
-    EXPECT_CALL(engine, GetConverter()).WillOnce(Return(&converter));
+    EXPECT_CALL(engine, GetConverter()).WillRepeatedly(Return(&converter));
     // ResetConversion is called twice, first in IMEOff through
     // InitSessionToPrecomposition() and then EchoBack() through
     // SendCommand().
@@ -867,6 +904,26 @@ TEST_F(SessionTest, SendCommand) {
   EXPECT_FALSE(command.output().consumed());
 }
 
+TEST_F(SessionTest, MovesToReloadedConverter) {
+  MockEngine engine;
+  MockConverter converter1;
+  MockConverter converter2;
+  ConverterInterface *current = &converter1;
+  EXPECT_CALL(engine, GetConverter()).WillRepeatedly([&current] {
+    return current;
+  });
+
+  Session session(&engine);
+  InitSessionToPrecomposition(&session);
+
+  // The engine is reloaded. The next command runs on the new converter.
+  current = &converter2;
+  EXPECT_CALL(converter1, ResetConversion(_)).Times(0);
+  EXPECT_CALL(converter2, ResetConversion(_));
+  commands::Command command;
+  SendCommand(commands::SessionCommand::RESET_CONTEXT, &session, &command);
+}
+
 TEST_F(SessionTest, SwitchInputMode) {
   MockConverter converter;
   MockEngine engine;
@@ -2325,6 +2382,147 @@ TEST_F(SessionTest, OutputAllCandidateWords) {
   }
 }
 
+TEST_F(SessionTest, RestoreSessionSnapshot) {
+  MockConverter converter;
+  MockEngine engine;
+  EXPECT_CALL(engine, GetConverter()).WillRepeatedly(Return(&converter));
+
+  Session session(&engine);
+  commands::Capability capability;
+  capability.set_session_snapshot(true);
+  session.set_client_capability(capability);
+  InitSessionToPrecomposition(&session);
+  commands::Command command;
+  InsertCharacterChars("aiueo", &session, &command);
+  ASSERT_TRUE(command.output().has_session_snapshot());
+  commands::SessionSnapshot snapshot = command.output().session_snapshot();
+  EXPECT_EQ(snapshot.state(), commands::SessionSnapshot::COMPOSITION);
+
+  Session restored(&engine);
+  InitSessionToPrecomposition(&restored);
+  auto restore = [&](const commands::SessionSnapshot &snapshot) {
+    command.Clear();
+    command.mutable_input()->set_type(commands::Input::SEND_COMMAND);
+    commands::SessionCommand *session_command =
+        command.mutable_input()->mutable_command();
+    session_command->set_type(
+        commands::SessionCommand::RESTORE_SESSION_SNAPSHOT);
+    *session_command->mutable_session_snapshot() = snapshot;
+    return restored.SendCommand(&command);
+  };
+
+  EXPECT_TRUE(restore(snapshot));
+  EXPECT_TRUE(command.output().consumed());
+  EXPECT_EQ(GetComposition(command), "あいうえお");
+  // The snapshot is not requested by the restored session.
+  EXPECT_FALSE(command.output().has_session_snapshot());
+
+  // The composition continues on the restored session.
+  InsertCharacterChars("ka", &restored, &command);
+  EXPECT_EQ(GetComposition(command), "あいうえおか");
+
+  snapshot.mutable_composition()->set_position(100);
+  EXPECT_FALSE(restore(snapshot));
+  EXPECT_FALSE(command.output().consumed());
+}
+
+TEST_F(SessionTest, OutputSessionSnapshotOnlyWhenChanged) {
+  MockConverter converter;
+  MockEngine engine;
+  EXPECT_CALL(engine, GetConverter()).WillRepeatedly(Return(&converter));
+
+  Session session(&engine);
+  commands::Capability capability;
+  capability.set_session_snapshot(true);
+  session.set_client_capability(capability);
+  InitSessionToPrecomposition(&session);
+  commands::Command command;
+  InsertCharacterChars("ai", &session, &command);
+  EXPECT_TRUE(command.output().has_session_snapshot());
+
+  command.Clear();
+  EXPECT_TRUE(SendKey("Left", &session, &command));
+  EXPECT_TRUE(command.output().consumed());
+  ASSERT_TRUE(command.output().has_session_snapshot());
+  EXPECT_EQ(command.output().session_snapshot().composition().position(), 1);
+
+  // The cursor doesn't move any more.
+  command.Clear();
+  EXPECT_TRUE(SendKey("Left", &session, &command));
+  command.Clear();
+  EXPECT_TRUE(SendKey("Left", &session, &command));
+  EXPECT_TRUE(command.output().consumed());
+  EXPECT_FALSE(command.output().has_session_snapshot());
+}
+
+TEST_F(SessionTest, OutputPagedCandidateWords) {
+  MockConverter converter;
+  MockEngine engine;
+  EXPECT_CALL(engine, GetConverter()).WillRepeatedly(Return(&converter));
+
+  Session session(&engine);
+  commands::Capability capability;
+  capability.set_paged_candidate_words(true);
+  session.set_client_capability(capability);
+  InitSessionToPrecomposition(&session);
+  commands::Command command;
+
+  Segments segments;
+  SetAiueo(&segments);
+  InsertCharacterChars("aiueo", &session, &command);
+
+  ConversionRequest request;
+  SetComposer(&session, &request);
+  FillT13Ns(request, &segments);
+  EXPECT_CALL(converter, StartConversion(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(segments), Return(true)));
+
+  command.Clear();
+  session.Convert(&command);
+  const commands::CandidateList &first = command.output().all_candidate_words();
+  const uint64_t candidate_list_id = first.id();
+  const uint32_t size = first.size();
+  EXPECT_NE(candidate_list_id, 0);
+  EXPECT_GT(size, 2);
+  EXPECT_EQ(first.offset(), 0);
+  EXPECT_EQ(first.focused_index(), 0);
+  EXPECT_LE(first.candidates_size(), 9);
+
+  // Moving the focus keeps the id of the candidate list.
+  command.Clear();
+  session.ConvertNext(&command);
+  EXPECT_EQ(command.output().all_candidate_words().id(), candidate_list_id);
+  EXPECT_EQ(command.output().all_candidate_words().focused_index(), 1);
+
+  command.Clear();
+  command.mutable_input()->set_type(commands::Input::SEND_COMMAND);
+  commands::SessionCommand *session_command =
+      command.mutable_input()->mutable_command();
+  session_command->set_type(commands::SessionCommand::GET_CANDIDATE_WORDS);
+  session_command->mutable_candidate_words_range()->set_candidate_list_id(
+      candidate_list_id);
+  session_command->mutable_candidate_words_range()->set_offset(1);
+  session_command->mutable_candidate_words_range()->set_size(2);
+  EXPECT_TRUE(session.SendCommand(&command));
+  {
+    const commands::Output &output = command.output();
+    EXPECT_FALSE(output.consumed());
+    EXPECT_FALSE(output.has_preedit());
+    EXPECT_EQ(output.all_candidate_words().size(), size);
+    EXPECT_EQ(output.all_candidate_words().offset(), 1);
+    ASSERT_EQ(output.all_candidate_words().candidates_size(), 2);
+    EXPECT_EQ(output.all_candidate_words().candidates(0).index(), 1);
+    EXPECT_EQ(output.all_candidate_words().focused_index(), 0);
+  }
+
+  // A stale id is rejected.
+  session_command->mutable_candidate_words_range()->set_candidate_list_id(
+      candidate_list_id + 1);
+  command.clear_output();
+  EXPECT_FALSE(session.SendCommand(&command));
+  EXPECT_FALSE(command.output().has_all_candidate_words());
+}
+
 TEST_F(SessionTest, UndoForComposition) {
   MockConverter converter;
   MockEngine engine;
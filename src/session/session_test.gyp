@@ -117,6 +117,22 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'multi_user_session_server_test',
+      'type': 'executable',
+      'sources': [
+        'multi_user_session_server_test.cc',
+      ],
+      'dependencies': [
+        '<(mozc_oss_src_dir)/base/base_test.gyp:clock_mock',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:gtest_main',
+        '<(mozc_oss_src_dir)/testing/testing.gyp:mozctest',
+        'session.gyp:multi_user_session_server',
+      ],
+      'variables': {
+        'test_size': 'large',
+      },
+    },
     {
       'target_name': 'session_converter_test',
       'type': 'executable',
@@ -320,6 +336,11 @@
         'session_watch_dog_test',
       ],
       'conditions': [
+        ['target_platform=="Linux"', {
+          'dependencies': [
+            'multi_user_session_server_test',
+          ],
+        }],
       ],
     },
   ],
@@ -31,6 +31,7 @@
 #include "unix/fcitx5/mozc_connection.h"
 
 #include <memory>
+#include <utility>
 
 #include "base/vlog.h"
 #include "client/client.h"
@@ -39,18 +40,24 @@
 
 namespace fcitx {
 
-std::unique_ptr<mozc::client::ClientInterface> CreateAndConfigureClient() {
-  auto client = mozc::client::ClientFactory::NewClient();
+std::unique_ptr<mozc::client::ClientInterface> CreateAndConfigureClient(
+    std::shared_ptr<mozc::client::ClientConnection> client_connection) {
+  auto client =
+      mozc::client::ClientFactory::NewClient(std::move(client_connection));
   // Currently client capability is fixed.
   mozc::commands::Capability capability;
   capability.set_text_deletion(
       mozc::commands::Capability::DELETE_PRECEDING_TEXT);
+  // The candidate window is built from Output::candidates, so the whole
+  // candidate words are not necessary.
+  capability.set_paged_candidate_words(true);
   client->set_client_capability(capability);
   return client;
 }
 
 MozcConnection::MozcConnection()
-    : client_factory_(mozc::IPCClientFactory::GetIPCClientFactory()) {
+    : client_factory_(mozc::IPCClientFactory::GetIPCClientFactory()),
+      client_connection_(std::make_shared<mozc::client::ClientConnection>()) {
   MOZC_VLOG(1) << "MozcConnection is created";
 }
 
@@ -59,7 +66,7 @@ MozcConnection::~MozcConnection() {
 }
 
 std::unique_ptr<mozc::client::ClientInterface> MozcConnection::CreateClient() {
-  auto client = CreateAndConfigureClient();
+  auto client = CreateAndConfigureClient(client_connection_);
   client->SetIPCClientFactory(client_factory_);
   return client;
 }
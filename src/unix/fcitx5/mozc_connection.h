@@ -39,6 +39,7 @@ class IPCClientInterface;
 class IPCClientFactoryInterface;
 
 namespace client {
+class ClientConnection;
 class ClientInterface;
 }  // namespace client
 
@@ -54,10 +55,13 @@ class MozcConnection {
   MozcConnection(const MozcConnection &) = delete;
   virtual ~MozcConnection();
 
+  // The clients share the IPC buffer and the key tables, so a client per
+  // input context costs only its session.
   std::unique_ptr<mozc::client::ClientInterface> CreateClient();
 
  private:
   mozc::IPCClientFactoryInterface *client_factory_;
+  std::shared_ptr<mozc::client::ClientConnection> client_connection_;
 };
 
 }  // namespace fcitx
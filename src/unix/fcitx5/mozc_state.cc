@@ -41,7 +41,9 @@
 #include <fcitx/text.h>
 #include <fcitx/userinterface.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -135,8 +137,16 @@ bool MozcState::TrySendKeyEvent(InputContext* ic,
 
   mozc::commands::Context context;
   SurroundingTextInfo surrounding_text_info;
-  if (GetSurroundingText(ic, &surrounding_text_info,
-                         engine_->clipboardAddon())) {
+  const mozc::commands::Output::SurroundingTextLimit limit =
+      client->surrounding_text_limit();
+  if (GetSurroundingText(
+          ic, &surrounding_text_info, engine_->clipboardAddon(),
+          limit.has_max_preceding_length()
+              ? limit.max_preceding_length()
+              : std::numeric_limits<size_t>::max(),
+          limit.has_max_following_length()
+              ? limit.max_following_length()
+              : std::numeric_limits<size_t>::max())) {
     context.set_preceding_text(surrounding_text_info.preceding_text);
     context.set_following_text(surrounding_text_info.following_text);
   }
@@ -186,7 +186,8 @@ bool SurroundingTextUtil::GetAnchorPosFromSelection(
 }
 
 bool GetSurroundingText(InputContext *ic, SurroundingTextInfo *info,
-                        AddonInstance *clipboard) {
+                        AddonInstance *clipboard, size_t max_preceding_length,
+                        size_t max_following_length) {
   if (!ic->capabilityFlags().test(CapabilityFlag::SurroundingText) ||
       !ic->surroundingText().isValid()) {
     return false;
@@ -215,12 +216,15 @@ bool GetSurroundingText(InputContext *ic, SurroundingTextInfo *info,
 
   const size_t selection_start = std::min(cursor_pos, anchor_pos);
   const size_t selection_length = std::abs(info->relative_selected_length);
-  info->preceding_text =
-      std::string(Util::Utf8SubString(surrounding_text, 0, selection_start));
+  const size_t preceding_length =
+      std::min(selection_start, max_preceding_length);
+  info->preceding_text = std::string(Util::Utf8SubString(
+      surrounding_text, selection_start - preceding_length, preceding_length));
   info->selection_text = std::string(
       Util::Utf8SubString(surrounding_text, selection_start, selection_length));
-  info->following_text = std::string(Util::Utf8SubString(
-      surrounding_text, selection_start + selection_length));
+  info->following_text = std::string(
+      Util::Utf8SubString(surrounding_text, selection_start + selection_length,
+                          max_following_length));
   return true;
 }
 
@@ -32,7 +32,9 @@
 
 #include <fcitx/inputcontext.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 
 namespace fcitx {
@@ -75,8 +77,13 @@ class SurroundingTextUtil {
                                         unsigned int *anchor_pos);
 };
 
-bool GetSurroundingText(InputContext *ic, SurroundingTextInfo *info,
-                        AddonInstance *clipboard);
+// Extracts the surrounding text of |ic|. At most |max_preceding_length|
+// characters before the selection and |max_following_length| characters after
+// it are copied into |info|.
+bool GetSurroundingText(
+    InputContext *ic, SurroundingTextInfo *info, AddonInstance *clipboard,
+    size_t max_preceding_length = std::numeric_limits<size_t>::max(),
+    size_t max_following_length = std::numeric_limits<size_t>::max());
 
 }  // namespace fcitx
 
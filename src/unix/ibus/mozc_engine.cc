@@ -30,6 +30,7 @@
 #include "unix/ibus/mozc_engine.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -111,7 +112,12 @@ struct SurroundingTextInfo {
   std::string following_text;
 };
 
-bool GetSurroundingText(IbusEngineWrapper *engine, SurroundingTextInfo *info) {
+// At most |max_preceding_length| characters before the selection and
+// |max_following_length| characters after it are copied into |info|.
+bool GetSurroundingText(
+    IbusEngineWrapper *engine, SurroundingTextInfo *info,
+    size_t max_preceding_length = std::numeric_limits<size_t>::max(),
+    size_t max_following_length = std::numeric_limits<size_t>::max()) {
   if (!(engine->CheckCapabilities(IBUS_CAP_SURROUNDING_TEXT))) {
     MOZC_VLOG(1) << "Give up CONVERT_REVERSE due to client_capabilities: "
                  << engine->GetCapabilities();
@@ -151,10 +157,13 @@ bool GetSurroundingText(IbusEngineWrapper *engine, SurroundingTextInfo *info) {
     return false;
   }
 
-  Util::Utf8SubString(surrounding_text, 0, pos1, &(info->preceding_text));
+  const size_t preceding_length = std::min(pos1, max_preceding_length);
+  Util::Utf8SubString(surrounding_text, pos1 - preceding_length,
+                      preceding_length, &(info->preceding_text));
   Util::Utf8SubString(surrounding_text, pos1, selection_length,
                       &(info->selection_text));
-  Util::Utf8SubString(surrounding_text, pos2, text_length - pos2,
+  Util::Utf8SubString(surrounding_text, pos2,
+                      std::min(text_length - pos2, max_following_length),
                       &(info->following_text));
   return true;
 }
@@ -165,6 +174,9 @@ std::unique_ptr<client::ClientInterface> CreateAndConfigureClient() {
   // Currently client capability is fixed.
   commands::Capability capability;
   capability.set_text_deletion(commands::Capability::DELETE_PRECEDING_TEXT);
+  // The candidate window is built from Output::candidates, so the whole
+  // candidate words are not necessary.
+  capability.set_paged_candidate_words(true);
   client->set_client_capability(capability);
   return client;
 }
@@ -397,7 +409,15 @@ bool MozcEngine::ProcessKeyEvent(IbusEngineWrapper *engine, uint keyval,
 
   commands::Context context;
   SurroundingTextInfo surrounding_text_info;
-  if (GetSurroundingText(engine, &surrounding_text_info)) {
+  const commands::Output::SurroundingTextLimit limit =
+      client_->surrounding_text_limit();
+  if (GetSurroundingText(engine, &surrounding_text_info,
+                         limit.has_max_preceding_length()
+                             ? limit.max_preceding_length()
+                             : std::numeric_limits<size_t>::max(),
+                         limit.has_max_following_length()
+                             ? limit.max_following_length()
+                             : std::numeric_limits<size_t>::max())) {
     context.set_preceding_text(surrounding_text_info.preceding_text);
     context.set_following_text(surrounding_text_info.following_text);
   }
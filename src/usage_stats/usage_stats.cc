@@ -29,12 +29,14 @@
 
 #include "usage_stats/usage_stats.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <map>
 #include <string>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
@@ -52,6 +54,11 @@ constexpr absl::string_view kRegistryPrefix = "usage_stats.";
 
 #include "usage_stats/usage_stats_list.inc"
 
+// Nothing stores usage stats anymore, so the registry can only have the data
+// loaded from the file written by older versions. Once it is purged, Sync()
+// doesn't need to look up every stats again.
+std::atomic<bool> g_legacy_data_purged = false;
+
 bool LoadStats(const absl::string_view name, Stats *stats) {
   DCHECK(UsageStats::IsListed(name)) << name << " is not in the list";
   std::string stats_str;
@@ -83,12 +90,11 @@ bool GetterInternal(const absl::string_view name, Stats::Type type,
 }  // namespace
 
 bool UsageStats::IsListed(const absl::string_view name) {
-  for (size_t i = 0; i < std::size(kStatsList); ++i) {
-    if (name == kStatsList[i]) {
-      return true;
-    }
-  }
-  return false;
+  // Called from DCHECK on every update, so avoids scanning the whole list.
+  static const absl::flat_hash_set<absl::string_view> *const listed =
+      new absl::flat_hash_set<absl::string_view>(std::begin(kStatsList),
+                                                 std::end(kStatsList));
+  return listed->contains(name);
 }
 
 void UsageStats::ClearStats() {
@@ -249,13 +255,21 @@ void UsageStats::StoreTouchEventStats(
   // Does nothing
 }
 
+void UsageStats::ResetLegacyDataPurgedForTest() {
+  g_legacy_data_purged.store(false, std::memory_order_relaxed);
+}
+
 bool UsageStats::Sync() {
+  if (g_legacy_data_purged.load(std::memory_order_relaxed)) {
+    return true;
+  }
   ClearAllStats();                      // Clears accumulated data.
   UsageStatsUploader::ClearMetaData();  // Clears meta data to send usage stats.
   if (!storage::Registry::Sync()) {
     LOG(ERROR) << "sync failed";
     return false;
   }
+  g_legacy_data_purged.store(true, std::memory_order_relaxed);
   return true;
 }
 
@@ -89,6 +89,9 @@ class UsageStats {
 
   static void ClearAllStatsForTest() { ClearAllStats(); }
 
+  // Makes the next Sync() purge the legacy data again.
+  static void ResetLegacyDataPurgedForTest();
+
   // NOTE: These methods are for unit tests.
   // Reads a value from registry, and sets it in the value.
   // Returns true if all steps go successfully.
@@ -51,6 +51,7 @@ class UsageStatsTest : public testing::TestWithTempUserProfile {
     // Update the registry file path by creating a new storage.
     storage::Registry::SetStorage(storage::TinyStorage::New());
     EXPECT_TRUE(storage::Registry::Clear());
+    UsageStats::ResetLegacyDataPurgedForTest();
     mozc::config::StatsConfigUtil::SetHandler(&stats_config_util_);
   }
   void TearDown() override {
@@ -134,6 +135,22 @@ TEST_F(UsageStatsTest, StoreTest) {
                                                      &virtual_keyboard_val));
 }
 
+TEST_F(UsageStatsTest, SyncPurgesLegacyDataOnce) {
+  // Written by an older version.
+  constexpr char kKey[] = "usage_stats.ShutDown";
+  std::string stats_str;
+  EXPECT_TRUE(storage::Registry::Insert(kKey, std::string("legacy")));
+
+  EXPECT_TRUE(UsageStats::Sync());
+  EXPECT_FALSE(storage::Registry::Lookup(kKey, &stats_str));
+
+  // Nothing stores the stats in this process, so later syncs don't look them
+  // up again.
+  EXPECT_TRUE(storage::Registry::Insert(kKey, std::string("legacy")));
+  EXPECT_TRUE(UsageStats::Sync());
+  EXPECT_TRUE(storage::Registry::Lookup(kKey, &stats_str));
+}
+
 namespace {
 void SetDoubleValueStats(uint32_t num, double total, double square_total,
                          usage_stats::Stats::DoubleValueStats *double_stats) {
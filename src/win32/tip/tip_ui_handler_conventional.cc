@@ -429,6 +429,7 @@ void TipUiHandlerConventional::OnDeactivate() {
 
 void TipUiHandlerConventional::OnFocusChange(
     TipTextService *text_service, ITfDocumentMgr *focused_document_manager) {
+  Win32RendererClient::OnFocusChanged();
   if (!focused_document_manager) {
     // Empty document. Hide the renderer.
     RendererCommand command;